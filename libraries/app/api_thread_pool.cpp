@@ -0,0 +1,125 @@
+#include <scorum/app/api_thread_pool.hpp>
+
+#include <scorum/utils/thread_pool.hpp>
+
+#include <fc/log/logger.hpp>
+
+namespace scorum {
+namespace app {
+
+namespace {
+thread_local bool api_worker_thread = false;
+
+template <typename T> void update_max(std::atomic<T>& max, T value)
+{
+    T current = max.load();
+    while (current < value && !max.compare_exchange_weak(current, value))
+    {
+    }
+}
+}
+
+void api_thread_pool::counters::enqueued()
+{
+    update_max(max_queue_depth, ++queue_depth);
+}
+
+void api_thread_pool::counters::started(const fc::time_point& queued)
+{
+    --queue_depth;
+    total_wait_microseconds += (fc::time_point::now() - queued).count();
+}
+
+void api_thread_pool::counters::finished(const fc::time_point& started)
+{
+    const uint64_t elapsed = (fc::time_point::now() - started).count();
+
+    ++calls;
+    total_exec_microseconds += elapsed;
+    update_max(max_exec_microseconds, elapsed);
+}
+
+api_thread_pool_stats api_thread_pool::counters::get() const
+{
+    api_thread_pool_stats stats;
+    stats.calls = calls;
+    stats.queue_depth = queue_depth;
+    stats.max_queue_depth = max_queue_depth;
+    stats.total_wait_microseconds = total_wait_microseconds;
+    stats.total_exec_microseconds = total_exec_microseconds;
+    stats.max_exec_microseconds = max_exec_microseconds;
+    return stats;
+}
+
+api_thread_pool::api_thread_pool()
+{
+}
+
+api_thread_pool::~api_thread_pool()
+{
+    stop();
+}
+
+void api_thread_pool::start(uint32_t threads_count)
+{
+    FC_ASSERT(!_pool, "API thread pool is already started.");
+
+    if (threads_count > 0)
+    {
+        ilog("Starting ${n} API worker threads", ("n", threads_count));
+        _pool.reset(new utils::thread_pool(threads_count));
+    }
+}
+
+void api_thread_pool::stop()
+{
+    if (_pool)
+    {
+        _pool->stop();
+        _pool.reset();
+    }
+}
+
+uint32_t api_thread_pool::size() const
+{
+    return _pool ? (uint32_t)_pool->size() : 0u;
+}
+
+std::map<std::string, api_thread_pool_stats> api_thread_pool::get_stats() const
+{
+    std::map<std::string, api_thread_pool_stats> result;
+
+    std::lock_guard<std::mutex> lock(_counters_mutex);
+    for (const auto& c : _counters)
+    {
+        result.emplace(c.first, c.second->get());
+    }
+
+    return result;
+}
+
+api_thread_pool::counters& api_thread_pool::get_counters(const std::string& api_name)
+{
+    std::lock_guard<std::mutex> lock(_counters_mutex);
+
+    auto& c = _counters[api_name];
+    if (!c)
+        c.reset(new counters());
+
+    return *c;
+}
+
+void api_thread_pool::post(std::function<void()> task)
+{
+    _pool->post([task]() {
+        api_worker_thread = true;
+        task();
+    });
+}
+
+bool api_thread_pool::is_worker_thread()
+{
+    return api_worker_thread;
+}
+}
+}
@@ -27,6 +27,8 @@
 #include <scorum/app/advertising_api.hpp>
 #include <scorum/app/api_access.hpp>
 #include <scorum/app/application.hpp>
+#include <scorum/app/head_state_snapshot.hpp>
+#include <scorum/app/api_thread_pool.hpp>
 #include <scorum/app/plugin.hpp>
 #include <scorum/account_statistics/account_statistics_api.hpp>
 #include <scorum/account_statistics/account_statistics_plugin.hpp>
@@ -41,6 +43,7 @@
 #include <scorum/chain/database_exceptions.hpp>
 #include <scorum/chain/genesis/genesis_state.hpp>
 #include <scorum/egenesis/egenesis.hpp>
+#include <scorum/protocol/signature_keys_cache.hpp>
 
 #include <fc/time.hpp>
 
@@ -104,6 +107,43 @@ namespace detail {
 using plugins_type = std::map<std::string, std::shared_ptr<abstract_plugin>>;
 using plugin_names_type = std::set<std::string>;
 
+chainbase::mapping_options get_shared_file_mapping(const bpo::variables_map& options)
+{
+    using chainbase::mapping_options;
+
+    static const std::map<std::string, mapping_options::access_advice> advices
+        = { { "normal", mapping_options::access_advice::normal },
+            { "random", mapping_options::access_advice::random },
+            { "sequential", mapping_options::access_advice::sequential },
+            { "willneed", mapping_options::access_advice::willneed } };
+
+    static const std::map<std::string, mapping_options::numa_policy> policies
+        = { { "none", mapping_options::numa_policy::none },
+            { "interleave", mapping_options::numa_policy::interleave },
+            { "bind", mapping_options::numa_policy::bind } };
+
+    mapping_options result;
+
+    result.huge_pages = options.at("shared-file-huge-pages").as<bool>();
+    result.prefault = options.count("shared-file-prefault") > 0;
+
+    const auto advice = options.at("shared-file-advice").as<std::string>();
+    FC_ASSERT(advices.count(advice), "Unknown shared file advice '${a}'", ("a", advice));
+    result.advice = advices.at(advice);
+
+    const auto policy = options.at("shared-file-numa-policy").as<std::string>();
+    FC_ASSERT(policies.count(policy), "Unknown shared file NUMA policy '${p}'", ("p", policy));
+    result.numa = policies.at(policy);
+
+    if (options.count("shared-file-numa-node"))
+        result.numa_nodes = options.at("shared-file-numa-node").as<std::vector<uint32_t>>();
+
+    FC_ASSERT(result.numa == mapping_options::numa_policy::none || !result.numa_nodes.empty(),
+              "NUMA nodes should be set by shared-file-numa-node for '${p}' policy", ("p", policy));
+
+    return result;
+}
+
 class application_impl : public graphene::net::node_delegate
 {
 public:
@@ -282,6 +322,23 @@ public:
         : _self(self)
         , _chain_db(std::move(chain_db))
     {
+        // not connected to applied_block: it is emitted before block session is pushed, by every block of
+        // reindex and by every block applied while switching forks
+        _chain_db->head_block_changed.connect([this]() { update_head_state(); });
+    }
+
+    void update_head_state()
+    {
+        try
+        {
+            _head_state.update(*_chain_db);
+        }
+        catch (const fc::exception& e)
+        {
+            // readers fall back to the locked path
+            _head_state.reset();
+            wlog("Unable to update head state snapshot: ${e}", ("e", e.to_detail_string()));
+        }
     }
 
     ~application_impl()
@@ -339,6 +396,7 @@ public:
 
             _shared_file_size = fc::parse_size(_options->at("shared-file-size").as<std::string>());
             ilog("shared_file_size is ${n} bytes", ("n", _shared_file_size));
+            _chain_db->set_shared_file_mapping(get_shared_file_mapping(*_options));
             register_builtin_apis();
 
             if (_options->count("check-locks"))
@@ -370,6 +428,20 @@ public:
                 }
 
                 _chain_db->set_flush_interval(_options->at("flush").as<uint32_t>());
+                _chain_db->set_shared_file_autoscale(_options->at("shared-file-full-threshold").as<uint16_t>(),
+                                                     _options->at("shared-file-scale-rate").as<uint16_t>());
+                _chain_db->set_memory_stats_interval(_options->at("memory-stats-interval").as<uint32_t>());
+                _chain_db->set_state_digest_interval(_options->at("state-digest-interval").as<uint32_t>());
+                _chain_db->set_replay_threads(_options->at("replay-threads").as<uint32_t>());
+                _chain_db->set_signature_threads(_options->at("signature-threads").as<uint32_t>());
+
+                chain::pending_transaction_limits pending_limits;
+                pending_limits.max_count = _options->at("max-pending-transactions").as<uint32_t>();
+                pending_limits.max_bytes = _options->at("max-pending-transactions-size").as<uint64_t>() * 1024 * 1024;
+                pending_limits.max_per_account = _options->at("max-pending-transactions-per-account").as<uint32_t>();
+                _chain_db->set_pending_transaction_limits(pending_limits);
+                protocol::signature_keys_cache::instance().set_capacity(
+                    _options->at("signature-cache-size").as<uint32_t>());
 
                 flat_map<uint32_t, block_id_type> loaded_checkpoints;
                 if (_options->count("checkpoint"))
@@ -384,7 +456,18 @@ public:
                 }
                 _chain_db->add_checkpoints(loaded_checkpoints);
 
-                if (_options->count("replay-blockchain") && !_options->count("resync-blockchain"))
+                if (_options->count("import-state-snapshot"))
+                {
+                    ilog("Importing state snapshot on user request.");
+
+                    _chain_db->wipe(block_log_dir, _shared_dir, false);
+                    _chain_db->open(block_log_dir, _shared_dir, _shared_file_size, chainbase::database::read_write,
+                                    genesis_state);
+                    _chain_db->import_state_snapshot(
+                        _options->at("import-state-snapshot").as<boost::filesystem::path>(),
+                        _options->at("state-snapshot-threads").as<uint32_t>(), _chain_db->get_reindex_skip_flags());
+                }
+                else if (_options->count("replay-blockchain") && !_options->count("resync-blockchain"))
                 {
                     ilog("Replaying blockchain on user request.");
 
@@ -400,6 +483,19 @@ public:
                                     genesis_state);
                 }
 
+                update_head_state();
+
+                if (_options->count("compact-shared-file"))
+                {
+                    _chain_db->compact_shared_memory();
+                }
+
+                if (_options->count("export-state-snapshot"))
+                {
+                    _chain_db->export_state_snapshot(
+                        _options->at("export-state-snapshot").as<boost::filesystem::path>());
+                }
+
                 if (_options->count("force-validate"))
                 {
                     ilog("All transaction signatures will be validated");
@@ -474,6 +570,8 @@ public:
                 reset_p2p_node(_data_dir);
             }
 
+            _api_pool.start(_options->at("rpc-threads").as<uint32_t>());
+
             reset_websocket_server();
             reset_websocket_tls_server();
         }
@@ -1049,6 +1147,7 @@ public:
     {
         _running = false;
         fc::usleep(fc::seconds(1));
+        _api_pool.stop();
         if (_p2p_network)
         {
             _p2p_network->close();
@@ -1081,6 +1180,8 @@ public:
     api_access _apiaccess;
 
     std::shared_ptr<scorum::chain::database> _chain_db;
+    head_state_snapshot _head_state;
+    api_thread_pool _api_pool;
     std::shared_ptr<graphene::net::node> _p2p_network;
     std::shared_ptr<fc::http::websocket_server> _websocket_server;
     std::shared_ptr<fc::http::websocket_tls_server> _websocket_tls_server;
@@ -1172,7 +1273,15 @@ void application::set_program_options(boost::program_options::options_descriptio
     ("data-dir,d", bpo::value<boost::filesystem::path>()->default_value("witness_node_data_dir"), "Directory containing databases, configuration file, etc.")
     ("shared-file-dir", bpo::value<boost::filesystem::path>(), "Location of the shared memory file. Defaults to data_dir/blockchain")
     ("shared-file-size", bpo::value<std::string>()->default_value("54G"), "Size of the shared memory file. Default: 54G")
+    ("shared-file-full-threshold", bpo::value<uint16_t>()->default_value(0), "Used part of the shared memory file (0-10000, 10000 = 100%) at which the file is grown between blocks. 0 disables growth")
+    ("shared-file-scale-rate", bpo::value<uint16_t>()->default_value(1000), "Part of the current shared memory file size (0-10000, 10000 = 100%) added when the file is grown")
+    ("shared-file-huge-pages", bpo::value<bool>()->default_value(false), "Advise transparent huge pages for the shared memory file. Takes effect when the file is on tmpfs, place it on hugetlbfs mount for explicit huge pages")
+    ("shared-file-advice", bpo::value<std::string>()->default_value("normal"), "Access pattern advice for the shared memory file: normal, random, sequential or willneed")
+    ("shared-file-numa-policy", bpo::value<std::string>()->default_value("none"), "NUMA memory policy for the shared memory file: none, interleave or bind")
+    ("shared-file-numa-node", bpo::value<std::vector<uint32_t>>()->composing(), "NUMA node used by shared-file-numa-policy (may specify multiple times)")
+    ("shared-file-prefault", "Pre-fault all pages of the shared memory file on startup")
     ("rpc-endpoint", bpo::value<std::string>()->implicit_value("127.0.0.1:8090"), "Endpoint for websocket RPC to listen on")
+    ("rpc-threads", bpo::value<uint32_t>()->default_value(0), "Number of threads executing read-only API calls. 0 executes them on the main thread")
     ("rpc-tls-endpoint", bpo::value<std::string>()->implicit_value("127.0.0.1:8089"), "Endpoint for TLS websocket RPC to listen on")
     ("read-forward-rpc", bpo::value<std::string>(), "Endpoint to forward write API calls to for a read node")
     ("server-pem,p", bpo::value<std::string>()->implicit_value("server.pem"), "The TLS certificate file for this server")
@@ -1182,10 +1291,22 @@ void application::set_program_options(boost::program_options::options_descriptio
     ("enable-plugin", bpo::value< std::vector<std::string> >()->composing()->default_value(default_plugins, str_default_plugins), "Plugin(s) to enable, may be specified multiple times")
     ("max-block-age", bpo::value< int32_t >()->default_value(200), "Maximum age of head block when broadcasting tx via API")
     ("flush", bpo::value< uint32_t >()->default_value(100000), "Flush shared memory file to disk this many blocks")
+    ("memory-stats-interval", bpo::value<uint32_t>()->default_value(0), "Log memory used by every index of shared memory file each this many blocks. 0 disables it")
+    ("state-digest-interval", bpo::value<uint32_t>()->default_value(0), "Maintain digest of chain state updated on every change of objects and log it each this many blocks. 0 disables it")
     ("genesis-json,g", bpo::value<boost::filesystem::path>(), "File to read genesis state from")
     ("replay-blockchain", "Rebuild object graph by replaying all blocks")
     ("replay-skip-witness-schedule-check", bpo::value<bool>()->default_value(true), "Skip witness schedule check wile block replaying")
+    ("replay-threads", bpo::value<uint32_t>()->default_value(0), "Number of threads prefetching and hashing blocks while replaying. 0 disables replay pipeline")
+    ("signature-threads", bpo::value<uint32_t>()->default_value(0), "Number of threads recovering signature keys and validating operations of transactions of incoming blocks in parallel. 0 disables it")
+    ("signature-cache-size", bpo::value<uint32_t>()->default_value(protocol::signature_keys_cache::default_capacity), "Number of public keys recovered from signatures kept in cache. 0 disables cache")
+    ("max-pending-transactions", bpo::value<uint32_t>()->default_value(0), "Maximum number of pending transactions. 0 is unlimited")
+    ("max-pending-transactions-size", bpo::value<uint64_t>()->default_value(0), "Maximum size of pending transactions in MiB. 0 is unlimited")
+    ("max-pending-transactions-per-account", bpo::value<uint32_t>()->default_value(0), "Maximum number of pending transactions requiring authority of the same account. 0 is unlimited")
     ("resync-blockchain", "Delete all blocks and re-sync with network from scratch")
+    ("compact-shared-file", "Rewrite the shared memory file into a densely packed one on startup")
+    ("export-state-snapshot", bpo::value<boost::filesystem::path>(), "Write portable state snapshot at the head block to the file on startup")
+    ("import-state-snapshot", bpo::value<boost::filesystem::path>(), "Rebuild state from the snapshot file instead of replaying blocks preceding it. Block log must contain the snapshot block")
+    ("state-snapshot-threads", bpo::value<uint32_t>()->default_value(4), "Number of threads loading indexes of state snapshot")
     ("force-validate", "Force validation of all transactions")
     ("read-only", "Node will not connect to p2p network and can only read from the chain state")
     ("check-locks", "Check correctness of chainbase locking")
@@ -1365,6 +1486,16 @@ std::shared_ptr<chain::database> application::chain_database() const
     return my->_chain_db;
 }
 
+const head_state_snapshot& application::head_state() const
+{
+    return my->_head_state;
+}
+
+api_thread_pool& application::api_pool()
+{
+    return my->_api_pool;
+}
+
 void application::set_block_production(bool producing_blocks)
 {
     my->_is_block_producer = producing_blocks;
@@ -1,6 +1,8 @@
 #include <scorum/app/api_context.hpp>
 #include <scorum/app/application.hpp>
 #include <scorum/app/database_api.hpp>
+#include <scorum/app/head_state_snapshot.hpp>
+#include <scorum/app/api_thread_pool.hpp>
 
 #include <scorum/protocol/get_config.hpp>
 
@@ -144,7 +146,14 @@ public:
 
     std::function<void(const fc::variant&)> _block_applied_callback;
 
+    template <typename Lambda> auto with_read_lock(Lambda&& callback) const -> decltype((*(Lambda*)nullptr)())
+    {
+        return _api_pool.with_read_lock(API_DATABASE, _db, std::forward<Lambda>(callback));
+    }
+
     scorum::chain::database& _db;
+    const head_state_snapshot& _head_state;
+    api_thread_pool& _api_pool;
 
     boost::signals2::scoped_connection _block_applied_connection;
 
@@ -161,6 +170,7 @@ public:
 
 void database_api::set_block_applied_callback(std::function<void(const variant& block_id)> cb)
 {
+    // connects to database signal so it stays on the chain thread
     my->_db.with_read_lock([&]() { my->set_block_applied_callback(cb); });
 }
 
@@ -200,6 +210,8 @@ database_api::~database_api()
 
 database_api_impl::database_api_impl(const scorum::app::api_context& ctx)
     : _db(*ctx.app.chain_database())
+    , _head_state(ctx.app.head_state())
+    , _api_pool(ctx.app.api_pool())
 {
     wlog("creating database api ${x}", ("x", int64_t(this)));
 }
@@ -221,7 +233,8 @@ void database_api::on_api_startup()
 
 fc::variant_object database_api::get_config() const
 {
-    return my->_db.with_read_lock([&]() { return my->get_config(); });
+    // protocol constants only, no lock required
+    return my->get_config();
 }
 
 fc::variant_object database_api_impl::get_config() const
@@ -231,36 +244,23 @@ fc::variant_object database_api_impl::get_config() const
 
 dynamic_global_property_api_obj database_api::get_dynamic_global_properties() const
 {
-    return my->_db.with_read_lock([&]() { return my->get_dynamic_global_properties(); });
+    if (auto state = my->_head_state.get())
+        return state->dynamic_global_properties;
+
+    return my->with_read_lock([&]() { return my->get_dynamic_global_properties(); });
 }
 
 dynamic_global_property_api_obj database_api_impl::get_dynamic_global_properties() const
 {
-    dynamic_global_property_api_obj gpao;
-    gpao = _db.obtain_service<dbs_dynamic_global_property>().get();
-
-    if (_db.has_index<witness::reserve_ratio_index>())
-    {
-        const auto& r = _db.find(witness::reserve_ratio_id_type());
-
-        if (BOOST_LIKELY(r != nullptr))
-        {
-            gpao = *r;
-        }
-    }
-
-    gpao.registration_pool_balance = _db.obtain_service<dbs_registration_pool>().get().balance;
-    gpao.fund_budget_balance = _db.obtain_service<dbs_fund_budget>().get().balance;
-    gpao.reward_pool_balance = _db.obtain_service<dbs_content_reward_scr>().get().balance;
-    gpao.content_reward_scr_balance = _db.obtain_service<dbs_content_reward_fund_scr>().get().activity_reward_balance;
-    gpao.content_reward_sp_balance = _db.obtain_service<dbs_content_reward_fund_sp>().get().activity_reward_balance;
-
-    return gpao;
+    return make_dynamic_global_property_api_obj(_db);
 }
 
 chain_id_type database_api::get_chain_id() const
 {
-    return my->_db.with_read_lock([&]() { return my->get_chain_id(); });
+    if (auto state = my->_head_state.get())
+        return state->chain_id;
+
+    return my->with_read_lock([&]() { return my->get_chain_id(); });
 }
 
 chain_id_type database_api_impl::get_chain_id() const
@@ -270,7 +270,10 @@ chain_id_type database_api_impl::get_chain_id() const
 
 witness_schedule_api_obj database_api::get_witness_schedule() const
 {
-    return my->_db.with_read_lock([&]() { return my->_db.get(witness_schedule_id_type()); });
+    if (auto state = my->_head_state.get())
+        return state->witness_schedule;
+
+    return my->with_read_lock([&]() { return my->_db.get(witness_schedule_id_type()); });
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -281,7 +284,7 @@ witness_schedule_api_obj database_api::get_witness_schedule() const
 
 std::vector<std::set<std::string>> database_api::get_key_references(std::vector<public_key_type> key) const
 {
-    return my->_db.with_read_lock([&]() { return my->get_key_references(key); });
+    return my->with_read_lock([&]() { return my->get_key_references(key); });
 }
 
 /**
@@ -303,7 +306,7 @@ std::vector<std::set<std::string>> database_api_impl::get_key_references(std::ve
 
 std::vector<extended_account> database_api::get_accounts(const std::vector<std::string>& names) const
 {
-    return my->_db.with_read_lock([&]() { return my->get_accounts(names); });
+    return my->with_read_lock([&]() { return my->get_accounts(names); });
 }
 
 std::vector<extended_account> database_api_impl::get_accounts(const std::vector<std::string>& names) const
@@ -336,7 +339,7 @@ std::vector<extended_account> database_api_impl::get_accounts(const std::vector<
 
 std::vector<account_id_type> database_api::get_account_references(account_id_type account_id) const
 {
-    return my->_db.with_read_lock([&]() { return my->get_account_references(account_id); });
+    return my->with_read_lock([&]() { return my->get_account_references(account_id); });
 }
 
 std::vector<account_id_type> database_api_impl::get_account_references(account_id_type account_id) const
@@ -359,7 +362,7 @@ std::vector<account_id_type> database_api_impl::get_account_references(account_i
 std::vector<optional<account_api_obj>>
 database_api::lookup_account_names(const std::vector<std::string>& account_names) const
 {
-    return my->_db.with_read_lock([&]() { return my->lookup_account_names(account_names); });
+    return my->with_read_lock([&]() { return my->lookup_account_names(account_names); });
 }
 
 std::vector<optional<account_api_obj>>
@@ -386,7 +389,7 @@ database_api_impl::lookup_account_names(const std::vector<std::string>& account_
 
 std::set<std::string> database_api::lookup_accounts(const std::string& lower_bound_name, uint32_t limit) const
 {
-    return my->_db.with_read_lock([&]() { return my->lookup_accounts(lower_bound_name, limit); });
+    return my->with_read_lock([&]() { return my->lookup_accounts(lower_bound_name, limit); });
 }
 
 std::set<std::string> database_api_impl::lookup_accounts(const std::string& lower_bound_name, uint32_t limit) const
@@ -405,7 +408,7 @@ std::set<std::string> database_api_impl::lookup_accounts(const std::string& lowe
 
 uint64_t database_api::get_account_count() const
 {
-    return my->_db.with_read_lock([&]() { return my->get_account_count(); });
+    return my->with_read_lock([&]() { return my->get_account_count(); });
 }
 
 uint64_t database_api_impl::get_account_count() const
@@ -415,7 +418,7 @@ uint64_t database_api_impl::get_account_count() const
 
 std::vector<owner_authority_history_api_obj> database_api::get_owner_history(const std::string& account) const
 {
-    return my->_db.with_read_lock([&]() {
+    return my->with_read_lock([&]() {
         std::vector<owner_authority_history_api_obj> results;
 
         const auto& hist_idx = my->_db.get_index<owner_authority_history_index>().indices().get<by_account>();
@@ -433,7 +436,7 @@ std::vector<owner_authority_history_api_obj> database_api::get_owner_history(con
 
 optional<account_recovery_request_api_obj> database_api::get_recovery_request(const std::string& account) const
 {
-    return my->_db.with_read_lock([&]() {
+    return my->with_read_lock([&]() {
         optional<account_recovery_request_api_obj> result;
 
         const auto& rec_idx = my->_db.get_index<account_recovery_request_index>().indices().get<by_account>();
@@ -448,7 +451,7 @@ optional<account_recovery_request_api_obj> database_api::get_recovery_request(co
 
 optional<escrow_api_obj> database_api::get_escrow(const std::string& from, uint32_t escrow_id) const
 {
-    return my->_db.with_read_lock([&]() {
+    return my->with_read_lock([&]() {
         optional<escrow_api_obj> result;
 
         try
@@ -466,7 +469,7 @@ optional<escrow_api_obj> database_api::get_escrow(const std::string& from, uint3
 std::vector<withdraw_route> database_api::get_withdraw_routes(const std::string& account,
                                                               withdraw_route_type type) const
 {
-    return my->_db.with_read_lock([&]() {
+    return my->with_read_lock([&]() {
         std::vector<withdraw_route> result;
 
         const auto& acc = my->_db.obtain_service<chain::dbs_account>().get_account(account);
@@ -539,7 +542,7 @@ optional<account_bandwidth_api_obj> database_api::get_account_bandwidth(const st
 std::vector<optional<witness_api_obj>>
 database_api::get_witnesses(const std::vector<witness_id_type>& witness_ids) const
 {
-    return my->_db.with_read_lock([&]() { return my->get_witnesses(witness_ids); });
+    return my->with_read_lock([&]() { return my->get_witnesses(witness_ids); });
 }
 
 std::vector<optional<witness_api_obj>>
@@ -558,12 +561,12 @@ database_api_impl::get_witnesses(const std::vector<witness_id_type>& witness_ids
 
 fc::optional<witness_api_obj> database_api::get_witness_by_account(const std::string& account_name) const
 {
-    return my->_db.with_read_lock([&]() { return my->get_witness_by_account(account_name); });
+    return my->with_read_lock([&]() { return my->get_witness_by_account(account_name); });
 }
 
 std::vector<witness_api_obj> database_api::get_witnesses_by_vote(const std::string& from, uint32_t limit) const
 {
-    return my->_db.with_read_lock([&]() {
+    return my->with_read_lock([&]() {
         // idump((from)(limit));
         FC_ASSERT(limit <= get_api_config(API_DATABASE).lookup_limit);
 
@@ -602,7 +605,7 @@ fc::optional<witness_api_obj> database_api_impl::get_witness_by_account(const st
 std::set<account_name_type> database_api::lookup_witness_accounts(const std::string& lower_bound_name,
                                                                   uint32_t limit) const
 {
-    return my->_db.with_read_lock([&]() { return my->lookup_witness_accounts(lower_bound_name, limit); });
+    return my->with_read_lock([&]() { return my->lookup_witness_accounts(lower_bound_name, limit); });
 }
 
 std::set<account_name_type> database_api_impl::lookup_witness_accounts(const std::string& lower_bound_name,
@@ -628,7 +631,7 @@ std::set<account_name_type> database_api_impl::lookup_witness_accounts(const std
 
 uint64_t database_api::get_witness_count() const
 {
-    return my->_db.with_read_lock([&]() { return my->get_witness_count(); });
+    return my->with_read_lock([&]() { return my->get_witness_count(); });
 }
 
 uint64_t database_api_impl::get_witness_count() const
@@ -638,7 +641,10 @@ uint64_t database_api_impl::get_witness_count() const
 
 advertising_property_api_obj database_api::get_advertising_property() const
 {
-    return my->_db.with_read_lock([&]() { return my->get_advertising_property(); });
+    if (auto state = my->_head_state.get())
+        return state->advertising_property;
+
+    return my->with_read_lock([&]() { return my->get_advertising_property(); });
 }
 
 advertising_property_api_obj database_api_impl::get_advertising_property() const
@@ -650,13 +656,13 @@ std::set<account_name_type> database_api::lookup_registration_committee_members(
                                                                                 uint32_t limit) const
 {
 
-    return my->_db.with_read_lock([&]() { return my->lookup_registration_committee_members(lower_bound_name, limit); });
+    return my->with_read_lock([&]() { return my->lookup_registration_committee_members(lower_bound_name, limit); });
 }
 
 std::set<account_name_type> database_api::lookup_development_committee_members(const std::string& lower_bound_name,
                                                                                uint32_t limit) const
 {
-    return my->_db.with_read_lock([&]() { return my->lookup_development_committee_members(lower_bound_name, limit); });
+    return my->with_read_lock([&]() { return my->lookup_development_committee_members(lower_bound_name, limit); });
 }
 
 std::set<account_name_type>
@@ -677,7 +683,7 @@ std::set<account_name_type> database_api_impl::lookup_development_committee_memb
 
 std::vector<proposal_api_obj> database_api::lookup_proposals() const
 {
-    return my->_db.with_read_lock([&]() { return my->lookup_proposals(); });
+    return my->with_read_lock([&]() { return my->lookup_proposals(); });
 }
 
 std::vector<proposal_api_obj> database_api_impl::lookup_proposals() const
@@ -695,7 +701,10 @@ std::vector<proposal_api_obj> database_api_impl::lookup_proposals() const
 
 registration_committee_api_obj database_api::get_registration_committee() const
 {
-    return my->_db.with_read_lock([&]() { return my->get_registration_committee(); });
+    if (auto state = my->_head_state.get())
+        return state->registration_committee;
+
+    return my->with_read_lock([&]() { return my->get_registration_committee(); });
 }
 
 registration_committee_api_obj database_api_impl::get_registration_committee() const
@@ -707,7 +716,10 @@ registration_committee_api_obj database_api_impl::get_registration_committee() c
 
 development_committee_api_obj database_api::get_development_committee() const
 {
-    return my->_db.with_read_lock([&]() { return my->get_development_committee(); });
+    if (auto state = my->_head_state.get())
+        return state->development_committee;
+
+    return my->with_read_lock([&]() { return my->get_development_committee(); });
 }
 
 development_committee_api_obj database_api_impl::get_development_committee() const
@@ -726,7 +738,7 @@ development_committee_api_obj database_api_impl::get_development_committee() con
 
 std::string database_api::get_transaction_hex(const signed_transaction& trx) const
 {
-    return my->_db.with_read_lock([&]() { return my->get_transaction_hex(trx); });
+    return my->with_read_lock([&]() { return my->get_transaction_hex(trx); });
 }
 
 std::string database_api_impl::get_transaction_hex(const signed_transaction& trx) const
@@ -737,7 +749,7 @@ std::string database_api_impl::get_transaction_hex(const signed_transaction& trx
 std::set<public_key_type> database_api::get_required_signatures(const signed_transaction& trx,
                                                                 const flat_set<public_key_type>& available_keys) const
 {
-    return my->_db.with_read_lock([&]() { return my->get_required_signatures(trx, available_keys); });
+    return my->with_read_lock([&]() { return my->get_required_signatures(trx, available_keys); });
 }
 
 std::set<public_key_type>
@@ -763,7 +775,7 @@ database_api_impl::get_required_signatures(const signed_transaction& trx,
 
 std::set<public_key_type> database_api::get_potential_signatures(const signed_transaction& trx) const
 {
-    return my->_db.with_read_lock([&]() { return my->get_potential_signatures(trx); });
+    return my->with_read_lock([&]() { return my->get_potential_signatures(trx); });
 }
 
 std::set<public_key_type> database_api_impl::get_potential_signatures(const signed_transaction& trx) const
@@ -798,7 +810,7 @@ std::set<public_key_type> database_api_impl::get_potential_signatures(const sign
 
 bool database_api::verify_authority(const signed_transaction& trx) const
 {
-    return my->_db.with_read_lock([&]() { return my->verify_authority(trx); });
+    return my->with_read_lock([&]() { return my->verify_authority(trx); });
 }
 
 bool database_api_impl::verify_authority(const signed_transaction& trx) const
@@ -820,7 +832,7 @@ bool database_api_impl::verify_authority(const signed_transaction& trx) const
 bool database_api::verify_account_authority(const std::string& name_or_id,
                                             const flat_set<public_key_type>& signers) const
 {
-    return my->_db.with_read_lock([&]() { return my->verify_account_authority(name_or_id, signers); });
+    return my->with_read_lock([&]() { return my->verify_account_authority(name_or_id, signers); });
 }
 
 bool database_api_impl::verify_account_authority(const std::string& name, const flat_set<public_key_type>& keys) const
@@ -840,7 +852,7 @@ bool database_api_impl::verify_account_authority(const std::string& name, const
 
 std::vector<vote_state> database_api::get_active_votes(const std::string& author, const std::string& permlink) const
 {
-    return my->_db.with_read_lock([&]() {
+    return my->with_read_lock([&]() {
         std::vector<vote_state> result;
         const auto& comment = my->_db.obtain_service<dbs_comment>().get(author, permlink);
         const auto& idx = my->_db.get_index<comment_vote_index>().indices().get<by_comment_voter>();
@@ -865,7 +877,7 @@ std::vector<vote_state> database_api::get_active_votes(const std::string& author
 
 std::vector<account_vote> database_api::get_account_votes(const std::string& voter) const
 {
-    return my->_db.with_read_lock([&]() {
+    return my->with_read_lock([&]() {
         std::vector<account_vote> result;
 
         const auto& voter_acnt = my->_db.obtain_service<chain::dbs_account>().get_account(voter);
@@ -897,7 +909,7 @@ std::vector<account_vote> database_api::get_account_votes(const std::string& vot
 //////////////////////////////////////////////////////////////////////
 std::vector<budget_api_obj> database_api::get_budgets(const budget_type type, const std::set<std::string>& names) const
 {
-    return my->_db.with_read_lock([&]() {
+    return my->with_read_lock([&]() {
         switch (type)
         {
         case budget_type::post:
@@ -913,7 +925,7 @@ std::vector<budget_api_obj> database_api::get_budgets(const budget_type type, co
 std::set<std::string>
 database_api::lookup_budget_owners(const budget_type type, const std::string& lower_bound_name, uint32_t limit) const
 {
-    return my->_db.with_read_lock([&]() {
+    return my->with_read_lock([&]() {
         switch (type)
         {
         case budget_type::post:
@@ -933,7 +945,7 @@ database_api::lookup_budget_owners(const budget_type type, const std::string& lo
 //////////////////////////////////////////////////////////////////////
 std::vector<atomicswap_contract_api_obj> database_api::get_atomicswap_contracts(const std::string& owner) const
 {
-    return my->_db.with_read_lock([&]() { return my->get_atomicswap_contracts(owner); });
+    return my->with_read_lock([&]() { return my->get_atomicswap_contracts(owner); });
 }
 
 std::vector<atomicswap_contract_api_obj> database_api_impl::get_atomicswap_contracts(const std::string& owner) const
@@ -958,7 +970,7 @@ atomicswap_contract_info_api_obj database_api::get_atomicswap_contract(const std
                                                                        const std::string& to,
                                                                        const std::string& secret_hash) const
 {
-    return my->_db.with_read_lock([&]() { return my->get_atomicswap_contract(from, to, secret_hash); });
+    return my->with_read_lock([&]() { return my->get_atomicswap_contract(from, to, secret_hash); });
 }
 
 atomicswap_contract_info_api_obj database_api_impl::get_atomicswap_contract(const std::string& from,
@@ -980,7 +992,10 @@ atomicswap_contract_info_api_obj database_api_impl::get_atomicswap_contract(cons
 
 std::vector<account_name_type> database_api::get_active_witnesses() const
 {
-    return my->_db.with_read_lock([&]() {
+    if (auto state = my->_head_state.get())
+        return state->active_witnesses;
+
+    return my->with_read_lock([&]() {
         const auto& wso = my->_db.obtain_service<chain::dbs_witness_schedule>().get();
         size_t n = wso.current_shuffled_witnesses.size();
         std::vector<account_name_type> result;
@@ -996,7 +1011,7 @@ database_api::get_scorumpower_delegations(const std::string& account, const std:
 {
     FC_ASSERT(limit <= get_api_config(API_DATABASE).lookup_limit);
 
-    return my->_db.with_read_lock([&]() {
+    return my->with_read_lock([&]() {
         std::vector<scorumpower_delegation_api_obj> result;
         result.reserve(limit);
 
@@ -1017,7 +1032,7 @@ std::vector<scorumpower_delegation_expiration_api_obj> database_api::get_expirin
 {
     FC_ASSERT(limit <= get_api_config(API_DATABASE).lookup_limit);
 
-    return my->_db.with_read_lock([&]() {
+    return my->with_read_lock([&]() {
         std::vector<scorumpower_delegation_expiration_api_obj> result;
         result.reserve(limit);
 
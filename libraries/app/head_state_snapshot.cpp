@@ -0,0 +1,72 @@
+#include <scorum/app/head_state_snapshot.hpp>
+
+#include <scorum/chain/database/database.hpp>
+
+#include <scorum/chain/services/budgets.hpp>
+#include <scorum/chain/services/dynamic_global_property.hpp>
+#include <scorum/chain/services/registration_pool.hpp>
+#include <scorum/chain/services/reward_balancer.hpp>
+#include <scorum/chain/services/reward_funds.hpp>
+#include <scorum/chain/services/witness_schedule.hpp>
+#include <scorum/chain/services/advertising_property.hpp>
+
+#include <scorum/chain/schema/committee.hpp>
+#include <scorum/chain/schema/registration_objects.hpp>
+
+namespace scorum {
+namespace app {
+
+std::shared_ptr<const head_state> head_state_snapshot::get() const
+{
+    return std::atomic_load(&_state);
+}
+
+void head_state_snapshot::update(chain::database& db)
+{
+    auto state = std::make_shared<head_state>();
+
+    state->head_block_num = db.head_block_num();
+    state->chain_id = db.get_chain_id();
+    state->dynamic_global_properties = make_dynamic_global_property_api_obj(db);
+
+    const auto& wso = db.obtain_service<chain::dbs_witness_schedule>().get();
+    state->witness_schedule = wso;
+    state->active_witnesses.assign(wso.current_shuffled_witnesses.begin(), wso.current_shuffled_witnesses.end());
+
+    state->advertising_property = advertising_property_api_obj(db.advertising_property_service().get());
+    state->registration_committee = registration_committee_api_obj(db.get(registration_pool_id_type()));
+    state->development_committee = db.get(dev_committee_id_type());
+
+    std::atomic_store(&_state, std::shared_ptr<const head_state>(std::move(state)));
+}
+
+void head_state_snapshot::reset()
+{
+    std::atomic_store(&_state, std::shared_ptr<const head_state>());
+}
+
+dynamic_global_property_api_obj make_dynamic_global_property_api_obj(chain::database& db)
+{
+    dynamic_global_property_api_obj gpao;
+    gpao = db.obtain_service<chain::dbs_dynamic_global_property>().get();
+
+    if (db.has_index<witness::reserve_ratio_index>())
+    {
+        const auto& r = db.find(witness::reserve_ratio_id_type());
+
+        if (BOOST_LIKELY(r != nullptr))
+        {
+            gpao = *r;
+        }
+    }
+
+    gpao.registration_pool_balance = db.obtain_service<chain::dbs_registration_pool>().get().balance;
+    gpao.fund_budget_balance = db.obtain_service<chain::dbs_fund_budget>().get().balance;
+    gpao.reward_pool_balance = db.obtain_service<chain::dbs_content_reward_scr>().get().balance;
+    gpao.content_reward_scr_balance = db.obtain_service<chain::dbs_content_reward_fund_scr>().get().activity_reward_balance;
+    gpao.content_reward_sp_balance = db.obtain_service<chain::dbs_content_reward_fund_sp>().get().activity_reward_balance;
+
+    return gpao;
+}
+}
+}
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <fc/exception/exception.hpp>
+#include <fc/reflect/reflect.hpp>
+#include <fc/optional.hpp>
+#include <fc/thread/future.hpp>
+#include <fc/thread/thread.hpp>
+#include <fc/time.hpp>
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace scorum {
+namespace utils {
+class thread_pool;
+}
+namespace app {
+
+struct api_thread_pool_stats
+{
+    uint64_t calls = 0;
+    uint32_t queue_depth = 0;
+    uint32_t max_queue_depth = 0;
+    uint64_t total_wait_microseconds = 0;
+    uint64_t total_exec_microseconds = 0;
+    uint64_t max_exec_microseconds = 0;
+};
+
+/**
+ * @brief Executes read-only API calls on worker threads.
+ *
+ * Calls are made from fc tasks serving websocket sessions. The calling task waits for the result on fc::future,
+ * so the fc thread keeps pushing blocks and transactions and serving other sessions meanwhile. The future is
+ * completed by a task queued back to the calling fc thread, not from the worker. With zero threads
+ * calls are executed inline. Calls made from a worker thread (nested API calls) are executed inline as well.
+ *
+ * Only read-only calls must be dispatched here. Calls that modify state or connect to database signals must stay
+ * on the chain thread.
+ */
+class api_thread_pool
+{
+public:
+    api_thread_pool();
+    ~api_thread_pool();
+
+    void start(uint32_t threads_count);
+    void stop();
+
+    uint32_t size() const;
+
+    template <typename Callable> auto run(const std::string& api_name, Callable&& callable) -> decltype(callable())
+    {
+        using result_type = decltype(callable());
+
+        counters& c = get_counters(api_name);
+
+        if (!_pool || is_worker_thread())
+        {
+            c.enqueued();
+            c.started(fc::time_point::now());
+            return execute(c, callable);
+        }
+
+        typename fc::promise<result_type>::ptr promise(new fc::promise<result_type>("api_thread_pool::run"));
+        fc::thread& caller = fc::thread::current();
+
+        auto finished = std::make_shared<std::promise<void>>();
+        std::shared_future<void> finished_future = finished->get_future().share();
+
+        const fc::time_point queued = fc::time_point::now();
+        c.enqueued();
+
+        auto task = [&c, &callable, &caller, promise, finished, queued]() {
+            c.started(queued);
+
+            auto result = std::make_shared<call_result<result_type>>();
+            try
+            {
+                result->value = execute(c, callable);
+            }
+            catch (const fc::exception& e)
+            {
+                result->error = e.dynamic_copy_exception();
+            }
+            catch (const std::exception& e)
+            {
+                result->error = std::make_shared<fc::unhandled_exception>(
+                    FC_LOG_MESSAGE(warn, "${what}", ("what", e.what())), std::current_exception());
+            }
+            catch (...)
+            {
+                result->error = std::make_shared<fc::unhandled_exception>(FC_LOG_MESSAGE(warn, "unknown exception"),
+                                                                          std::current_exception());
+            }
+
+            // promise is completed on the caller's fc thread, tasks are queued to fc thread from any thread
+            try
+            {
+                caller.async(
+                    [promise, result]() {
+                        if (result->error)
+                            promise->set_exception(result->error);
+                        else
+                            promise->set_value(std::move(*result->value));
+                    },
+                    "api_thread_pool::complete");
+            }
+            catch (...)
+            {
+                // caller's thread is quitting, nobody waits for the result
+            }
+
+            finished->set_value();
+        };
+
+        try
+        {
+            post(std::move(task));
+        }
+        catch (...)
+        {
+            c.started(queued);
+            throw;
+        }
+
+        try
+        {
+            return fc::future<result_type>(promise).wait();
+        }
+        catch (...)
+        {
+            // callable refers to caller's frame so it must not outlive it even if waiting task is canceled
+            finished_future.wait();
+            throw;
+        }
+    }
+
+    template <typename Lockable, typename Callable>
+    auto with_read_lock(const std::string& api_name, Lockable& db, Callable&& callable) -> decltype(callable())
+    {
+        return run(api_name, [&]() { return db.with_concurrent_read_lock(std::forward<Callable>(callable)); });
+    }
+
+    std::map<std::string, api_thread_pool_stats> get_stats() const;
+
+private:
+    template <typename T> struct call_result
+    {
+        fc::optional<T> value;
+        fc::exception_ptr error;
+    };
+
+    struct counters
+    {
+        void enqueued();
+        void started(const fc::time_point& queued);
+        void finished(const fc::time_point& started);
+
+        api_thread_pool_stats get() const;
+
+        std::atomic<uint64_t> calls{ 0 };
+        std::atomic<uint32_t> queue_depth{ 0 };
+        std::atomic<uint32_t> max_queue_depth{ 0 };
+        std::atomic<uint64_t> total_wait_microseconds{ 0 };
+        std::atomic<uint64_t> total_exec_microseconds{ 0 };
+        std::atomic<uint64_t> max_exec_microseconds{ 0 };
+    };
+
+    template <typename Callable> static auto execute(counters& c, Callable& callable) -> decltype(callable())
+    {
+        struct finish_guard
+        {
+            ~finish_guard()
+            {
+                c.finished(started);
+            }
+            counters& c;
+            fc::time_point started;
+        } guard{ c, fc::time_point::now() };
+
+        return callable();
+    }
+
+    counters& get_counters(const std::string& api_name);
+
+    void post(std::function<void()> task);
+
+    static bool is_worker_thread();
+
+    mutable std::mutex _counters_mutex;
+    std::map<std::string, std::unique_ptr<counters>> _counters;
+
+    std::unique_ptr<utils::thread_pool> _pool;
+};
+}
+}
+
+FC_REFLECT(scorum::app::api_thread_pool_stats,
+           (calls)(queue_depth)(max_queue_depth)(total_wait_microseconds)(total_exec_microseconds)(max_exec_microseconds))
@@ -84,6 +84,8 @@ class application_impl;
 class abstract_plugin;
 class plugin;
 class application;
+class head_state_snapshot;
+class api_thread_pool;
 
 class network_broadcast_api;
 class login_api;
@@ -138,6 +140,16 @@ public:
 
     graphene::net::node_ptr p2p_node();
     std::shared_ptr<chain::database> chain_database() const;
+
+    /**
+     * State at the last applied block which could be read without database lock.
+     */
+    const head_state_snapshot& head_state() const;
+
+    /**
+     * Worker threads executing read-only API calls.
+     */
+    api_thread_pool& api_pool();
     // std::shared_ptr<graphene::db::object_database> pending_trx_database() const;
 
     void set_block_production(bool producing_blocks);
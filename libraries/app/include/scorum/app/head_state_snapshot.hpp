@@ -0,0 +1,58 @@
+#pragma once
+
+#include <scorum/app/scorum_api_objects.hpp>
+
+#include <memory>
+
+namespace scorum {
+namespace chain {
+class database;
+}
+namespace app {
+
+/**
+ * @brief Immutable copy of frequently requested singleton objects at the last applied block.
+ */
+struct head_state
+{
+    uint32_t head_block_num = 0;
+    chain_id_type chain_id;
+
+    dynamic_global_property_api_obj dynamic_global_properties;
+    witness_schedule_api_obj witness_schedule;
+    std::vector<account_name_type> active_witnesses;
+    advertising_property_api_obj advertising_property;
+    registration_committee_api_obj registration_committee;
+    development_committee_api_obj development_committee;
+};
+
+/**
+ * @brief Copy-on-write snapshot of head state for API readers.
+ *
+ * The snapshot is rebuilt by the writer right after a block is applied, while it still holds
+ * the write lock, and published by atomically swapping a shared pointer. Readers take the pointer
+ * without any lock, so they are never blocked by block application and never delay it. A reader
+ * keeps using the state it took even if a newer one is published meanwhile.
+ */
+class head_state_snapshot
+{
+public:
+    /**
+     * Return last published state or nullptr if no block was applied yet.
+     */
+    std::shared_ptr<const head_state> get() const;
+
+    /**
+     * Build state from database. Caller must hold write (or read) lock.
+     */
+    void update(chain::database& db);
+
+    void reset();
+
+private:
+    std::shared_ptr<const head_state> _state;
+};
+
+dynamic_global_property_api_obj make_dynamic_global_property_api_obj(chain::database& db);
+}
+}
@@ -1,7 +1,25 @@
 #include <scorum/chain/block_log.hpp>
+#include <scorum/chain/compressed_block_log.hpp>
+#include <scorum/utils/thread_pool.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include <fc/io/raw.hpp>
 
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 #define LOG_READ (std::ios::in | std::ios::binary)
 #define LOG_WRITE (std::ios::out | std::ios::binary | std::ios::app)
 
@@ -9,6 +27,342 @@ namespace scorum {
 namespace chain {
 
 namespace detail {
+
+/**
+ * Read only shared mapping of block log and index. Mapping length is reserved ahead of file size,
+ * so appended data becomes visible through the same mapping without remapping.
+ */
+class block_log_mapping
+{
+public:
+    block_log_mapping(const fc::path& block_file,
+                      const fc::path& index_file,
+                      uint64_t blocks_capacity,
+                      uint64_t index_capacity)
+        : blocks_capacity(blocks_capacity)
+        , index_capacity(index_capacity)
+    {
+        blocks = (const char*)map_file(block_file, blocks_capacity);
+        try
+        {
+            index = (const uint64_t*)map_file(index_file, index_capacity);
+        }
+        catch (...)
+        {
+            unmap_file(blocks, blocks_capacity);
+            throw;
+        }
+    }
+
+    ~block_log_mapping()
+    {
+        unmap_file(blocks, blocks_capacity);
+        unmap_file(index, index_capacity);
+    }
+
+    const char* blocks = nullptr;
+    const uint64_t* index = nullptr;
+    const uint64_t blocks_capacity;
+    const uint64_t index_capacity;
+
+private:
+    static const void* map_file(const fc::path& file, uint64_t capacity)
+    {
+#ifndef WIN32
+        int fd = ::open(file.generic_string().c_str(), O_RDONLY);
+        FC_ASSERT(fd != -1, "Could not open ${f} for mapping", ("f", file.generic_string()));
+
+        void* addr = ::mmap(nullptr, capacity, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd); // mapping holds its own reference to file
+
+        FC_ASSERT(addr != MAP_FAILED, "Could not map ${f}", ("f", file.generic_string()));
+        ::madvise(addr, capacity, MADV_RANDOM);
+        return addr;
+#else
+        FC_ASSERT(false, "Memory mapped block log is not supported");
+#endif
+    }
+
+    static void unmap_file(const void* addr, uint64_t capacity)
+    {
+#ifndef WIN32
+        if (addr)
+            ::munmap(const_cast<void*>(addr), capacity);
+#endif
+    }
+};
+
+/**
+ * Lock-free reader of flushed blocks. Writer publishes head via seqlock; mappings are
+ * replaced only when data outgrows reserved length and old ones are kept until close,
+ * so pointers obtained by readers are never invalidated while log is open.
+ *
+ * open and reset are called by writer thread. They unpublish the mapping and wait for reads in progress
+ * before unmapping, views obtained before are invalidated.
+ */
+class block_log_mapped_reader
+{
+public:
+    ~block_log_mapped_reader()
+    {
+        reset();
+    }
+
+    void open(const fc::path& block_file, const fc::path& index_file, uint32_t first_block_num)
+    {
+        reset();
+
+        _block_file = block_file;
+        _index_file = index_file;
+        _first_block_num.store(first_block_num);
+    }
+
+    void reset()
+    {
+        ++_seq;
+        _head_num.store(0);
+        _mapping.store(nullptr);
+        ++_seq;
+
+        // a read either is counted here or has started after the mapping was unpublished
+        while (_readers.load())
+            std::this_thread::yield();
+
+        _mappings.clear();
+    }
+
+    // writer thread only
+    void publish(uint32_t head_num, uint64_t head_end_pos)
+    {
+#ifndef WIN32
+        const uint32_t first_block_num = _first_block_num.load();
+        if (head_num < first_block_num)
+            return;
+
+        const uint64_t index_size = sizeof(uint64_t) * (head_num - first_block_num + 1);
+        const block_log_mapping* current = _mapping.load();
+        if (!current || current->blocks_capacity < head_end_pos || current->index_capacity < index_size)
+        {
+            _mappings.emplace_back(new block_log_mapping(_block_file, _index_file, reserve(head_end_pos),
+                                                         reserve(index_size)));
+            _mapping.store(_mappings.back().get());
+        }
+
+        ++_seq;
+        _head_end_pos.store(head_end_pos);
+        _head_num.store(head_num);
+        ++_seq;
+#endif
+    }
+
+    bool read(uint32_t block_num, serialized_block_view& view) const
+    {
+        reader_guard guard(_readers);
+
+        uint64_t pos = 0;
+        uint64_t end_pos = 0;
+        const block_log_mapping* mapping = nullptr;
+
+        for (;;)
+        {
+            uint32_t seq = _seq.load();
+            if (seq & 1)
+                continue; // writer is publishing
+
+            uint32_t head_num = _head_num.load();
+            uint64_t head_end_pos = _head_end_pos.load();
+            mapping = _mapping.load();
+            const uint32_t first_block_num = _first_block_num.load();
+
+            if (seq != _seq.load())
+                continue;
+
+            if (!mapping || block_num < first_block_num || block_num > head_num)
+                return false;
+
+            pos = mapping->index[block_num - first_block_num];
+            end_pos = (block_num < head_num) ? mapping->index[block_num - first_block_num + 1] : head_end_pos;
+            break;
+        }
+
+        FC_ASSERT(end_pos >= pos + sizeof(uint64_t) && end_pos <= mapping->blocks_capacity,
+                  "Block log index is corrupted.", ("block_num", block_num)("pos", pos)("end", end_pos));
+
+        view.data = mapping->blocks + pos;
+        view.size = end_pos - pos - sizeof(uint64_t);
+        return true;
+    }
+
+    uint64_t get_block_pos(uint32_t block_num) const
+    {
+        reader_guard guard(_readers);
+
+        for (;;)
+        {
+            uint32_t seq = _seq.load();
+            if (seq & 1)
+                continue;
+
+            uint32_t head_num = _head_num.load();
+            const block_log_mapping* mapping = _mapping.load();
+            const uint32_t first_block_num = _first_block_num.load();
+
+            if (seq != _seq.load())
+                continue;
+
+            if (!mapping || block_num < first_block_num || block_num > head_num)
+                return block_log::npos;
+
+            return mapping->index[block_num - first_block_num];
+        }
+    }
+
+private:
+    struct reader_guard
+    {
+        explicit reader_guard(std::atomic<uint32_t>& readers)
+            : readers(readers)
+        {
+            ++readers;
+        }
+
+        ~reader_guard()
+        {
+            --readers;
+        }
+
+        std::atomic<uint32_t>& readers;
+    };
+
+    static uint64_t reserve(uint64_t size)
+    {
+        static const uint64_t min_reserve = 1ull << 30;
+        return std::max(size * 2, min_reserve);
+    }
+
+    fc::path _block_file;
+    fc::path _index_file;
+    std::atomic<uint32_t> _first_block_num{ 1 };
+
+    std::vector<std::unique_ptr<block_log_mapping>> _mappings;
+    std::atomic<const block_log_mapping*> _mapping{ nullptr };
+
+    std::atomic<uint32_t> _seq{ 0 };
+    std::atomic<uint32_t> _head_num{ 0 };
+    std::atomic<uint64_t> _head_end_pos{ 0 };
+
+    mutable std::atomic<uint32_t> _readers{ 0 };
+};
+
+// Every block is followed by its own position, so positions of all blocks can be collected
+// walking from the end of file without deserialization.
+std::vector<uint64_t> walk_block_positions(const char* data, uint64_t size)
+{
+    std::vector<uint64_t> positions;
+
+    uint64_t end_pos = size;
+    while (end_pos > 0)
+    {
+        FC_ASSERT(end_pos >= sizeof(uint64_t), "Block log is corrupted.", ("end", end_pos));
+
+        uint64_t pos = 0;
+        memcpy(&pos, data + end_pos - sizeof(pos), sizeof(pos));
+        FC_ASSERT(pos < end_pos - sizeof(pos), "Block log is corrupted.", ("pos", pos)("end", end_pos));
+
+        positions.push_back(pos);
+        end_pos = pos;
+    }
+
+    std::reverse(positions.begin(), positions.end());
+    return positions;
+}
+
+struct block_range_links
+{
+    block_id_type first_previous;
+    block_id_type last_id;
+};
+
+// Deserializes blocks of range and checks they are linked to each other.
+block_range_links validate_block_range(const char* data,
+                                       uint64_t size,
+                                       const std::vector<uint64_t>& positions,
+                                       size_t first,
+                                       size_t last)
+{
+    block_range_links links;
+
+    signed_block b;
+    for (size_t ci = first; ci < last; ++ci)
+    {
+        uint64_t end_pos = (ci + 1 < positions.size()) ? positions[ci + 1] : size;
+
+        fc::datastream<const char*> ds(data + positions[ci], end_pos - sizeof(uint64_t) - positions[ci]);
+        fc::raw::unpack(ds, b);
+        FC_ASSERT(ds.remaining() == 0, "Block log is corrupted.", ("pos", positions[ci]));
+
+        if (ci == first)
+            links.first_previous = b.previous;
+        else
+            FC_ASSERT(b.previous == links.last_id, "Block log is corrupted.", ("block_num", b.block_num()));
+
+        links.last_id = b.id();
+    }
+
+    return links;
+}
+
+// Validates ranges of blocks concurrently and then checks links between ranges.
+void validate_block_positions(const char* data,
+                              uint64_t size,
+                              const std::vector<uint64_t>& positions,
+                              uint32_t threads_count)
+{
+    if (!threads_count)
+        threads_count = std::max(std::thread::hardware_concurrency(), 1u);
+
+    const size_t segments_count = std::min<size_t>(threads_count * 4, positions.size());
+    if (!segments_count)
+        return;
+
+    const size_t segment_size = (positions.size() + segments_count - 1) / segments_count;
+
+    utils::thread_pool pool(threads_count);
+
+    std::vector<std::future<block_range_links>> results;
+    for (size_t first = 0; first < positions.size(); first += segment_size)
+    {
+        size_t last = std::min(first + segment_size, positions.size());
+        results.push_back(
+            pool.async([=, &positions]() { return validate_block_range(data, size, positions, first, last); }));
+    }
+
+    // wait for all ranges before rethrowing as tasks reference data
+    std::vector<block_range_links> links;
+    std::exception_ptr error;
+    for (auto& result : results)
+    {
+        try
+        {
+            links.push_back(result.get());
+        }
+        catch (...)
+        {
+            if (!error)
+                error = std::current_exception();
+        }
+    }
+
+    if (error)
+        std::rethrow_exception(error);
+
+    for (size_t ci = 1; ci < links.size(); ++ci)
+    {
+        FC_ASSERT(links[ci].first_previous == links[ci - 1].last_id, "Block log is corrupted.",
+                  ("segment", ci));
+    }
+}
+
 class block_log_impl
 {
 public:
@@ -20,6 +374,55 @@ public:
     fc::path index_file;
     bool block_write;
     bool index_write;
+    uint64_t head_end_pos = 0;
+
+    block_log_mapped_reader mapped_reader;
+
+    // blocks below first_block_num are stored in compressed archive only
+    compressed_block_log archive;
+    uint32_t first_block_num = 1;
+
+    index_rebuild_mode rebuild_mode = index_rebuild_mode::backward;
+    uint32_t rebuild_threads = 0;
+
+    // Streams are shared by appending and by reading of blocks which are not flushed to mapping yet, they are
+    // reopened on every switch between reading and writing, so any access to them is serialized. Methods of impl
+    // expect the mutex to be locked by caller.
+    std::mutex stream_mutex;
+
+    std::pair<signed_block, uint64_t> read_block(uint64_t pos)
+    {
+        check_block_read();
+
+        block_stream.seekg(pos);
+        std::pair<signed_block, uint64_t> result;
+        fc::raw::unpack(block_stream, result.first);
+        result.second = uint64_t(block_stream.tellg()) + 8;
+        return result;
+    }
+
+    uint64_t read_block_pos(uint32_t block_num)
+    {
+        check_index_read();
+
+        if (!(head.valid() && block_num <= protocol::block_header::num_from_id(head_id)
+              && block_num >= first_block_num))
+            return block_log::npos;
+        index_stream.seekg(sizeof(uint64_t) * (block_num - first_block_num));
+        uint64_t pos;
+        index_stream.read((char*)&pos, sizeof(pos));
+        return pos;
+    }
+
+    signed_block read_head()
+    {
+        check_block_read();
+
+        uint64_t pos;
+        block_stream.seekg(-sizeof(pos), std::ios::end);
+        block_stream.read((char*)&pos, sizeof(pos));
+        return read_block(pos).first;
+    }
 
     inline void check_block_read()
     {
@@ -93,6 +496,8 @@ block_log::~block_log()
 
 void block_log::open(const fc::path& file)
 {
+    std::lock_guard<std::mutex> lock(my->stream_mutex);
+
     if (my->block_stream.is_open())
         my->block_stream.close();
     if (my->index_stream.is_open())
@@ -101,6 +506,15 @@ void block_log::open(const fc::path& file)
     my->block_file = file;
     my->index_file = block_log_index_path(file);
 
+    auto archive_file = compressed_block_log::compressed_block_log_path(file);
+    my->archive.close();
+    if (fc::exists(archive_file))
+    {
+        ilog("Opening compressed block log ${f}", ("f", archive_file.generic_string()));
+        my->archive.open(archive_file);
+    }
+    my->first_block_num = my->archive.head_block_num() + 1;
+
     my->block_stream.open(my->block_file.generic_string().c_str(), LOG_WRITE);
     my->index_stream.open(my->index_file.generic_string().c_str(), LOG_WRITE);
     my->block_write = true;
@@ -130,9 +544,14 @@ void block_log::open(const fc::path& file)
     if (log_size)
     {
         ilog("Log is nonempty");
-        my->head = read_head();
+        my->head = my->read_head();
         my->head_id = my->head->id();
 
+        my->first_block_num = my->read_block(0).first.block_num();
+        FC_ASSERT(my->first_block_num <= my->archive.head_block_num() + 1,
+                  "Block log does not continue compressed block log.",
+                  ("first", my->first_block_num)("archive_head", my->archive.head_block_num()));
+
         if (index_size)
         {
             my->check_block_read();
@@ -172,10 +591,27 @@ void block_log::open(const fc::path& file)
         my->index_stream.open(my->index_file.generic_string().c_str(), LOG_WRITE);
         my->index_write = true;
     }
+
+    my->mapped_reader.open(my->block_file, my->index_file, my->first_block_num);
+    if (my->head.valid())
+    {
+        my->index_stream.flush();
+        my->head_end_pos = fc::file_size(my->block_file);
+        my->mapped_reader.publish(my->head->block_num(), my->head_end_pos);
+    }
+    else if (my->archive.head().valid())
+    {
+        my->head = my->archive.head();
+        my->head_id = my->head->id();
+    }
 }
 
 void block_log::close()
 {
+    {
+        std::lock_guard<std::mutex> lock(my->stream_mutex);
+        my->mapped_reader.reset();
+    }
     my.reset(new detail::block_log_impl());
 }
 
@@ -193,21 +629,24 @@ uint64_t block_log::append(const signed_block& b)
 {
     try
     {
+        std::lock_guard<std::mutex> lock(my->stream_mutex);
+
         my->check_block_write();
         my->check_index_write();
 
         uint64_t pos = my->block_stream.tellp();
         FC_ASSERT((uint64_t)my->index_stream.tellp()
-                      == (std::fstream::streampos)sizeof(uint64_t) * ((uint64_t)b.block_num() - 1),
+                      == (std::fstream::streampos)sizeof(uint64_t) * ((uint64_t)b.block_num() - my->first_block_num),
                   "Append to index file occuring at wrong position.",
-                  ("position", (uint64_t)my->index_stream.tellp())("expected",
-                                                                   ((uint64_t)b.block_num() - 1) * sizeof(uint64_t)));
+                  ("position", (uint64_t)my->index_stream.tellp())(
+                      "expected", ((uint64_t)b.block_num() - my->first_block_num) * sizeof(uint64_t)));
         auto data = fc::raw::pack(b);
         my->block_stream.write(data.data(), data.size());
         my->block_stream.write((char*)&pos, sizeof(pos));
         my->index_stream.write((char*)&pos, sizeof(pos));
         my->head = b;
         my->head_id = b.id();
+        my->head_end_pos = pos + data.size() + sizeof(pos);
 
         return pos;
     }
@@ -216,21 +655,22 @@ uint64_t block_log::append(const signed_block& b)
 
 void block_log::flush()
 {
+    std::lock_guard<std::mutex> lock(my->stream_mutex);
+
     my->block_stream.flush();
     my->index_stream.flush();
+
+    if (my->head.valid())
+        my->mapped_reader.publish(my->head->block_num(), my->head_end_pos);
 }
 
 std::pair<signed_block, uint64_t> block_log::read_block(uint64_t pos) const
 {
     try
     {
-        my->check_block_read();
+        std::lock_guard<std::mutex> lock(my->stream_mutex);
 
-        my->block_stream.seekg(pos);
-        std::pair<signed_block, uint64_t> result;
-        fc::raw::unpack(my->block_stream, result.first);
-        result.second = uint64_t(my->block_stream.tellg()) + 8;
-        return result;
+        return my->read_block(pos);
     }
     FC_LOG_AND_RETHROW()
 }
@@ -239,11 +679,29 @@ optional<signed_block> block_log::read_block_by_num(uint32_t block_num) const
 {
     try
     {
+        if (block_num < my->first_block_num)
+            return my->archive.read_block_by_num(block_num);
+
         optional<signed_block> b;
-        uint64_t pos = get_block_pos(block_num);
+
+        serialized_block_view view;
+        if (my->mapped_reader.read(block_num, view))
+        {
+            b = signed_block();
+            fc::datastream<const char*> ds(view.data, view.size);
+            fc::raw::unpack(ds, *b);
+            FC_ASSERT(b->block_num() == block_num, "Wrong block was read from block log.",
+                      ("returned", b->block_num())("expected", block_num));
+            return b;
+        }
+
+        // block is appended but not flushed yet
+        std::lock_guard<std::mutex> lock(my->stream_mutex);
+
+        uint64_t pos = my->read_block_pos(block_num);
         if (pos != npos)
         {
-            b = read_block(pos).first;
+            b = my->read_block(pos).first;
             FC_ASSERT(b->block_num() == block_num, "Wrong block was read from block log.",
                       ("returned", b->block_num())("expected", block_num));
         }
@@ -252,18 +710,53 @@ optional<signed_block> block_log::read_block_by_num(uint32_t block_num) const
     FC_LOG_AND_RETHROW()
 }
 
+optional<serialized_block_view> block_log::read_serialized_block_by_num(uint32_t block_num) const
+{
+    optional<serialized_block_view> result;
+
+    serialized_block_view view;
+    if (my->mapped_reader.read(block_num, view))
+        result = view;
+
+    return result;
+}
+
+optional<std::vector<char>> block_log::read_packed_block_by_num(uint32_t block_num) const
+{
+    try
+    {
+        if (block_num < my->first_block_num)
+            return my->archive.read_packed_block_by_num(block_num);
+
+        optional<std::vector<char>> result;
+
+        serialized_block_view view;
+        if (my->mapped_reader.read(block_num, view))
+        {
+            result = std::vector<char>(view.data, view.data + view.size);
+        }
+        else
+        {
+            auto b = read_block_by_num(block_num);
+            if (b.valid())
+                result = fc::raw::pack(*b);
+        }
+        return result;
+    }
+    FC_LOG_AND_RETHROW()
+}
+
 uint64_t block_log::get_block_pos(uint32_t block_num) const
 {
     try
     {
-        my->check_index_read();
+        uint64_t mapped_pos = my->mapped_reader.get_block_pos(block_num);
+        if (mapped_pos != npos)
+            return mapped_pos;
 
-        if (!(my->head.valid() && block_num <= protocol::block_header::num_from_id(my->head_id) && block_num > 0))
-            return npos;
-        my->index_stream.seekg(sizeof(uint64_t) * (block_num - 1));
-        uint64_t pos;
-        my->index_stream.read((char*)&pos, sizeof(pos));
-        return pos;
+        std::lock_guard<std::mutex> lock(my->stream_mutex);
+
+        return my->read_block_pos(block_num);
     }
     FC_LOG_AND_RETHROW()
 }
@@ -272,12 +765,9 @@ signed_block block_log::read_head() const
 {
     try
     {
-        my->check_block_read();
+        std::lock_guard<std::mutex> lock(my->stream_mutex);
 
-        uint64_t pos;
-        my->block_stream.seekg(-sizeof(pos), std::ios::end);
-        my->block_stream.read((char*)&pos, sizeof(pos));
-        return read_block(pos).first;
+        return my->read_head();
     }
     FC_LOG_AND_RETHROW()
 }
@@ -287,32 +777,80 @@ const optional<signed_block>& block_log::head() const
     return my->head;
 }
 
+void block_log::set_index_rebuild_mode(index_rebuild_mode mode, uint32_t threads_count)
+{
+    my->rebuild_mode = mode;
+    my->rebuild_threads = threads_count;
+}
+
 void block_log::construct_index()
 {
     try
     {
         ilog("Reconstructing Block Log Index...");
         my->index_stream.close();
-        fc::remove_all(my->index_file);
+
+        auto start = fc::time_point::now();
+        auto blocks_count = rebuild_index(my->block_file, my->rebuild_mode, my->rebuild_threads);
+        ilog("Block Log Index of ${n} blocks is reconstructed in ${t} ms",
+             ("n", blocks_count)("t", (fc::time_point::now() - start).count() / 1000));
+
         my->index_stream.open(my->index_file.generic_string().c_str(), LOG_WRITE);
         my->index_write = true;
+    }
+    FC_LOG_AND_RETHROW()
+}
 
-        uint64_t pos = 0;
-        uint64_t end_pos;
-        my->check_block_read();
+uint32_t block_log::rebuild_index(const fc::path& block_log_file, index_rebuild_mode mode, uint32_t threads_count)
+{
+    try
+    {
+        std::vector<uint64_t> positions;
+        const uint64_t log_size = fc::file_size(block_log_file);
 
-        my->block_stream.seekg(-sizeof(uint64_t), std::ios::end);
-        my->block_stream.read((char*)&end_pos, sizeof(end_pos));
-        signed_block tmp;
+        if (mode == index_rebuild_mode::unpack)
+        {
+            std::ifstream block_stream(block_log_file.generic_string().c_str(), LOG_READ);
+            block_stream.exceptions(std::fstream::failbit | std::fstream::badbit);
 
-        my->block_stream.seekg(pos);
+            uint64_t pos = 0;
+            uint64_t end_pos = 0;
+            if (log_size)
+            {
+                block_stream.seekg(-sizeof(uint64_t), std::ios::end);
+                block_stream.read((char*)&end_pos, sizeof(end_pos));
+                block_stream.seekg(0);
+            }
 
-        while (pos < end_pos)
+            signed_block tmp;
+            while (log_size && pos < end_pos)
+            {
+                fc::raw::unpack(block_stream, tmp);
+                block_stream.read((char*)&pos, sizeof(pos));
+                positions.push_back(pos);
+            }
+        }
+        else if (log_size)
         {
-            fc::raw::unpack(my->block_stream, tmp);
-            my->block_stream.read((char*)&pos, sizeof(pos));
-            my->index_stream.write((char*)&pos, sizeof(pos));
+            using namespace boost::interprocess;
+
+            file_mapping file(block_log_file.generic_string().c_str(), read_only);
+            mapped_region region(file, read_only);
+            region.advise(mapped_region::advice_willneed);
+
+            const char* data = (const char*)region.get_address();
+            positions = detail::walk_block_positions(data, log_size);
+
+            if (mode == index_rebuild_mode::parallel)
+                detail::validate_block_positions(data, log_size, positions, threads_count);
         }
+
+        std::ofstream index_stream(block_log_index_path(block_log_file).generic_string().c_str(),
+                                   std::ios::out | std::ios::binary | std::ios::trunc);
+        index_stream.exceptions(std::fstream::failbit | std::fstream::badbit);
+        index_stream.write((const char*)positions.data(), sizeof(uint64_t) * positions.size());
+
+        return positions.size();
     }
     FC_LOG_AND_RETHROW()
 }
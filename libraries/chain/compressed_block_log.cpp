@@ -0,0 +1,433 @@
+#include <scorum/chain/compressed_block_log.hpp>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <fc/io/raw.hpp>
+
+#include <zlib.h>
+
+#define LOG_READ (std::ios::in | std::ios::binary)
+#define LOG_CREATE (std::ios::out | std::ios::binary | std::ios::trunc)
+
+namespace scorum {
+namespace chain {
+
+namespace {
+
+const uint64_t compressed_block_log_magic = 0x31474f4c4b4c4253; // "SBLKLOG1"
+
+struct chunk_header
+{
+    uint32_t block_count = 0;
+    uint32_t raw_size = 0;
+    uint32_t compressed_size = 0;
+};
+
+std::vector<char> zlib_deflate(const std::vector<char>& raw, int level, const std::vector<char>& dictionary)
+{
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+
+    FC_ASSERT(deflateInit(&zs, level) == Z_OK, "Could not initialize zlib compressor.", ("level", level));
+
+    if (!dictionary.empty())
+        deflateSetDictionary(&zs, (const Bytef*)dictionary.data(), (uInt)dictionary.size());
+
+    std::vector<char> compressed(deflateBound(&zs, (uLong)raw.size()));
+
+    zs.next_in = (Bytef*)raw.data();
+    zs.avail_in = (uInt)raw.size();
+    zs.next_out = (Bytef*)compressed.data();
+    zs.avail_out = (uInt)compressed.size();
+
+    int rc = deflate(&zs, Z_FINISH);
+    compressed.resize(zs.total_out);
+    deflateEnd(&zs);
+
+    FC_ASSERT(rc == Z_STREAM_END, "Could not compress chunk.", ("rc", rc));
+
+    return compressed;
+}
+
+void zlib_inflate(const std::vector<char>& compressed, const std::vector<char>& dictionary, std::vector<char>& raw)
+{
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+
+    FC_ASSERT(inflateInit(&zs) == Z_OK, "Could not initialize zlib decompressor.");
+
+    zs.next_in = (Bytef*)compressed.data();
+    zs.avail_in = (uInt)compressed.size();
+    zs.next_out = (Bytef*)raw.data();
+    zs.avail_out = (uInt)raw.size();
+
+    int rc = inflate(&zs, Z_FINISH);
+    if (rc == Z_NEED_DICT && !dictionary.empty())
+    {
+        inflateSetDictionary(&zs, (const Bytef*)dictionary.data(), (uInt)dictionary.size());
+        rc = inflate(&zs, Z_FINISH);
+    }
+    uint64_t total_out = zs.total_out;
+    inflateEnd(&zs);
+
+    FC_ASSERT(rc == Z_STREAM_END && total_out == raw.size(), "Compressed block log chunk is corrupted.",
+              ("rc", rc)("size", total_out)("expected", raw.size()));
+}
+}
+
+namespace detail {
+class compressed_block_log_impl
+{
+public:
+    std::fstream block_stream;
+    std::fstream index_stream;
+    fc::path block_file;
+    fc::path index_file;
+    bool writable = false;
+
+    uint32_t blocks_per_chunk = 0;
+    int compression_level = Z_DEFAULT_COMPRESSION;
+    std::vector<char> dictionary;
+
+    uint32_t head_num = 0;
+    optional<signed_block> head;
+
+    // blocks of chunk that is not written yet
+    std::vector<std::vector<char>> pending;
+
+    // last decompressed chunk, so sequential reads decompress every chunk only once
+    std::mutex cache_mutex;
+    uint64_t cached_chunk = std::numeric_limits<uint64_t>::max();
+    uint32_t cached_block_count = 0;
+    std::vector<char> cached_raw;
+
+    void write_header()
+    {
+        block_stream.write((const char*)&compressed_block_log_magic, sizeof(compressed_block_log_magic));
+        block_stream.write((const char*)&blocks_per_chunk, sizeof(blocks_per_chunk));
+
+        uint32_t dictionary_size = dictionary.size();
+        block_stream.write((const char*)&dictionary_size, sizeof(dictionary_size));
+        block_stream.write(dictionary.data(), dictionary.size());
+    }
+
+    void read_header()
+    {
+        uint64_t magic = 0;
+        block_stream.read((char*)&magic, sizeof(magic));
+        FC_ASSERT(magic == compressed_block_log_magic, "Unknown compressed block log format.",
+                  ("file", block_file.generic_string()));
+
+        block_stream.read((char*)&blocks_per_chunk, sizeof(blocks_per_chunk));
+        FC_ASSERT(blocks_per_chunk > 0, "Compressed block log header is corrupted.");
+
+        uint32_t dictionary_size = 0;
+        block_stream.read((char*)&dictionary_size, sizeof(dictionary_size));
+        FC_ASSERT(dictionary_size <= compressed_block_log::max_dictionary_size,
+                  "Compressed block log header is corrupted.");
+
+        dictionary.resize(dictionary_size);
+        block_stream.read(dictionary.data(), dictionary.size());
+    }
+
+    void write_chunk()
+    {
+        const uint32_t block_count = pending.size();
+
+        std::vector<char> raw(sizeof(uint32_t) * block_count);
+        uint32_t end_offset = 0;
+        for (uint32_t ci = 0; ci < block_count; ++ci)
+        {
+            end_offset += pending[ci].size();
+            memcpy(raw.data() + sizeof(uint32_t) * ci, &end_offset, sizeof(end_offset));
+        }
+        raw.reserve(raw.size() + end_offset);
+        for (const auto& data : pending)
+            raw.insert(raw.end(), data.begin(), data.end());
+
+        auto compressed = zlib_deflate(raw, compression_level, dictionary);
+
+        chunk_header header;
+        header.block_count = block_count;
+        header.raw_size = raw.size();
+        header.compressed_size = compressed.size();
+
+        uint64_t pos = block_stream.tellp();
+        block_stream.write((const char*)&header, sizeof(header));
+        block_stream.write(compressed.data(), compressed.size());
+        index_stream.write((const char*)&pos, sizeof(pos));
+
+        pending.clear();
+    }
+
+    // cache_mutex must be locked
+    void load_chunk(uint64_t chunk_num)
+    {
+        if (cached_chunk == chunk_num)
+            return;
+
+        uint64_t pos = 0;
+        index_stream.seekg(sizeof(pos) * chunk_num);
+        index_stream.read((char*)&pos, sizeof(pos));
+
+        chunk_header header;
+        block_stream.seekg(pos);
+        block_stream.read((char*)&header, sizeof(header));
+        FC_ASSERT(header.block_count > 0 && header.block_count <= blocks_per_chunk
+                      && header.raw_size >= sizeof(uint32_t) * header.block_count,
+                  "Compressed block log chunk header is corrupted.", ("chunk", chunk_num));
+
+        std::vector<char> compressed(header.compressed_size);
+        block_stream.read(compressed.data(), compressed.size());
+
+        cached_chunk = std::numeric_limits<uint64_t>::max();
+        cached_raw.resize(header.raw_size);
+        zlib_inflate(compressed, dictionary, cached_raw);
+
+        cached_chunk = chunk_num;
+        cached_block_count = header.block_count;
+    }
+
+    // cache_mutex must be locked
+    std::pair<const char*, size_t> find_block(uint32_t block_num)
+    {
+        load_chunk((block_num - 1) / blocks_per_chunk);
+
+        uint32_t block_idx = (block_num - 1) % blocks_per_chunk;
+        FC_ASSERT(block_idx < cached_block_count, "Block is missing in compressed block log chunk.",
+                  ("block_num", block_num));
+
+        const char* offsets = cached_raw.data();
+        const size_t blocks_begin = sizeof(uint32_t) * cached_block_count;
+
+        uint32_t begin = 0;
+        uint32_t end = 0;
+        if (block_idx > 0)
+            memcpy(&begin, offsets + sizeof(uint32_t) * (block_idx - 1), sizeof(begin));
+        memcpy(&end, offsets + sizeof(uint32_t) * block_idx, sizeof(end));
+
+        FC_ASSERT(begin <= end && blocks_begin + end <= cached_raw.size(),
+                  "Compressed block log chunk is corrupted.", ("block_num", block_num));
+
+        return std::make_pair(cached_raw.data() + blocks_begin + begin, size_t(end - begin));
+    }
+};
+}
+
+compressed_block_log::compressed_block_log()
+    : my(new detail::compressed_block_log_impl())
+{
+}
+
+compressed_block_log::~compressed_block_log()
+{
+    try
+    {
+        close();
+    }
+    FC_CAPTURE_AND_LOG(())
+}
+
+void compressed_block_log::open(const fc::path& file)
+{
+    try
+    {
+        close();
+
+        my->block_file = file;
+        my->index_file = compressed_block_log_index_path(file);
+
+        my->block_stream.exceptions(std::fstream::failbit | std::fstream::badbit);
+        my->index_stream.exceptions(std::fstream::failbit | std::fstream::badbit);
+        my->block_stream.open(my->block_file.generic_string().c_str(), LOG_READ);
+        my->index_stream.open(my->index_file.generic_string().c_str(), LOG_READ);
+
+        my->read_header();
+
+        const uint64_t log_size = fc::file_size(my->block_file);
+        const uint64_t index_size = fc::file_size(my->index_file);
+        FC_ASSERT(index_size % sizeof(uint64_t) == 0, "Compressed block log index is corrupted.");
+
+        const uint64_t chunks_count = index_size / sizeof(uint64_t);
+        if (chunks_count)
+        {
+            uint64_t last_pos = 0;
+            my->index_stream.seekg(-sizeof(last_pos), std::ios::end);
+            my->index_stream.read((char*)&last_pos, sizeof(last_pos));
+            FC_ASSERT(last_pos + sizeof(chunk_header) <= log_size, "Compressed block log index is corrupted.",
+                      ("pos", last_pos)("size", log_size));
+
+            std::lock_guard<std::mutex> lock(my->cache_mutex);
+
+            my->load_chunk(chunks_count - 1);
+            my->head_num = (chunks_count - 1) * my->blocks_per_chunk + my->cached_block_count;
+
+            auto data = my->find_block(my->head_num);
+            signed_block b;
+            fc::datastream<const char*> ds(data.first, data.second);
+            fc::raw::unpack(ds, b);
+            FC_ASSERT(b.block_num() == my->head_num, "Compressed block log head is corrupted.",
+                      ("returned", b.block_num())("expected", my->head_num));
+            my->head = b;
+        }
+    }
+    FC_LOG_AND_RETHROW()
+}
+
+void compressed_block_log::create(const fc::path& file,
+                                  uint32_t blocks_per_chunk,
+                                  int compression_level,
+                                  const std::vector<char>& dictionary)
+{
+    try
+    {
+        FC_ASSERT(blocks_per_chunk > 0, "Chunk must contain at least one block.");
+        FC_ASSERT(dictionary.size() <= max_dictionary_size, "Dictionary is too large.",
+                  ("size", dictionary.size())("max", max_dictionary_size));
+
+        close();
+
+        my->block_file = file;
+        my->index_file = compressed_block_log_index_path(file);
+        my->blocks_per_chunk = blocks_per_chunk;
+        my->compression_level = compression_level;
+        my->dictionary = dictionary;
+
+        my->block_stream.exceptions(std::fstream::failbit | std::fstream::badbit);
+        my->index_stream.exceptions(std::fstream::failbit | std::fstream::badbit);
+        my->block_stream.open(my->block_file.generic_string().c_str(), LOG_CREATE);
+        my->index_stream.open(my->index_file.generic_string().c_str(), LOG_CREATE);
+        my->writable = true;
+
+        my->write_header();
+    }
+    FC_LOG_AND_RETHROW()
+}
+
+void compressed_block_log::close()
+{
+    if (my->writable)
+    {
+        if (!my->pending.empty())
+            my->write_chunk();
+
+        my->block_stream.flush();
+        my->index_stream.flush();
+    }
+
+    my.reset(new detail::compressed_block_log_impl());
+}
+
+bool compressed_block_log::is_open() const
+{
+    return my->block_stream.is_open();
+}
+
+fc::path compressed_block_log::compressed_block_log_path(const fc::path& block_log_file)
+{
+    return fc::path(block_log_file.generic_string() + ".chunks");
+}
+
+fc::path compressed_block_log::compressed_block_log_index_path(const fc::path& file)
+{
+    return fc::path(file.generic_string() + ".index");
+}
+
+std::vector<char> compressed_block_log::build_dictionary(const std::vector<std::vector<char>>& samples,
+                                                         size_t max_size)
+{
+    max_size = std::min(max_size, max_dictionary_size);
+
+    std::vector<char> dictionary;
+    dictionary.reserve(max_size);
+
+    // take samples from the end as zlib prefers the most recent dictionary data
+    auto first = samples.rbegin();
+    size_t total = 0;
+    for (; first != samples.rend() && total + first->size() <= max_size; ++first)
+        total += first->size();
+
+    if (first != samples.rend() && total < max_size)
+    {
+        // tail of the sample that does not fit entirely
+        dictionary.insert(dictionary.end(), first->end() - (max_size - total), first->end());
+    }
+
+    for (auto itr = first.base(); itr != samples.end(); ++itr)
+        dictionary.insert(dictionary.end(), itr->begin(), itr->end());
+
+    return dictionary;
+}
+
+void compressed_block_log::append(const signed_block& b)
+{
+    try
+    {
+        FC_ASSERT(my->writable, "Compressed block log is not opened for writing.");
+        FC_ASSERT(b.block_num() == my->head_num + 1, "Blocks must be appended in order.",
+                  ("block_num", b.block_num())("expected", my->head_num + 1));
+
+        my->pending.push_back(fc::raw::pack(b));
+        my->head = b;
+        my->head_num = b.block_num();
+
+        if (my->pending.size() == my->blocks_per_chunk)
+            my->write_chunk();
+    }
+    FC_LOG_AND_RETHROW()
+}
+
+optional<signed_block> compressed_block_log::read_block_by_num(uint32_t block_num) const
+{
+    try
+    {
+        optional<signed_block> b;
+        if (!my->writable && block_num > 0 && block_num <= my->head_num)
+        {
+            std::lock_guard<std::mutex> lock(my->cache_mutex);
+
+            auto data = my->find_block(block_num);
+            b = signed_block();
+            fc::datastream<const char*> ds(data.first, data.second);
+            fc::raw::unpack(ds, *b);
+            FC_ASSERT(b->block_num() == block_num, "Wrong block was read from compressed block log.",
+                      ("returned", b->block_num())("expected", block_num));
+        }
+        return b;
+    }
+    FC_LOG_AND_RETHROW()
+}
+
+optional<std::vector<char>> compressed_block_log::read_packed_block_by_num(uint32_t block_num) const
+{
+    try
+    {
+        optional<std::vector<char>> result;
+        if (!my->writable && block_num > 0 && block_num <= my->head_num)
+        {
+            std::lock_guard<std::mutex> lock(my->cache_mutex);
+
+            auto data = my->find_block(block_num);
+            result = std::vector<char>(data.first, data.first + data.second);
+        }
+        return result;
+    }
+    FC_LOG_AND_RETHROW()
+}
+
+uint32_t compressed_block_log::head_block_num() const
+{
+    return my->head_num;
+}
+
+const optional<signed_block>& compressed_block_log::head() const
+{
+    return my->head;
+}
+
+uint32_t compressed_block_log::blocks_per_chunk() const
+{
+    return my->blocks_per_chunk;
+}
+}
+} // scorum::chain
@@ -0,0 +1,161 @@
+#include <scorum/chain/database/block_replay_pipeline.hpp>
+#include <scorum/chain/block_log.hpp>
+
+#include <scorum/utils/thread_pool.hpp>
+
+#include <fc/io/raw.hpp>
+
+namespace scorum {
+namespace chain {
+
+block_replay_pipeline::block_replay_pipeline(const block_log& log,
+                                             uint32_t last_block_num,
+                                             uint32_t threads_count,
+                                             uint32_t queue_capacity)
+    : _block_log(log)
+    , _last_block_num(last_block_num)
+    , _threads_count(std::max(threads_count, 1u))
+    , _queue_capacity(queue_capacity ? queue_capacity : _threads_count * 256)
+{
+}
+
+block_replay_pipeline::~block_replay_pipeline()
+{
+    stop();
+}
+
+uint32_t block_replay_pipeline::threads_count() const
+{
+    return _threads_count;
+}
+
+uint32_t block_replay_pipeline::queue_capacity() const
+{
+    return _queue_capacity;
+}
+
+void block_replay_pipeline::start()
+{
+    FC_ASSERT(!_pool, "Replay pipeline is already started.");
+
+    _pool.reset(new utils::thread_pool(_threads_count));
+    _reader = std::thread([this]() { read_loop(); });
+}
+
+void block_replay_pipeline::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopped = true;
+    }
+    _capacity_cv.notify_all();
+    _ready_cv.notify_all();
+
+    if (_reader.joinable())
+        _reader.join();
+
+    if (_pool)
+        _pool->stop();
+}
+
+bool block_replay_pipeline::next(prefetched_block& result)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    if (_next_block_num > _last_block_num)
+        return false;
+
+    _ready_cv.wait(lock, [this]() { return _error || _stopped || _ready.count(_next_block_num); });
+
+    if (_error)
+        std::rethrow_exception(_error);
+
+    auto itr = _ready.find(_next_block_num);
+    if (itr == _ready.end())
+        return false; // stopped
+
+    result = std::move(itr->second);
+    _ready.erase(itr);
+
+    ++_next_block_num;
+    --_in_flight;
+
+    lock.unlock();
+    _capacity_cv.notify_one();
+
+    return true;
+}
+
+void block_replay_pipeline::read_loop()
+{
+    try
+    {
+        for (uint32_t block_num = 1; block_num <= _last_block_num; ++block_num)
+        {
+            auto packed = _block_log.read_packed_block_by_num(block_num);
+            FC_ASSERT(packed.valid(), "Block is missing in block log.", ("block_num", block_num));
+
+            auto data = std::make_shared<std::vector<char>>(std::move(*packed));
+
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _capacity_cv.wait(lock, [this]() { return _stopped || _in_flight < _queue_capacity; });
+                if (_stopped)
+                    return;
+                ++_in_flight;
+            }
+
+            _pool->post([this, block_num, data]() { prepare(block_num, data); });
+        }
+    }
+    catch (...)
+    {
+        set_error(std::current_exception());
+    }
+}
+
+void block_replay_pipeline::prepare(uint32_t block_num, std::shared_ptr<std::vector<char>> data)
+{
+    try
+    {
+        prefetched_block item;
+
+        fc::datastream<const char*> ds(data->data(), data->size());
+        fc::raw::unpack(ds, item.block);
+        data.reset();
+
+        FC_ASSERT(item.block.block_num() == block_num, "Wrong block was read from block log.",
+                  ("returned", item.block.block_num())("expected", block_num));
+
+        item.id = item.block.id();
+        item.merkle_root = item.block.calculate_merkle_root();
+        item.trx_ids.reserve(item.block.transactions.size());
+        for (const auto& trx : item.block.transactions)
+        {
+            item.trx_ids.push_back(trx.id());
+            item.operations_count += trx.operations.size();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _ready.emplace(block_num, std::move(item));
+        }
+        _ready_cv.notify_one();
+    }
+    catch (...)
+    {
+        set_error(std::current_exception());
+    }
+}
+
+void block_replay_pipeline::set_error(std::exception_ptr error)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_error)
+            _error = error;
+    }
+    _ready_cv.notify_all();
+}
+}
+}
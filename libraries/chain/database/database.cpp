@@ -1,7 +1,9 @@
+#include <algorithm>
 #include <cstdint>
 #include <deque>
 #include <fstream>
 #include <functional>
+#include <future>
 #include <openssl/md5.h>
 
 #include <boost/iostreams/device/mapped_file.hpp>
@@ -23,6 +25,11 @@
 #include <scorum/chain/operation_notification.hpp>
 
 #include <scorum/chain/database/database.hpp>
+#include <scorum/chain/database/block_replay_pipeline.hpp>
+#include <scorum/chain/database/signature_keys_recovery.hpp>
+#include <scorum/chain/database/transaction_prevalidation.hpp>
+#include <scorum/utils/thread_pool.hpp>
+#include <scorum/chain/compressed_block_log.hpp>
 #include <scorum/chain/database_exceptions.hpp>
 #include <scorum/chain/db_with.hpp>
 
@@ -84,6 +91,36 @@
 namespace scorum {
 namespace chain {
 
+namespace {
+// Points pointer to data owned by the caller and restores previous value when leaving the scope
+template <typename T> class scoped_pointer_value
+{
+public:
+    scoped_pointer_value(T*& ptr, T* value)
+        : _ptr(ptr)
+        , _prev(ptr)
+    {
+        _ptr = value;
+    }
+
+    ~scoped_pointer_value()
+    {
+        _ptr = _prev;
+    }
+
+private:
+    T*& _ptr;
+    T* _prev;
+};
+
+// Size of block left for transactions
+uint64_t block_transactions_capacity(uint64_t maximum_block_size)
+{
+    static const size_t max_block_header_size = fc::raw::pack_size(signed_block_header()) + 4;
+    return maximum_block_size > max_block_header_size ? maximum_block_size - max_block_header_size : 0;
+}
+}
+
 class database_impl
 {
 public:
@@ -131,6 +168,7 @@ uint32_t database::get_reindex_skip_flags() const
     skip_flags |= database::skip_validate_invariants;
     skip_flags |= database::skip_block_log;
     skip_flags |= database::skip_witness_schedule_check;
+    skip_flags |= database::skip_undo_block;
     return skip_flags;
 }
 
@@ -142,7 +180,7 @@ void database::open(const fc::path& data_dir,
 {
     try
     {
-        chainbase::database::open(shared_mem_dir, chainbase_flags, shared_file_size);
+        chainbase::database::open(shared_mem_dir, chainbase_flags, shared_file_size, _shared_file_mapping);
 
         // must be initialized before evaluators creation
         _my->_genesis_persistent_state = static_cast<const genesis_persistent_state_type&>(genesis_state);
@@ -152,6 +190,10 @@ void database::open(const fc::path& data_dir,
 
         if (chainbase_flags & chainbase::database::read_write)
         {
+            for_each_index([&](chainbase::abstract_generic_index_i& item) {
+                item.set_digest_enabled(_state_digest_blocks != 0);
+            });
+
             if (!find<dynamic_global_property_object>())
                 with_write_lock([&]() { init_genesis(genesis_state); });
 
@@ -186,6 +228,9 @@ void database::open(const fc::path& data_dir,
 
                 _fork_db.start_block(*head_block);
             }
+
+            if (_state_digest_blocks != 0)
+                update_state_digest();
         }
 
         try
@@ -235,22 +280,75 @@ void database::reindex(const fc::path& data_dir,
 
         ilog("Replaying ${n} blocks...", ("n", last_block_num));
 
+        uint64_t interval_operations = 0;
+        auto interval_start = fc::time_point::now();
+
+        auto report_progress = [&](uint32_t cur_block_num, uint32_t operations_count) {
+            interval_operations += operations_count;
+
+            if (cur_block_num % log_interval_sz == 0 || cur_block_num == last_block_num)
+            {
+                auto now = fc::time_point::now();
+                double elapsed_sec = std::max(double((now - interval_start).count()) / 1000000.0, 0.000001);
+                uint32_t interval_blocks = (cur_block_num % log_interval_sz) ? (cur_block_num % log_interval_sz)
+                                                                             : log_interval_sz;
+
+                double percent = (cur_block_num * double(100)) / last_block_num;
+                ilog("${p}% applied. ${bps} blocks/s, ${ops} ops/s. ${m}M free.",
+                     ("p", (boost::format("%5.2f") % percent).str())(
+                         "bps", (boost::format("%.1f") % (interval_blocks / elapsed_sec)).str())(
+                         "ops", (boost::format("%.1f") % (interval_operations / elapsed_sec)).str())(
+                         "m", get_free_memory() / (1024 * 1024)));
+
+                interval_operations = 0;
+                interval_start = now;
+            }
+        };
+
         with_write_lock([&]() {
-            auto itr = _block_log.read_block(0);
-            while (itr.first.block_num() <= last_block_num)
+            if (_replay_threads > 0)
             {
-                auto cur_block_num = itr.first.block_num();
-                if (cur_block_num % log_interval_sz == 0 || cur_block_num == last_block_num)
+                ilog("Using replay pipeline with ${t} threads", ("t", _replay_threads));
+
+                block_replay_pipeline pipeline(_block_log, last_block_num, _replay_threads);
+                pipeline.start();
+
+                prefetched_block item;
+                while (pipeline.next(item))
                 {
-                    double percent = (cur_block_num * double(100)) / last_block_num;
-                    ilog("${p}% applied. ${m}M free.",
-                         ("p", (boost::format("%5.2f") % percent).str())("m", get_free_memory() / (1024 * 1024)));
+                    _prefetched_block = &item;
+                    try
+                    {
+                        apply_block(item.block, skip_flags);
+                    }
+                    catch (...)
+                    {
+                        _prefetched_block = nullptr;
+                        throw;
+                    }
+                    _prefetched_block = nullptr;
+
+                    report_progress(item.block.block_num(), item.operations_count);
+                    check_free_memory();
+                }
+            }
+            else
+            {
+                // read by number as first blocks can be stored in compressed block log
+                for (uint32_t cur_block_num = 1; cur_block_num <= last_block_num; ++cur_block_num)
+                {
+                    auto block = _block_log.read_block_by_num(cur_block_num);
+                    SCORUM_ASSERT(block.valid(), block_log_exception, "Block ${n} is missing in block log.",
+                                  ("n", cur_block_num));
+
+                    uint32_t operations_count = 0;
+                    for (const auto& trx : block->transactions)
+                        operations_count += trx.operations.size();
+
+                    apply_block(*block, skip_flags);
+                    report_progress(cur_block_num, operations_count);
+                    check_free_memory();
                 }
-                apply_block(itr.first, skip_flags);
-                if (cur_block_num != last_block_num)
-                    itr = _block_log.read_block(itr.second);
-                else
-                    break;
             }
 
             for_each_index([&](chainbase::abstract_generic_index_i& item) { item.set_revision(head_block_num()); });
@@ -276,6 +374,10 @@ void database::wipe(const fc::path& data_dir, const fc::path& shared_mem_dir, bo
         fc::path block_log_file = block_log_path(data_dir);
         fc::remove_all(block_log_file);
         fc::remove_all(block_log::block_log_index_path(block_log_file));
+
+        fc::path archive_file = compressed_block_log::compressed_block_log_path(block_log_file);
+        fc::remove_all(archive_file);
+        fc::remove_all(compressed_block_log::compressed_block_log_index_path(archive_file));
     }
 }
 
@@ -305,6 +407,148 @@ void database::close()
     FC_CAPTURE_AND_RETHROW()
 }
 
+void database::export_state_snapshot(const fc::path& snapshot_file)
+{
+    try
+    {
+        with_read_lock([&]() {
+            state_snapshot_header header;
+            header.chain_id = get_chain_id();
+            header.head_block_num = head_block_num();
+            header.head_block_id = head_block_id();
+
+            ilog("Exporting state snapshot at block ${n}", ("n", header.head_block_num));
+            auto start = fc::time_point::now();
+
+            state_snapshot_writer writer(snapshot_file, header);
+            for (const auto& item : _snapshot_indexes)
+            {
+                item.second.save(writer, item.first);
+            }
+            writer.finish();
+
+            auto end = fc::time_point::now();
+            ilog("Done exporting state snapshot, elapsed time: ${t} sec",
+                 ("t", double((end - start).count()) / 1000000.0));
+        });
+    }
+    FC_CAPTURE_AND_RETHROW((snapshot_file))
+}
+
+void database::import_state_snapshot(const fc::path& snapshot_file, uint32_t threads_count, uint32_t skip_flags)
+{
+    try
+    {
+        state_snapshot_reader reader(snapshot_file);
+        const auto& header = reader.header();
+
+        FC_ASSERT(header.chain_id == get_chain_id(), "State snapshot is made for another chain ${id}",
+                  ("id", header.chain_id));
+        FC_ASSERT(head_block_num() == 0, "State snapshot can be imported into empty database only");
+
+        auto snapshot_block = _block_log.read_block_by_num(header.head_block_num);
+        FC_ASSERT(snapshot_block.valid() && snapshot_block->id() == header.head_block_id,
+                  "Block log does not contain snapshot block ${n}", ("n", header.head_block_num));
+
+        std::map<std::string, const state_snapshot_section*> sections;
+        for (const auto& section : reader.sections())
+        {
+            if (_snapshot_indexes.count(section.name))
+            {
+                sections[section.name] = &section;
+            }
+            else
+            {
+                FC_ASSERT(section.optional, "State snapshot section ${s} is not supported", ("s", section.name));
+                wlog("Skipping state snapshot section ${s}", ("s", section.name));
+            }
+        }
+
+        for (const auto& item : _snapshot_indexes)
+        {
+            if (!sections.count(item.first))
+            {
+                FC_ASSERT(item.second.optional, "State snapshot has no section ${s}", ("s", item.first));
+                wlog("State snapshot has no section ${s}, index is left empty", ("s", item.first));
+            }
+        }
+
+        ilog("Importing state snapshot at block ${n}", ("n", header.head_block_num));
+        auto start = fc::time_point::now();
+
+        with_write_lock([&]() {
+            utils::thread_pool pool(std::max<uint32_t>(threads_count, 1));
+
+            std::vector<std::future<void>> results;
+            for (const auto& item : _snapshot_indexes)
+            {
+                auto itr = sections.find(item.first);
+                const state_snapshot_section* section = itr != sections.end() ? itr->second : nullptr;
+                const auto& load = item.second.load;
+
+                // indexes are independent containers, the segment allocator is synchronized
+                results.push_back(pool.async([&reader, &load, section]() { load(reader, section); }));
+            }
+
+            std::exception_ptr error;
+            for (auto& result : results)
+            {
+                try
+                {
+                    result.get();
+                }
+                catch (...)
+                {
+                    if (!error)
+                        error = std::current_exception();
+                }
+            }
+            if (error)
+                std::rethrow_exception(error);
+
+            FC_ASSERT(head_block_num() == header.head_block_num && head_block_id() == header.head_block_id,
+                      "State snapshot does not match its header");
+
+            for_each_index([&](chainbase::abstract_generic_index_i& item) { item.set_revision(head_block_num()); });
+
+            init_hardforks(_hardfork_times[0]);
+            validate_invariants();
+
+            if (_state_digest_blocks != 0)
+                update_state_digest();
+        });
+
+        auto end = fc::time_point::now();
+        ilog("Done importing state snapshot, elapsed time: ${t} sec", ("t", double((end - start).count()) / 1000000.0));
+
+        const uint32_t last_block_num = _block_log.head()->block_num();
+        if (last_block_num > header.head_block_num)
+        {
+            ilog("Replaying ${n} blocks following state snapshot", ("n", last_block_num - header.head_block_num));
+
+            with_write_lock([&]() {
+                for (uint32_t cur_block_num = header.head_block_num + 1; cur_block_num <= last_block_num;
+                     ++cur_block_num)
+                {
+                    auto block = _block_log.read_block_by_num(cur_block_num);
+                    SCORUM_ASSERT(block.valid(), block_log_exception, "Block ${n} is missing in block log.",
+                                  ("n", cur_block_num));
+
+                    apply_block(*block, skip_flags);
+                    check_free_memory();
+                }
+
+                for_each_index(
+                    [&](chainbase::abstract_generic_index_i& item) { item.set_revision(head_block_num()); });
+            });
+        }
+
+        _fork_db.reset();
+        _fork_db.start_block(*_block_log.head());
+    }
+    FC_CAPTURE_AND_RETHROW((snapshot_file)(threads_count)(skip_flags))
+}
+
 bool database::is_known_block(const block_id_type& id) const
 {
     try
@@ -510,14 +754,36 @@ bool database::push_block(const signed_block& new_block, uint32_t skip)
 
     debug_log(ctx, "push_block skip=${s}", ("s", skip));
 
+    FC_ASSERT(!_state_corrupted, "State is corrupted by failed irreversible block. Replay blockchain.");
+
+    // signature keys and validation of operations do not depend on state so they are done before write lock
+    // is taken
+    std::unique_ptr<recovered_signature_keys> signature_keys;
+    if (_signature_pool && !(skip & (skip_transaction_signatures | skip_authority_check)))
+        signature_keys.reset(new recovered_signature_keys(new_block, get_chain_id(), *_signature_pool));
+
+    std::unique_ptr<prevalidated_transactions> prevalidated;
+    if (_signature_pool && !(skip & skip_validate))
+        prevalidated.reset(new prevalidated_transactions(new_block, *_signature_pool));
+
     bool result;
     detail::with_skip_flags(*this, skip, [&]() {
         with_write_lock([&]() {
-            detail::without_pending_transactions(*this, std::move(_pending_tx), [&]() {
+            detail::without_pending_transactions(*this, _pending_tx.take(), [&]() {
+                scoped_pointer_value<const recovered_signature_keys> keys_guard(_recovered_signature_keys,
+                                                                                signature_keys.get());
+                scoped_pointer_value<const prevalidated_transactions> prevalidated_guard(_prevalidated_transactions,
+                                                                                         prevalidated.get());
                 try
                 {
                     result = _push_block(new_block);
                     debug_log(ctx, "push_block resut=${r}", ("r", result));
+
+                    if (result)
+                        notify_head_block_changed();
+
+                    // pending transactions are cleared and block session is pushed, no session is alive here
+                    check_free_memory();
                 }
                 FC_CAPTURE_AND_RETHROW(((std::string)ctx))
             });
@@ -558,7 +824,6 @@ bool database::_push_block(const signed_block& new_block)
     try
     {
         uint32_t skip = get_node_properties().skip_flags;
-        // uint32_t skip_undo_db = skip & skip_undo_block;
 
         if (!(skip & skip_fork_db))
         {
@@ -588,7 +853,7 @@ bool database::_push_block(const signed_block& new_block)
                     while (head_block_id() != branches.second.back()->data.previous)
                     {
                         debug_log(ctx, "popping block_id=${id}", ("id", head_block_id()));
-                        pop_block();
+                        _pop_block();
                     }
 
                     // push all blocks on the new fork
@@ -626,7 +891,7 @@ bool database::_push_block(const signed_block& new_block)
                             while (head_block_id() != branches.second.back()->data.previous)
                             {
                                 debug_log(ctx, "popping block_id=${id}", ("id", head_block_id()));
-                                pop_block();
+                                _pop_block();
                             }
 
                             // restore all blocks from the good fork
@@ -654,9 +919,16 @@ bool database::_push_block(const signed_block& new_block)
 
         try
         {
-            auto session = start_undo_session();
-            apply_block(new_block, skip);
-            session->push();
+            if (_is_irreversible_block(new_block, skip))
+            {
+                _apply_irreversible_block(new_block, skip);
+            }
+            else
+            {
+                auto session = start_undo_session();
+                apply_block(new_block, skip);
+                session->push();
+            }
         }
         catch (const fc::exception& e)
         {
@@ -671,6 +943,45 @@ bool database::_push_block(const signed_block& new_block)
     FC_CAPTURE_AND_RETHROW(((std::string)ctx))
 }
 
+bool database::_is_irreversible_block(const signed_block& b, uint32_t skip) const
+{
+    if (skip & skip_undo_block)
+        return true;
+
+    // blocks up to the last checkpoint are already trusted by apply_block
+    return _checkpoints.size() && _checkpoints.rbegin()->second != block_id_type()
+        && _checkpoints.rbegin()->first >= b.block_num();
+}
+
+/**
+ * Applies block which will never be popped without recording undo history.
+ *
+ * Existing undo history is committed first, so there is nothing to undo below the block and indexes
+ * do not copy objects on modification. If the block fails to apply the state can't be restored.
+ */
+void database::_apply_irreversible_block(const signed_block& b, uint32_t skip)
+{
+    for_each_index([&](chainbase::abstract_generic_index_i& item) { item.commit(item.revision()); });
+
+    try
+    {
+        apply_block(b, skip);
+    }
+    catch (...)
+    {
+        // there is no session to undo partially applied block. Further blocks are refused, and revision that
+        // does not match head block makes open demand replay after restart.
+        _state_corrupted = true;
+        for_each_index([&](chainbase::abstract_generic_index_i& item) { item.set_revision(-1); });
+
+        elog("Irreversible block ${n} failed to apply, state is corrupted. Replay blockchain.",
+             ("n", b.block_num()));
+        throw;
+    }
+
+    for_each_index([&](chainbase::abstract_generic_index_i& item) { item.set_revision(head_block_num()); });
+}
+
 /**
  * Attempts to push the transaction into the pending queue
  *
@@ -686,6 +997,8 @@ void database::push_transaction(const signed_transaction& trx, uint32_t skip)
     {
         try
         {
+            FC_ASSERT(!_state_corrupted, "State is corrupted by failed irreversible block. Replay blockchain.");
+
             size_t trx_size = fc::raw::pack_size(trx);
             FC_ASSERT(
                 trx_size
@@ -705,11 +1018,35 @@ void database::push_transaction(const signed_transaction& trx, uint32_t skip)
 
 void database::_push_transaction(const signed_transaction& trx)
 {
+    _push_transaction(pending_transaction(trx, get_transaction_id(trx)));
+}
+
+void database::_push_transaction(pending_transaction&& trx)
+{
+    // early rejection only, transactions re-signed with the same body have the same id and are let through
+    // by skip_transaction_dupe_check like in _apply_transaction
+    FC_ASSERT((get_node_properties().skip_flags & skip_transaction_dupe_check) || !_pending_tx.contains(trx.id),
+              "Duplicate transaction check failed", ("trx_ix", trx.id));
+
+    try
+    {
+        _pending_tx.check_admission(trx);
+    }
+    catch (const fc::exception&)
+    {
+        ++_pending_tx.stats().rejected;
+        throw;
+    }
+
     // If this is the first transaction pushed after applying a block, start a new undo session.
     // This allows us to quickly rewind to the clean state of the head block, in case a new block arrives.
     if (!_pending_tx_session.valid())
     {
         _pending_tx_session = start_undo_session();
+        _pending_tx.open_candidate(
+            head_block_id(),
+            block_transactions_capacity(
+                obtain_service<dbs_dynamic_global_property>().get().median_chain_props.maximum_block_size));
     }
 
     // Create a temporary undo session as a child of _pending_tx_session.
@@ -718,15 +1055,97 @@ void database::_push_transaction(const signed_transaction& trx)
     // apply the changes.
 
     auto temp_session = start_undo_session();
-    _apply_transaction(trx);
-    _pending_tx.push_back(trx);
+    {
+        scoped_pointer_value<pending_transaction> verification_guard(_pending_verification, &trx);
+        _apply_transaction(trx.trx);
+    }
+    _pending_tx.push(std::move(trx));
 
     // The transaction applied successfully. Merge its changes into the pending block session.
     for_each_index([&](chainbase::abstract_generic_index_i& item) { item.squash(); });
     temp_session->push();
 
     // notify anyone listening to pending transactions
-    notify_on_pending_transaction(trx);
+    notify_on_pending_transaction(_pending_tx.transactions().back().trx);
+}
+
+void database::_restore_pending_transactions(pending_transaction_pool::container_type&& transactions)
+{
+    const auto start = fc::time_point::now();
+    auto& stats = _pending_tx.stats();
+    const auto now = head_block_time();
+
+    // expired and included transactions are dropped without applying them
+    for (auto it = transactions.begin(); it != transactions.end();)
+    {
+        if (it->trx.expiration <= now)
+        {
+            ++stats.dropped_expired;
+            it = transactions.erase(it);
+        }
+        else if (is_known_transaction(it->id))
+        {
+            ++stats.dropped_included;
+            it = transactions.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    // popped transactions are already restored, the rest is cut to limits of the pool
+    stats.evicted += _pending_tx.evict_by_expiration(transactions);
+
+    // evaluators are run again for every transaction, only authority verification is reused
+    for (auto& trx : transactions)
+    {
+        try
+        {
+            _pending_tx.check_admission(trx);
+        }
+        catch (const fc::exception&)
+        {
+            ++stats.evicted;
+            continue;
+        }
+
+        try
+        {
+            _push_transaction(std::move(trx));
+        }
+        catch (const transaction_exception& e)
+        {
+            ++stats.dropped_invalid;
+            dlog("Pending transaction became invalid after switching to block ${b} ${n} ${t}",
+                 ("b", head_block_id())("n", head_block_num())("t", head_block_time()));
+            dlog("The invalid transaction caused exception ${e}", ("e", e.to_detail_string()));
+        }
+        catch (const fc::exception& e)
+        {
+            ++stats.dropped_invalid;
+        }
+    }
+
+    const uint64_t elapsed = (fc::time_point::now() - start).count();
+    ++stats.restores;
+    stats.last_restore_microseconds = elapsed;
+    stats.max_restore_microseconds = std::max(stats.max_restore_microseconds, elapsed);
+}
+
+void database::set_pending_transaction_limits(const pending_transaction_limits& limits)
+{
+    _pending_tx.set_limits(limits);
+}
+
+pending_transaction_stats database::get_pending_transaction_stats() const
+{
+    return _pending_tx.get_stats();
+}
+
+block_production_stats database::get_block_production_stats() const
+{
+    return _block_production_stats;
 }
 
 signed_block database::generate_block(fc::time_point_sec when,
@@ -775,66 +1194,96 @@ signed_block database::_generate_block(fc::time_point_sec when,
         FC_ASSERT(witness_obj.signing_key == block_signing_private_key.get_public_key());
     }
 
-    static const size_t max_block_header_size = fc::raw::pack_size(signed_block_header()) + 4;
-    auto maximum_block_size = obtain_service<dbs_dynamic_global_property>()
-                                  .get()
-                                  .median_chain_props.maximum_block_size; // SCORUM_MAX_BLOCK_SIZE;
-    size_t total_block_size = max_block_header_size;
+    const auto start = fc::time_point::now();
+
+    const uint64_t capacity = block_transactions_capacity(
+        obtain_service<dbs_dynamic_global_property>().get().median_chain_props.maximum_block_size);
 
     signed_block pending_block;
 
     with_write_lock([&]() {
-        //
-        // The following code throws away existing pending_tx_session and
-        // rebuilds it by re-applying pending transactions.
-        //
-        // This rebuild is necessary because pending transactions' validity
-        // and semantics may have changed since they were received, because
-        // time-based semantics are evaluated based on the current block
-        // time.  These changes can only be reflected in the database when
-        // the value of the "when" variable is known, which means we need to
-        // re-apply pending transactions in this method.
-        //
-        _pending_tx_session.reset();
-        _pending_tx_session = start_undo_session();
-
         uint64_t postponed_tx_count = 0;
-        // pop pending state (reset to head block state)
-        for (const signed_transaction& tx : _pending_tx)
-        {
-            // Only include transactions that have not expired yet for currently generating block,
-            // this should clear problem transactions and allow block production to continue
 
-            if (tx.expiration < when)
+        // Pending transactions are applied to the head block state in order of arrival as the block applies
+        // them, so the candidate is the block as long as none of its transactions expires before the slot.
+        const auto& candidate = _pending_tx.candidate();
+        if (_pending_tx.empty()
+            || (_pending_tx_session.valid() && candidate.valid && candidate.head_block_id == head_block_id()
+                && candidate.capacity == capacity && candidate.min_expiration >= when))
+        {
+            pending_block.transactions.reserve(candidate.count);
+            auto it = _pending_tx.transactions().begin();
+            for (size_t ci = 0; ci < candidate.count; ++ci, ++it)
             {
-                continue;
+                pending_block.transactions.push_back(it->trx);
             }
 
-            uint64_t new_total_size = total_block_size + fc::raw::pack_size(tx);
-
-            // postpone transaction if it would make block too big
-            if (new_total_size >= maximum_block_size)
+            postponed_tx_count = candidate.closed ? _pending_tx.size() - candidate.count : 0;
+            ++_block_production_stats.speculative_blocks;
+        }
+        else
+        {
+            //
+            // The following code throws away existing pending_tx_session and
+            // rebuilds it by re-applying pending transactions.
+            //
+            // This rebuild is necessary because pending transactions' validity
+            // and semantics may have changed since they were received, because
+            // time-based semantics are evaluated based on the current block
+            // time.  These changes can only be reflected in the database when
+            // the value of the "when" variable is known, which means we need to
+            // re-apply pending transactions in this method.
+            //
+            _pending_tx_session.reset();
+            _pending_tx_session = start_undo_session();
+
+            uint64_t total_block_size = 0;
+            size_t selected_tx_count = 0;
+            // pop pending state (reset to head block state)
+            for (auto& pending : _pending_tx.transactions())
             {
-                postponed_tx_count++;
-                continue;
-            }
+                const signed_transaction& tx = pending.trx;
+                ++selected_tx_count;
 
-            try
-            {
-                auto temp_session = start_undo_session();
-                _apply_transaction(tx);
-                for_each_index([&](chainbase::abstract_generic_index_i& item) { item.squash(); });
-                temp_session->push();
+                // Only include transactions that have not expired yet for currently generating block,
+                // this should clear problem transactions and allow block production to continue
 
-                total_block_size += fc::raw::pack_size(tx);
-                pending_block.transactions.push_back(tx);
-            }
-            catch (const fc::exception& e)
-            {
-                // Do nothing, transaction will not be re-applied
-                // wlog( "Transaction was not processed while generating block due to ${e}", ("e", e) );
-                // wlog( "The transaction was ${t}", ("t", tx) );
+                if (tx.expiration < when)
+                {
+                    continue;
+                }
+
+                uint64_t new_total_size = total_block_size + pending.pack_size;
+
+                // postpone the rest of transactions if it would make block too big, they are applied in order
+                // of arrival as later transactions can depend on earlier ones
+                if (new_total_size >= capacity)
+                {
+                    postponed_tx_count = _pending_tx.size() - selected_tx_count + 1;
+                    break;
+                }
+
+                try
+                {
+                    auto temp_session = start_undo_session();
+                    {
+                        scoped_pointer_value<pending_transaction> verification_guard(_pending_verification, &pending);
+                        _apply_transaction(tx);
+                    }
+                    for_each_index([&](chainbase::abstract_generic_index_i& item) { item.squash(); });
+                    temp_session->push();
+
+                    total_block_size += pending.pack_size;
+                    pending_block.transactions.push_back(tx);
+                }
+                catch (const fc::exception& e)
+                {
+                    // Do nothing, transaction will not be re-applied
+                    // wlog( "Transaction was not processed while generating block due to ${e}", ("e", e) );
+                    // wlog( "The transaction was ${t}", ("t", tx) );
+                }
             }
+            ++_block_production_stats.rebuilt_blocks;
         }
         if (postponed_tx_count > 0)
         {
@@ -844,6 +1293,8 @@ signed_block database::_generate_block(fc::time_point_sec when,
         _pending_tx_session.reset();
     });
 
+    _block_production_stats.assembly.add((fc::time_point::now() - start).count());
+
     // We have temporarily broken the invariant that
     // _pending_tx_session is the result of applying _pending_tx, as
     // _pending_tx now consists of the set of postponed transactions.
@@ -897,6 +1348,8 @@ signed_block database::_generate_block(fc::time_point_sec when,
 
     push_block(pending_block, skip);
 
+    _block_production_stats.production.add((fc::time_point::now() - start).count());
+
     debug_log(ctx, "_generate_block result=${b}", ("b", (std::string)block_info(pending_block)));
 
     return pending_block;
@@ -907,6 +1360,12 @@ signed_block database::_generate_block(fc::time_point_sec when,
  * undoes any changes it made.
  */
 void database::pop_block()
+{
+    _pop_block();
+    notify_head_block_changed();
+}
+
+void database::_pop_block()
 {
     block_info ctx;
 
@@ -932,6 +1391,9 @@ void database::pop_block()
 
         _popped_tx.insert(_popped_tx.begin(), head_block->transactions.begin(), head_block->transactions.end());
 
+        if (_state_digest_blocks != 0)
+            update_state_digest();
+
         debug_log(ctx, "pop_block result");
     }
     FC_CAPTURE_AND_RETHROW(((std::string)ctx))
@@ -1000,6 +1462,11 @@ void database::notify_applied_block(const signed_block& block)
     SCORUM_TRY_NOTIFY(applied_block, block)
 }
 
+void database::notify_head_block_changed()
+{
+    SCORUM_TRY_NOTIFY(head_block_changed)
+}
+
 void database::notify_on_pending_transaction(const signed_transaction& tx)
 {
     SCORUM_TRY_NOTIFY(on_pending_transaction, tx)
@@ -1298,6 +1765,89 @@ void database::set_flush_interval(uint32_t flush_blocks)
     _next_flush_block = 0;
 }
 
+void database::set_shared_file_autoscale(uint16_t full_threshold, uint16_t scale_rate)
+{
+    FC_ASSERT(full_threshold <= SCORUM_100_PERCENT, "Invalid shared file full threshold ${t}", ("t", full_threshold));
+    FC_ASSERT(!full_threshold || scale_rate > 0, "Shared file scale rate must be positive");
+
+    _shared_file_full_threshold = full_threshold;
+    _shared_file_scale_rate = scale_rate;
+}
+
+void database::set_shared_file_mapping(const chainbase::mapping_options& options)
+{
+    _shared_file_mapping = options;
+}
+
+void database::compact_shared_memory()
+{
+    with_write_lock([&]() {
+        const size_t free_before = get_free_memory();
+
+        ilog("Compacting shared memory file, ${n}M free", ("n", free_before / (1024 * 1024)));
+
+        chainbase::database::compact();
+
+        ilog("Shared memory file is compacted, ${n}M free", ("n", get_free_memory() / (1024 * 1024)));
+    });
+}
+
+void database::set_replay_threads(uint32_t replay_threads)
+{
+    _replay_threads = replay_threads;
+}
+
+void database::set_signature_threads(uint32_t signature_threads)
+{
+    if (signature_threads)
+        _signature_pool.reset(new utils::thread_pool(signature_threads));
+    else
+        _signature_pool.reset();
+}
+
+block_id_type database::get_block_id(const signed_block& b) const
+{
+    if (_prefetched_block && &_prefetched_block->block == &b)
+        return _prefetched_block->id;
+    return b.id();
+}
+
+checksum_type database::get_merkle_root(const signed_block& b) const
+{
+    if (_prefetched_block && &_prefetched_block->block == &b)
+        return _prefetched_block->merkle_root;
+    return b.calculate_merkle_root();
+}
+
+transaction_id_type database::get_transaction_id(const signed_transaction& trx) const
+{
+    if (_prefetched_block)
+    {
+        const auto& transactions = _prefetched_block->block.transactions;
+        if (!transactions.empty() && &trx >= &transactions.front() && &trx <= &transactions.back())
+            return _prefetched_block->trx_ids[&trx - &transactions.front()];
+    }
+
+    if (_prevalidated_transactions)
+    {
+        const auto* id = _prevalidated_transactions->find_id(trx);
+        if (id)
+            return *id;
+    }
+    return trx.id();
+}
+
+flat_set<public_key_type> database::get_signature_keys(const signed_transaction& trx) const
+{
+    if (_recovered_signature_keys)
+    {
+        const auto* keys = _recovered_signature_keys->find(trx);
+        if (keys)
+            return *keys;
+    }
+    return trx.get_signature_keys(get_chain_id());
+}
+
 //////////////////// private methods ////////////////////
 
 void database::apply_block(const signed_block& next_block, uint32_t skip)
@@ -1315,8 +1865,8 @@ void database::apply_block(const signed_block& next_block, uint32_t skip)
         {
             auto itr = _checkpoints.find(block_num);
             if (itr != _checkpoints.end())
-                FC_ASSERT(next_block.id() == itr->second, "Block did not match checkpoint",
-                          ("checkpoint", *itr)("block_id", next_block.id()));
+                FC_ASSERT(get_block_id(next_block) == itr->second, "Block did not match checkpoint",
+                          ("checkpoint", *itr)("block_id", get_block_id(next_block)));
 
             if (_checkpoints.rbegin()->first >= block_num)
                 skip = skip_witness_signature | skip_transaction_signatures | skip_transaction_dupe_check | skip_fork_db
@@ -1326,6 +1876,25 @@ void database::apply_block(const signed_block& next_block, uint32_t skip)
                     | skip_undo_history_check | skip_witness_schedule_check | skip_validate | skip_validate_invariants;
         }
 
+        // blocks pushed with signature threads enabled come here with keys already recovered
+        std::unique_ptr<recovered_signature_keys> signature_keys;
+        if (_signature_pool && !(skip & (skip_transaction_signatures | skip_authority_check))
+            && !(_recovered_signature_keys && &_recovered_signature_keys->block() == &next_block))
+        {
+            signature_keys.reset(new recovered_signature_keys(next_block, get_chain_id(), *_signature_pool));
+        }
+        scoped_pointer_value<const recovered_signature_keys> keys_guard(
+            _recovered_signature_keys, signature_keys ? signature_keys.get() : _recovered_signature_keys);
+
+        std::unique_ptr<prevalidated_transactions> prevalidated;
+        if (_signature_pool && !(skip & skip_validate)
+            && !(_prevalidated_transactions && &_prevalidated_transactions->block() == &next_block))
+        {
+            prevalidated.reset(new prevalidated_transactions(next_block, *_signature_pool));
+        }
+        scoped_pointer_value<const prevalidated_transactions> prevalidated_guard(
+            _prevalidated_transactions, prevalidated ? prevalidated.get() : _prevalidated_transactions);
+
         detail::with_skip_flags(*this, skip, [&]() { _apply_block(next_block); });
 
         /// check invariants
@@ -1367,17 +1936,53 @@ void database::apply_block(const signed_block& next_block, uint32_t skip)
             {
                 _next_flush_block = 0;
                 // ilog( "Flushing database shared memory at block ${b}", ("b", block_num) );
-                chainbase::database::flush();
+                // flushed by background thread, block processing is not stalled by msync
+                chainbase::database::flush_async();
             }
         }
 
         show_free_memory(false);
 
+        if (_memory_stats_blocks != 0 && block_num % _memory_stats_blocks == 0)
+        {
+            show_index_memory();
+        }
+
+        if (_state_digest_blocks != 0)
+        {
+            update_state_digest();
+
+            if (block_num % _state_digest_blocks == 0)
+                ilog("State digest at block ${n}: ${d}", ("n", block_num)("d", _state_digest.digest));
+        }
+
         debug_log(ctx, "apply_block result");
     }
     FC_CAPTURE_AND_RETHROW(((std::string)ctx))
 }
 
+void database::check_free_memory()
+{
+    if (!_shared_file_full_threshold)
+        return;
+
+    const uint64_t size = get_size();
+    const uint64_t used = size - get_free_memory();
+
+    if (fc::uint128_t(used) * SCORUM_100_PERCENT < fc::uint128_t(size) * _shared_file_full_threshold)
+        return;
+
+    const uint64_t new_size
+        = size + (fc::uint128_t(size) * _shared_file_scale_rate / SCORUM_100_PERCENT).to_uint64();
+
+    ilog("Shared memory file is ${p}% full, growing it from ${s}M to ${n}M",
+         ("p", used * 100 / size)("s", size / (1024 * 1024))("n", new_size / (1024 * 1024)));
+
+    chainbase::database::resize(new_size);
+
+    show_free_memory(true);
+}
+
 void database::show_free_memory(bool force)
 {
     uint32_t free_gb = uint32_t(get_free_memory() / (1024 * 1024 * 1024));
@@ -1398,6 +2003,67 @@ void database::show_free_memory(bool force)
     }
 }
 
+void database::set_memory_stats_interval(uint32_t memory_stats_blocks)
+{
+    _memory_stats_blocks = memory_stats_blocks;
+}
+
+void database::set_state_digest_interval(uint32_t state_digest_blocks)
+{
+    _state_digest_blocks = state_digest_blocks;
+}
+
+state_digest database::get_state_digest() const
+{
+    FC_ASSERT(_state_digest_blocks != 0, "State digest is disabled");
+
+    return _state_digest;
+}
+
+void database::update_state_digest()
+{
+    _state_digest.block_num = head_block_num();
+    _state_digest.block_id = head_block_id();
+    _state_digest.indexes = get_digests();
+
+    std::sort(_state_digest.indexes.begin(), _state_digest.indexes.end(),
+              [](const chainbase::index_digest& a, const chainbase::index_digest& b) { return a.name < b.name; });
+
+    fc::sha256::encoder enc;
+    for (const auto& index : _state_digest.indexes)
+    {
+        auto it = _snapshot_indexes.find(index.name);
+        if (it == _snapshot_indexes.end() || it->second.optional)
+            continue;
+
+        fc::raw::pack(enc, index.name);
+        fc::raw::pack(enc, index.digest);
+    }
+    _state_digest.digest = enc.result();
+}
+
+void database::show_index_memory() const
+{
+    auto stats = get_memory_stats();
+
+    std::sort(stats.begin(), stats.end(), [](const chainbase::index_memory_stats& a,
+                                             const chainbase::index_memory_stats& b) {
+        return a.total_bytes() > b.total_bytes();
+    });
+
+    for (const auto& index : stats)
+    {
+        if (!index.nodes && index.undo_revisions.empty())
+            continue;
+
+        ilog("${name}: ${n} objects, ${node}K in nodes, ${id}K in id table, ${dyn}K${e} in dynamic members, "
+             "${undo}K in undo history of ${r} revisions",
+             ("name", index.name)("n", index.nodes)("node", index.node_bytes / 1024)("id", index.id_table_bytes / 1024)(
+                 "dyn", index.dynamic_bytes / 1024)("e", index.dynamic_bytes_estimated ? " (estimated)" : "")(
+                 "undo", index.undo_bytes / 1024)("r", index.undo_revisions.size()));
+    }
+}
+
 void database::_apply_block(const signed_block& next_block)
 {
     block_info ctx(next_block);
@@ -1415,7 +2081,7 @@ void database::_apply_block(const signed_block& next_block)
 
         if (!(skip & skip_merkle_check))
         {
-            auto merkle_root = next_block.calculate_merkle_root();
+            auto merkle_root = get_merkle_root(next_block);
 
             try
             {
@@ -1589,16 +2255,17 @@ void database::_apply_transaction(const signed_transaction& trx)
 {
     try
     {
-        _current_trx_id = trx.id();
+        auto trx_id = get_transaction_id(trx);
+        _current_trx_id = trx_id;
         uint32_t skip = get_node_properties().skip_flags;
 
         if (!(skip & skip_validate)) /* issue #505 explains why this skip_flag is disabled */
         {
-            trx.validate();
+            if (!_prevalidated_transactions || !_prevalidated_transactions->check(trx))
+                trx.validate();
         }
 
         auto& trx_idx = get_index<transaction_index>();
-        auto trx_id = trx.id();
         // idump((trx_id)(skip&skip_transaction_dupe_check));
         FC_ASSERT((skip & skip_transaction_dupe_check)
                       || trx_idx.indices().get<by_trx_id>().find(trx_id) == trx_idx.indices().get<by_trx_id>().end(),
@@ -1606,26 +2273,14 @@ void database::_apply_transaction(const signed_transaction& trx)
 
         if (!(skip & (skip_transaction_signatures | skip_authority_check)))
         {
-            auto get_active = [&](const std::string& name) {
-                return authority(get<account_authority_object, by_account>(name).active);
-            };
-            auto get_owner = [&](const std::string& name) {
-                return authority(get<account_authority_object, by_account>(name).owner);
-            };
-            auto get_posting = [&](const std::string& name) {
-                return authority(get<account_authority_object, by_account>(name).posting);
-            };
-
-            try
+            if (_pending_verification && _pending_verification->verified
+                && is_authority_unchanged(_pending_verification->authorities))
             {
-                trx.verify_authority(get_chain_id(), get_active, get_owner, get_posting, SCORUM_MAX_SIG_CHECK_DEPTH);
+                ++_pending_tx.stats().reused_verifications;
             }
-            catch (protocol::tx_missing_active_auth& e)
+            else
             {
-                if (get_shared_db_merkle().find(head_block_num() + 1) == get_shared_db_merkle().end())
-                {
-                    throw e;
-                }
+                verify_transaction_authority(trx);
             }
         }
 
@@ -1682,6 +2337,93 @@ void database::_apply_transaction(const signed_transaction& trx)
     FC_CAPTURE_AND_RETHROW((trx))
 }
 
+void database::verify_transaction_authority(const signed_transaction& trx)
+{
+    pending_transaction* pending = _pending_verification;
+    if (pending)
+    {
+        ++_pending_tx.stats().full_verifications;
+        pending->verified = false;
+        pending->authorities.clear();
+        if (pending->signature_keys.empty())
+            pending->signature_keys = get_signature_keys(trx);
+    }
+
+    auto read = [&](const std::string& name, authority::classification classification,
+                    const shared_authority& value) {
+        authority result(value);
+        if (pending)
+        {
+            auto it = std::find_if(pending->authorities.begin(), pending->authorities.end(),
+                                   [&](const authority_read& r) {
+                                       return r.account == name && r.classification == classification;
+                                   });
+            if (it == pending->authorities.end())
+                pending->authorities.push_back(authority_read{ name, classification, result });
+        }
+        return result;
+    };
+
+    auto get_active = [&](const std::string& name) {
+        return read(name, authority::active, get<account_authority_object, by_account>(name).active);
+    };
+    auto get_owner = [&](const std::string& name) {
+        return read(name, authority::owner, get<account_authority_object, by_account>(name).owner);
+    };
+    auto get_posting = [&](const std::string& name) {
+        return read(name, authority::posting, get<account_authority_object, by_account>(name).posting);
+    };
+
+    try
+    {
+        trx.verify_authority(pending ? pending->signature_keys : get_signature_keys(trx), get_active, get_owner,
+                             get_posting, SCORUM_MAX_SIG_CHECK_DEPTH);
+    }
+    catch (protocol::tx_missing_active_auth& e)
+    {
+        if (get_shared_db_merkle().find(head_block_num() + 1) == get_shared_db_merkle().end())
+        {
+            throw e;
+        }
+
+        // accepted by exception for the next block only, so it is not reused
+        return;
+    }
+
+    if (pending)
+        pending->verified = true;
+}
+
+bool database::is_authority_unchanged(const std::vector<authority_read>& authorities) const
+{
+    for (const auto& read : authorities)
+    {
+        const auto* it = find<account_authority_object, by_account>(read.account);
+        if (!it)
+            return false;
+
+        switch (read.classification)
+        {
+        case authority::owner:
+            if (!(authority(it->owner) == read.value))
+                return false;
+            break;
+        case authority::active:
+            if (!(authority(it->active) == read.value))
+                return false;
+            break;
+        case authority::posting:
+            if (!(authority(it->posting) == read.value))
+                return false;
+            break;
+        default:
+            return false;
+        }
+    }
+
+    return true;
+}
+
 void database::apply_operation(const operation& op)
 {
     auto note = create_notification(op);
@@ -1734,7 +2476,7 @@ void database::create_block_summary(const signed_block& next_block)
     try
     {
         block_summary_id_type sid(next_block.block_num() & (uint32_t)SCORUM_BLOCKID_POOL_SIZE);
-        modify(get<block_summary_object>(sid), [&](block_summary_object& p) { p.block_id = next_block.id(); });
+        modify(get<block_summary_object>(sid), [&](block_summary_object& p) { p.block_id = get_block_id(next_block); });
     }
     FC_CAPTURE_AND_RETHROW()
 }
@@ -1794,7 +2536,7 @@ void database::update_global_dynamic_data(const signed_block& b)
             }
 
             dgp.head_block_number = b.block_num();
-            dgp.head_block_id = b.id();
+            dgp.head_block_id = get_block_id(b);
             dgp.time = b.timestamp;
             dgp.current_aslot += missed_blocks + 1;
         });
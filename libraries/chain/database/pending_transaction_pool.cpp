@@ -0,0 +1,197 @@
+#include <scorum/chain/database/pending_transaction_pool.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include <algorithm>
+
+namespace scorum {
+namespace chain {
+
+pending_transaction::pending_transaction(const signed_transaction& trx_, const transaction_id_type& id_)
+    : trx(trx_)
+    , id(id_)
+    , pack_size(fc::raw::pack_size(trx_))
+{
+    if (trx.operations.empty())
+        return;
+
+    // quota is charged to the account paying for the first operation, not to the lowest name among signers
+    fc::flat_set<account_name_type> active;
+    fc::flat_set<account_name_type> owner;
+    fc::flat_set<account_name_type> posting;
+    std::vector<authority> other;
+    scorum::protocol::operation_get_required_authorities(trx.operations.front(), active, owner, posting, other);
+
+    if (!active.empty())
+        account = *active.begin();
+    else if (!owner.empty())
+        account = *owner.begin();
+    else if (!posting.empty())
+        account = *posting.begin();
+}
+
+void pending_transaction_pool::set_limits(const pending_transaction_limits& limits)
+{
+    _limits = limits;
+}
+
+const pending_transaction_limits& pending_transaction_pool::limits() const
+{
+    return _limits;
+}
+
+void pending_transaction_pool::check_admission(const pending_transaction& trx) const
+{
+    FC_ASSERT(!_limits.max_count || _transactions.size() < _limits.max_count,
+              "Pending transactions pool is full: ${n} transactions", ("n", _transactions.size()));
+    FC_ASSERT(!_limits.max_bytes || _bytes + trx.pack_size <= _limits.max_bytes,
+              "Pending transactions pool is full: ${n} bytes", ("n", _bytes));
+    FC_ASSERT(!_limits.max_per_account || count_by_account(trx.account) < _limits.max_per_account,
+              "Account ${a} has too many pending transactions", ("a", trx.account));
+}
+
+void pending_transaction_pool::push(pending_transaction&& trx)
+{
+    auto it = _transactions.insert(_transactions.end(), std::move(trx));
+
+    _by_id.emplace(it->id, it);
+    ++_by_account[it->account];
+    _bytes += it->pack_size;
+
+    if (!_candidate.valid || _candidate.closed)
+        return;
+
+    if (_candidate.bytes + it->pack_size >= _candidate.capacity)
+    {
+        _candidate.closed = true;
+        return;
+    }
+
+    ++_candidate.count;
+    _candidate.bytes += it->pack_size;
+    _candidate.min_expiration = std::min(_candidate.min_expiration, it->trx.expiration);
+}
+
+void pending_transaction_pool::open_candidate(const block_id_type& head_block_id, uint64_t capacity)
+{
+    _candidate = pending_block_candidate();
+    _candidate.head_block_id = head_block_id;
+    _candidate.capacity = capacity;
+    // transactions left in the pool were applied to another state
+    _candidate.valid = _transactions.empty();
+}
+
+const pending_block_candidate& pending_transaction_pool::candidate() const
+{
+    return _candidate;
+}
+
+pending_transaction_pool::container_type pending_transaction_pool::take()
+{
+    container_type result;
+    result.splice(result.end(), _transactions);
+    clear();
+    return result;
+}
+
+size_t pending_transaction_pool::evict_by_expiration(container_type& candidates) const
+{
+    size_t excess_count = 0;
+    if (_limits.max_count && _transactions.size() + candidates.size() > _limits.max_count)
+        excess_count = _transactions.size() + candidates.size() - _limits.max_count;
+
+    uint64_t candidates_bytes = 0;
+    for (const auto& trx : candidates)
+        candidates_bytes += trx.pack_size;
+
+    uint64_t excess_bytes = 0;
+    if (_limits.max_bytes && _bytes + candidates_bytes > _limits.max_bytes)
+        excess_bytes = _bytes + candidates_bytes - _limits.max_bytes;
+
+    if (!excess_count && !excess_bytes)
+        return 0;
+
+    std::vector<container_type::iterator> by_expiration;
+    by_expiration.reserve(candidates.size());
+    for (auto it = candidates.begin(); it != candidates.end(); ++it)
+        by_expiration.push_back(it);
+
+    std::stable_sort(by_expiration.begin(), by_expiration.end(),
+                     [](container_type::iterator a, container_type::iterator b) {
+                         return a->trx.expiration < b->trx.expiration;
+                     });
+
+    size_t evicted = 0;
+    uint64_t evicted_bytes = 0;
+    for (auto it : by_expiration)
+    {
+        if (evicted >= excess_count && evicted_bytes >= excess_bytes)
+            break;
+
+        evicted_bytes += it->pack_size;
+        ++evicted;
+        candidates.erase(it);
+    }
+
+    return evicted;
+}
+
+void pending_transaction_pool::clear()
+{
+    _transactions.clear();
+    _by_id.clear();
+    _by_account.clear();
+    _bytes = 0;
+    _candidate = pending_block_candidate();
+}
+
+bool pending_transaction_pool::contains(const transaction_id_type& id) const
+{
+    return _by_id.find(id) != _by_id.end();
+}
+
+size_t pending_transaction_pool::count_by_account(const account_name_type& account) const
+{
+    auto it = _by_account.find(account);
+    return it != _by_account.end() ? it->second : 0;
+}
+
+pending_transaction_pool::container_type& pending_transaction_pool::transactions()
+{
+    return _transactions;
+}
+
+const pending_transaction_pool::container_type& pending_transaction_pool::transactions() const
+{
+    return _transactions;
+}
+
+size_t pending_transaction_pool::size() const
+{
+    return _transactions.size();
+}
+
+uint64_t pending_transaction_pool::bytes() const
+{
+    return _bytes;
+}
+
+bool pending_transaction_pool::empty() const
+{
+    return _transactions.empty();
+}
+
+pending_transaction_stats& pending_transaction_pool::stats()
+{
+    return _stats;
+}
+
+pending_transaction_stats pending_transaction_pool::get_stats() const
+{
+    pending_transaction_stats result = _stats;
+    result.pending = _transactions.size();
+    result.pending_bytes = _bytes;
+    return result;
+}
+}
+}
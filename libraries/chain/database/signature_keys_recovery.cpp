@@ -0,0 +1,63 @@
+#include <scorum/chain/database/signature_keys_recovery.hpp>
+
+#include <scorum/utils/thread_pool.hpp>
+
+namespace scorum {
+namespace chain {
+
+recovered_signature_keys::recovered_signature_keys(const signed_block& block,
+                                                   const chain_id_type& chain_id,
+                                                   utils::thread_pool& pool)
+    : _block(block)
+    , _keys(block.transactions.size())
+    , _errors(block.transactions.size())
+{
+    const size_t trx_count = block.transactions.size();
+    if (!trx_count)
+        return;
+
+    // few transactions per task to amortize scheduling
+    const size_t batch_size = std::max<size_t>(trx_count / (pool.size() * 4), 1u);
+
+    std::vector<std::future<void>> results;
+    for (size_t first = 0; first < trx_count; first += batch_size)
+    {
+        size_t last = std::min(first + batch_size, trx_count);
+        results.push_back(pool.async([this, &chain_id, first, last]() {
+            for (size_t ci = first; ci < last; ++ci)
+            {
+                try
+                {
+                    _keys[ci] = _block.transactions[ci].get_signature_keys(chain_id);
+                }
+                catch (...)
+                {
+                    _errors[ci] = std::current_exception();
+                }
+            }
+        }));
+    }
+
+    for (auto& result : results)
+        result.wait();
+}
+
+const signed_block& recovered_signature_keys::block() const
+{
+    return _block;
+}
+
+const fc::flat_set<public_key_type>* recovered_signature_keys::find(const signed_transaction& trx) const
+{
+    const auto& transactions = _block.transactions;
+    if (transactions.empty() || &trx < &transactions.front() || &trx > &transactions.back())
+        return nullptr;
+
+    size_t idx = &trx - &transactions.front();
+    if (_errors[idx])
+        std::rethrow_exception(_errors[idx]);
+
+    return &_keys[idx];
+}
+}
+}
@@ -0,0 +1,291 @@
+#include <scorum/chain/database/state_snapshot.hpp>
+
+#include <cstring>
+#include <fstream>
+
+#include <zlib.h>
+
+#define SNAPSHOT_READ (std::ios::in | std::ios::binary)
+#define SNAPSHOT_CREATE (std::ios::out | std::ios::binary | std::ios::trunc)
+
+namespace scorum {
+namespace chain {
+
+namespace {
+
+const uint64_t state_snapshot_magic = 0x31504e5352524353; // "SCRRSNP1"
+const uint32_t state_snapshot_version = 1;
+
+struct chunk_header
+{
+    uint32_t object_count = 0;
+    uint32_t raw_size = 0;
+    uint32_t compressed_size = 0;
+    uint32_t checksum = 0;
+};
+}
+}
+}
+
+FC_REFLECT(scorum::chain::chunk_header, (object_count)(raw_size)(compressed_size)(checksum))
+
+namespace scorum {
+namespace chain {
+
+namespace {
+
+uint32_t checksum(const std::vector<char>& raw)
+{
+    return (uint32_t)crc32(crc32(0L, Z_NULL, 0), (const Bytef*)raw.data(), (uInt)raw.size());
+}
+
+std::vector<char> zlib_deflate(const std::vector<char>& raw, int level)
+{
+    uLongf compressed_size = compressBound((uLong)raw.size());
+    std::vector<char> compressed(compressed_size);
+
+    int rc = compress2((Bytef*)compressed.data(), &compressed_size, (const Bytef*)raw.data(), (uLong)raw.size(),
+                       level);
+    FC_ASSERT(rc == Z_OK, "Could not compress snapshot chunk.", ("rc", rc));
+
+    compressed.resize(compressed_size);
+    return compressed;
+}
+
+void zlib_inflate(const std::vector<char>& compressed, std::vector<char>& raw)
+{
+    uLongf raw_size = (uLongf)raw.size();
+
+    int rc = uncompress((Bytef*)raw.data(), &raw_size, (const Bytef*)compressed.data(), (uLong)compressed.size());
+    FC_ASSERT(rc == Z_OK && raw_size == raw.size(), "State snapshot chunk is corrupted.",
+              ("rc", rc)("size", (uint64_t)raw_size)("expected", raw.size()));
+}
+
+template <typename T> void write_value(std::ostream& stream, const T& value)
+{
+    auto packed = fc::raw::pack(value);
+    stream.write(packed.data(), packed.size());
+}
+
+template <typename T> void read_value(std::istream& stream, T& value)
+{
+    std::vector<char> packed(fc::raw::pack_size(value));
+    stream.read(packed.data(), packed.size());
+    value = fc::raw::unpack<T>(packed);
+}
+}
+
+namespace detail {
+class state_snapshot_writer_impl
+{
+public:
+    std::fstream stream;
+    fc::path file;
+
+    uint32_t chunk_size = 0;
+    int compression_level = 0;
+
+    std::vector<state_snapshot_section> sections;
+
+    std::vector<char> raw;
+    uint32_t object_count = 0;
+
+    void write_chunk()
+    {
+        chunk_header header;
+        header.object_count = object_count;
+        header.raw_size = raw.size();
+        header.checksum = checksum(raw);
+
+        std::vector<char> compressed;
+        if (!raw.empty())
+            compressed = zlib_deflate(raw, compression_level);
+        header.compressed_size = compressed.size();
+
+        write_value(stream, header);
+        stream.write(compressed.data(), compressed.size());
+
+        raw.clear();
+        object_count = 0;
+    }
+};
+
+class state_snapshot_reader_impl
+{
+public:
+    fc::path file;
+
+    state_snapshot_header header;
+    std::vector<state_snapshot_section> sections;
+};
+}
+
+state_snapshot_writer::state_snapshot_writer(const fc::path& file,
+                                             const state_snapshot_header& header,
+                                             uint32_t chunk_size,
+                                             int compression_level)
+    : my(new detail::state_snapshot_writer_impl())
+{
+    FC_ASSERT(chunk_size > 0, "Chunk size must be positive.");
+
+    my->file = file;
+    my->chunk_size = chunk_size;
+    my->compression_level = compression_level;
+
+    my->stream.open(file.generic_string().c_str(), SNAPSHOT_CREATE);
+    FC_ASSERT(my->stream.good(), "Could not create state snapshot file.", ("file", file.generic_string()));
+
+    write_value(my->stream, state_snapshot_magic);
+    write_value(my->stream, state_snapshot_version);
+
+    const auto packed_header = fc::raw::pack(header);
+    write_value(my->stream, (uint32_t)packed_header.size());
+    my->stream.write(packed_header.data(), packed_header.size());
+}
+
+state_snapshot_writer::~state_snapshot_writer()
+{
+}
+
+void state_snapshot_writer::begin_section(const std::string& name, bool optional, int64_t next_id)
+{
+    state_snapshot_section section;
+    section.name = name;
+    section.optional = optional;
+    section.position = my->stream.tellp();
+    section.next_id = next_id;
+
+    my->sections.push_back(section);
+}
+
+std::vector<char>& state_snapshot_writer::chunk_buffer()
+{
+    return my->raw;
+}
+
+void state_snapshot_writer::object_packed()
+{
+    ++my->object_count;
+    ++my->sections.back().objects;
+
+    if (my->raw.size() >= my->chunk_size)
+        my->write_chunk();
+}
+
+void state_snapshot_writer::end_section()
+{
+    if (my->object_count)
+        my->write_chunk();
+
+    // empty chunk terminates section
+    my->write_chunk();
+}
+
+void state_snapshot_writer::finish()
+{
+    const uint64_t table_position = my->stream.tellp();
+
+    const auto packed_table = fc::raw::pack(my->sections);
+    my->stream.write(packed_table.data(), packed_table.size());
+    write_value(my->stream, table_position);
+
+    my->stream.flush();
+    FC_ASSERT(my->stream.good(), "Could not write state snapshot file.", ("file", my->file.generic_string()));
+
+    my->stream.close();
+}
+
+state_snapshot_reader::state_snapshot_reader(const fc::path& file)
+    : my(new detail::state_snapshot_reader_impl())
+{
+    my->file = file;
+
+    std::fstream stream(file.generic_string().c_str(), SNAPSHOT_READ);
+    FC_ASSERT(stream.good(), "Could not open state snapshot file.", ("file", file.generic_string()));
+
+    uint64_t magic = 0;
+    read_value(stream, magic);
+    FC_ASSERT(magic == state_snapshot_magic, "Unknown state snapshot format.", ("file", file.generic_string()));
+
+    uint32_t version = 0;
+    read_value(stream, version);
+    FC_ASSERT(version == state_snapshot_version, "Unsupported state snapshot version ${v}.", ("v", version));
+
+    uint32_t header_size = 0;
+    read_value(stream, header_size);
+    std::vector<char> packed_header(header_size);
+    stream.read(packed_header.data(), packed_header.size());
+    FC_ASSERT(stream.good(), "State snapshot header is corrupted.");
+    my->header = fc::raw::unpack<state_snapshot_header>(packed_header);
+
+    stream.seekg(-(int64_t)sizeof(uint64_t), std::ios::end);
+    const uint64_t table_end = stream.tellg();
+
+    uint64_t table_position = 0;
+    read_value(stream, table_position);
+    FC_ASSERT(stream.good() && table_position < table_end, "State snapshot is not finished.");
+
+    std::vector<char> packed_table(table_end - table_position);
+    stream.seekg(table_position);
+    stream.read(packed_table.data(), packed_table.size());
+    FC_ASSERT(stream.good(), "State snapshot section table is corrupted.");
+    my->sections = fc::raw::unpack<std::vector<state_snapshot_section>>(packed_table);
+}
+
+state_snapshot_reader::~state_snapshot_reader()
+{
+}
+
+const state_snapshot_header& state_snapshot_reader::header() const
+{
+    return my->header;
+}
+
+const std::vector<state_snapshot_section>& state_snapshot_reader::sections() const
+{
+    return my->sections;
+}
+
+void state_snapshot_reader::read_section(const state_snapshot_section& section, const object_loader& loader) const
+{
+    std::fstream stream(my->file.generic_string().c_str(), SNAPSHOT_READ);
+    FC_ASSERT(stream.good(), "Could not open state snapshot file.", ("file", my->file.generic_string()));
+
+    stream.seekg(section.position);
+
+    uint64_t objects = 0;
+    std::vector<char> compressed;
+    std::vector<char> raw;
+
+    while (true)
+    {
+        chunk_header header;
+        read_value(stream, header);
+        FC_ASSERT(stream.good(), "State snapshot section ${s} is truncated.", ("s", section.name));
+
+        if (!header.object_count)
+            break;
+
+        compressed.resize(header.compressed_size);
+        stream.read(compressed.data(), compressed.size());
+        FC_ASSERT(stream.good(), "State snapshot section ${s} is truncated.", ("s", section.name));
+
+        raw.resize(header.raw_size);
+        zlib_inflate(compressed, raw);
+        FC_ASSERT(checksum(raw) == header.checksum, "State snapshot section ${s} checksum mismatch.",
+                  ("s", section.name));
+
+        fc::datastream<const char*> ds(raw.data(), raw.size());
+        for (uint32_t ci = 0; ci < header.object_count; ++ci)
+            loader(ds);
+
+        FC_ASSERT(ds.remaining() == 0, "State snapshot section ${s} is corrupted.", ("s", section.name));
+
+        objects += header.object_count;
+    }
+
+    FC_ASSERT(objects == section.objects, "State snapshot section ${s} has ${n} objects, expected ${e}.",
+              ("s", section.name)("n", objects)("e", section.objects));
+}
+}
+}
@@ -0,0 +1,81 @@
+#include <scorum/chain/database/transaction_prevalidation.hpp>
+
+#include <scorum/utils/thread_pool.hpp>
+
+namespace scorum {
+namespace chain {
+
+prevalidated_transactions::prevalidated_transactions(const signed_block& block, utils::thread_pool& pool)
+    : _block(block)
+    , _ids(block.transactions.size())
+    , _errors(block.transactions.size())
+{
+    const size_t trx_count = block.transactions.size();
+    if (!trx_count)
+        return;
+
+    // few transactions per task to amortize scheduling
+    const size_t batch_size = std::max<size_t>(trx_count / (pool.size() * 4), 1u);
+
+    std::vector<std::future<void>> results;
+    for (size_t first = 0; first < trx_count; first += batch_size)
+    {
+        size_t last = std::min(first + batch_size, trx_count);
+        results.push_back(pool.async([this, first, last]() {
+            for (size_t ci = first; ci < last; ++ci)
+            {
+                const auto& trx = _block.transactions[ci];
+                try
+                {
+                    _ids[ci] = trx.id();
+                    trx.validate();
+                }
+                catch (...)
+                {
+                    _errors[ci] = std::current_exception();
+                }
+            }
+        }));
+    }
+
+    for (auto& result : results)
+        result.wait();
+}
+
+const signed_block& prevalidated_transactions::block() const
+{
+    return _block;
+}
+
+bool prevalidated_transactions::check(const signed_transaction& trx) const
+{
+    if (!contains(trx))
+        return false;
+
+    size_t idx = &trx - &_block.transactions.front();
+    if (_errors[idx])
+        std::rethrow_exception(_errors[idx]);
+
+    return true;
+}
+
+const transaction_id_type* prevalidated_transactions::find_id(const signed_transaction& trx) const
+{
+    if (!contains(trx))
+        return nullptr;
+
+    // failed transaction may have no id calculated
+    size_t idx = &trx - &_block.transactions.front();
+    if (_errors[idx])
+        return nullptr;
+
+    return &_ids[idx];
+}
+
+bool prevalidated_transactions::contains(const signed_transaction& trx) const
+{
+    const auto& transactions = _block.transactions;
+    return !transactions.empty() && &trx >= &transactions.front() && &trx <= &transactions.back();
+}
+}
+}
@@ -11,6 +11,23 @@ namespace detail {
 class block_log_impl;
 }
 
+/**
+ * Serialized block placed in memory mapped block log. It points to mapped memory directly
+ * and stays valid until block log is closed.
+ */
+struct serialized_block_view
+{
+    const char* data = nullptr;
+    size_t size = 0;
+};
+
+enum class index_rebuild_mode
+{
+    unpack, ///< deserialize every block sequentially
+    backward, ///< walk trailing positions from the end of file without deserialization
+    parallel ///< backward walk followed by concurrent validation of block ranges
+};
+
 /* The block log is an external append only log of the blocks. Blocks should only be written
  * to the log after they irreverisble as the log is append only. The log is a doubly linked
  * list of blocks. There is a secondary index file of only block positions that enables O(1)
@@ -34,6 +51,15 @@ class block_log_impl;
  *
  * The main file is the only file that needs to persist. The index file can be reconstructed during a
  * linear scan of the main file.
+ *
+ * Flushed blocks are also served from read only memory mappings of both files which are independent
+ * of the append streams. Random access by block number through the mappings is lock-free and safe to
+ * use concurrently with appending. Blocks which are appended but not flushed yet are read through the
+ * append streams, such reads are serialized with appending by a mutex.
+ *
+ * If compressed block log (see compressed_block_log) exists next to the main file, the main file may
+ * start right after the last archived block. Blocks below the first block of the main file are read
+ * from the archive transparently.
  */
 
 class block_log
@@ -42,17 +68,46 @@ public:
     block_log();
     ~block_log();
 
+    /**
+     * Open and close unmap blocks served before, views returned by read_serialized_block_by_num are
+     * invalidated. They wait for mapped reads in progress, but must not be called while other threads
+     * may start new reads.
+     */
     void open(const fc::path& file);
     void close();
     bool is_open() const;
 
     static fc::path block_log_index_path(const fc::path& block_log_file);
 
+    /**
+     * Set the way index is reconstructed on open if it is missing or inconsistent.
+     * @param threads_count number of validating threads for parallel mode, 0 means hardware concurrency
+     */
+    void set_index_rebuild_mode(index_rebuild_mode mode, uint32_t threads_count = 0);
+
+    /**
+     * Rewrite index file of block log.
+     * @return number of blocks in block log
+     */
+    static uint32_t
+    rebuild_index(const fc::path& block_log_file, index_rebuild_mode mode, uint32_t threads_count = 0);
+
     uint64_t append(const signed_block& b);
     void flush();
     std::pair<signed_block, uint64_t> read_block(uint64_t file_pos) const;
     optional<signed_block> read_block_by_num(uint32_t block_num) const;
 
+    /**
+     * Return view of serialized block from the memory mapped block log without copying or
+     * deserialization. Only blocks that were flushed are available.
+     */
+    optional<serialized_block_view> read_serialized_block_by_num(uint32_t block_num) const;
+
+    /**
+     * Return copy of serialized block regardless of where it is stored.
+     */
+    optional<std::vector<char>> read_packed_block_by_num(uint32_t block_num) const;
+
     /**
      * Return offset of block in file, or block_log::npos if it does not exist.
      */
@@ -0,0 +1,93 @@
+#pragma once
+#include <fc/filesystem.hpp>
+#include <scorum/protocol/block.hpp>
+
+namespace scorum {
+namespace chain {
+
+using namespace scorum::protocol;
+
+namespace detail {
+class compressed_block_log_impl;
+}
+
+/* The compressed block log is a read optimized archive of irreversible blocks. Blocks are grouped
+ * into chunks of fixed number of blocks and every chunk is compressed with zlib, optionally using
+ * a preset dictionary stored in the file header. The secondary index file holds an 8 byte position
+ * of every chunk so that block lookup by number stays O(1).
+ *
+ * main file:
+ * +--------+------------------+----------------+------------+-----+------------+
+ * | magic  | blocks per chunk | dictionary len | dictionary | Ch1 | Ch2 ...    |
+ * +--------+------------------+----------------+------------+-----+------------+
+ *
+ * chunk:
+ * +-------------+----------+-----------------+------------------------------------------+
+ * | block count | raw size | compressed size | compressed(block end offsets, blocks...) |
+ * +-------------+----------+-----------------+------------------------------------------+
+ *
+ * index file:
+ * +------+------+------+-----+
+ * | Pos1 | Pos2 | Pos3 | ... |
+ * +------+------+------+-----+
+ *
+ * The archive is written once (see programs/util/convert_block_log) and is immutable afterwards.
+ * Only the last chunk may hold less than blocks per chunk blocks.
+ */
+
+class compressed_block_log
+{
+public:
+    static const uint32_t default_blocks_per_chunk = 256;
+    static const size_t max_dictionary_size = 32 * 1024;
+
+    compressed_block_log();
+    ~compressed_block_log();
+
+    /**
+     * Open existing archive for reading.
+     */
+    void open(const fc::path& file);
+
+    /**
+     * Create new archive for writing, existing files are truncated.
+     */
+    void create(const fc::path& file,
+                uint32_t blocks_per_chunk = default_blocks_per_chunk,
+                int compression_level = 9,
+                const std::vector<char>& dictionary = std::vector<char>());
+
+    /**
+     * Finish pending chunk (if archive was created) and close files.
+     */
+    void close();
+    bool is_open() const;
+
+    static fc::path compressed_block_log_path(const fc::path& block_log_file);
+    static fc::path compressed_block_log_index_path(const fc::path& file);
+
+    /**
+     * Build preset dictionary from sample blocks. Samples placed last are preferred by zlib,
+     * so the most representative samples should go last.
+     */
+    static std::vector<char> build_dictionary(const std::vector<std::vector<char>>& samples,
+                                              size_t max_size = max_dictionary_size);
+
+    void append(const signed_block& b);
+
+    optional<signed_block> read_block_by_num(uint32_t block_num) const;
+
+    /**
+     * Return serialized block copied from decompressed chunk.
+     */
+    optional<std::vector<char>> read_packed_block_by_num(uint32_t block_num) const;
+
+    uint32_t head_block_num() const;
+    const optional<signed_block>& head() const;
+    uint32_t blocks_per_chunk() const;
+
+private:
+    std::unique_ptr<detail::compressed_block_log_impl> my;
+};
+}
+}
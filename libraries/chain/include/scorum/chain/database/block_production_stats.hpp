@@ -0,0 +1,55 @@
+#pragma once
+
+#include <fc/reflect/reflect.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace scorum {
+namespace chain {
+
+/**
+ * Counts of durations by buckets. Bucket i counts durations up to bounds[i] microseconds, the last bucket
+ * counts durations longer than the last bound.
+ */
+struct latency_histogram
+{
+    latency_histogram()
+        : bounds{ 1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000, 500000, 1000000 }
+        , counts(bounds.size() + 1, 0)
+    {
+    }
+
+    void add(uint64_t microseconds)
+    {
+        auto it = std::lower_bound(bounds.begin(), bounds.end(), microseconds);
+        ++counts[std::distance(bounds.begin(), it)];
+
+        last = microseconds;
+        max = std::max(max, microseconds);
+    }
+
+    std::vector<uint64_t> bounds;
+    std::vector<uint64_t> counts;
+    uint64_t last = 0;
+    uint64_t max = 0;
+};
+
+struct block_production_stats
+{
+    /// blocks made of pending transactions already applied in order of arrival
+    uint64_t speculative_blocks = 0;
+    /// blocks made by applying pending transactions again, if the candidate was not valid for the slot
+    uint64_t rebuilt_blocks = 0;
+
+    /// selection of transactions of the block
+    latency_histogram assembly;
+    /// whole production including push of the block
+    latency_histogram production;
+};
+}
+}
+
+FC_REFLECT(scorum::chain::latency_histogram, (bounds)(counts)(last)(max))
+
+FC_REFLECT(scorum::chain::block_production_stats, (speculative_blocks)(rebuilt_blocks)(assembly)(production))
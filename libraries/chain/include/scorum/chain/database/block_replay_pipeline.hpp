@@ -0,0 +1,92 @@
+#pragma once
+
+#include <scorum/protocol/block.hpp>
+
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace scorum {
+namespace utils {
+class thread_pool;
+}
+namespace chain {
+
+class block_log;
+
+using scorum::protocol::signed_block;
+using scorum::protocol::block_id_type;
+using scorum::protocol::checksum_type;
+using scorum::protocol::transaction_id_type;
+
+/**
+ * Block read from block log with all pure (state independent) hashes calculated in advance.
+ */
+struct prefetched_block
+{
+    signed_block block;
+    block_id_type id;
+    checksum_type merkle_root;
+    std::vector<transaction_id_type> trx_ids;
+    uint32_t operations_count = 0;
+};
+
+/**
+ * @brief Prefetches blocks from block log for replay.
+ *
+ * The reader stage sequentially reads serialized blocks from block log (from memory mapped file
+ * or compressed archive, see block_log::read_packed_block_by_num) and the worker pool
+ * deserializes them and calculates block ids, transaction ids and merkle roots. Blocks are
+ * returned strictly in block number order by next(). The number of blocks that are read
+ * but not consumed yet is bounded by queue capacity.
+ */
+class block_replay_pipeline
+{
+public:
+    block_replay_pipeline(const block_log& log,
+                          uint32_t last_block_num,
+                          uint32_t threads_count,
+                          uint32_t queue_capacity = 0);
+    ~block_replay_pipeline();
+
+    void start();
+    void stop();
+
+    /**
+     * Waits for the next block in order.
+     * @return false if there are no more blocks to replay
+     * @throw rethrows exception occurred in the reader or worker threads
+     */
+    bool next(prefetched_block& result);
+
+    uint32_t threads_count() const;
+    uint32_t queue_capacity() const;
+
+private:
+    void read_loop();
+    void prepare(uint32_t block_num, std::shared_ptr<std::vector<char>> data);
+    void set_error(std::exception_ptr error);
+
+    const block_log& _block_log;
+    const uint32_t _last_block_num;
+    const uint32_t _threads_count;
+    const uint32_t _queue_capacity;
+
+    std::unique_ptr<utils::thread_pool> _pool;
+    std::thread _reader;
+
+    std::mutex _mutex;
+    std::condition_variable _ready_cv;
+    std::condition_variable _capacity_cv;
+
+    std::map<uint32_t, prefetched_block> _ready;
+    uint32_t _next_block_num = 1;
+    uint32_t _in_flight = 0;
+    bool _stopped = false;
+    std::exception_ptr _error;
+};
+}
+}
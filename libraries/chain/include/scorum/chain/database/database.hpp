@@ -16,6 +16,10 @@
 #include <scorum/chain/data_service_factory.hpp>
 
 #include <scorum/chain/database/database_virtual_operations.hpp>
+#include <scorum/chain/database/block_production_stats.hpp>
+#include <scorum/chain/database/pending_transaction_pool.hpp>
+#include <scorum/chain/database/state_digest.hpp>
+#include <scorum/chain/database/state_snapshot.hpp>
 
 #include <fc/signals.hpp>
 #include <fc/shared_string.hpp>
@@ -25,6 +29,9 @@
 #include <memory>
 
 namespace scorum {
+namespace utils {
+class thread_pool;
+}
 namespace chain {
 
 using scorum::protocol::asset;
@@ -34,6 +41,9 @@ using scorum::protocol::operation;
 using scorum::protocol::signed_transaction;
 
 class database_impl;
+struct prefetched_block;
+class recovered_signature_keys;
+class prevalidated_transactions;
 
 struct genesis_state_type;
 struct genesis_persistent_state_type;
@@ -85,7 +95,7 @@ public:
         skip_witness_schedule_check = 1 << 9, ///< used while reindexing
         skip_validate = 1 << 10, ///< used prior to checkpoint, skips validate() call on transaction
         skip_validate_invariants = 1 << 11, ///< used to skip database invariant check on block application
-        skip_undo_block = 1 << 12, ///< used to skip undo db on reindex
+        skip_undo_block = 1 << 12, ///< used to skip undo db on reindex and for blocks known to be irreversible
         skip_block_log = 1 << 13 ///< used to skip block logging on reindex
     };
 
@@ -129,6 +139,19 @@ public:
 
     void close();
 
+    /**
+     * @brief Write all indexes into portable state snapshot at head block
+     */
+    void export_state_snapshot(const fc::path& snapshot_file);
+
+    /**
+     * @brief Replace state of database opened on empty shared memory by state snapshot
+     *
+     * Indexes are loaded by threads_count threads. Block log must contain snapshot block, blocks following it
+     * are replayed with skip_flags, so the node continues syncing from the block log head.
+     */
+    void import_state_snapshot(const fc::path& snapshot_file, uint32_t threads_count, uint32_t skip_flags);
+
     time_point_sec get_genesis_time() const;
 
     //////////////////// db_block.cpp ////////////////////
@@ -172,6 +195,19 @@ public:
 
     void _push_transaction(const signed_transaction& trx);
 
+    /// applies transaction reusing its previous authority verification if authorities it has read are unchanged
+    void _push_transaction(pending_transaction&& trx);
+
+    /**
+     * Applies transactions of pending state again after block was pushed, reusing their authority verification.
+     *
+     * Every kept transaction is evaluated again: pending undo session is discarded before the block is applied,
+     * and chainbase does not track objects read by evaluators, so there is no read set to skip unaffected ones.
+     * Only expired and included transactions are dropped without evaluation, and signatures are verified again
+     * only for transactions which authorities are changed by the block.
+     */
+    void _restore_pending_transactions(pending_transaction_pool::container_type&& transactions);
+
     signed_block generate_block(const fc::time_point_sec when,
                                 const account_name_type& witness_owner,
                                 const fc::ecc::private_key& block_signing_private_key,
@@ -180,6 +216,24 @@ public:
     void pop_block();
     void clear_pending();
 
+    /**
+     * @brief Limits count and size of pending transactions and count of pending transactions per account.
+     * Transactions over limits are rejected on push, on rebuild of pending state the earliest expiring are evicted.
+     */
+    void set_pending_transaction_limits(const pending_transaction_limits& limits);
+
+    /**
+     * @brief Returns size of pending transactions pool and counters of its rebuilds after blocks:
+     * verifications done and reused, transactions dropped as expired, included or invalid.
+     */
+    pending_transaction_stats get_pending_transaction_stats() const;
+
+    /**
+     * @brief Returns counts of blocks generated from the block candidate of pending state and by applying
+     * pending transactions again, with histograms of generation latency.
+     */
+    block_production_stats get_block_production_stats() const;
+
     /**
      *  This method is used to track applied operations during the evaluation of a block, these
      *  operations should include any operation actually included in a transaction as well
@@ -196,6 +250,7 @@ public:
 
     void notify_pre_applied_block(const signed_block& block);
     void notify_applied_block(const signed_block& block);
+    void notify_head_block_changed();
     void notify_on_pending_transaction(const signed_transaction& tx);
     void notify_on_pre_apply_transaction(const signed_transaction& tx);
     void notify_on_applied_transaction(const signed_transaction& tx);
@@ -217,6 +272,13 @@ public:
      */
     fc::signal<void(const signed_block&)> applied_block;
 
+    /**
+     *  This signal is emitted when push_block or pop_block has changed head block, after undo session of
+     *  the block is pushed (or undone) and before pending transactions are applied again. Fork switch is
+     *  reported once, blocks applied by reindex or snapshot replay are not reported.
+     */
+    fc::signal<void()> head_block_changed;
+
     /**
      * This signal is emitted any time a new transaction is added to the pending
      * block state.
@@ -313,14 +375,104 @@ public:
 
     void validate_invariants() const;
 
+    /**
+     * @brief Schedules background flush of shared memory file every flush_blocks applied blocks.
+     * Blocks applied by reindex are counted as well, so long replays are flushed in the background too.
+     */
     void set_flush_interval(uint32_t flush_blocks);
+
+    /**
+     * @brief Enables pipelined replay. Blocks are prefetched, deserialized and hashed by
+     * worker threads while the current block is applied. Zero disables pipeline.
+     */
+    void set_replay_threads(uint32_t replay_threads);
+
+    /**
+     * @brief Enables recovery of transaction signature keys and validation of transaction operations of pushed
+     * blocks by the pool of worker threads before write lock is acquired. Zero disables it.
+     */
+    void set_signature_threads(uint32_t signature_threads);
+
     void show_free_memory(bool force);
 
+    /**
+     * @brief Enables logging of per index memory usage (objects, dynamic members and undo history)
+     * every memory_stats_blocks blocks. Zero disables it.
+     */
+    void set_memory_stats_interval(uint32_t memory_stats_blocks);
+
+    void show_index_memory() const;
+
+    /**
+     * @brief Enables digest of state maintained by every index on each change of its objects and its logging
+     * every state_digest_blocks blocks. Must be set before open, zero disables it.
+     */
+    void set_state_digest_interval(uint32_t state_digest_blocks);
+
+    /**
+     * @brief Returns digest of state at the head block combined from digests of indexes. It is taken when
+     * the head block is applied or popped, so pending transactions are not included.
+     * @throw fc::assert_exception if state digest is disabled
+     */
+    state_digest get_state_digest() const;
+
+    /**
+     * @brief Enables growth of shared memory file between blocks. When used memory exceeds full_threshold
+     * (in SCORUM_100_PERCENT units) the file is grown by scale_rate of its size. Zero threshold disables it.
+     */
+    void set_shared_file_autoscale(uint16_t full_threshold, uint16_t scale_rate);
+
+    /**
+     * @brief Sets huge pages, access advice, NUMA policy and prefault of shared memory file mapping
+     * used by following open.
+     */
+    void set_shared_file_mapping(const chainbase::mapping_options& options);
+
+    /**
+     * @brief Rewrites all indexes into a fresh densely packed shared memory file reclaiming fragmented memory.
+     * Must be called after open when there is no undo history.
+     */
+    void compact_shared_memory();
+
     // index
 
+    /**
+     * Adds index to chainbase and registers it as state snapshot section. Optional sections
+     * may be absent in snapshot.
+     */
+    template <typename MultiIndexType>
+    const chainbase::generic_index<MultiIndexType>& add_index(bool optional_in_snapshot = false)
+    {
+        using index_type = chainbase::generic_index<MultiIndexType>;
+        using value_type = typename index_type::value_type;
+
+        const index_type& index = chainbase::database::add_index<MultiIndexType>();
+
+        snapshot_index_handlers handlers;
+        handlers.optional = optional_in_snapshot;
+        handlers.save = [this, optional_in_snapshot](state_snapshot_writer& writer, const std::string& name) {
+            writer.write_section(name, optional_in_snapshot, this->get_index<MultiIndexType>());
+        };
+        handlers.load = [this](const state_snapshot_reader& reader, const state_snapshot_section* section) {
+            auto& idx = this->get_mutable_index<MultiIndexType>();
+            idx.clear(section ? section->next_id : 0);
+
+            if (!section)
+                return;
+
+            reader.read_section(*section, [&](fc::datastream<const char*>& ds) {
+                idx.insert([&](value_type& obj) { fc::raw::unpack(ds, obj); });
+            });
+        };
+
+        _snapshot_indexes[boost::core::demangle(typeid(value_type).name())] = handlers;
+
+        return index;
+    }
+
     template <typename MultiIndexType> void add_plugin_index()
     {
-        _plugin_index_signal.connect([this]() { this->add_index<MultiIndexType>(); });
+        _plugin_index_signal.connect([this]() { this->add_index<MultiIndexType>(true); });
     }
 
     const genesis_persistent_state_type& genesis_persistent_state() const;
@@ -335,6 +487,9 @@ private:
 
     void _maybe_warn_multiple_production(uint32_t height) const;
     bool _push_block(const signed_block& b);
+    void _pop_block();
+    bool _is_irreversible_block(const signed_block& b, uint32_t skip) const;
+    void _apply_irreversible_block(const signed_block& b, uint32_t skip);
 
     signed_block _generate_block(const fc::time_point_sec when,
                                  const account_name_type& witness_owner,
@@ -352,6 +507,19 @@ protected:
     void _apply_transaction(const signed_transaction& trx);
     void apply_operation(const operation& op);
 
+    void verify_transaction_authority(const signed_transaction& trx);
+    bool is_authority_unchanged(const std::vector<authority_read>& authorities) const;
+
+    /// These return hashes precomputed by replay pipeline if it's possible
+    ///@{
+    block_id_type get_block_id(const signed_block& b) const;
+    checksum_type get_merkle_root(const signed_block& b) const;
+    transaction_id_type get_transaction_id(const signed_transaction& trx) const;
+    ///@}
+
+    /// Return keys recovered in advance by signature threads if it's possible
+    flat_set<public_key_type> get_signature_keys(const signed_transaction& trx) const;
+
     /// Steps involved in applying a new block
     ///@{
 
@@ -361,6 +529,8 @@ protected:
     void update_global_dynamic_data(const signed_block& b);
     void update_signing_witness(const witness_object& signing_witness, const signed_block& new_block);
     void update_last_irreversible_block();
+    void check_free_memory();
+    void update_state_digest();
     void clear_expired_transactions();
     void clear_expired_delegations();
     void process_header_extensions(const signed_block& next_block);
@@ -378,7 +548,10 @@ private:
 
     optional<chainbase::abstract_undo_session_ptr> _pending_tx_session;
 
-    std::vector<signed_transaction> _pending_tx;
+    pending_transaction_pool _pending_tx;
+    /// pending transaction being applied, its verification is reused or recorded
+    pending_transaction* _pending_verification = nullptr;
+    block_production_stats _block_production_stats;
     fork_database _fork_db;
     fc::time_point_sec _hardfork_times[SCORUM_NUM_HARDFORKS + 1];
     protocol::hardfork_version _hardfork_versions[SCORUM_NUM_HARDFORKS + 1];
@@ -387,6 +560,15 @@ private:
 
     fc::signal<void()> _plugin_index_signal;
 
+    struct snapshot_index_handlers
+    {
+        bool optional = false;
+        std::function<void(state_snapshot_writer&, const std::string&)> save;
+        std::function<void(const state_snapshot_reader&, const state_snapshot_section*)> load;
+    };
+
+    std::map<std::string, snapshot_index_handlers> _snapshot_indexes;
+
     transaction_id_type _current_trx_id;
     uint32_t _current_block_num = 0;
     uint16_t _current_trx_in_block = 0;
@@ -394,12 +576,30 @@ private:
 
     flat_map<uint32_t, block_id_type> _checkpoints;
 
+    /// set when irreversible block fails to apply, its changes can't be undone, so state must be replayed
+    bool _state_corrupted = false;
+
     node_property_object _node_property_object;
 
     uint32_t _flush_blocks = 0;
     uint32_t _next_flush_block = 0;
 
+    uint32_t _replay_threads = 0;
+    const prefetched_block* _prefetched_block = nullptr;
+
+    std::unique_ptr<utils::thread_pool> _signature_pool;
+    const recovered_signature_keys* _recovered_signature_keys = nullptr;
+    const prevalidated_transactions* _prevalidated_transactions = nullptr;
+
     uint32_t _last_free_gb_printed = 0;
+    uint32_t _memory_stats_blocks = 0;
+    uint32_t _state_digest_blocks = 0;
+    state_digest _state_digest;
+
+    uint16_t _shared_file_full_threshold = 0;
+    uint16_t _shared_file_scale_rate = 0;
+
+    chainbase::mapping_options _shared_file_mapping;
 
     fc::time_point_sec _const_genesis_time; // should be const
 };
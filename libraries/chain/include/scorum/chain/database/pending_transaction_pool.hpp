@@ -0,0 +1,185 @@
+#pragma once
+
+#include <scorum/protocol/authority.hpp>
+#include <scorum/protocol/transaction.hpp>
+
+#include <fc/reflect/reflect.hpp>
+
+#include <list>
+#include <map>
+#include <vector>
+
+namespace scorum {
+namespace chain {
+
+using scorum::protocol::account_name_type;
+using scorum::protocol::authority;
+using scorum::protocol::block_id_type;
+using scorum::protocol::public_key_type;
+using scorum::protocol::signed_transaction;
+using scorum::protocol::transaction_id_type;
+
+/**
+ * Authority of account read by verification of transaction signatures.
+ */
+struct authority_read
+{
+    account_name_type account;
+    authority::classification classification = authority::active;
+    authority value;
+};
+
+/**
+ * Transaction of pending state with the result of its authority verification.
+ *
+ * Verification depends on signatures of transaction and authorities it has read only, so it is not repeated
+ * when pending state is rebuilt after a block while none of these authorities is changed by the block.
+ */
+struct pending_transaction
+{
+    pending_transaction() = default;
+    pending_transaction(const signed_transaction& trx_, const transaction_id_type& id_);
+
+    signed_transaction trx;
+    transaction_id_type id;
+
+    /// packed size of transaction
+    size_t pack_size = 0;
+    /// account which authority the first operation requires, transactions of pool are limited per this account
+    account_name_type account;
+
+    bool verified = false;
+    fc::flat_set<public_key_type> signature_keys;
+    std::vector<authority_read> authorities;
+};
+
+/**
+ * Limits of pending transactions pool, zero means unlimited.
+ */
+struct pending_transaction_limits
+{
+    uint32_t max_count = 0;
+    uint64_t max_bytes = 0;
+    uint32_t max_per_account = 0;
+};
+
+/**
+ * Prefix of pending transactions which makes the next block.
+ *
+ * Pending transactions are applied in order of arrival to the state of the head block, the same way a block
+ * applies them, so the prefix which fits into the block is the block ready to be produced. It is extended on
+ * every push until the first transaction which does not fit, later transactions are postponed to next blocks.
+ */
+struct pending_block_candidate
+{
+    /// block which state transactions are applied to
+    block_id_type head_block_id;
+    /// maximum size of transactions of the block
+    uint64_t capacity = 0;
+
+    size_t count = 0;
+    uint64_t bytes = 0;
+    fc::time_point_sec min_expiration = fc::time_point_sec::maximum();
+
+    /// false if pending state was not started from the head block with the empty pool
+    bool valid = false;
+    /// true after a transaction did not fit into the block
+    bool closed = false;
+};
+
+struct pending_transaction_stats
+{
+    uint64_t pending = 0;
+    uint64_t pending_bytes = 0;
+
+    /// rebuilds of pending state after push_block, every kept transaction is evaluated again
+    uint64_t restores = 0;
+    uint64_t last_restore_microseconds = 0;
+    uint64_t max_restore_microseconds = 0;
+
+    uint64_t full_verifications = 0;
+    uint64_t reused_verifications = 0;
+
+    uint64_t dropped_expired = 0;
+    uint64_t dropped_included = 0;
+    uint64_t dropped_invalid = 0;
+
+    /// transactions rejected on push because pool or account limit was reached
+    uint64_t rejected = 0;
+    /// transactions evicted in order of expiration when pending state was rebuilt over limits
+    uint64_t evicted = 0;
+};
+
+/**
+ * Transactions applied to pending state in order of their application, indexed by id and account.
+ *
+ * Pending state is a single undo session, so a transaction can not be removed from it alone. The pool is kept
+ * within limits by rejecting new transactions when it is full and by evicting the earliest expiring ones when
+ * pending state is rebuilt after a block.
+ */
+class pending_transaction_pool
+{
+public:
+    using container_type = std::list<pending_transaction>;
+
+    void set_limits(const pending_transaction_limits& limits);
+    const pending_transaction_limits& limits() const;
+
+    /// @throw fc::assert_exception if transaction exceeds limits of the pool
+    void check_admission(const pending_transaction& trx) const;
+
+    void push(pending_transaction&& trx);
+
+    /// starts block candidate for pending state started from the head block
+    void open_candidate(const block_id_type& head_block_id, uint64_t capacity);
+    const pending_block_candidate& candidate() const;
+
+    /// removes all transactions and returns them in order of application to be applied again
+    container_type take();
+
+    /**
+     * Removes the earliest expiring transactions from candidates to be applied again, so that the rest fits
+     * into the pool together with transactions it already has.
+     * @return number of evicted transactions
+     */
+    size_t evict_by_expiration(container_type& candidates) const;
+
+    void clear();
+
+    bool contains(const transaction_id_type& id) const;
+    size_t count_by_account(const account_name_type& account) const;
+
+    container_type& transactions();
+    const container_type& transactions() const;
+
+    size_t size() const;
+    uint64_t bytes() const;
+    bool empty() const;
+
+    pending_transaction_stats& stats();
+    pending_transaction_stats get_stats() const;
+
+private:
+    container_type _transactions;
+    /// id does not cover signatures, so the same body signed differently may be pushed with dupe check skipped
+    std::multimap<transaction_id_type, container_type::iterator> _by_id;
+    std::map<account_name_type, uint32_t> _by_account;
+    uint64_t _bytes = 0;
+
+    pending_block_candidate _candidate;
+
+    pending_transaction_limits _limits;
+    pending_transaction_stats _stats;
+};
+}
+}
+
+FC_REFLECT(scorum::chain::pending_transaction_limits, (max_count)(max_bytes)(max_per_account))
+
+FC_REFLECT(scorum::chain::pending_block_candidate,
+           (head_block_id)(capacity)(count)(bytes)(min_expiration)(valid)(closed))
+
+FC_REFLECT(scorum::chain::pending_transaction_stats,
+           (pending)(pending_bytes)(restores)(last_restore_microseconds)(max_restore_microseconds)(
+               full_verifications)(reused_verifications)(dropped_expired)(dropped_included)(dropped_invalid)(
+               rejected)(evicted))
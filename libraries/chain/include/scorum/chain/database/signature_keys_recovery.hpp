@@ -0,0 +1,41 @@
+#pragma once
+
+#include <scorum/protocol/block.hpp>
+
+#include <exception>
+#include <vector>
+
+namespace scorum {
+namespace utils {
+class thread_pool;
+}
+namespace chain {
+
+using scorum::protocol::chain_id_type;
+using scorum::protocol::public_key_type;
+using scorum::protocol::signed_block;
+using scorum::protocol::signed_transaction;
+
+/**
+ * Public keys recovered from signatures of all transactions of a block in advance.
+ */
+class recovered_signature_keys
+{
+public:
+    recovered_signature_keys(const signed_block& block, const chain_id_type& chain_id, utils::thread_pool& pool);
+
+    const signed_block& block() const;
+
+    /**
+     * @return keys of transaction if it belongs to the block or nullptr otherwise
+     * @throw rethrows exception occurred during recovery of the transaction signatures
+     */
+    const fc::flat_set<public_key_type>* find(const signed_transaction& trx) const;
+
+private:
+    const signed_block& _block;
+    std::vector<fc::flat_set<public_key_type>> _keys;
+    std::vector<std::exception_ptr> _errors;
+};
+}
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <scorum/protocol/types.hpp>
+
+#include <chainbase/index_digest.hpp>
+
+#include <fc/reflect/reflect.hpp>
+
+#include <vector>
+
+namespace scorum {
+namespace chain {
+
+using scorum::protocol::block_id_type;
+
+/**
+ * Digest of chain state at the head block. It is combined from digests of objects of indexes which are
+ * not optional in state snapshot, so it does not depend on plugins enabled on the node. Digests of all
+ * indexes are listed to find the diverged one.
+ */
+struct state_digest
+{
+    uint32_t block_num = 0;
+    block_id_type block_id;
+    fc::sha256 digest;
+    std::vector<chainbase::index_digest> indexes;
+};
+}
+}
+
+FC_REFLECT(scorum::chain::state_digest, (block_num)(block_id)(digest)(indexes))
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <fc/filesystem.hpp>
+#include <fc/io/datastream.hpp>
+#include <fc/io/raw.hpp>
+
+#include <scorum/protocol/types.hpp>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace scorum {
+namespace chain {
+
+using scorum::protocol::chain_id_type;
+using scorum::protocol::block_id_type;
+
+namespace detail {
+class state_snapshot_writer_impl;
+class state_snapshot_reader_impl;
+}
+
+/* State snapshot is a portable image of all indexes at some block. Objects are packed by fc::raw in order
+ * of their ids, so unlike shared memory file the snapshot does not depend on compiler, build or memory layout.
+ * Every index is stored in its own section. Objects of a section are grouped into chunks compressed with zlib,
+ * every chunk is protected by crc32 of its raw content.
+ *
+ * file:
+ * +-------+---------+--------+-----------+-----+-----------+---------------+----------------+
+ * | magic | version | header | section 1 | ... | section N | section table | table position |
+ * +-------+---------+--------+-----------+-----+-----------+---------------+----------------+
+ *
+ * section:
+ * +---------+---------+-----+-------------+
+ * | chunk 1 | chunk 2 | ... | empty chunk |
+ * +---------+---------+-----+-------------+
+ *
+ * chunk:
+ * +--------------+----------+-----------------+-------+----------------------------+
+ * | object count | raw size | compressed size | crc32 | compressed(packed objects) |
+ * +--------------+----------+-----------------+-------+----------------------------+
+ *
+ * Fixed size fields (magic, version, sizes, positions and chunk headers) are packed by fc::raw too, so they are
+ * read back field by field with the same byte order as objects, independently of struct layout.
+ *
+ * The section table holds position of every section, so sections can be read by several threads at once.
+ * Sections of plugin indexes are marked as optional and can be skipped by nodes without these plugins.
+ */
+
+struct state_snapshot_header
+{
+    chain_id_type chain_id;
+    uint32_t head_block_num = 0;
+    block_id_type head_block_id;
+};
+
+struct state_snapshot_section
+{
+    std::string name;
+    bool optional = false;
+    uint64_t position = 0;
+    uint64_t objects = 0;
+    int64_t next_id = 0;
+};
+
+class state_snapshot_writer
+{
+public:
+    static const uint32_t default_chunk_size = 1024 * 1024;
+
+    state_snapshot_writer(const fc::path& file,
+                          const state_snapshot_header& header,
+                          uint32_t chunk_size = default_chunk_size,
+                          int compression_level = 6);
+    ~state_snapshot_writer();
+
+    template <typename IndexType> void write_section(const std::string& name, bool optional, const IndexType& index)
+    {
+        begin_section(name, optional, index.next_id()._id);
+
+        for (const auto& obj : index.indices())
+        {
+            std::vector<char>& buffer = chunk_buffer();
+
+            const size_t pos = buffer.size();
+            buffer.resize(pos + fc::raw::pack_size(obj));
+
+            fc::datastream<char*> ds(buffer.data() + pos, buffer.size() - pos);
+            fc::raw::pack(ds, obj);
+
+            object_packed();
+        }
+
+        end_section();
+    }
+
+    /**
+     * Writes section table, the snapshot is not readable until this call.
+     */
+    void finish();
+
+private:
+    void begin_section(const std::string& name, bool optional, int64_t next_id);
+    std::vector<char>& chunk_buffer();
+    void object_packed();
+    void end_section();
+
+    std::unique_ptr<detail::state_snapshot_writer_impl> my;
+};
+
+class state_snapshot_reader
+{
+public:
+    using object_loader = std::function<void(fc::datastream<const char*>&)>;
+
+    explicit state_snapshot_reader(const fc::path& file);
+    ~state_snapshot_reader();
+
+    const state_snapshot_header& header() const;
+    const std::vector<state_snapshot_section>& sections() const;
+
+    /**
+     * Calls loader for every object of section. Every call opens its own stream,
+     * so different sections can be read concurrently.
+     */
+    void read_section(const state_snapshot_section& section, const object_loader& loader) const;
+
+private:
+    std::unique_ptr<detail::state_snapshot_reader_impl> my;
+};
+}
+}
+
+FC_REFLECT(scorum::chain::state_snapshot_header, (chain_id)(head_block_num)(head_block_id))
+FC_REFLECT(scorum::chain::state_snapshot_section, (name)(optional)(position)(objects)(next_id))
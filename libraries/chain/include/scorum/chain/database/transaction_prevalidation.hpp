@@ -0,0 +1,48 @@
+#pragma once
+
+#include <scorum/protocol/block.hpp>
+
+#include <exception>
+#include <vector>
+
+namespace scorum {
+namespace utils {
+class thread_pool;
+}
+namespace chain {
+
+using scorum::protocol::signed_block;
+using scorum::protocol::signed_transaction;
+using scorum::protocol::transaction_id_type;
+
+/**
+ * Transactions of a block checked in advance by state independent validation of their operations.
+ *
+ * Errors are kept per transaction and rethrown when the transaction is applied, so a block fails at
+ * the same transaction and with the same exception as by sequential validation.
+ */
+class prevalidated_transactions
+{
+public:
+    prevalidated_transactions(const signed_block& block, utils::thread_pool& pool);
+
+    const signed_block& block() const;
+
+    /**
+     * @return false if transaction does not belong to the block
+     * @throw rethrows exception occurred during validation of the transaction
+     */
+    bool check(const signed_transaction& trx) const;
+
+    /// @return id of transaction if it belongs to the block or nullptr otherwise
+    const transaction_id_type* find_id(const signed_transaction& trx) const;
+
+private:
+    bool contains(const signed_transaction& trx) const;
+
+    const signed_block& _block;
+    std::vector<transaction_id_type> _ids;
+    std::vector<std::exception_ptr> _errors;
+};
+}
+}
@@ -49,7 +49,7 @@ struct skip_flags_restorer
  */
 struct pending_transactions_restorer
 {
-    pending_transactions_restorer(database& db, std::vector<signed_transaction>&& pending_transactions)
+    pending_transactions_restorer(database& db, pending_transaction_pool::container_type&& pending_transactions)
         : _db(db)
         , _pending_transactions(std::move(pending_transactions))
     {
@@ -74,39 +74,14 @@ struct pending_transactions_restorer
             }
         }
         _db._popped_tx.clear();
-        for (const signed_transaction& tx : _pending_transactions)
-        {
-            try
-            {
-                if (!_db.is_known_transaction(tx.id()))
-                {
-                    // since push_transaction() takes a signed_transaction,
-                    // the operation_results field will be ignored.
-                    _db._push_transaction(tx);
-                }
-            }
-            catch (const transaction_exception& e)
-            {
-                dlog("Pending transaction became invalid after switching to block ${b} ${n} ${t}",
-                     ("b", _db.head_block_id())("n", _db.head_block_num())("t", _db.head_block_time()));
-                dlog("The invalid transaction caused exception ${e}", ("e", e.to_detail_string()));
-                dlog("${t}", ("t", tx));
-            }
-            catch (const fc::exception& e)
-            {
 
-                /*
-                dlog( "Pending transaction became invalid after switching to block ${b} ${n} ${t}",
-                   ("b", _db.head_block_id())("n", _db.head_block_num())("t", _db.head_block_time()) );
-                dlog( "The invalid pending transaction caused exception ${e}", ("e", e.to_detail_string() ) );
-                dlog( "${t}", ("t", tx) );
-                */
-            }
-        }
+        // expired and included transactions are dropped in bulk, authority verification is repeated only
+        // for transactions which have read authorities changed by the block
+        _db._restore_pending_transactions(std::move(_pending_transactions));
     }
 
     database& _db;
-    std::vector<signed_transaction> _pending_transactions;
+    pending_transaction_pool::container_type _pending_transactions;
 };
 
 /**
@@ -130,7 +105,9 @@ template <typename Lambda> void with_skip_flags(database& db, uint32_t skip_flag
  * Pending transactions which no longer validate will be culled.
  */
 template <typename Lambda>
-void without_pending_transactions(database& db, std::vector<signed_transaction>&& pending_transactions, Lambda callback)
+void without_pending_transactions(database& db,
+                                  pending_transaction_pool::container_type&& pending_transactions,
+                                  Lambda callback)
 {
     pending_transactions_restorer restorer(db, std::move(pending_transactions));
     callback();
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
 #include <string>
 #include <typeinfo>
 
@@ -28,6 +29,9 @@ protected:
 public:
     template <typename ConcreteService> ConcreteService& obtain_service() const
     {
+        // services are created lazily and could be requested by API worker threads
+        std::lock_guard<std::recursive_mutex> lock(_dbs_mutex);
+
         auto it = _dbs.find(boost::typeindex::type_id<ConcreteService>());
         if (it == _dbs.end())
         {
@@ -42,6 +46,7 @@ public:
 
 private:
     mutable boost::container::flat_map<boost::typeindex::type_index, BaseServicePtr> _dbs;
+    mutable std::recursive_mutex _dbs_mutex;
     database& _db_core;
 };
 } // namespace chain
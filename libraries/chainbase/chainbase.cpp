@@ -46,7 +46,10 @@ boost::filesystem::path database::shared_memory_meta_path(const boost::filesyste
     return data_dir / "shared_memory.meta";
 }
 
-void database::open(const boost::filesystem::path& dir, uint32_t flags, uint64_t shared_file_size)
+void database::open(const boost::filesystem::path& dir,
+                    uint32_t flags,
+                    uint64_t shared_file_size,
+                    const mapping_options& options)
 {
     bool read_only = !(flags & database::read_write);
 
@@ -54,6 +57,8 @@ void database::open(const boost::filesystem::path& dir, uint32_t flags, uint64_t
 
     close();
 
+    _mapping_options = options;
+
     create_segment_file(shared_memory_path(dir), read_only, shared_file_size);
 
     create_meta_file(shared_memory_meta_path(dir));
@@ -69,14 +74,47 @@ void database::open(const boost::filesystem::path& dir, uint32_t flags, uint64_t
 
 void database::flush()
 {
+    if (_flusher)
+        _flusher->wait();
+
     flush_segment_file();
 
     if (_meta)
         _meta->flush();
 }
 
+void database::flush_async()
+{
+    if (!_flusher)
+    {
+        _flusher.reset(new segment_flusher(
+            [this](const std::function<void()>& callback) {
+                std::lock_guard<std::mutex> lock(_remap_mutex);
+                callback();
+            },
+            [this]() {
+                if (!_segment)
+                    return segment_flusher::region_type(nullptr, 0);
+                return segment_flusher::region_type(static_cast<char*>(_segment->get_address()),
+                                                    _segment->get_size());
+            }));
+    }
+
+    _flusher->request();
+}
+
+flush_stats database::get_flush_stats() const
+{
+    if (!_flusher)
+        return flush_stats();
+    return _flusher->get_stats();
+}
+
 void database::close()
 {
+    // background flush uses the mapping
+    _flusher.reset();
+
     close_segment_file();
 
     _meta.reset();
@@ -88,7 +126,46 @@ void database::wipe(const boost::filesystem::path& dir)
 
     boost::filesystem::remove_all(shared_memory_path(dir));
     boost::filesystem::remove_all(shared_memory_meta_path(dir));
-    _index_map.clear();
+    clear_indexes();
+}
+
+void database::resize(uint64_t new_shared_file_size)
+{
+    std::lock_guard<std::mutex> lock(_remap_mutex);
+
+    try
+    {
+        grow_segment_file(new_shared_file_size);
+    }
+    catch (...)
+    {
+        // segment is mapped again at its old size, pointers to the old mapping are invalid
+        if (_segment)
+            reattach_indexes();
+        throw;
+    }
+    reattach_indexes();
+}
+
+void database::compact()
+{
+    // the environment check is the only named object besides indexes
+    if (get_named_objects_count() != _index_map.size() + 1)
+        BOOST_THROW_EXCEPTION(std::logic_error("database contains indexes that are not added, they would be lost"));
+
+    std::lock_guard<std::mutex> lock(_remap_mutex);
+
+    try
+    {
+        rewrite_segment_file(get_index_copiers());
+    }
+    catch (...)
+    {
+        if (_segment)
+            reattach_indexes();
+        throw;
+    }
+    reattach_indexes();
 }
 
 } // namespace chainbase
@@ -31,6 +31,8 @@ uint32_t read_write_mutex_manager::current_lock_num()
 }
 
 //////////////////////////////////////////////////////////////////////////
+thread_local int32_t database_guard::_concurrent_read_depth = 0;
+
 database_guard::~database_guard()
 {
 }
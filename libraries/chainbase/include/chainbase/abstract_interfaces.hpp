@@ -4,6 +4,9 @@
 #include <vector>
 #include <boost/cstdint.hpp>
 
+#include <chainbase/index_digest.hpp>
+#include <chainbase/memory_stats.hpp>
+
 namespace chainbase {
 
 struct abstract_undo_session
@@ -30,5 +33,10 @@ struct abstract_generic_index_i
     virtual void undo_all() = 0;
     virtual void squash() = 0;
     virtual void commit(int64_t revision) = 0;
+
+    virtual index_memory_stats get_memory_stats(size_t max_samples) const = 0;
+
+    virtual void set_digest_enabled(bool enabled) = 0;
+    virtual index_digest get_digest() const = 0;
 };
 }
@@ -3,6 +3,9 @@
 #include <boost/filesystem.hpp>
 #include <boost/interprocess/sync/file_lock.hpp>
 
+#include <mutex>
+
+#include <chainbase/segment_flusher.hpp>
 #include <chainbase/undo_db_state.hpp>
 
 namespace chainbase {
@@ -13,6 +16,11 @@ class database : public undo_db_state
 
     std::unique_ptr<boost::interprocess::managed_mapped_file> _meta;
 
+    std::unique_ptr<segment_flusher> _flusher;
+
+    // held by background flush for a slice and by remapping, block processing locks are not taken by flush
+    std::mutex _remap_mutex;
+
 private:
     void check_dir_existance(const boost::filesystem::path& dir, bool read_only);
     void create_meta_file(const boost::filesystem::path& file);
@@ -29,10 +37,37 @@ public:
     static boost::filesystem::path shared_memory_path(const boost::filesystem::path& data_dir);
     static boost::filesystem::path shared_memory_meta_path(const boost::filesystem::path& data_dir);
 
-    void open(const boost::filesystem::path& dir, uint32_t write = read_only, uint64_t shared_file_size = 0);
+    void open(const boost::filesystem::path& dir,
+              uint32_t write = read_only,
+              uint64_t shared_file_size = 0,
+              const mapping_options& options = mapping_options());
     void close();
+
+    /**
+    * Flushes whole shared memory file synchronously, waits for background flush first.
+    */
     void flush();
+
+    /**
+    * Schedules flush of shared memory file by background thread. Slices of the file are flushed
+    * under the remap mutex only, so block processing is not blocked. Resize and compact wait for a slice.
+    */
+    void flush_async();
+
+    flush_stats get_flush_stats() const;
     void wipe(const boost::filesystem::path& dir);
+
+    /**
+    * Grows shared memory file without reopening the database. Segment is remapped, so references to objects
+    * and undo sessions must not be kept across the call. Undo history itself is kept.
+    */
+    void resize(uint64_t new_shared_file_size);
+
+    /**
+    * Rewrites all added indexes into a fresh densely packed shared memory file of the same size.
+    * All indexes in the file must be added and undo history must be empty.
+    */
+    void compact();
 };
 
 } // namespace chainbase
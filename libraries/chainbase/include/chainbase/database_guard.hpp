@@ -5,11 +5,11 @@
 #include <typeinfo>
 
 #include <boost/interprocess/sync/interprocess_sharable_mutex.hpp>
+#include <boost/interprocess/sync/scoped_lock.hpp>
 #include <boost/interprocess/sync/sharable_lock.hpp>
 #include <boost/thread/locks.hpp>
 
 #include <fc/exception/exception.hpp>
-#include <fc/scoped_increment.hpp>
 
 #ifndef CHAINBASE_NUM_RW_LOCKS
 #define CHAINBASE_NUM_RW_LOCKS 10
@@ -46,10 +46,33 @@ class database_guard
 protected:
     read_write_mutex_manager* _rw_manager = nullptr;
 
-    int32_t _read_lock_count = 0;
-    int32_t _write_lock_count = 0;
+    // locks are taken by the chain thread and by API worker threads at the same time
+    std::atomic<int32_t> _read_lock_count{ 0 };
+    std::atomic<int32_t> _write_lock_count{ 0 };
     bool _enable_require_locking = false;
 
+    // writer waits for concurrent readers unconditionally, it doesn't move to the next lock on timeout for them
+    read_write_mutex _concurrent_readers_mutex;
+    static thread_local int32_t _concurrent_read_depth;
+
+    class lock_counter
+    {
+    public:
+        explicit lock_counter(std::atomic<int32_t>& counter)
+            : _counter(counter)
+        {
+            ++_counter;
+        }
+
+        ~lock_counter()
+        {
+            --_counter;
+        }
+
+    private:
+        std::atomic<int32_t>& _counter;
+    };
+
 public:
     virtual ~database_guard();
 
@@ -69,7 +92,7 @@ public:
         FC_ASSERT(_rw_manager);
 
         read_lock lock(_rw_manager->current_lock(), boost::interprocess::defer_lock_type());
-        SCOPED_INCREMENT(_read_lock_count);
+        lock_counter counter(_read_lock_count);
 
         if (!wait_micro)
         {
@@ -94,7 +117,7 @@ public:
         FC_ASSERT(_rw_manager);
 
         write_lock lock(_rw_manager->current_lock(), boost::defer_lock_t());
-        SCOPED_INCREMENT(_write_lock_count);
+        lock_counter counter(_write_lock_count);
 
         if (!wait_micro)
         {
@@ -111,7 +134,41 @@ public:
             }
         }
 
+        boost::interprocess::scoped_lock<read_write_mutex> readers_lock(_concurrent_readers_mutex);
+
         return callback();
     }
+
+    /**
+    *  Read lock for threads other than the chain one. The writer moves to the next lock when a reader holds
+    *  the current one for too long, so such reader could run alongside it. Concurrent readers additionally
+    *  share a mutex the writer always waits for. Nested calls on the same thread don't take it again.
+    */
+    template <typename Lambda>
+    auto with_concurrent_read_lock(Lambda&& callback, uint64_t wait_micro = 1000000) -> decltype((*(Lambda*)nullptr)())
+    {
+        if (_concurrent_read_depth > 0)
+            return with_read_lock(std::forward<Lambda>(callback), wait_micro);
+
+        return with_read_lock(
+            [&]() {
+                boost::interprocess::sharable_lock<read_write_mutex> readers_lock(_concurrent_readers_mutex);
+
+                struct depth_guard
+                {
+                    depth_guard()
+                    {
+                        ++_concurrent_read_depth;
+                    }
+                    ~depth_guard()
+                    {
+                        --_concurrent_read_depth;
+                    }
+                } depth;
+
+                return callback();
+            },
+            wait_micro);
+    }
 };
 }
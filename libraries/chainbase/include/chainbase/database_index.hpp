@@ -2,6 +2,11 @@
 
 #include <boost/container/flat_map.hpp>
 
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <vector>
+
 #include <chainbase/chain_object.hpp>
 #include <chainbase/database_guard.hpp>
 #include <chainbase/generic_index.hpp>
@@ -25,7 +30,7 @@ public:
 
         const uint16_t type_id = index_type::value_type::type_id;
 
-        if (_index_map.find(type_id) != _index_map.end())
+        if (_index_slots[type_id])
         {
             std::string type_name = boost::core::demangle(typeid(typename index_type::value_type).name());
             BOOST_THROW_EXCEPTION(std::logic_error(type_name + "::type_id is already in use"));
@@ -36,6 +41,12 @@ public:
         idx_ptr->validate();
 
         _index_map[type_id] = idx_ptr;
+        _index_slots[type_id] = idx_ptr;
+
+        _index_handlers[type_id] = { [this]() -> void* { return this->template allocate_index<index_type>(); },
+                                     [this](boost::interprocess::managed_mapped_file& dst) {
+                                         this->template copy_index<index_type>(dst);
+                                     } };
 
         return *idx_ptr;
     }
@@ -44,7 +55,7 @@ public:
     {
         CHAINBASE_REQUIRE_READ_LOCK(typename MultiIndexType::value_type);
         typedef generic_index<MultiIndexType> index_type;
-        return _index_map.find((uint16_t)index_type::value_type::type_id) != _index_map.end();
+        return _index_slots[index_type::value_type::type_id] != nullptr;
     }
 
     template <typename MultiIndexType> const generic_index<MultiIndexType>& get_index() const
@@ -59,7 +70,7 @@ public:
             BOOST_THROW_EXCEPTION(std::runtime_error("unable to find index for " + type_name + " in database"));
         }
 
-        return *index_type_ptr(_index_map.find((uint16_t)index_type::value_type::type_id)->second);
+        return *index_type_ptr(_index_slots[index_type::value_type::type_id]);
     }
 
     template <typename MultiIndexType, typename ByIndex>
@@ -75,7 +86,7 @@ public:
             BOOST_THROW_EXCEPTION(std::runtime_error("unable to find index for " + type_name + " in database"));
         }
 
-        return index_type_ptr(_index_map.find((uint16_t)index_type::value_type::type_id)->second)
+        return index_type_ptr(_index_slots[index_type::value_type::type_id])
             ->indices()
             .template get<ByIndex>();
     }
@@ -92,7 +103,7 @@ public:
             BOOST_THROW_EXCEPTION(std::runtime_error("unable to find index for " + type_name + " in database"));
         }
 
-        return *index_type_ptr(_index_map.find((uint16_t)index_type::value_type::type_id)->second);
+        return *index_type_ptr(_index_slots[index_type::value_type::type_id]);
     }
 
     template <typename ObjectType, typename IndexedByType, typename CompatibleKey>
@@ -111,11 +122,7 @@ public:
     {
         CHAINBASE_REQUIRE_READ_LOCK(ObjectType);
         typedef typename get_index_type<ObjectType>::type index_type;
-        const auto& idx = get_index<index_type>().indices();
-        auto itr = idx.find(key);
-        if (itr == idx.end())
-            return nullptr;
-        return &*itr;
+        return get_index<index_type>().find(key);
     }
 
     template <typename ObjectType, typename IndexedByType, typename CompatibleKey>
@@ -167,9 +174,51 @@ public:
     }
 
 protected:
+    void clear_indexes()
+    {
+        _index_map.clear();
+        _index_handlers.clear();
+        std::fill(_index_slots.begin(), _index_slots.end(), nullptr);
+    }
+
+    /**
+    * Finds added indexes again after segment was remapped
+    */
+    void reattach_indexes()
+    {
+        for (auto& item : _index_map)
+        {
+            item.second = _index_handlers[item.first].attach();
+            _index_slots[item.first] = item.second;
+        }
+    }
+
+    std::vector<typename segment_manager::segment_copier> get_index_copiers() const
+    {
+        std::vector<typename segment_manager::segment_copier> copiers;
+        copiers.reserve(_index_handlers.size());
+        for (const auto& item : _index_handlers)
+            copiers.push_back(item.second.copy);
+        return copiers;
+    }
+
     /**
-    * This is a full map (size 2^16) of all possible index designed for constant time lookup
+    * Added indexes ordered by type id
     */
     boost::container::flat_map<uint16_t, void*> _index_map;
+
+    /**
+    * This is a full map (size 2^16) of all possible index designed for constant time lookup by type id
+    */
+    std::vector<void*> _index_slots = std::vector<void*>(std::numeric_limits<uint16_t>::max() + 1, nullptr);
+
+private:
+    struct index_handlers
+    {
+        std::function<void*()> attach;
+        typename segment_manager::segment_copier copy;
+    };
+
+    boost::container::flat_map<uint16_t, index_handlers> _index_handlers;
 };
 }
@@ -1,11 +1,19 @@
 #pragma once
 
+#include <boost/core/demangle.hpp>
+#include <boost/interprocess/offset_ptr.hpp>
 #include <boost/throw_exception.hpp>
+#include <algorithm>
 #include <stdexcept>
+#include <type_traits>
+#include <typeinfo>
 
 #include <fc/shared_containers.hpp>
 
+#include <chainbase/index_digest.hpp>
+#include <chainbase/undo_journal.hpp>
 #include <chainbase/undo_session.hpp>
+#include <chainbase/undo_tree.hpp>
 
 namespace chainbase {
 
@@ -14,16 +22,22 @@ namespace chainbase {
 *  be the primary key and it will be assigned and managed by generic_index.
 *
 *  Additionally, the constructor for value_type must take an allocator
+*
+*  Besides the multi index container every object is addressed by its id in a dense table, so lookup by id
+*  is a single array access instead of a tree search. Ids are assigned sequentially and objects are mostly
+*  removed in order of creation, so the table is trimmed from both ends and keeps few holes.
 */
 template <typename MultiIndexType> class base_index
 {
 public:
     using value_type = typename MultiIndexType::value_type;
     using allocator_type = typename MultiIndexType::allocator_type;
+    using id_type = typename value_type::id_type;
 
     template <typename Allocator>
     base_index(const Allocator& a)
         : _indices(a)
+        , _nodes_by_id(a)
         , _size_of_value_type(sizeof(typename MultiIndexType::node_type))
         , _size_of_this(sizeof(*this))
     {
@@ -42,10 +56,8 @@ public:
 
     template <typename CompatibleKey> const value_type* find(CompatibleKey&& key) const
     {
-        auto itr = _indices.find(std::forward<CompatibleKey>(key));
-        if (itr != _indices.end())
-            return &*itr;
-        return nullptr;
+        return find_(std::forward<CompatibleKey>(key),
+                     std::is_same<typename std::decay<CompatibleKey>::type, id_type>());
     }
 
     template <typename CompatibleKey> const value_type& get(CompatibleKey&& key) const
@@ -79,14 +91,21 @@ protected:
 
     template <typename Modifier> void modify(const value_type& obj, Modifier&& m)
     {
+        const id_type id = obj.id;
+
         auto ok = _indices.modify(_indices.iterator_to(obj), m);
         if (!ok)
+        {
+            // multi index container erases object which violates constraint
+            reset_node(id);
             BOOST_THROW_EXCEPTION(
                 std::logic_error("Could not modify object, most likely a uniqueness constraint was violated"));
+        }
     }
 
     void remove(const value_type& obj)
     {
+        reset_node(obj.id);
         _indices.erase(_indices.iterator_to(obj));
     }
 
@@ -105,54 +124,135 @@ protected:
                 std::logic_error("could not insert object, most likely a uniqueness constraint was violated"));
         }
 
+        set_node(*insert_result.first);
+
         return *insert_result.first;
     }
 
+    size_t id_table_bytes() const
+    {
+        return _nodes_by_id.size() * sizeof(node_ptr);
+    }
+
+    /**
+    *  Calls visitor for at most max_count objects taken evenly by id, or for every object if there are less of them.
+    *
+    *  @return number of visited objects
+    */
+    template <typename Visitor> size_t sample(size_t max_count, Visitor&& visit) const
+    {
+        if (_indices.size() <= max_count)
+        {
+            for (const auto& v : _indices)
+                visit(v);
+            return _indices.size();
+        }
+
+        const size_t step = std::max<size_t>(_nodes_by_id.size() / std::max<size_t>(max_count, 1), 1);
+
+        size_t visited = 0;
+        for (size_t pos = 0; pos < _nodes_by_id.size() && visited < max_count; pos += step)
+        {
+            if (!_nodes_by_id[pos])
+                continue;
+            visit(*_nodes_by_id[pos]);
+            ++visited;
+        }
+        return visited;
+    }
+
+private:
+    using node_ptr = boost::interprocess::offset_ptr<const value_type>;
+
+    template <typename CompatibleKey> const value_type* find_(CompatibleKey&& key, std::false_type) const
+    {
+        auto itr = _indices.find(std::forward<CompatibleKey>(key));
+        if (itr != _indices.end())
+            return &*itr;
+        return nullptr;
+    }
+
+    const value_type* find_(const id_type& id, std::true_type) const
+    {
+        if (id._id < _nodes_base || id._id - _nodes_base >= (int64_t)_nodes_by_id.size())
+            return nullptr;
+        return _nodes_by_id[id._id - _nodes_base].get();
+    }
+
+    void set_node(const value_type& v)
+    {
+        const int64_t id = v.id._id;
+
+        if (_nodes_by_id.empty())
+        {
+            _nodes_base = id;
+        }
+        else if (id < _nodes_base)
+        {
+            // object removed from the front is restored by undo
+            _nodes_by_id.insert(_nodes_by_id.begin(), _nodes_base - id, node_ptr());
+            _nodes_base = id;
+        }
+
+        const size_t pos = id - _nodes_base;
+        if (pos >= _nodes_by_id.size())
+            _nodes_by_id.resize(pos + 1);
+
+        _nodes_by_id[pos] = &v;
+    }
+
+    void reset_node(const id_type& id)
+    {
+        if (id._id < _nodes_base || id._id - _nodes_base >= (int64_t)_nodes_by_id.size())
+            return;
+
+        _nodes_by_id[id._id - _nodes_base] = nullptr;
+
+        while (!_nodes_by_id.empty() && !_nodes_by_id.front())
+        {
+            _nodes_by_id.pop_front();
+            ++_nodes_base;
+        }
+        while (!_nodes_by_id.empty() && !_nodes_by_id.back())
+        {
+            _nodes_by_id.pop_back();
+        }
+    }
+
 protected:
     typename value_type::id_type _next_id = 0;
     MultiIndexType _indices;
+
+private:
+    fc::shared_deque<node_ptr> _nodes_by_id;
+    int64_t _nodes_base = 0;
+
+protected:
     uint32_t _size_of_value_type = 0;
     uint32_t _size_of_this = 0;
 };
 
 //------------------------------------------------------------------------------------------------------//
 
-template <typename MultiIndexType>
+#ifdef CHAINBASE_UNDO_JOURNAL
+template <typename ValueType> using default_undo_storage = undo_journal<ValueType>;
+#else
+template <typename ValueType> using default_undo_storage = undo_tree<ValueType>;
+#endif
+
+template <typename MultiIndexType, template <typename> class UndoStorage = default_undo_storage>
 class generic_index : public abstract_generic_index_i, public base_index<MultiIndexType>
 {
 public:
     using value_type = typename MultiIndexType::value_type;
     using base_index_type = base_index<MultiIndexType>;
-
-private:
-    //------------------------------------------//
-    class undo_state
-    {
-    public:
-        using id_type = typename value_type::id_type;
-        using id_type_set = fc::shared_set<id_type>;
-        using id_value_type_map = fc::shared_map<id_type, value_type>;
-
-        template <typename T>
-        undo_state(const fc::shared_allocator<T>& al)
-            : old_values(al)
-            , removed_values(al)
-            , new_ids(al)
-        {
-        }
-
-        id_value_type_map old_values;
-        id_value_type_map removed_values;
-        id_type_set new_ids;
-        id_type old_next_id = 0;
-        int64_t revision = 0;
-    };
+    using undo_storage_type = UndoStorage<value_type>;
 
 public:
     template <typename Allocator>
     generic_index(const Allocator& a)
         : base_index_type(a)
-        , _stack(a)
+        , _undo(a)
     {
     }
 
@@ -160,34 +260,105 @@ public:
     {
         const value_type& value = base_index_type::emplace(c);
 
-        on_create(value);
+        _undo.on_create(value);
+        digest_add(value);
 
         return value;
     }
 
     template <typename Modifier> void modify(const value_type& obj, Modifier&& m)
     {
+        // object failing modification is erased, so it is not added back
+        digest_sub(obj);
+
+        if (!_undo.enabled())
+        {
+            // no session (replay or irreversible block), nothing to record
+            base_index_type::modify(obj, m);
+            digest_add(obj);
+            return;
+        }
+
         auto unmodified_copy = obj;
 
         base_index_type::modify(obj, m);
+        digest_add(obj);
 
-        on_modify(unmodified_copy);
+        _undo.on_modify(unmodified_copy);
     }
 
     void remove(const value_type& obj)
     {
-        on_remove(obj); // after base_index_type::remove(obj); obj is invalid, so do this call here
+        _undo.on_remove(obj); // after base_index_type::remove(obj); obj is invalid, so do this call here
+        digest_sub(obj);
 
         base_index_type::remove(obj);
     }
 
+    /**
+    *  Copies all objects of index allocated in another segment. Objects are assigned to values constructed
+    *  with allocator of this index, so dynamic members are allocated here. Undo history is not copied.
+    */
+    void copy_from(const generic_index& other)
+    {
+        if (other._undo.enabled())
+            BOOST_THROW_EXCEPTION(std::logic_error("cannot copy index while there is an existing undo stack"));
+
+        for (const auto& v : other.indices())
+        {
+            base_index_type::emplace_([&](value_type& copy) { copy = v; }, this->get_allocator());
+        }
+
+        this->_next_id = other._next_id;
+        _revision = other._revision;
+        _digest = other._digest;
+        _digest_enabled = other._digest_enabled;
+    }
+
+    typename value_type::id_type next_id() const
+    {
+        return this->_next_id;
+    }
+
+    /**
+    *  Inserts object keeping id assigned by constructor, it's used to load objects stored outside of segment.
+    *  Undo history is not recorded, next id is set to follow the object if needed.
+    */
+    template <typename Constructor> const value_type& insert(Constructor&& c)
+    {
+        if (_undo.enabled())
+            BOOST_THROW_EXCEPTION(std::logic_error("cannot insert object while there is an existing undo stack"));
+
+        const value_type& value = base_index_type::emplace_(c, this->get_allocator());
+
+        if (value.id._id >= this->_next_id._id)
+            this->_next_id = value.id._id + 1;
+
+        digest_add(value);
+
+        return value;
+    }
+
+    /**
+    *  Removes all objects and sets next id, undo history is not recorded.
+    */
+    void clear(typename value_type::id_type next_id = 0)
+    {
+        if (_undo.enabled())
+            BOOST_THROW_EXCEPTION(std::logic_error("cannot clear index while there is an existing undo stack"));
+
+        while (!this->_indices.empty())
+            base_index_type::remove(*this->_indices.begin());
+
+        this->_next_id = next_id;
+        _digest.reset();
+    }
+
 private:
     // abstract_generic_index_i interface
     abstract_undo_session_ptr start_undo_session() override
     {
-        _stack.emplace_back(this->get_allocator());
-        _stack.back().old_next_id = this->_next_id;
-        _stack.back().revision = ++_revision;
+        _undo.start(this->_next_id, ++_revision);
 
         return std::move(abstract_undo_session_ptr(new session(*this)));
     }
@@ -198,29 +369,25 @@ private:
     */
     void undo() override
     {
-        if (!enabled())
+        if (!_undo.enabled())
             return;
 
-        const auto& head = _stack.back();
-
-        for (auto& item : head.old_values)
-        {
-            base_index_type::modify(this->get(item.second.id), [&](value_type& v) { v = std::move(item.second); });
-        }
-
-        for (auto id : head.new_ids)
-        {
-            base_index_type::remove(this->get(id));
-        }
-
-        this->_next_id = head.old_next_id;
-
-        for (auto& item : head.removed_values)
-        {
-            base_index_type::emplace_(std::move(item.second));
-        }
+        // clang-format off
+        this->_next_id = _undo.undo(
+            [&](value_type& old) {
+                const value_type& current = this->get(old.id);
+                digest_sub(current);
+                base_index_type::modify(current, [&](value_type& v) { v = std::move(old); });
+                digest_add(current);
+            },
+            [&](typename value_type::id_type id) {
+                const value_type& created = this->get(id);
+                digest_sub(created);
+                base_index_type::remove(created);
+            },
+            [&](value_type& removed) { digest_add(base_index_type::emplace_(std::move(removed))); });
+        // clang-format on
 
-        _stack.pop_back();
         --_revision;
     }
 
@@ -232,112 +399,15 @@ private:
     */
     void squash() override
     {
-        if (!enabled())
+        if (!_undo.enabled())
             return;
-        if (_stack.size() == 1)
-        {
-            _stack.pop_front();
-            return;
-        }
 
-        auto& state = _stack.back();
-        auto& prev_state = _stack[_stack.size() - 2];
-
-        // An object's relationship to a state can be:
-        // in new_ids            : new
-        // in old_values (was=X) : upd(was=X)
-        // in removed (was=X)    : del(was=X)
-        // not in any of above   : nop
-        //
-        // When merging A=prev_state and B=state we have a 4x4 matrix of all possibilities:
-        //
-        //                   |--------------------- B ----------------------|
-        //
-        //                +------------+------------+------------+------------+
-        //                | new        | upd(was=Y) | del(was=Y) | nop        |
-        //   +------------+------------+------------+------------+------------+
-        // / | new        | N/A        | new       A| nop       C| new       A|
-        // | +------------+------------+------------+------------+------------+
-        // | | upd(was=X) | N/A        | upd(was=X)A| del(was=X)C| upd(was=X)A|
-        // A +------------+------------+------------+------------+------------+
-        // | | del(was=X) | N/A        | N/A        | N/A        | del(was=X)A|
-        // | +------------+------------+------------+------------+------------+
-        // \ | nop        | new       B| upd(was=Y)B| del(was=Y)B| nop      AB|
-        //   +------------+------------+------------+------------+------------+
-        //
-        // Each entry was composed by labelling what should occur in the given case.
-        //
-        // Type A means the composition of states contains the same entry as the first of the two merged states for that
-        // object.
-        // Type B means the composition of states contains the same entry as the second of the two merged states for
-        // that object.
-        // Type C means the composition of states contains an entry different from either of the merged states for that
-        // object.
-        // Type N/A means the composition of states violates causal timing.
-        // Type AB means both type A and type B simultaneously.
-        //
-        // The merge() operation is defined as modifying prev_state in-place to be the state object which represents the
-        // composition of
-        // state A and B.
-        //
-        // Type A (and AB) can be implemented as a no-op; prev_state already contains the correct value for the merged
-        // state.
-        // Type B (and AB) can be implemented by copying from state to prev_state.
-        // Type C needs special case-by-case logic.
-        // Type N/A can be ignored or assert(false) as it can only occur if prev_state and state have illegal values
-        // (a serious logic error which should never happen).
-        //
-
-        // We can only be outside type A/AB (the nop path) if B is not nop, so it suffices to iterate through B's three
-        // containers.
-
-        for (const auto& item : state.old_values)
-        {
-            if (prev_state.new_ids.find(item.second.id) != prev_state.new_ids.end())
-            {
-                // new+upd -> new, type A
-                continue;
-            }
-            if (prev_state.old_values.find(item.second.id) != prev_state.old_values.end())
-            {
-                // upd(was=X) + upd(was=Y) -> upd(was=X), type A
-                continue;
-            }
-            // del+upd -> N/A
-            assert(prev_state.removed_values.find(item.second.id) == prev_state.removed_values.end());
-            // nop+upd(was=Y) -> upd(was=Y), type B
-            prev_state.old_values.emplace(std::move(item));
-        }
+        const bool last = _undo.size() == 1;
 
-        // *+new, but we assume the N/A cases don't happen, leaving type B nop+new -> new
-        for (auto id : state.new_ids)
-            prev_state.new_ids.insert(id);
+        _undo.squash();
 
-        // *+del
-        for (auto& obj : state.removed_values)
-        {
-            if (prev_state.new_ids.find(obj.second.id) != prev_state.new_ids.end())
-            {
-                // new + del -> nop (type C)
-                prev_state.new_ids.erase(obj.second.id);
-                continue;
-            }
-            auto it = prev_state.old_values.find(obj.second.id);
-            if (it != prev_state.old_values.end())
-            {
-                // upd(was=X) + del(was=Y) -> del(was=X)
-                prev_state.removed_values.emplace(std::move(*it));
-                prev_state.old_values.erase(obj.second.id);
-                continue;
-            }
-            // del + del -> N/A
-            assert(prev_state.removed_values.find(obj.second.id) == prev_state.removed_values.end());
-            // nop + del(was=Y) -> del(was=Y)
-            prev_state.removed_values.emplace(std::move(obj)); //[obj.second->id] = std::move(obj.second);
-        }
-
-        _stack.pop_back();
-        --_revision;
+        if (!last)
+            --_revision;
     }
 
     /**
@@ -345,10 +415,7 @@ private:
     */
     void commit(int64_t revision) override
     {
-        while (_stack.size() && _stack[0].revision <= revision)
-        {
-            _stack.pop_front();
-        }
+        _undo.commit(revision);
     }
 
     /**
@@ -356,13 +423,13 @@ private:
     */
     void undo_all() override
     {
-        while (enabled())
+        while (_undo.enabled())
             undo();
     }
 
     void set_revision(int64_t revision) override
     {
-        if (_stack.size() != 0)
+        if (_undo.enabled())
             BOOST_THROW_EXCEPTION(std::logic_error("cannot set revision while there is an existing undo stack"));
         _revision = revision;
     }
@@ -372,65 +439,78 @@ private:
         return _revision;
     }
 
-    //////////////////////////////////////////////////////////////////////////
-    bool enabled() const
-    {
-        return !_stack.empty();
-    }
-
-    void on_modify(const value_type& v)
+    /**
+    *  Dynamic members are walked for max_samples objects at most and extrapolated to the whole index,
+    *  so the cost of the call does not depend on the index size.
+    */
+    index_memory_stats get_memory_stats(size_t max_samples) const override
     {
-        if (!enabled())
-            return;
-
-        auto& head = _stack.back();
+        index_memory_stats stats;
+        stats.name = boost::core::demangle(typeid(value_type).name());
+        stats.nodes = this->_indices.size();
+        stats.node_bytes = stats.nodes * this->_size_of_value_type;
+        stats.id_table_bytes = this->id_table_bytes();
+
+        uint64_t dynamic_bytes = 0;
+        const size_t sampled
+            = this->sample(max_samples, [&](const value_type& v) { dynamic_bytes += dynamic_memory_size(v); });
+        if (sampled && sampled < stats.nodes)
+        {
+            stats.dynamic_bytes = dynamic_bytes * stats.nodes / sampled;
+            stats.dynamic_bytes_estimated = true;
+        }
+        else
+        {
+            stats.dynamic_bytes = dynamic_bytes;
+        }
 
-        if (head.new_ids.find(v.id) != head.new_ids.end())
-            return;
+        stats.undo_revisions = _undo.get_memory_stats();
+        for (const auto& r : stats.undo_revisions)
+            stats.undo_bytes += r.bytes;
 
-        auto itr = head.old_values.find(v.id);
-        if (itr != head.old_values.end())
-            return;
-
-        head.old_values.emplace(std::pair<typename value_type::id_type, const value_type&>(v.id, v));
+        return stats;
     }
 
-    void on_remove(const value_type& v)
+    /**
+    *  Digest is recalculated from all objects when it is enabled, then it is updated on every change.
+    *  It stays enabled in shared memory file, so it is not recalculated on the next start.
+    */
+    void set_digest_enabled(bool enabled) override
     {
-        if (!enabled())
-            return;
-
-        auto& head = _stack.back();
-        if (head.new_ids.count(v.id))
+        if (enabled && !_digest_enabled)
         {
-            head.new_ids.erase(v.id);
-            return;
-        }
-
-        auto itr = head.old_values.find(v.id);
-        if (itr != head.old_values.end())
-        {
-            head.removed_values.emplace(std::move(*itr));
-            head.old_values.erase(v.id);
-            return;
+            _digest.reset();
+            for (const auto& v : this->_indices)
+                _digest.add(object_hash(v));
         }
 
-        if (head.removed_values.count(v.id))
-            return;
+        _digest_enabled = enabled;
+    }
 
-        head.removed_values.emplace(std::pair<typename value_type::id_type, const value_type&>(v.id, v));
+    index_digest get_digest() const override
+    {
+        index_digest result;
+        result.name = boost::core::demangle(typeid(value_type).name());
+        result.objects = this->_indices.size();
+        result.enabled = _digest_enabled;
+        if (_digest_enabled)
+            result.digest = _digest.value();
+        return result;
     }
 
-    void on_create(const value_type& v)
+private:
+    void digest_add(const value_type& v)
     {
-        if (!enabled())
-            return;
-        auto& head = _stack.back();
+        if (_digest_enabled)
+            _digest.add(object_hash(v));
+    }
 
-        head.new_ids.insert(v.id);
+    void digest_sub(const value_type& v)
+    {
+        if (_digest_enabled)
+            _digest.sub(object_hash(v));
     }
 
-private:
     /**
     *  Each new session increments the revision, a squash will decrement the revision by combining
     *  the two most recent revisions into one revision.
@@ -439,7 +519,10 @@ private:
     */
     int64_t _revision = 0;
 
-    fc::shared_deque<undo_state> _stack;
+    undo_storage_type _undo;
+
+    digest_accumulator _digest;
+    bool _digest_enabled = false;
 };
 
 /** this class is meant to be specified to enable lookup of index type by object type using
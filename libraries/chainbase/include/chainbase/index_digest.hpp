@@ -0,0 +1,69 @@
+#pragma once
+
+#include <fc/crypto/sha256.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/reflect/reflect.hpp>
+
+#include <string>
+
+namespace chainbase {
+
+struct index_digest
+{
+    std::string name;
+    uint64_t objects = 0;
+    bool enabled = false;
+    fc::sha256 digest;
+};
+
+/**
+*  Digest of a set of objects independent of their order: sum of object hashes by 64 bit lanes modulo 2^64.
+*  An object is added on create, subtracted on remove and both on modify, so the digest is updated in
+*  constant time and returns to the same value when changes are undone.
+*/
+class digest_accumulator
+{
+public:
+    void add(const fc::sha256& hash)
+    {
+        for (int ci = 0; ci < 4; ++ci)
+            _lanes[ci] += hash._hash[ci];
+    }
+
+    void sub(const fc::sha256& hash)
+    {
+        for (int ci = 0; ci < 4; ++ci)
+            _lanes[ci] -= hash._hash[ci];
+    }
+
+    void reset()
+    {
+        for (int ci = 0; ci < 4; ++ci)
+            _lanes[ci] = 0;
+    }
+
+    fc::sha256 value() const
+    {
+        fc::sha256 result;
+        for (int ci = 0; ci < 4; ++ci)
+            result._hash[ci] = _lanes[ci];
+        return result;
+    }
+
+private:
+    uint64_t _lanes[4] = { 0, 0, 0, 0 };
+};
+
+/**
+*  Hash of object packed by FC serialization, the same as it is stored in state snapshot.
+*/
+template <typename T> fc::sha256 object_hash(const T& value)
+{
+    static_assert(fc::reflector<T>::is_defined::value, "objects of index must be reflected to be hashed by content");
+
+    const auto packed = fc::raw::pack(value);
+    return fc::sha256::hash(packed.data(), packed.size());
+}
+}
+
+FC_REFLECT(chainbase::index_digest, (name)(objects)(enabled)(digest))
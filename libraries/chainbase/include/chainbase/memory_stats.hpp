@@ -0,0 +1,193 @@
+#pragma once
+
+#include <boost/container/deque.hpp>
+#include <boost/container/flat_map.hpp>
+#include <boost/container/flat_set.hpp>
+#include <boost/container/map.hpp>
+#include <boost/container/set.hpp>
+#include <boost/container/vector.hpp>
+
+#include <fc/reflect/reflect.hpp>
+
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace chainbase {
+
+struct undo_revision_memory_stats
+{
+    int64_t revision = 0;
+    uint64_t objects = 0;
+    uint64_t bytes = 0;
+};
+
+struct index_memory_stats
+{
+    std::string name;
+
+    uint64_t nodes = 0;
+    uint64_t node_bytes = 0;
+    uint64_t id_table_bytes = 0;
+
+    /// memory allocated by shared containers of objects, estimated by sample if index is large
+    uint64_t dynamic_bytes = 0;
+    bool dynamic_bytes_estimated = false;
+
+    uint64_t undo_bytes = 0;
+    std::vector<undo_revision_memory_stats> undo_revisions;
+
+    uint64_t total_bytes() const
+    {
+        return node_bytes + id_table_bytes + dynamic_bytes + undo_bytes;
+    }
+};
+
+/**
+*  Approximate size of a node of tree based containers besides the value, used to estimate undo stacks.
+*/
+const size_t tree_node_overhead = 4 * sizeof(void*);
+
+/**
+*  Memory allocated by shared containers of object outside of its node. Objects are walked by FC reflection,
+*  strings and containers count their capacity, other members are supposed to have no dynamic memory.
+*/
+template <typename T> size_t dynamic_memory_size(const T& value);
+
+namespace detail {
+
+template <typename T, typename = void> struct has_capacity : std::false_type
+{
+};
+
+template <typename T>
+struct has_capacity<T, decltype(void(std::declval<const T&>().capacity()), void(sizeof(typename T::value_type)))>
+    : std::true_type
+{
+};
+
+template <typename T>
+using is_reflected_class = std::integral_constant<bool, std::is_class<T>::value && fc::reflector<T>::is_defined::value>;
+
+template <typename T> struct dynamic_memory_visitor
+{
+    dynamic_memory_visitor(const T& value_, size_t& result_)
+        : value(value_)
+        , result(result_)
+    {
+    }
+
+    template <typename Member, class Class, Member(Class::*member)> void operator()(const char*) const
+    {
+        result += dynamic_memory_size(value.*member);
+    }
+
+    const T& value;
+    size_t& result;
+};
+
+// reflected structures are walked by members, other types with capacity are taken as strings (custom shared strings)
+template <typename T, bool Reflected = is_reflected_class<T>::value, bool Capacity = has_capacity<T>::value>
+struct dynamic_memory
+{
+    static size_t size(const T&)
+    {
+        return 0;
+    }
+};
+
+template <typename T, bool Capacity> struct dynamic_memory<T, true, Capacity>
+{
+    static size_t size(const T& value)
+    {
+        size_t result = 0;
+        fc::reflector<T>::visit(dynamic_memory_visitor<T>(value, result));
+        return result;
+    }
+};
+
+template <typename T> struct dynamic_memory<T, false, true>
+{
+    static size_t size(const T& value)
+    {
+        return value.capacity() * sizeof(typename T::value_type);
+    }
+};
+
+template <typename Sequence> size_t sequence_memory_size(const Sequence& items, size_t count, size_t node_overhead)
+{
+    size_t result = count * (sizeof(typename Sequence::value_type) + node_overhead);
+    for (const auto& item : items)
+        result += dynamic_memory_size(item);
+    return result;
+}
+
+template <typename Map> size_t map_memory_size(const Map& items, size_t count, size_t node_overhead)
+{
+    size_t result = count * (sizeof(typename Map::value_type) + node_overhead);
+    for (const auto& item : items)
+        result += dynamic_memory_size(item.first) + dynamic_memory_size(item.second);
+    return result;
+}
+
+template <typename T, typename... Args> struct dynamic_memory<boost::container::vector<T, Args...>, false, true>
+{
+    static size_t size(const boost::container::vector<T, Args...>& v)
+    {
+        return sequence_memory_size(v, v.capacity(), 0);
+    }
+};
+
+template <typename T, typename... Args> struct dynamic_memory<boost::container::deque<T, Args...>, false, false>
+{
+    static size_t size(const boost::container::deque<T, Args...>& v)
+    {
+        return sequence_memory_size(v, v.size(), 0);
+    }
+};
+
+template <typename K, typename... Args> struct dynamic_memory<boost::container::flat_set<K, Args...>, false, true>
+{
+    static size_t size(const boost::container::flat_set<K, Args...>& v)
+    {
+        return sequence_memory_size(v, v.capacity(), 0);
+    }
+};
+
+template <typename K, typename V, typename... Args>
+struct dynamic_memory<boost::container::flat_map<K, V, Args...>, false, true>
+{
+    static size_t size(const boost::container::flat_map<K, V, Args...>& v)
+    {
+        return map_memory_size(v, v.capacity(), 0);
+    }
+};
+
+template <typename K, typename... Args> struct dynamic_memory<boost::container::set<K, Args...>, false, false>
+{
+    static size_t size(const boost::container::set<K, Args...>& v)
+    {
+        return sequence_memory_size(v, v.size(), tree_node_overhead);
+    }
+};
+
+template <typename K, typename V, typename... Args>
+struct dynamic_memory<boost::container::map<K, V, Args...>, false, false>
+{
+    static size_t size(const boost::container::map<K, V, Args...>& v)
+    {
+        return map_memory_size(v, v.size(), tree_node_overhead);
+    }
+};
+}
+
+template <typename T> size_t dynamic_memory_size(const T& value)
+{
+    return detail::dynamic_memory<T>::size(value);
+}
+}
+
+FC_REFLECT(chainbase::undo_revision_memory_stats, (revision)(objects)(bytes))
+FC_REFLECT(chainbase::index_memory_stats,
+           (name)(nodes)(node_bytes)(id_table_bytes)(dynamic_bytes)(dynamic_bytes_estimated)(undo_bytes)(
+               undo_revisions))
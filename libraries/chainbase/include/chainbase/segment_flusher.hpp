@@ -0,0 +1,84 @@
+#pragma once
+
+#include <fc/reflect/reflect.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace chainbase {
+
+struct flush_stats
+{
+    uint64_t flushes = 0;
+    uint64_t requests = 0;
+    uint64_t last_flush_microseconds = 0;
+    uint64_t max_flush_microseconds = 0;
+    uint64_t total_flush_microseconds = 0;
+    uint64_t last_written_bytes = 0;
+    uint64_t total_written_bytes = 0;
+    bool in_progress = false;
+};
+
+/**
+*  Flushes mapped segment to disk by background thread.
+*
+*  The mapping is flushed by slices with msync. Every slice is flushed under the lock provided by the owner
+*  (remap mutex of database), so the segment can not be remapped meanwhile and remapping waits for one slice
+*  at most instead of the whole mapping. Database read and write locks are not taken, objects are modified
+*  while their pages are flushed. The kernel keeps track of dirty pages, so msync of a clean slice
+*  is cheap and every pass writes only pages modified since the previous one.
+*
+*  Written bytes are taken from the process I/O counters (Linux only), so they include other writes
+*  of the process made during the pass.
+*/
+class segment_flusher
+{
+public:
+    static const size_t default_slice_size = 64 * 1024 * 1024;
+
+    using region_type = std::pair<char*, size_t>;
+    using locker_type = std::function<void(const std::function<void()>&)>;
+    using region_getter_type = std::function<region_type()>;
+
+    segment_flusher(locker_type locker, region_getter_type region_getter, size_t slice_size = default_slice_size);
+    ~segment_flusher();
+
+    /**
+    * Schedules flush pass and returns immediately. Request made during a pass schedules one more pass.
+    */
+    void request();
+
+    /**
+    * Waits until scheduled passes are finished.
+    */
+    void wait();
+
+    flush_stats get_stats() const;
+
+private:
+    void run();
+    void flush_pass();
+
+    locker_type _locker;
+    region_getter_type _region_getter;
+    size_t _slice_size;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _cv;
+    std::condition_variable _idle_cv;
+    bool _requested = false;
+    std::atomic<bool> _stopped{ false };
+
+    flush_stats _stats;
+
+    std::thread _thread;
+};
+}
+
+FC_REFLECT(chainbase::flush_stats,
+           (flushes)(requests)(last_flush_microseconds)(max_flush_microseconds)(total_flush_microseconds)(
+               last_written_bytes)(total_written_bytes)(in_progress))
@@ -2,15 +2,54 @@
 
 #include <boost/filesystem/path.hpp>
 
+#include <functional>
+#include <vector>
+
 #include <chainbase/generic_index.hpp>
 
 namespace chainbase {
 
+/**
+*  Hints for the kernel how to map segment file. They are applied every time the file is mapped
+*  and are supported on Linux only.
+*
+*  Transparent huge pages take effect for files on tmpfs (shmem_enabled set to advise or always).
+*  Explicit huge pages are used by placing the file on hugetlbfs mount. NUMA policy is applied to pages
+*  which are not faulted yet, so it is most useful together with prefault.
+*/
+struct mapping_options
+{
+    enum class access_advice
+    {
+        normal,
+        random,
+        sequential,
+        willneed
+    };
+
+    enum class numa_policy
+    {
+        none,
+        interleave,
+        bind
+    };
+
+    bool huge_pages = false;
+    access_advice advice = access_advice::normal;
+    numa_policy numa = numa_policy::none;
+    std::vector<uint32_t> numa_nodes;
+    bool prefault = false;
+};
+
 class segment_manager
 {
 protected:
     bool _read_only = false;
 
+    mapping_options _mapping_options;
+
+    boost::filesystem::path _segment_path;
+
     std::unique_ptr<boost::interprocess::managed_mapped_file> _segment;
 
 public:
@@ -25,6 +64,27 @@ protected:
 
     void close_segment_file();
 
+    void apply_mapping_options();
+
+    /**
+    * Grows mapped file to new size. Segment is remapped and can be placed at another address,
+    * so all pointers to the segment content must be obtained again.
+    * If the file can't be grown, it is mapped again at its old size before exception is thrown,
+    * so pointers must be obtained again in this case too.
+    */
+    void grow_segment_file(uint64_t new_size);
+
+    using segment_copier = std::function<void(boost::interprocess::managed_mapped_file&)>;
+
+    /**
+    * Creates fresh file of the same size, fills it by copiers and replaces segment file by it.
+    * Segment is remapped, so all pointers to the segment content must be obtained again. If the file
+    * can't be replaced, the original one is mapped again before exception is thrown.
+    */
+    void rewrite_segment_file(const std::vector<segment_copier>& copiers);
+
+    size_t get_named_objects_count() const;
+
     template <typename index_type> index_type* allocate_index()
     {
         std::string type_name = boost::core::demangle(typeid(typename index_type::value_type).name());
@@ -46,5 +106,17 @@ protected:
 
         return idx_ptr;
     }
+
+    template <typename index_type> void copy_index(boost::interprocess::managed_mapped_file& dst) const
+    {
+        std::string type_name = boost::core::demangle(typeid(typename index_type::value_type).name());
+
+        const index_type* src_ptr = _segment->find<index_type>(type_name.c_str()).first;
+        if (!src_ptr)
+            BOOST_THROW_EXCEPTION(std::runtime_error("unable to find index for " + type_name + " to copy"));
+
+        index_type* dst_ptr = dst.construct<index_type>(type_name.c_str())(dst.get_segment_manager());
+        dst_ptr->copy_from(*src_ptr);
+    }
 };
 }
@@ -19,5 +19,15 @@ public:
     }
 
     abstract_undo_session_ptr start_undo_session();
+
+    /**
+    * Memory used by every added index, dynamic members are estimated by max_samples objects of each index.
+    */
+    std::vector<index_memory_stats> get_memory_stats(size_t max_samples = 1000) const;
+
+    /**
+    * Digests of objects of every added index, see generic_index::set_digest_enabled.
+    */
+    std::vector<index_digest> get_digests() const;
 };
 }
@@ -0,0 +1,372 @@
+#pragma once
+
+#include <cassert>
+#include <vector>
+
+#include <fc/shared_containers.hpp>
+
+#include <chainbase/memory_stats.hpp>
+
+namespace chainbase {
+
+/**
+*  Undo storage keeping an append-only journal of changes shared by all sessions.
+*
+*  Create, modify and remove append a record and, for modify and remove, a copy of the object value.
+*  Records and values are kept in deques. Like undo_tree, an object is recorded once per session: records of
+*  the current session are looked up by id, further modifications are skipped, remove turns the record
+*  of modified object into remove record and drops the record of object created by the session.
+*  Undo replays the journal in reverse order.
+*
+*  Records of the current session are found through a flat open addressing table which slots are stamped by
+*  session, so it is cleared by changing the stamp and it allocates only when it grows, not per object.
+*
+*  A session is just a mark in the journal, so squash only drops the mark and commit pops records from the front.
+*  Records of sessions merged by squash or resumed by undo are not looked up, so an object could be recorded
+*  again by such session, replaying its records in reverse order still restores the earliest value.
+*/
+template <typename ValueType> class undo_journal
+{
+public:
+    using value_type = ValueType;
+    using id_type = typename value_type::id_type;
+
+private:
+    enum class operation : uint8_t
+    {
+        create,
+        modify,
+        remove,
+        /// object created and removed by the session
+        none
+    };
+
+    struct record
+    {
+        record(operation op_, const id_type& id_)
+            : op(op_)
+            , id(id_)
+        {
+        }
+
+        operation op;
+        id_type id;
+    };
+
+    struct session_slot
+    {
+        id_type id = 0;
+        size_t offset = 0;
+        uint32_t stamp = 0;
+    };
+
+    struct session_mark
+    {
+        session_mark(size_t records_, size_t values_, const id_type& old_next_id_, int64_t revision_)
+            : records(records_)
+            , values(values_)
+            , old_next_id(old_next_id_)
+            , revision(revision_)
+        {
+        }
+
+        size_t records = 0;
+        size_t values = 0;
+        id_type old_next_id = 0;
+        int64_t revision = 0;
+    };
+
+public:
+    template <typename Allocator>
+    undo_journal(const Allocator& a)
+        : _records(a)
+        , _values(a)
+        , _sessions(a)
+        , _session_slots(a)
+    {
+    }
+
+    bool enabled() const
+    {
+        return !_sessions.empty();
+    }
+
+    size_t size() const
+    {
+        return _sessions.size();
+    }
+
+    void start(id_type next_id, int64_t revision)
+    {
+        _sessions.emplace_back(_records.size(), _values.size(), next_id, revision);
+        clear_session_records();
+    }
+
+    /**
+    *  Replays records of the current session in reverse order using the index callbacks.
+    *
+    *  @return next id at the start of session
+    */
+    template <typename Restore, typename Remove, typename Emplace>
+    id_type undo(Restore&& restore, Remove&& remove, Emplace&& emplace)
+    {
+        const auto& head = _sessions.back();
+
+        while (_records.size() > head.records)
+        {
+            const record& r = _records.back();
+
+            switch (r.op)
+            {
+            case operation::create:
+                remove(r.id);
+                break;
+            case operation::modify:
+                restore(_values.back());
+                _values.pop_back();
+                break;
+            case operation::remove:
+                emplace(_values.back());
+                _values.pop_back();
+                break;
+            case operation::none:
+                break;
+            }
+
+            _records.pop_back();
+        }
+
+        assert(_values.size() == head.values);
+
+        const id_type old_next_id = head.old_next_id;
+
+        _sessions.pop_back();
+        clear_session_records();
+
+        return old_next_id;
+    }
+
+    /**
+    *  Merges two most recent sessions into one. Journal of merged session is concatenation of theirs,
+    *  so only the mark of the last session is dropped.
+    */
+    void squash()
+    {
+        clear_session_records();
+
+        if (_sessions.size() == 1)
+        {
+            _records.clear();
+            _values.clear();
+            _sessions.pop_front();
+            return;
+        }
+
+        _sessions.pop_back();
+    }
+
+    /**
+    * Discards all undo history prior to revision
+    */
+    void commit(int64_t revision)
+    {
+        while (_sessions.size() && _sessions.front().revision <= revision)
+        {
+            _sessions.pop_front();
+        }
+
+        if (_sessions.empty())
+        {
+            _records.clear();
+            _values.clear();
+            clear_session_records();
+            return;
+        }
+
+        const size_t records = _sessions.front().records;
+        const size_t values = _sessions.front().values;
+
+        if (!records && !values)
+            return;
+
+        _records.erase(_records.begin(), _records.begin() + records);
+        _values.erase(_values.begin(), _values.begin() + values);
+
+        for (auto& s : _sessions)
+        {
+            s.records -= records;
+            s.values -= values;
+        }
+    }
+
+    /**
+    *  Memory used by records and values of each session, lookup table is accounted to the current session.
+    */
+    std::vector<undo_revision_memory_stats> get_memory_stats() const
+    {
+        std::vector<undo_revision_memory_stats> result;
+        result.reserve(_sessions.size());
+
+        for (size_t ci = 0; ci < _sessions.size(); ++ci)
+        {
+            const auto& s = _sessions[ci];
+            const bool last = ci + 1 == _sessions.size();
+            const size_t records_end = last ? _records.size() : _sessions[ci + 1].records;
+            const size_t values_end = last ? _values.size() : _sessions[ci + 1].values;
+
+            undo_revision_memory_stats stats;
+            stats.revision = s.revision;
+            stats.objects = records_end - s.records;
+            stats.bytes = sizeof(session_mark) + stats.objects * sizeof(record)
+                + (values_end - s.values) * sizeof(value_type);
+
+            for (size_t vi = s.values; vi < values_end; ++vi)
+                stats.bytes += dynamic_memory_size(_values[vi]);
+
+            if (last)
+                stats.bytes += _session_slots.size() * sizeof(session_slot);
+
+            result.push_back(stats);
+        }
+
+        return result;
+    }
+
+    void on_modify(const value_type& v)
+    {
+        if (!enabled())
+            return;
+
+        // the value before the first modification or the creation is restored
+        if (find_session_record(v.id))
+            return;
+
+        add_session_record(v.id);
+
+        _values.emplace_back(v);
+        _records.emplace_back(operation::modify, v.id);
+    }
+
+    void on_remove(const value_type& v)
+    {
+        if (!enabled())
+            return;
+
+        // removed object is not touched again, so its slot is left as is
+        if (const session_slot* slot = find_session_record(v.id))
+        {
+            record& r = _records[_sessions.back().records + slot->offset];
+            r.op = r.op == operation::create ? operation::none : operation::remove;
+            return;
+        }
+
+        _values.emplace_back(v);
+        _records.emplace_back(operation::remove, v.id);
+    }
+
+    void on_create(const value_type& v)
+    {
+        if (!enabled())
+            return;
+
+        add_session_record(v.id);
+        _records.emplace_back(operation::create, v.id);
+    }
+
+private:
+    size_t slot_index(const id_type& id) const
+    {
+        // Fibonacci hashing spreads sequential ids over the table
+        return (size_t)(((uint64_t)id._id * 0x9E3779B97F4A7C15ull) >> (64 - _session_bits));
+    }
+
+    const session_slot* find_session_record(const id_type& id) const
+    {
+        if (!_session_count)
+            return nullptr;
+
+        const size_t mask = _session_slots.size() - 1;
+        for (size_t ci = slot_index(id);; ci = (ci + 1) & mask)
+        {
+            const session_slot& slot = _session_slots[ci];
+            if (slot.stamp != _session_stamp)
+                return nullptr;
+            if (slot.id == id)
+                return &slot;
+        }
+    }
+
+    /// records offset of the record that is appended next
+    void add_session_record(const id_type& id)
+    {
+        // load factor is kept under a half
+        if ((_session_count + 1) * 2 > _session_slots.size())
+            grow_session_slots();
+
+        const size_t mask = _session_slots.size() - 1;
+        size_t ci = slot_index(id);
+        while (_session_slots[ci].stamp == _session_stamp)
+            ci = (ci + 1) & mask;
+
+        session_slot& slot = _session_slots[ci];
+        slot.id = id;
+        slot.offset = _records.size() - _sessions.back().records;
+        slot.stamp = _session_stamp;
+        ++_session_count;
+    }
+
+    void grow_session_slots()
+    {
+        std::vector<session_slot> live;
+        live.reserve(_session_count);
+        for (const auto& slot : _session_slots)
+        {
+            if (slot.stamp == _session_stamp)
+                live.push_back(slot);
+        }
+
+        if (_session_slots.empty())
+            _session_bits = min_session_bits;
+        else
+            ++_session_bits;
+        _session_slots.clear();
+        _session_slots.resize((size_t)1 << _session_bits);
+        _session_stamp = 1;
+
+        const size_t mask = _session_slots.size() - 1;
+        for (const auto& slot : live)
+        {
+            size_t ci = slot_index(slot.id);
+            while (_session_slots[ci].stamp == _session_stamp)
+                ci = (ci + 1) & mask;
+            _session_slots[ci] = slot;
+            _session_slots[ci].stamp = _session_stamp;
+        }
+    }
+
+    void clear_session_records()
+    {
+        _session_count = 0;
+
+        if (++_session_stamp == 0)
+        {
+            // stamps wrapped around, slots stamped long ago would be taken as occupied
+            for (auto& slot : _session_slots)
+                slot.stamp = 0;
+            _session_stamp = 1;
+        }
+    }
+
+    static const uint32_t min_session_bits = 6;
+
+    fc::shared_deque<record> _records;
+    fc::shared_deque<value_type> _values;
+    fc::shared_deque<session_mark> _sessions;
+    /// records of the current session by object id, offsets are counted from the start of session
+    fc::shared_deque<session_slot> _session_slots;
+    size_t _session_count = 0;
+    uint32_t _session_bits = 0;
+    uint32_t _session_stamp = 1;
+};
+
+} // namespace chainbase
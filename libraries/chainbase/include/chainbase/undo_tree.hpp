@@ -0,0 +1,310 @@
+#pragma once
+
+#include <cassert>
+
+#include <fc/shared_containers.hpp>
+
+#include <chainbase/memory_stats.hpp>
+
+namespace chainbase {
+
+/**
+*  Undo storage keeping first old value of every modified or removed object of a session in ordered maps.
+*
+*  Each object is recorded at most once per session, but every first modification allocates a tree node
+*  in addition to the object copy.
+*/
+template <typename ValueType> class undo_tree
+{
+public:
+    using value_type = ValueType;
+    using id_type = typename value_type::id_type;
+
+private:
+    class undo_state
+    {
+    public:
+        using id_type_set = fc::shared_set<id_type>;
+        using id_value_type_map = fc::shared_map<id_type, value_type>;
+
+        template <typename T>
+        undo_state(const fc::shared_allocator<T>& al)
+            : old_values(al)
+            , removed_values(al)
+            , new_ids(al)
+        {
+        }
+
+        id_value_type_map old_values;
+        id_value_type_map removed_values;
+        id_type_set new_ids;
+        id_type old_next_id = 0;
+        int64_t revision = 0;
+    };
+
+public:
+    template <typename Allocator>
+    undo_tree(const Allocator& a)
+        : _stack(a)
+    {
+    }
+
+    bool enabled() const
+    {
+        return !_stack.empty();
+    }
+
+    size_t size() const
+    {
+        return _stack.size();
+    }
+
+    void start(id_type next_id, int64_t revision)
+    {
+        _stack.emplace_back(_stack.get_allocator());
+        _stack.back().old_next_id = next_id;
+        _stack.back().revision = revision;
+    }
+
+    /**
+    *  Restores the state to how it was prior to the current session using the index callbacks.
+    *
+    *  @return next id at the start of session
+    */
+    template <typename Restore, typename Remove, typename Emplace>
+    id_type undo(Restore&& restore, Remove&& remove, Emplace&& emplace)
+    {
+        auto& head = _stack.back();
+
+        for (auto& item : head.old_values)
+        {
+            restore(item.second);
+        }
+
+        for (auto id : head.new_ids)
+        {
+            remove(id);
+        }
+
+        const id_type old_next_id = head.old_next_id;
+
+        for (auto& item : head.removed_values)
+        {
+            emplace(item.second);
+        }
+
+        _stack.pop_back();
+
+        return old_next_id;
+    }
+
+    /**
+    *  This method works similar to git squash, it merges the change set from the two most
+    *  recent revision numbers into one revision number (reducing the head revision number)
+    *
+    *  This method does not change the state of the index, only the state of the undo buffer.
+    */
+    void squash()
+    {
+        if (_stack.size() == 1)
+        {
+            _stack.pop_front();
+            return;
+        }
+
+        auto& state = _stack.back();
+        auto& prev_state = _stack[_stack.size() - 2];
+
+        // An object's relationship to a state can be:
+        // in new_ids            : new
+        // in old_values (was=X) : upd(was=X)
+        // in removed (was=X)    : del(was=X)
+        // not in any of above   : nop
+        //
+        // When merging A=prev_state and B=state we have a 4x4 matrix of all possibilities:
+        //
+        //                   |--------------------- B ----------------------|
+        //
+        //                +------------+------------+------------+------------+
+        //                | new        | upd(was=Y) | del(was=Y) | nop        |
+        //   +------------+------------+------------+------------+------------+
+        // / | new        | N/A        | new       A| nop       C| new       A|
+        // | +------------+------------+------------+------------+------------+
+        // | | upd(was=X) | N/A        | upd(was=X)A| del(was=X)C| upd(was=X)A|
+        // A +------------+------------+------------+------------+------------+
+        // | | del(was=X) | N/A        | N/A        | N/A        | del(was=X)A|
+        // | +------------+------------+------------+------------+------------+
+        // \ | nop        | new       B| upd(was=Y)B| del(was=Y)B| nop      AB|
+        //   +------------+------------+------------+------------+------------+
+        //
+        // Each entry was composed by labelling what should occur in the given case.
+        //
+        // Type A means the composition of states contains the same entry as the first of the two merged states for that
+        // object.
+        // Type B means the composition of states contains the same entry as the second of the two merged states for
+        // that object.
+        // Type C means the composition of states contains an entry different from either of the merged states for that
+        // object.
+        // Type N/A means the composition of states violates causal timing.
+        // Type AB means both type A and type B simultaneously.
+        //
+        // The merge() operation is defined as modifying prev_state in-place to be the state object which represents the
+        // composition of
+        // state A and B.
+        //
+        // Type A (and AB) can be implemented as a no-op; prev_state already contains the correct value for the merged
+        // state.
+        // Type B (and AB) can be implemented by copying from state to prev_state.
+        // Type C needs special case-by-case logic.
+        // Type N/A can be ignored or assert(false) as it can only occur if prev_state and state have illegal values
+        // (a serious logic error which should never happen).
+        //
+
+        // We can only be outside type A/AB (the nop path) if B is not nop, so it suffices to iterate through B's three
+        // containers.
+
+        for (const auto& item : state.old_values)
+        {
+            if (prev_state.new_ids.find(item.second.id) != prev_state.new_ids.end())
+            {
+                // new+upd -> new, type A
+                continue;
+            }
+            if (prev_state.old_values.find(item.second.id) != prev_state.old_values.end())
+            {
+                // upd(was=X) + upd(was=Y) -> upd(was=X), type A
+                continue;
+            }
+            // del+upd -> N/A
+            assert(prev_state.removed_values.find(item.second.id) == prev_state.removed_values.end());
+            // nop+upd(was=Y) -> upd(was=Y), type B
+            prev_state.old_values.emplace(std::move(item));
+        }
+
+        // *+new, but we assume the N/A cases don't happen, leaving type B nop+new -> new
+        for (auto id : state.new_ids)
+            prev_state.new_ids.insert(id);
+
+        // *+del
+        for (auto& obj : state.removed_values)
+        {
+            if (prev_state.new_ids.find(obj.second.id) != prev_state.new_ids.end())
+            {
+                // new + del -> nop (type C)
+                prev_state.new_ids.erase(obj.second.id);
+                continue;
+            }
+            auto it = prev_state.old_values.find(obj.second.id);
+            if (it != prev_state.old_values.end())
+            {
+                // upd(was=X) + del(was=Y) -> del(was=X)
+                prev_state.removed_values.emplace(std::move(*it));
+                prev_state.old_values.erase(obj.second.id);
+                continue;
+            }
+            // del + del -> N/A
+            assert(prev_state.removed_values.find(obj.second.id) == prev_state.removed_values.end());
+            // nop + del(was=Y) -> del(was=Y)
+            prev_state.removed_values.emplace(std::move(obj)); //[obj.second->id] = std::move(obj.second);
+        }
+
+        _stack.pop_back();
+    }
+
+    /**
+    * Discards all undo history prior to revision
+    */
+    void commit(int64_t revision)
+    {
+        while (_stack.size() && _stack[0].revision <= revision)
+        {
+            _stack.pop_front();
+        }
+    }
+
+    /**
+    *  Memory used by each state of the stack, tree nodes are estimated.
+    */
+    std::vector<undo_revision_memory_stats> get_memory_stats() const
+    {
+        std::vector<undo_revision_memory_stats> result;
+        result.reserve(_stack.size());
+
+        for (const auto& state : _stack)
+        {
+            undo_revision_memory_stats stats;
+            stats.revision = state.revision;
+            stats.objects = state.old_values.size() + state.removed_values.size() + state.new_ids.size();
+            stats.bytes = sizeof(undo_state)
+                + (state.old_values.size() + state.removed_values.size())
+                    * (sizeof(typename undo_state::id_value_type_map::value_type) + tree_node_overhead)
+                + state.new_ids.size() * (sizeof(id_type) + tree_node_overhead);
+
+            for (const auto& item : state.old_values)
+                stats.bytes += dynamic_memory_size(item.second);
+            for (const auto& item : state.removed_values)
+                stats.bytes += dynamic_memory_size(item.second);
+
+            result.push_back(stats);
+        }
+
+        return result;
+    }
+
+    void on_modify(const value_type& v)
+    {
+        if (!enabled())
+            return;
+
+        auto& head = _stack.back();
+
+        if (head.new_ids.find(v.id) != head.new_ids.end())
+            return;
+
+        auto itr = head.old_values.find(v.id);
+        if (itr != head.old_values.end())
+            return;
+
+        head.old_values.emplace(std::pair<id_type, const value_type&>(v.id, v));
+    }
+
+    void on_remove(const value_type& v)
+    {
+        if (!enabled())
+            return;
+
+        auto& head = _stack.back();
+        if (head.new_ids.count(v.id))
+        {
+            head.new_ids.erase(v.id);
+            return;
+        }
+
+        auto itr = head.old_values.find(v.id);
+        if (itr != head.old_values.end())
+        {
+            head.removed_values.emplace(std::move(*itr));
+            head.old_values.erase(v.id);
+            return;
+        }
+
+        if (head.removed_values.count(v.id))
+            return;
+
+        head.removed_values.emplace(std::pair<id_type, const value_type&>(v.id, v));
+    }
+
+    void on_create(const value_type& v)
+    {
+        if (!enabled())
+            return;
+        auto& head = _stack.back();
+
+        head.new_ids.insert(v.id);
+    }
+
+private:
+    fc::shared_deque<undo_state> _stack;
+};
+
+} // namespace chainbase
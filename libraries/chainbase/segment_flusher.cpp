@@ -0,0 +1,149 @@
+#include <chainbase/segment_flusher.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/time.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include <sys/mman.h>
+
+namespace chainbase {
+
+namespace {
+
+uint64_t process_written_bytes()
+{
+#ifdef __linux__
+    std::ifstream io("/proc/self/io");
+    std::string name;
+    uint64_t value = 0;
+    while (io >> name >> value)
+    {
+        if (name == "write_bytes:")
+            return value;
+    }
+#endif
+    return 0;
+}
+}
+
+segment_flusher::segment_flusher(locker_type locker, region_getter_type region_getter, size_t slice_size)
+    : _locker(std::move(locker))
+    , _region_getter(std::move(region_getter))
+    , _slice_size(slice_size)
+{
+    FC_ASSERT(_slice_size > 0);
+
+    _thread = std::thread([this]() { run(); });
+}
+
+segment_flusher::~segment_flusher()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopped = true;
+    }
+    _cv.notify_all();
+    _idle_cv.notify_all();
+
+    _thread.join();
+}
+
+void segment_flusher::request()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _requested = true;
+        ++_stats.requests;
+    }
+    _cv.notify_one();
+}
+
+void segment_flusher::wait()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _idle_cv.wait(lock, [&]() { return _stopped || (!_requested && !_stats.in_progress); });
+}
+
+flush_stats segment_flusher::get_stats() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats;
+}
+
+void segment_flusher::run()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    while (true)
+    {
+        _cv.wait(lock, [&]() { return _stopped || _requested; });
+        if (_stopped)
+            return;
+
+        _requested = false;
+        _stats.in_progress = true;
+
+        lock.unlock();
+
+        const auto start = fc::time_point::now();
+        const uint64_t written_before = process_written_bytes();
+
+        try
+        {
+            flush_pass();
+        }
+        catch (const fc::exception& e)
+        {
+            wlog("Flush of segment file failed: ${e}", ("e", e.to_detail_string()));
+        }
+        catch (const std::exception& e)
+        {
+            wlog("Flush of segment file failed: ${e}", ("e", e.what()));
+        }
+
+        const uint64_t elapsed = (fc::time_point::now() - start).count();
+        const uint64_t written = process_written_bytes() - written_before;
+
+        lock.lock();
+
+        ++_stats.flushes;
+        _stats.last_flush_microseconds = elapsed;
+        _stats.max_flush_microseconds = std::max(_stats.max_flush_microseconds, elapsed);
+        _stats.total_flush_microseconds += elapsed;
+        _stats.last_written_bytes = written;
+        _stats.total_written_bytes += written;
+        _stats.in_progress = false;
+
+        _idle_cv.notify_all();
+    }
+}
+
+void segment_flusher::flush_pass()
+{
+    size_t offset = 0;
+    bool done = false;
+
+    while (!done && !_stopped)
+    {
+        _locker([&]() {
+            const region_type region = _region_getter();
+            if (!region.first || offset >= region.second)
+            {
+                done = true;
+                return;
+            }
+
+            const size_t size = std::min(_slice_size, region.second - offset);
+            if (msync(region.first + offset, size, MS_SYNC) != 0)
+                wlog("Could not flush segment file: ${e}", ("e", std::strerror(errno)));
+
+            offset += size;
+        });
+    }
+}
+}
@@ -1,8 +1,20 @@
 #include <boost/array.hpp>
 #include <boost/filesystem.hpp>
 #include <fc/exception/exception.hpp>
+#include <fc/time.hpp>
 #include <chainbase/segment_manager.hpp>
 
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 namespace chainbase {
 
 struct environment_check
@@ -37,6 +49,63 @@ struct environment_check
     bool windows = false;
 };
 
+namespace {
+
+#ifdef __linux__
+
+// mbind is called directly to avoid dependency on libnuma
+const int mpol_bind = 2;
+const int mpol_interleave = 3;
+
+void set_numa_policy(void* address, size_t size, const mapping_options& options)
+{
+    const size_t bits = sizeof(unsigned long) * CHAR_BIT;
+
+    uint32_t max_node = 0;
+    for (auto node : options.numa_nodes)
+        max_node = std::max(max_node, node);
+
+    std::vector<unsigned long> mask(max_node / bits + 1, 0);
+    for (auto node : options.numa_nodes)
+        mask[node / bits] |= 1ul << (node % bits);
+
+    const int mode = options.numa == mapping_options::numa_policy::bind ? mpol_bind : mpol_interleave;
+
+    if (syscall(SYS_mbind, address, size, mode, mask.data(), mask.size() * bits + 1, 0) != 0)
+        wlog("Could not set NUMA policy for segment file: ${e}", ("e", std::strerror(errno)));
+}
+
+void advise(void* address, size_t size, int advice, const char* name)
+{
+    if (madvise(address, size, advice) != 0)
+        wlog("Could not advise ${a} for segment file: ${e}", ("a", name)("e", std::strerror(errno)));
+}
+
+#endif
+
+void prefault(const void* address, size_t size)
+{
+#ifdef __linux__
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+#else
+    const size_t page_size = 4096;
+#endif
+
+    ilog("Pre-faulting ${n}M of segment file", ("n", size / (1024 * 1024)));
+
+    auto start = fc::time_point::now();
+
+    const volatile char* data = static_cast<const volatile char*>(address);
+    char sum = 0;
+    for (size_t offset = 0; offset < size; offset += page_size)
+        sum ^= data[offset];
+    (void)sum;
+
+    auto elapsed = fc::time_point::now() - start;
+    ilog("Segment file is pre-faulted in ${t} sec", ("t", double(elapsed.count()) / 1000000.0));
+}
+}
+
 //////////////////////////////////////////////////////////////////////////
 
 void segment_manager::create_segment_file(const boost::filesystem::path& file,
@@ -45,6 +114,8 @@ void segment_manager::create_segment_file(const boost::filesystem::path& file,
 {
     ilog("Try to open segment file");
 
+    _segment_path = file;
+
     if (boost::filesystem::exists(file))
     {
         if (read_only)
@@ -81,6 +152,52 @@ void segment_manager::create_segment_file(const boost::filesystem::path& file,
                                                                     file.generic_string().c_str(), shared_file_size));
         _segment->construct<environment_check>("environment")();
     }
+
+    apply_mapping_options();
+}
+
+void segment_manager::apply_mapping_options()
+{
+    FC_ASSERT(_segment);
+
+    void* address = _segment->get_address();
+    const size_t size = _segment->get_size();
+
+#ifdef __linux__
+    if (_mapping_options.numa != mapping_options::numa_policy::none)
+        set_numa_policy(address, size, _mapping_options);
+
+    if (_mapping_options.huge_pages)
+    {
+#ifdef MADV_HUGEPAGE
+        advise(address, size, MADV_HUGEPAGE, "huge pages");
+#else
+        wlog("Transparent huge pages are not supported by this system");
+#endif
+    }
+
+    switch (_mapping_options.advice)
+    {
+    case mapping_options::access_advice::normal:
+        break;
+    case mapping_options::access_advice::random:
+        advise(address, size, MADV_RANDOM, "random access");
+        break;
+    case mapping_options::access_advice::sequential:
+        advise(address, size, MADV_SEQUENTIAL, "sequential access");
+        break;
+    case mapping_options::access_advice::willneed:
+        advise(address, size, MADV_WILLNEED, "will need");
+        break;
+    }
+#else
+    if (_mapping_options.huge_pages || _mapping_options.advice != mapping_options::access_advice::normal
+        || _mapping_options.numa != mapping_options::numa_policy::none)
+        wlog("Mapping options of segment file are supported on Linux only");
+#endif
+
+    if (_mapping_options.prefault)
+        prefault(address, size);
 }
 
 void segment_manager::flush_segment_file()
@@ -94,6 +211,97 @@ void segment_manager::close_segment_file()
     _segment.reset();
 }
 
+void segment_manager::grow_segment_file(uint64_t new_size)
+{
+    FC_ASSERT(_segment && !_read_only);
+
+    const auto file_name = _segment_path.generic_string();
+    const auto existing_file_size = boost::filesystem::file_size(_segment_path);
+    if (new_size <= existing_file_size)
+        return;
+
+    // failure is detected before unmapping while it is possible, pages of grown file are allocated lazily
+    const auto space = boost::filesystem::space(boost::filesystem::absolute(_segment_path).parent_path());
+    if (space.available < new_size - existing_file_size)
+        BOOST_THROW_EXCEPTION(std::runtime_error("not enough disk space to grow database file to requested size."));
+
+    // file can be grown only while it is not mapped
+    _segment.reset();
+
+    bool grown = false;
+    try
+    {
+        grown = boost::interprocess::managed_mapped_file::grow(file_name.c_str(), new_size - existing_file_size);
+    }
+    catch (...)
+    {
+    }
+
+    // file is mapped again even if it was not grown, so that the caller can reattach indexes
+    _segment.reset(new boost::interprocess::managed_mapped_file(boost::interprocess::open_only, file_name.c_str()));
+
+    apply_mapping_options();
+
+    if (!grown)
+        BOOST_THROW_EXCEPTION(std::runtime_error("could not grow database file to requested size."));
+}
+
+void segment_manager::rewrite_segment_file(const std::vector<segment_copier>& copiers)
+{
+    FC_ASSERT(_segment && !_read_only);
+
+    boost::filesystem::path compact_path = _segment_path;
+    compact_path += ".compact";
+
+    boost::filesystem::remove(compact_path);
+
+    try
+    {
+        boost::interprocess::managed_mapped_file dst(boost::interprocess::create_only,
+                                                     compact_path.generic_string().c_str(),
+                                                     boost::filesystem::file_size(_segment_path));
+        dst.construct<environment_check>("environment")();
+
+        for (const auto& copier : copiers)
+            copier(dst);
+
+        dst.flush();
+    }
+    catch (...)
+    {
+        boost::filesystem::remove(compact_path);
+        throw;
+    }
+
+    _segment.reset();
+
+    std::exception_ptr error;
+    try
+    {
+        boost::filesystem::rename(compact_path, _segment_path);
+    }
+    catch (...)
+    {
+        boost::filesystem::remove(compact_path);
+        error = std::current_exception();
+    }
+
+    // the original file is mapped again if it was not replaced, so that the caller can reattach indexes
+    _segment.reset(new boost::interprocess::managed_mapped_file(boost::interprocess::open_only,
+                                                                _segment_path.generic_string().c_str()));
+
+    apply_mapping_options();
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+size_t segment_manager::get_named_objects_count() const
+{
+    FC_ASSERT(_segment);
+    return _segment->get_segment_manager()->get_num_named_objects();
+}
+
 size_t segment_manager::get_free_memory() const
 {
     FC_ASSERT(_segment);
@@ -6,8 +6,11 @@
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index/member.hpp>
+#include <boost/interprocess/managed_mapped_file.hpp>
 
+#include <atomic>
 #include <iostream>
+#include <thread>
 
 using namespace boost::multi_index;
 
@@ -30,6 +33,8 @@ typedef fc::shared_multi_index_container<book,
 
 CHAINBASE_SET_INDEX_TYPE(book, book_index)
 
+FC_REFLECT(book, (id)(a)(b))
+
 class moc_database : public chainbase::database
 {
     typedef chainbase::database _Base;
@@ -146,4 +151,413 @@ BOOST_AUTO_TEST_CASE(open_and_create)
     }
 }
 
+BOOST_AUTO_TEST_CASE(find_by_id)
+{
+    boost::filesystem::path temp = boost::filesystem::unique_path();
+    try
+    {
+        moc_database db;
+        db.open(temp, chainbase::database::read_write, 1024 * 1024 * 8);
+        db.add_index<book_index>();
+
+        for (int i = 0; i < 4; ++i)
+            db.create<book>([&](book& b) { b.a = i; });
+
+        db.remove(db.get(book::id_type(1)));
+        BOOST_CHECK(db.find(book::id_type(1)) == nullptr);
+        BOOST_CHECK_EQUAL(db.get(book::id_type(2)).a, 2);
+
+        db.remove(db.get(book::id_type(0)));
+        BOOST_CHECK(db.find(book::id_type(0)) == nullptr);
+        BOOST_CHECK(db.find(book::id_type(4)) == nullptr);
+
+        {
+            auto session = db.start_undo_session();
+            db.remove(db.get(book::id_type(2)));
+            db.remove(db.get(book::id_type(3)));
+            BOOST_CHECK(db.find(book::id_type(3)) == nullptr);
+            db.create<book>([&](book& b) { b.a = 4; });
+            BOOST_CHECK_EQUAL(db.get(book::id_type(4)).a, 4);
+        }
+
+        BOOST_CHECK(db.find(book::id_type(0)) == nullptr);
+        BOOST_CHECK(db.find(book::id_type(1)) == nullptr);
+        BOOST_CHECK_EQUAL(db.get(book::id_type(2)).a, 2);
+        BOOST_CHECK_EQUAL(db.get(book::id_type(3)).a, 3);
+        BOOST_CHECK(db.find(book::id_type(4)) == nullptr);
+
+        const auto& book4 = db.create<book>([&](book& b) { b.a = 5; });
+        BOOST_CHECK(&db.get(book::id_type(4)) == &book4);
+    }
+    catch (...)
+    {
+        boost::filesystem::remove_all(temp);
+        throw;
+    }
+    boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_CASE(resize_and_compact)
+{
+    boost::filesystem::path temp = boost::filesystem::unique_path();
+    try
+    {
+        moc_database db;
+        db.open(temp, chainbase::database::read_write, 1024 * 1024 * 8);
+        db.add_index<book_index>();
+
+        for (int i = 0; i < 100; ++i)
+            db.create<book>([&](book& b) { b.a = i; });
+
+        {
+            auto session = db.start_undo_session();
+            db.modify(db.get(book::id_type(0)), [&](book& b) { b.a = 100; });
+            session->push();
+        }
+
+        const size_t size = db.get_size();
+
+        db.resize(size * 2);
+
+        BOOST_CHECK_GT(db.get_size(), size);
+        BOOST_CHECK_EQUAL(db.get(book::id_type(0)).a, 100);
+        BOOST_CHECK_EQUAL(db.get(book::id_type(99)).a, 99);
+
+        // undo history is kept
+        db.undo();
+        BOOST_CHECK_EQUAL(db.get(book::id_type(0)).a, 0);
+
+        for (int i = 0; i < 100; i += 2)
+            db.remove(db.get(book::id_type(i)));
+
+        const size_t free_memory = db.get_free_memory();
+
+        db.compact();
+
+        BOOST_CHECK_GE(db.get_free_memory(), free_memory);
+        BOOST_CHECK_EQUAL(db.get_index<book_index>().indices().size(), 50u);
+        BOOST_CHECK(db.find(book::id_type(0)) == nullptr);
+        BOOST_CHECK_EQUAL(db.get(book::id_type(99)).a, 99);
+        BOOST_CHECK_EQUAL(db.create<book>([&](book& b) { b.a = 100; }).id._id, 100);
+    }
+    catch (...)
+    {
+        boost::filesystem::remove_all(temp);
+        throw;
+    }
+    boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_CASE(background_flush)
+{
+    boost::filesystem::path temp = boost::filesystem::unique_path();
+    try
+    {
+        moc_database db;
+        db.open(temp, chainbase::database::read_write, 1024 * 1024 * 8);
+        db.add_index<book_index>();
+
+        BOOST_CHECK_EQUAL(db.get_flush_stats().flushes, 0u);
+
+        db.create<book>([&](book& b) { b.a = 1; });
+        db.flush_async();
+
+        // synchronous flush waits for background one
+        db.flush();
+
+        auto stats = db.get_flush_stats();
+        BOOST_CHECK_EQUAL(stats.requests, 1u);
+        BOOST_CHECK_EQUAL(stats.flushes, 1u);
+        BOOST_CHECK(!stats.in_progress);
+
+        // flush doesn't take database locks, remapping waits for the flushed slice
+        db.with_write_lock([&]() {
+            db.flush_async();
+            db.resize(1024 * 1024 * 16);
+        });
+        db.flush();
+
+        BOOST_CHECK_EQUAL(db.get_flush_stats().requests, 2u);
+        BOOST_CHECK_EQUAL(db.find<book>(book::id_type(0))->a, 1);
+
+        db.close();
+    }
+    catch (...)
+    {
+        boost::filesystem::remove_all(temp);
+        throw;
+    }
+    boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_readers_and_writer)
+{
+    boost::filesystem::path temp = boost::filesystem::unique_path();
+    try
+    {
+        moc_database db;
+        db.open(temp, chainbase::database::read_write, 1024 * 1024 * 8);
+        db.add_index<book_index>();
+
+        const auto id = db.with_write_lock([&]() { return db.create<book>([](book& b) { b.b = 0; }).id; });
+
+        std::atomic<bool> stop(false);
+        std::atomic<int> inconsistent(0);
+        std::atomic<int> reads(0);
+
+        std::vector<std::thread> readers;
+        for (int ci = 0; ci < 4; ++ci)
+        {
+            readers.emplace_back([&]() {
+                while (!stop)
+                {
+                    try
+                    {
+                        db.with_concurrent_read_lock([&]() {
+                            // nested lock on the same thread doesn't wait for the writer
+                            db.with_concurrent_read_lock([&]() {
+                                const auto& b = db.get<book>(id);
+                                const int a = b.a;
+                                // readers outlast writer timeout to make it move to the next lock
+                                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                                if (a != b.b)
+                                    ++inconsistent;
+                            });
+                        });
+                        ++reads;
+                    }
+                    catch (const std::runtime_error&)
+                    {
+                        // lock timeout
+                    }
+                }
+            });
+        }
+
+        // fewer writes than rotated locks, a lock is reinitialized when writer wraps around
+        for (int ci = 0; ci < CHAINBASE_NUM_RW_LOCKS / 2; ++ci)
+        {
+            db.with_write_lock(
+                [&]() {
+                    const auto& b = db.get<book>(id);
+                    db.modify(b, [](book& b) { ++b.a; });
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    db.modify(b, [](book& b) { ++b.b; });
+                },
+                100);
+        }
+
+        stop = true;
+        for (auto& reader : readers)
+            reader.join();
+
+        BOOST_CHECK_GT(reads, 0);
+        BOOST_CHECK_EQUAL(inconsistent, 0);
+        BOOST_CHECK_EQUAL(db.get<book>(id).a, CHAINBASE_NUM_RW_LOCKS / 2);
+
+        db.close();
+    }
+    catch (...)
+    {
+        boost::filesystem::remove_all(temp);
+        throw;
+    }
+    boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_CASE(index_memory_stats)
+{
+    boost::filesystem::path temp = boost::filesystem::unique_path();
+    try
+    {
+        moc_database db;
+        db.open(temp, chainbase::database::read_write, 1024 * 1024 * 8);
+        db.add_index<book_index>();
+
+        for (int ci = 0; ci < 100; ++ci)
+            db.create<book>([&](book& b) { b.a = ci; });
+
+        auto stats = db.get_memory_stats(10);
+        BOOST_REQUIRE_EQUAL(stats.size(), 1u);
+        BOOST_CHECK_EQUAL(stats[0].nodes, 100u);
+        BOOST_CHECK_EQUAL(stats[0].node_bytes, 100u * sizeof(book_index::node_type));
+        BOOST_CHECK_GE(stats[0].id_table_bytes, 100u * sizeof(void*));
+        BOOST_CHECK_EQUAL(stats[0].dynamic_bytes, 0u);
+        BOOST_CHECK(stats[0].dynamic_bytes_estimated);
+        BOOST_CHECK(stats[0].undo_revisions.empty());
+
+        {
+            auto session = db.start_undo_session();
+            db.modify(db.get(book::id_type(1)), [](book& b) { b.a = 1000; });
+            db.remove(db.get(book::id_type(2)));
+
+            stats = db.get_memory_stats(1000);
+            BOOST_CHECK(!stats[0].dynamic_bytes_estimated);
+            BOOST_REQUIRE_EQUAL(stats[0].undo_revisions.size(), 1u);
+            BOOST_CHECK_EQUAL(stats[0].undo_revisions[0].objects, 2u);
+            BOOST_CHECK_GT(stats[0].undo_bytes, 2u * sizeof(book));
+        }
+
+        db.close();
+    }
+    catch (...)
+    {
+        boost::filesystem::remove_all(temp);
+        throw;
+    }
+    boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_CASE(index_digest)
+{
+    boost::filesystem::path temp = boost::filesystem::unique_path();
+    try
+    {
+        moc_database db;
+        db.open(temp, chainbase::database::read_write, 1024 * 1024 * 8);
+        db.add_index<book_index>();
+
+        for (int ci = 0; ci < 10; ++ci)
+            db.create<book>([&](book& b) { b.a = ci; });
+
+        BOOST_CHECK(!db.get_digests()[0].enabled);
+
+        db.for_each_index([](chainbase::abstract_generic_index_i& item) { item.set_digest_enabled(true); });
+
+        const auto initial = db.get_digests()[0];
+        BOOST_CHECK(initial.enabled);
+        BOOST_CHECK_EQUAL(initial.objects, 10u);
+
+        {
+            auto session = db.start_undo_session();
+            db.modify(db.get(book::id_type(1)), [](book& b) { b.a = 1000; });
+            db.remove(db.get(book::id_type(2)));
+            db.create<book>([&](book& b) { b.a = 11; });
+
+            const auto changed = db.get_digests()[0];
+            BOOST_CHECK(changed.digest != initial.digest);
+
+            // incremental digest is the same as calculated from all objects
+            db.for_each_index([](chainbase::abstract_generic_index_i& item) { item.set_digest_enabled(false); });
+            db.for_each_index([](chainbase::abstract_generic_index_i& item) { item.set_digest_enabled(true); });
+            BOOST_CHECK(db.get_digests()[0].digest == changed.digest);
+        }
+
+        // undo restores digest
+        BOOST_CHECK(db.get_digests()[0].digest == initial.digest);
+
+        db.close();
+    }
+    catch (...)
+    {
+        boost::filesystem::remove_all(temp);
+        throw;
+    }
+    boost::filesystem::remove_all(temp);
+}
+
+template <template <typename> class UndoStorage> void check_undo_storage()
+{
+    using index_type = chainbase::generic_index<book_index, UndoStorage>;
+
+    boost::filesystem::path temp = boost::filesystem::unique_path();
+    boost::interprocess::managed_mapped_file segment(boost::interprocess::create_only, temp.generic_string().c_str(),
+                                                     1024 * 1024 * 8);
+    try
+    {
+        index_type* idx = segment.construct<index_type>("books")(segment.get_segment_manager());
+        chainbase::abstract_generic_index_i& undo_idx = *idx;
+
+        const auto& first = idx->emplace([](book& b) { b.a = 1; });
+
+        {
+            auto block = undo_idx.start_undo_session();
+            {
+                auto trx = undo_idx.start_undo_session();
+                idx->modify(first, [](book& b) { b.a = 2; });
+                const auto& second = idx->emplace([](book& b) { b.a = 10; });
+                idx->modify(second, [](book& b) { b.a = 11; });
+                trx->push();
+            }
+            undo_idx.squash();
+            {
+                auto trx = undo_idx.start_undo_session();
+                idx->modify(first, [](book& b) { b.a = 3; });
+                idx->remove(idx->get(book::id_type(1)));
+                trx->push();
+            }
+            undo_idx.squash();
+
+            BOOST_REQUIRE_EQUAL(first.a, 3);
+            BOOST_REQUIRE_EQUAL(idx->indices().size(), 1u);
+            BOOST_REQUIRE_EQUAL(undo_idx.revision(), 1);
+        }
+
+        BOOST_REQUIRE_EQUAL(idx->indices().size(), 1u);
+        BOOST_REQUIRE_EQUAL(idx->get(book::id_type(0)).a, 1);
+        BOOST_REQUIRE_EQUAL(undo_idx.revision(), 0);
+
+        {
+            auto block = undo_idx.start_undo_session();
+            idx->modify(first, [](book& b) { b.a = 4; });
+            block->push();
+        }
+        {
+            auto block = undo_idx.start_undo_session();
+            idx->remove(first);
+            block->push();
+        }
+        undo_idx.commit(1);
+        undo_idx.undo();
+
+        BOOST_REQUIRE_EQUAL(idx->indices().size(), 1u);
+        BOOST_REQUIRE_EQUAL(idx->get(book::id_type(0)).a, 4);
+
+        // nothing to undo after commit
+        undo_idx.undo_all();
+        BOOST_REQUIRE_EQUAL(idx->get(book::id_type(0)).a, 4);
+
+        const auto& third = idx->emplace([](book& b) { b.a = 5; });
+        BOOST_REQUIRE(third.id == book::id_type(1)); // ids of undone objects are reused
+
+        {
+            auto block = undo_idx.start_undo_session();
+            idx->modify(first, [](book& b) { b.a = 6; });
+            idx->modify(first, [](book& b) { b.a = 7; });
+            idx->modify(first, [](book& b) { b.a = 8; });
+
+            // repeated modifications of an object are recorded once per session
+            BOOST_REQUIRE_EQUAL(idx->get_memory_stats(0).undo_revisions.back().objects, 1u);
+
+            idx->modify(third, [](book& b) { b.a = 9; });
+            idx->remove(third);
+            const auto& temp = idx->emplace([](book& b) { b.a = 10; });
+            idx->modify(temp, [](book& b) { b.a = 11; });
+            idx->remove(temp);
+        }
+
+        BOOST_REQUIRE_EQUAL(idx->indices().size(), 2u);
+        BOOST_REQUIRE_EQUAL(idx->get(book::id_type(0)).a, 4);
+        BOOST_REQUIRE_EQUAL(idx->get(book::id_type(1)).a, 5);
+
+        segment.destroy_ptr(idx);
+    }
+    catch (...)
+    {
+        boost::filesystem::remove_all(temp);
+        throw;
+    }
+    boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_CASE(undo_tree_storage)
+{
+    check_undo_storage<chainbase::undo_tree>();
+}
+
+BOOST_AUTO_TEST_CASE(undo_journal_storage)
+{
+    check_undo_storage<chainbase::undo_journal>();
+}
+
 // BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,200 @@
+// Compares modify, undo and squash throughput of undo storages of generic_index.
+//
+// Usage: chainbase_undo_benchmark [objects] [operations]
+
+#include <chainbase/chainbase.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/managed_mapped_file.hpp>
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/member.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+using namespace boost::multi_index;
+
+namespace {
+
+struct post : public chainbase::object<0, post>
+{
+    CHAINBASE_DEFAULT_DYNAMIC_CONSTRUCTOR(post, (body))
+
+    id_type id;
+    int64_t net_votes = 0;
+    fc::shared_string body;
+};
+
+typedef fc::shared_multi_index_container<post,
+                                         indexed_by<ordered_unique<member<post, post::id_type, &post::id>>,
+                                                    ordered_non_unique<member<post, int64_t, &post::net_votes>>>>
+    post_index;
+}
+
+FC_REFLECT(post, (id)(net_votes)(body))
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+double seconds_since(const clock_type::time_point& start)
+{
+    return std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+void report(const std::string& storage, const std::string& name, size_t ops, double seconds)
+{
+    std::cout << std::left << std::setw(14) << storage << std::setw(10) << name << std::right << std::setw(12)
+              << std::fixed << std::setprecision(0) << ops / seconds << " ops/s" << std::endl;
+}
+
+template <template <typename> class UndoStorage> struct undo_benchmark
+{
+    using index_type = chainbase::generic_index<post_index, UndoStorage>;
+
+    undo_benchmark(const std::string& storage, size_t objects, size_t ops)
+        : _storage(storage)
+        , _objects(objects)
+        , _ops(ops)
+        , _path(boost::filesystem::unique_path())
+        , _segment(boost::interprocess::create_only, _path.generic_string().c_str(), 1024ull * 1024 * 1024)
+    {
+        _index = _segment.construct<index_type>("posts")(_segment.get_segment_manager());
+
+        const std::string body(512, 'x');
+        for (size_t ci = 0; ci < _objects; ++ci)
+        {
+            _index->emplace([&](post& p) { fc::from_string(p.body, body); });
+        }
+    }
+
+    ~undo_benchmark()
+    {
+        _segment.destroy_ptr(_index);
+        boost::filesystem::remove(_path);
+    }
+
+    void run()
+    {
+        bench_modify();
+        bench_squash();
+        bench_undo();
+    }
+
+private:
+    // single session with many modifications, same objects are modified repeatedly
+    void bench_modify()
+    {
+        auto session = undo().start_undo_session();
+
+        auto start = clock_type::now();
+        modify(_ops);
+        report(_storage, "modify", _ops, seconds_since(start));
+    }
+
+    // transaction sessions squashed into block session
+    void bench_squash()
+    {
+        const size_t ops_per_session = 10;
+        const size_t sessions = _ops / ops_per_session;
+
+        auto block = undo().start_undo_session();
+
+        double squash_seconds = 0;
+        for (size_t ci = 0; ci < sessions; ++ci)
+        {
+            auto trx = undo().start_undo_session();
+            modify(ops_per_session);
+            create_and_remove();
+            trx->push();
+
+            auto start = clock_type::now();
+            undo().squash();
+            squash_seconds += seconds_since(start);
+        }
+
+        report(_storage, "squash", sessions, squash_seconds);
+    }
+
+    void bench_undo()
+    {
+        const int64_t votes_before = total_votes();
+
+        auto session = undo().start_undo_session();
+        modify(_ops);
+        create_and_remove();
+        session->push();
+
+        auto start = clock_type::now();
+        undo().undo();
+        report(_storage, "undo", _ops, seconds_since(start));
+
+        if (total_votes() != votes_before)
+            throw std::logic_error(_storage + ": state is not restored by undo");
+    }
+
+    void modify(size_t ops)
+    {
+        std::uniform_int_distribution<int64_t> dist(0, _objects - 1);
+        for (size_t ci = 0; ci < ops; ++ci)
+        {
+            const auto& p = _index->get(post::id_type(dist(_rand)));
+            _index->modify(p, [&](post& v) { ++v.net_votes; });
+        }
+    }
+
+    void create_and_remove()
+    {
+        const auto& p = _index->emplace([&](post& v) { v.net_votes = -1; });
+        _index->remove(p);
+    }
+
+    int64_t total_votes() const
+    {
+        int64_t result = 0;
+        for (const auto& p : _index->indices())
+            result += p.net_votes;
+        return result;
+    }
+
+    chainbase::abstract_generic_index_i& undo()
+    {
+        return *_index;
+    }
+
+    std::string _storage;
+    size_t _objects;
+    size_t _ops;
+    boost::filesystem::path _path;
+    boost::interprocess::managed_mapped_file _segment;
+    index_type* _index = nullptr;
+    std::mt19937 _rand{ 42 };
+};
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        const size_t objects = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+        const size_t ops = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 200000;
+
+        std::cout << "objects: " << objects << ", operations: " << ops << std::endl;
+
+        undo_benchmark<chainbase::undo_tree>("undo_tree", objects, ops).run();
+        undo_benchmark<chainbase::undo_journal>("undo_journal", objects, ops).run();
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
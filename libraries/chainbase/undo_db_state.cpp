@@ -34,4 +34,32 @@ abstract_undo_session_ptr undo_db_state::start_undo_session()
 
     return std::move(abstract_undo_session_ptr(new session_container(std::move(sub_sessions))));
 }
+
+std::vector<index_memory_stats> undo_db_state::get_memory_stats(size_t max_samples) const
+{
+    std::vector<index_memory_stats> result;
+    result.reserve(_index_map.size());
+
+    for (const auto& item : _index_map)
+    {
+        const abstract_generic_index_i* index = static_cast<const abstract_generic_index_i*>(item.second);
+        result.push_back(index->get_memory_stats(max_samples));
+    }
+
+    return result;
+}
+
+std::vector<index_digest> undo_db_state::get_digests() const
+{
+    std::vector<index_digest> result;
+    result.reserve(_index_map.size());
+
+    for (const auto& item : _index_map)
+    {
+        const abstract_generic_index_i* index = static_cast<const abstract_generic_index_i*>(item.second);
+        result.push_back(index->get_digest());
+    }
+
+    return result;
+}
 }
@@ -1,8 +1,10 @@
 #include <scorum/blockchain_history/account_history_api.hpp>
 #include <scorum/blockchain_history/blockchain_history_plugin.hpp>
+#include <scorum/blockchain_history/history_archive.hpp>
 #include <scorum/blockchain_history/schema/account_history_object.hpp>
 #include <scorum/app/api_context.hpp>
 #include <scorum/app/application.hpp>
+#include <scorum/app/api_thread_pool.hpp>
 #include <scorum/blockchain_history/schema/operation_objects.hpp>
 #include <scorum/common_api/config_api.hpp>
 #include <scorum/protocol/operations.hpp>
@@ -13,17 +15,66 @@ namespace scorum {
 namespace blockchain_history {
 
 namespace detail {
+
+/// history object of shared memory or entry of history archive
+struct history_entry
+{
+    uint32_t sequence = 0;
+    int64_t op = 0;
+    std::vector<int64_t> progress;
+};
+
+template <typename history_object_type> std::vector<int64_t> get_progress(const history_object_type&)
+{
+    return std::vector<int64_t>();
+}
+
+template <uint16_t HistoryType>
+std::vector<int64_t> get_progress(const withdrawals_history_object<HistoryType>& obj)
+{
+    std::vector<int64_t> result;
+    for (const auto& id : obj.progress)
+        result.push_back(id._id);
+    return result;
+}
+
 class account_history_api_impl
 {
 public:
     scorum::app::application& _app;
+    std::shared_ptr<const history_archive> _archive;
 
 public:
     account_history_api_impl(scorum::app::application& app)
         : _app(app)
     {
+        auto plugin = _app.get_plugin<blockchain_history_plugin>(BLOCKCHAIN_HISTORY_PLUGIN_NAME);
+        if (plugin)
+            _archive = plugin->archive();
+    }
+
+    template <typename Lambda> auto with_read_lock(Lambda&& callback) const -> decltype((*(Lambda*)nullptr)())
+    {
+        return _app.api_pool().with_read_lock(API_ACCOUNT_HISTORY, *_app.chain_database(),
+                                              std::forward<Lambda>(callback));
+    }
+
+    applied_operation get_operation(int64_t id) const
+    {
+        const auto* obj = _app.chain_database()->find<operation_object>(operation_object::id_type(id));
+        if (obj)
+            return *obj;
+
+        fc::optional<applied_operation> op;
+        if (_archive)
+            op = _archive->find_operation(id);
+        FC_ASSERT(op.valid(), "Operation ${id} is not found", ("id", id));
+        return *op;
     }
 
+    /**
+    *  Newer part of history is kept in shared memory, irreversible part could be moved to the archive.
+    */
     template <typename history_object_type, typename fill_result_functor>
     void get_history(const std::string& account, uint64_t from, uint32_t limit, fill_result_functor& funct) const
     {
@@ -35,21 +86,44 @@ public:
                   ("l", limit)("2", get_api_config(API_ACCOUNT_HISTORY).max_blockchain_history_depth));
         FC_ASSERT(from >= limit, "From must be greater than limit");
 
+        const uint16_t list = history_object_type::type_id;
+        const uint64_t archived = _archive ? _archive->next_sequence(list, account) : 0;
+
         const auto& idx = db->get_index<history_index<history_object_type>>().indices().get<by_account>();
-        auto itr = idx.lower_bound(boost::make_tuple(account, from));
-        if (itr != idx.end())
+
+        auto last = idx.lower_bound(account);
+        if (last != idx.end() && last->account == account)
+            from = std::min<uint64_t>(from, last->sequence);
+        else if (archived)
+            from = std::min<uint64_t>(from, archived - 1);
+        else
+            return;
+
+        const uint64_t to = from >= limit ? from - limit + 1 : 0;
+
+        uint64_t lowest = from + 1;
+        for (auto itr = idx.lower_bound(boost::make_tuple(account, from));
+             itr != idx.end() && itr->account == account && itr->sequence >= to; ++itr)
         {
-            auto end = idx.upper_bound(boost::make_tuple(account, int64_t(0)));
-            int64_t pos = int64_t(itr->sequence) - limit;
-            if (pos > 0)
-            {
-                end = idx.lower_bound(boost::make_tuple(account, pos));
-            }
-            while (itr != end)
-            {
-                funct(*itr);
-                ++itr;
-            }
+            history_entry entry;
+            entry.sequence = itr->sequence;
+            entry.op = itr->op._id;
+            entry.progress = get_progress(*itr);
+            funct(entry);
+
+            lowest = itr->sequence;
+        }
+
+        if (lowest > to && archived > to)
+        {
+            _archive->get_postings(list, account, to, std::min(lowest - 1, archived - 1),
+                                   [&](const history_archive::posting_entry& posting) {
+                                       history_entry entry;
+                                       entry.sequence = posting.sequence;
+                                       entry.op = posting.op;
+                                       entry.progress = posting.progress;
+                                       funct(entry);
+                                   });
         }
     }
 
@@ -58,9 +132,7 @@ public:
     {
         std::map<uint32_t, applied_operation> result;
 
-        const auto db = _app.chain_database();
-
-        auto fill_funct = [&](const history_object_type& hobj) { result[hobj.sequence] = db->get(hobj.op); };
+        auto fill_funct = [&](const history_entry& entry) { result[entry.sequence] = get_operation(entry.op); };
         this->template get_history<history_object_type>(account, from, limit, fill_funct);
 
         return result;
@@ -85,7 +157,7 @@ std::map<uint32_t, applied_operation>
 account_history_api::get_account_scr_to_scr_transfers(const std::string& account, uint64_t from, uint32_t limit) const
 {
     const auto db = _impl->_app.chain_database();
-    return db->with_read_lock(
+    return _impl->with_read_lock(
         [&]() { return _impl->get_history<transfers_to_scr_history_object>(account, from, limit); });
 }
 
@@ -93,7 +165,7 @@ std::map<uint32_t, applied_operation>
 account_history_api::get_account_scr_to_sp_transfers(const std::string& account, uint64_t from, uint32_t limit) const
 {
     const auto db = _impl->_app.chain_database();
-    return db->with_read_lock(
+    return _impl->with_read_lock(
         [&]() { return _impl->get_history<transfers_to_sp_history_object>(account, from, limit); });
 }
 
@@ -101,18 +173,17 @@ std::map<uint32_t, applied_operation>
 account_history_api::get_account_history(const std::string& account, uint64_t from, uint32_t limit) const
 {
     const auto db = _impl->_app.chain_database();
-    return db->with_read_lock([&]() { return _impl->get_history<account_history_object>(account, from, limit); });
+    return _impl->with_read_lock([&]() { return _impl->get_history<account_history_object>(account, from, limit); });
 }
 
 std::map<uint32_t, applied_withdraw_operation>
 account_history_api::get_account_sp_to_scr_transfers(const std::string& account, uint64_t from, uint32_t limit) const
 {
-    const auto db = _impl->_app.chain_database();
-    return db->with_read_lock([&]() {
+    return _impl->with_read_lock([&]() {
         std::map<uint32_t, applied_withdraw_operation> result;
 
-        auto fill_funct = [&](const withdrawals_to_scr_history_object& obj) {
-            auto it = result.emplace(obj.sequence, applied_withdraw_operation(db->get(obj.op))).first;
+        auto fill_funct = [&](const detail::history_entry& obj) {
+            auto it = result.emplace(obj.sequence, applied_withdraw_operation(_impl->get_operation(obj.op))).first;
             auto& applied_op = it->second;
 
             share_type to_withdraw = 0;
@@ -126,7 +197,7 @@ account_history_api::get_account_sp_to_scr_transfers(const std::string& account,
             }
             else if (!obj.progress.empty())
             {
-                auto last_op = fc::raw::unpack<operation>(db->get(obj.progress.back()).serialized_op);
+                auto last_op = _impl->get_operation(obj.progress.back()).op;
 
                 last_op.weak_visit(
                     [&](const acc_finished_vesting_withdraw_operation&) {
@@ -141,8 +212,7 @@ account_history_api::get_account_sp_to_scr_transfers(const std::string& account,
 
                 if (obj.progress.size() > 1)
                 {
-                    auto before_last_op_obj = db->get(*(obj.progress.rbegin() + 1));
-                    auto before_last_op = fc::raw::unpack<operation>(before_last_op_obj.serialized_op);
+                    auto before_last_op = _impl->get_operation(*(obj.progress.rbegin() + 1)).op;
 
                     before_last_op.weak_visit([&](const acc_finished_vesting_withdraw_operation&) {
                         // if pre-last 'progress' operation is 'acc_finished_' then withdraw was finished
@@ -152,7 +222,7 @@ account_history_api::get_account_sp_to_scr_transfers(const std::string& account,
 
                 for (auto& id : obj.progress)
                 {
-                    auto op = fc::raw::unpack<operation>(db->get(id).serialized_op);
+                    auto op = _impl->get_operation(id).op;
 
                     op.weak_visit(
                         [&](const acc_to_acc_vesting_withdraw_operation& op) {
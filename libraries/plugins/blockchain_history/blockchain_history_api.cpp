@@ -1,7 +1,9 @@
 #include <scorum/blockchain_history/blockchain_history_api.hpp>
 #include <scorum/blockchain_history/blockchain_history_plugin.hpp>
+#include <scorum/blockchain_history/history_archive.hpp>
 #include <scorum/blockchain_history/schema/operation_objects.hpp>
 #include <scorum/app/application.hpp>
+#include <scorum/app/api_thread_pool.hpp>
 #include <scorum/chain/services/dynamic_global_property.hpp>
 #include <scorum/common_api/config_api.hpp>
 
@@ -19,11 +21,25 @@ class blockchain_history_api_impl
 public:
     scorum::app::application& _app;
     std::shared_ptr<chain::database> _db;
+    std::shared_ptr<const history_archive> _archive;
 
 private:
+    applied_operation get_operation(int64_t id) const
+    {
+        const auto* obj = _db->find<operation_object>(operation_object::id_type(id));
+        if (obj)
+            return *obj;
+
+        fc::optional<applied_operation> op;
+        if (_archive)
+            op = _archive->find_operation(id);
+        FC_ASSERT(op.valid(), "Operation ${id} is not found", ("id", id));
+        return *op;
+    }
+
     template <typename ObjectType> applied_operation get_filtered_operation(const ObjectType& obj) const
     {
-        return _db->get(obj.op);
+        return get_operation(obj.op._id);
     }
 
     applied_operation get_operation(const filtered_not_virt_operations_history_object& obj) const
@@ -53,11 +69,48 @@ private:
         return _db->obtain_service<dbs_dynamic_global_property>().get().head_block_number;
     }
 
+    /// id following the last archived object of index
+    int64_t get_archived_end(const operation_index&) const
+    {
+        return _archive ? _archive->next_operation_id() : 0;
+    }
+
+    template <typename IndexType> int64_t get_archived_end(const IndexType&) const
+    {
+        return _archive ? _archive->next_sequence(IndexType::value_type::type_id, account_name_type()) : 0;
+    }
+
+    template <typename Result>
+    void get_archived_ops(const operation_index&, int64_t from, int64_t to, Result& result) const
+    {
+        _archive->get_operations(from, to, [&](int64_t id, const applied_operation& op) {
+            result[(uint32_t)id] = op;
+            return true;
+        });
+    }
+
+    template <typename IndexType, typename Result>
+    void get_archived_ops(const IndexType&, int64_t from, int64_t to, Result& result) const
+    {
+        _archive->get_postings(IndexType::value_type::type_id, account_name_type(), from, to,
+                               [&](const history_archive::posting_entry& posting) {
+                                   result[(uint32_t)posting.sequence] = get_operation(posting.op);
+                               });
+    }
+
 public:
     blockchain_history_api_impl(scorum::app::application& app)
         : _app(app)
         , _db(_app.chain_database())
     {
+        auto plugin = _app.get_plugin<blockchain_history_plugin>(BLOCKCHAIN_HISTORY_PLUGIN_NAME);
+        if (plugin)
+            _archive = plugin->archive();
+    }
+
+    template <typename Lambda> auto with_read_lock(Lambda&& callback) const -> decltype((*(Lambda*)nullptr)())
+    {
+        return _app.api_pool().with_read_lock(API_BLOCKCHAIN_HISTORY, *_db, std::forward<Lambda>(callback));
     }
 
     using result_type = std::map<uint32_t, applied_operation>;
@@ -72,26 +125,35 @@ public:
 
         result_type result;
 
-        const auto& idx = _db->get_index<IndexType>().indices().get<by_id>();
-        if (idx.empty())
+        const auto& indices = _db->get_index<IndexType>().indices();
+        const auto& idx = indices.template get<by_id>();
+
+        // older operations could be moved to the archive
+        const int64_t archived_end = get_archived_end(indices);
+
+        int64_t last = archived_end - 1;
+        if (!idx.empty())
+            last = idx.rbegin()->id._id;
+        if (last < 0)
             return result;
 
         // move to last operation object
-        auto itr = idx.lower_bound(from_op);
-        if (itr == idx.end())
-            --itr;
-
-        auto start = (int64_t(itr->id._id) - limit);
-        auto end = itr->id._id;
+        auto end = std::min<int64_t>(from_op, last);
+        auto start = end - limit;
         auto range = idx.range(start < boost::lambda::_1, boost::lambda::_1 <= end);
 
+        int64_t lowest = end + 1;
         for (auto it = range.first; it != range.second; ++it)
         {
             auto id = it->id;
             FC_ASSERT(id._id >= 0, "Invalid operation_object id");
             result[(uint32_t)id._id] = get_operation(*it);
+            lowest = std::min(lowest, id._id);
         }
 
+        if (lowest > start + 1 && archived_end > start + 1)
+            get_archived_ops(indices, std::max<int64_t>(start + 1, 0), std::min(lowest, archived_end) - 1, result);
+
         return result;
     }
 
@@ -113,7 +175,21 @@ public:
 
         result_type result;
 
-        const auto& idx = _db->get_index<IndexType>().indices().get<by_timestamp>();
+        // archived operations precede operations of shared memory both by ids and timestamps
+        const int64_t archived_end = _archive ? _archive->next_operation_id() : 0;
+        if (archived_end > 0)
+        {
+            _archive->get_operations_by_time(from, to, [&](int64_t id, const applied_operation& op) {
+                if (id > from_op)
+                    return true;
+
+                --limit;
+                result[(uint32_t)id] = op;
+                return limit > 0;
+            });
+        }
+
+        const auto& idx = _db->get_index<IndexType>().indices().template get<by_timestamp>();
         if (idx.empty())
             return result;
 
@@ -125,7 +201,7 @@ public:
             auto id = it->id;
             FC_ASSERT(id._id >= 0, "Invalid operation_object id");
             const operation_object& op = (*it);
-            if (id > from_op)
+            if (id > from_op || id._id < archived_end)
                 continue;
 
             --limit;
@@ -141,6 +217,15 @@ public:
 
         result_type result;
 
+        if (_archive && block_num <= _archive->last_block())
+        {
+            _archive->get_operations_in_block(block_num, [&](int64_t id, const applied_operation& op) {
+                if (operation_filter(op.op))
+                    result[(uint32_t)id] = op;
+                return true;
+            });
+        }
+
         auto range = idx.equal_range(block_num);
 
         for (auto it = range.first; it != range.second; ++it)
@@ -178,6 +263,20 @@ public:
             result.transaction_num = itr->trx_in_block;
             return result;
         }
+
+        uint32_t block = 0;
+        uint32_t trx_in_block = 0;
+        if (_archive && _archive->find_transaction(id, block, trx_in_block))
+        {
+            auto blk = _db->fetch_block_by_number(block);
+            FC_ASSERT(blk.valid());
+            FC_ASSERT(blk->transactions.size() > trx_in_block);
+            annotated_signed_transaction result = blk->transactions[trx_in_block];
+            result.block_num = block;
+            result.transaction_num = trx_in_block;
+            return result;
+        }
+
         FC_ASSERT(false, "Unknown Transaction ${t}", ("t", id));
 #endif
     }
@@ -239,7 +338,7 @@ void blockchain_history_api::on_api_startup()
 std::map<uint32_t, applied_operation> blockchain_history_api::get_ops_history(
     uint32_t from_op, uint32_t limit, applied_operation_type type_of_operation) const
 {
-    return _impl->_app.chain_database()->with_read_lock([&]() {
+    return _impl->with_read_lock([&]() {
         switch (type_of_operation)
         {
         case applied_operation_type::not_virt:
@@ -260,14 +359,14 @@ std::map<uint32_t, applied_operation> blockchain_history_api::get_ops_history_by
                                                                                       uint32_t from_op,
                                                                                       uint32_t limit) const
 {
-    return _impl->_app.chain_database()->with_read_lock(
+    return _impl->with_read_lock(
         [&]() { return _impl->get_ops_history_by_time<operation_index>(from, to, from_op, limit); });
 }
 
 std::map<uint32_t, applied_operation>
 blockchain_history_api::get_ops_in_block(uint32_t block_num, applied_operation_type type_of_operation) const
 {
-    return _impl->_app.chain_database()->with_read_lock([&]() {
+    return _impl->with_read_lock([&]() {
         switch (type_of_operation)
         {
         case applied_operation_type::market:
@@ -285,7 +384,7 @@ blockchain_history_api::get_ops_in_block(uint32_t block_num, applied_operation_t
 
 annotated_signed_transaction blockchain_history_api::get_transaction(transaction_id_type id) const
 {
-    return _impl->_app.chain_database()->with_read_lock([&]() { return _impl->get_transaction(id); });
+    return _impl->with_read_lock([&]() { return _impl->get_transaction(id); });
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -294,19 +393,19 @@ annotated_signed_transaction blockchain_history_api::get_transaction(transaction
 
 optional<block_header> blockchain_history_api::get_block_header(uint32_t block_num) const
 {
-    return _impl->_db->with_read_lock([&]() { return _impl->get_block(block_num); });
+    return _impl->with_read_lock([&]() { return _impl->get_block(block_num); });
 }
 
 optional<signed_block_api_obj> blockchain_history_api::get_block(uint32_t block_num) const
 {
-    return _impl->_db->with_read_lock([&]() { return _impl->get_block(block_num); });
+    return _impl->with_read_lock([&]() { return _impl->get_block(block_num); });
 }
 
 std::map<uint32_t, block_header> blockchain_history_api::get_block_headers_history(uint32_t block_num,
                                                                                    uint32_t limit) const
 {
     FC_ASSERT(!_impl->_app.is_read_only(), "Disabled for read only mode");
-    return _impl->_db->with_read_lock(
+    return _impl->with_read_lock(
         [&]() { return _impl->get_blocks_history_by_number<block_header>(block_num, limit); });
 }
 
@@ -314,8 +413,17 @@ std::map<uint32_t, signed_block_api_obj> blockchain_history_api::get_blocks_hist
                                                                                     uint32_t limit) const
 {
     FC_ASSERT(!_impl->_app.is_read_only(), "Disabled for read only mode");
-    return _impl->_db->with_read_lock(
+    return _impl->with_read_lock(
         [&]() { return _impl->get_blocks_history_by_number<signed_block_api_obj>(block_num, limit); });
 }
+
+history_export_stats blockchain_history_api::get_history_export_stats() const
+{
+    return _impl->with_read_lock([&]() {
+        auto plugin = _impl->_app.get_plugin<blockchain_history_plugin>(BLOCKCHAIN_HISTORY_PLUGIN_NAME);
+        FC_ASSERT(plugin, "Blockchain history plugin is not loaded");
+        return plugin->export_stats();
+    });
+}
 }
 }
@@ -1,7 +1,10 @@
 #include <scorum/blockchain_history/blockchain_history_plugin.hpp>
 #include <scorum/blockchain_history/account_history_api.hpp>
 #include <scorum/blockchain_history/blockchain_history_api.hpp>
+#include <scorum/blockchain_history/history_archive.hpp>
+#include <scorum/blockchain_history/history_exporter.hpp>
 #include <scorum/blockchain_history/schema/account_history_object.hpp>
+#include <scorum/blockchain_history/schema/applied_operation.hpp>
 
 #include <scorum/account_identity/impacted.hpp>
 
@@ -10,6 +13,7 @@
 
 #include <scorum/chain/database/database.hpp>
 #include <scorum/chain/operation_notification.hpp>
+#include <scorum/chain/services/dynamic_global_property.hpp>
 #include <scorum/blockchain_history/schema/operation_objects.hpp>
 
 #include <fc/smart_ref_impl.hpp>
@@ -26,6 +30,9 @@ namespace detail {
 
 using namespace scorum::protocol;
 
+/// bounds the number of objects removed from shared memory by one block, the rest is archived by next blocks
+const size_t max_archived_operations_per_block = 100000;
+
 class blockchain_history_plugin_impl
 {
 public:
@@ -56,30 +63,77 @@ public:
         db.add_plugin_index<filtered_market_operations_history_index>();
 
         db.pre_apply_operation.connect([&](const operation_notification& note) { on_operation(note); });
+
+        if (_archive)
+            db.applied_block.connect([&](const signed_block& block) { on_applied_block(block); });
+
+        if (_exporter)
+        {
+            db.pre_applied_block.connect([&](const signed_block&) { _export_operations.clear(); });
+            db.pre_apply_operation.connect([&](const operation_notification& note) { on_export_operation(note); });
+            db.applied_block.connect([&](const signed_block& block) { on_export_block(block); });
+        }
     }
 
     const operation_object& create_operation_obj(const operation_notification& note);
     void update_filtered_operation_index(const operation_object& object, const operation& op);
     void on_operation(const operation_notification& note);
 
+    void on_applied_block(const signed_block& block);
+    void archive_history(uint32_t last_irreversible_block);
+
+    void on_export_operation(const operation_notification& note);
+    void on_export_block(const signed_block& block);
+    void export_irreversible_blocks();
+    exported_block read_exported_block(uint32_t block_num);
+
+    template <typename history_object_type>
+    std::function<void()> collect_history(int64_t next_operation_id,
+                                          bool synced,
+                                          std::vector<history_archive::posting_entry>& postings);
+
+    template <typename filtered_object_type>
+    std::function<void()> collect_filtered(int64_t next_operation_id,
+                                           bool synced,
+                                           std::vector<history_archive::posting_entry>& postings);
+
     blockchain_history_plugin& _self;
     flat_map<account_name_type, account_name_type> _tracked_accounts;
     bool _filter_content = false;
     bool _blacklist = false;
     flat_set<std::string> _op_list;
+
+    std::shared_ptr<history_archive> _archive;
+    uint32_t _archive_interval = 0;
+    bool _archive_checked = false;
+    bool _archive_backlog = false;
+
+    std::unique_ptr<history_exporter> _exporter;
+    /// operations of the block being applied, operations of pending transactions are dropped by next block
+    std::vector<exported_operation> _export_operations;
+    /// operations of applied blocks which are not exported yet, irreversible ones are dropped while export is stalled
+    std::map<uint32_t, exported_block> _export_pending;
+    uint32_t _export_last_irreversible_block = 0;
+    /// next block handed to exporter, blocks missing in _export_pending are read from history
+    uint32_t _export_next_block = 0;
 };
 
 class operation_visitor
 {
     database& _db;
+    const history_archive* _archive;
     const operation_object& _obj;
     account_name_type _item;
 
 public:
     using result_type = void;
 
-    operation_visitor(database& db, const operation_object& obj, const account_name_type& i)
+    operation_visitor(database& db,
+                      const history_archive* archive,
+                      const operation_object& obj,
+                      const account_name_type& i)
         : _db(db)
+        , _archive(archive)
         , _obj(obj)
         , _item(i)
     {
@@ -144,6 +198,8 @@ private:
         uint32_t sequence = 0;
         if (hist_itr != hist_idx.end() && hist_itr->account == _item)
             sequence = hist_itr->sequence + 1;
+        else if (_archive)
+            sequence = _archive->next_sequence(history_object_type::type_id, _item);
 
         _db.create<history_object_type>([&](history_object_type& ahist) {
             ahist.account = _item;
@@ -276,9 +332,327 @@ void blockchain_history_plugin_impl::on_operation(const operation_notification&
 
         if (!_tracked_accounts.size() || (itr != _tracked_accounts.end() && itr->first <= item && item <= itr->second))
         {
-            note.op.visit(operation_visitor(db, new_obj, item));
+            note.op.visit(operation_visitor(db, _archive.get(), new_obj, item));
+        }
+    }
+}
+
+template <typename history_object_type, typename index_type>
+bool is_archivable(const history_object_type&, const index_type&)
+{
+    return true;
+}
+
+// the last withdrawal of account collects progress operations, so it is kept in shared memory
+template <uint16_t HistoryType, typename index_type>
+bool is_archivable(const withdrawals_history_object<HistoryType>& obj, const index_type& by_account_idx)
+{
+    return by_account_idx.lower_bound(obj.account)->id != obj.id;
+}
+
+template <typename history_object_type> std::vector<int64_t> get_progress(const history_object_type&)
+{
+    return std::vector<int64_t>();
+}
+
+template <uint16_t HistoryType>
+std::vector<int64_t> get_progress(const withdrawals_history_object<HistoryType>& obj)
+{
+    std::vector<int64_t> result;
+    result.reserve(obj.progress.size());
+    for (const auto& id : obj.progress)
+        result.push_back(id._id);
+    return result;
+}
+
+template <typename history_object_type>
+std::function<void()>
+blockchain_history_plugin_impl::collect_history(int64_t next_operation_id,
+                                                bool synced,
+                                                std::vector<history_archive::posting_entry>& postings)
+{
+    chain::database& db = database();
+
+    const auto& idx = db.get_index<history_index<history_object_type>, by_id>();
+    const auto& by_account_idx = db.get_index<history_index<history_object_type>, by_account>();
+
+    std::vector<const history_object_type*> archived;
+
+    for (auto it = idx.begin(); it != idx.end() && it->op._id < next_operation_id; ++it)
+    {
+        if (!is_archivable(*it, by_account_idx))
+            continue;
+
+        // archived by previous appends or restored by undo after it was archived
+        if (it->sequence < _archive->next_sequence(history_object_type::type_id, it->account))
+        {
+            if (synced)
+                archived.push_back(&(*it));
+            continue;
+        }
+
+        history_archive::posting_entry entry;
+        entry.list = history_object_type::type_id;
+        entry.account = it->account;
+        entry.sequence = it->sequence;
+        entry.op = it->op._id;
+        entry.progress = get_progress(*it);
+        postings.push_back(std::move(entry));
+    }
+
+    return [&db, archived]() {
+        for (const auto* obj : archived)
+            db.remove(*obj);
+    };
+}
+
+template <typename filtered_object_type>
+std::function<void()>
+blockchain_history_plugin_impl::collect_filtered(int64_t next_operation_id,
+                                                 bool synced,
+                                                 std::vector<history_archive::posting_entry>& postings)
+{
+    chain::database& db = database();
+
+    const auto& idx = db.get_index<typename chainbase::get_index_type<filtered_object_type>::type, by_id>();
+    const uint64_t next_sequence = _archive->next_sequence(filtered_object_type::type_id, account_name_type());
+
+    std::vector<const filtered_object_type*> archived;
+
+    for (auto it = idx.begin(); it != idx.end() && it->op._id < next_operation_id; ++it)
+    {
+        if (uint64_t(it->id._id) < next_sequence)
+        {
+            if (synced)
+                archived.push_back(&(*it));
+            continue;
+        }
+
+        history_archive::posting_entry entry;
+        entry.list = filtered_object_type::type_id;
+        entry.sequence = it->id._id;
+        entry.op = it->op._id;
+        postings.push_back(std::move(entry));
+    }
+
+    return [&db, archived]() {
+        for (const auto* obj : archived)
+            db.remove(*obj);
+    };
+}
+
+void blockchain_history_plugin_impl::on_applied_block(const signed_block& block)
+{
+    const uint32_t block_num = block.block_num();
+
+    if (!_archive_checked)
+    {
+        _archive_checked = true;
+
+        // state is rebuilt from earlier block (replay or resync), archived history is going to be created again
+        if (_archive->last_block() >= block_num)
+        {
+            wlog("History archive contains block ${a} ahead of applied block ${b}, clearing it",
+                 ("a", _archive->last_block())("b", block_num));
+            _archive->clear();
+        }
+    }
+
+    if (block_num % _archive_interval != 0 && !_archive_backlog)
+        return;
+
+    archive_history(database().obtain_service<dbs_dynamic_global_property>().get().last_irreversible_block_num);
+}
+
+void blockchain_history_plugin_impl::archive_history(uint32_t last_irreversible_block)
+{
+    chain::database& db = database();
+
+    std::vector<history_archive::operation_entry> operations;
+    std::vector<const operation_object*> archived_ops;
+
+    // archive is rolled back to the last synced append by a crash, so objects are removed from shared memory
+    // by the first round which finds their append synced
+    const bool synced = _archive->is_synced();
+
+    _archive_backlog = false;
+
+    size_t visited = 0;
+    int64_t next_operation_id = 0;
+
+    const auto& op_idx = db.get_index<operation_index, by_id>();
+    for (auto it = op_idx.begin(); it != op_idx.end() && it->block <= last_irreversible_block; ++it)
+    {
+        if (visited == max_archived_operations_per_block)
+        {
+            _archive_backlog = true;
+            break;
+        }
+
+        ++visited;
+        next_operation_id = it->id._id + 1;
+
+        // archived by previous appends or restored by undo after it was archived
+        if (it->id._id < _archive->next_operation_id())
+        {
+            if (synced)
+                archived_ops.push_back(&(*it));
+            continue;
+        }
+
+        history_archive::operation_entry entry;
+        entry.id = it->id._id;
+        entry.trx_id = it->trx_id;
+        entry.block = it->block;
+        entry.trx_in_block = it->trx_in_block;
+        entry.op_in_trx = it->op_in_trx;
+        entry.timestamp = it->timestamp;
+        entry.serialized_op.assign(it->serialized_op.data(), it->serialized_op.data() + it->serialized_op.size());
+        operations.push_back(std::move(entry));
+    }
+
+    if (!visited)
+        return;
+
+    std::vector<history_archive::posting_entry> postings;
+    std::vector<std::function<void()>> removals;
+
+    removals.push_back(collect_history<account_history_object>(next_operation_id, synced, postings));
+    removals.push_back(collect_history<transfers_to_scr_history_object>(next_operation_id, synced, postings));
+    removals.push_back(collect_history<transfers_to_sp_history_object>(next_operation_id, synced, postings));
+    removals.push_back(collect_history<withdrawals_to_scr_history_object>(next_operation_id, synced, postings));
+    removals.push_back(
+        collect_filtered<filtered_not_virt_operations_history_object>(next_operation_id, synced, postings));
+    removals.push_back(collect_filtered<filtered_virt_operations_history_object>(next_operation_id, synced, postings));
+    removals.push_back(
+        collect_filtered<filtered_market_operations_history_object>(next_operation_id, synced, postings));
+
+    _archive->append(operations, postings);
+
+    for (const auto& remove : removals)
+        remove();
+
+    for (const auto* op : archived_ops)
+        db.remove(*op);
+
+    if (!operations.empty())
+    {
+        ilog("Archived ${n} operations up to block ${b}", ("n", operations.size())("b", operations.back().block));
+    }
+}
+
+void blockchain_history_plugin_impl::on_export_operation(const operation_notification& note)
+{
+    exported_operation op;
+    op.block = note.block;
+    op.trx_id = note.trx_id;
+    op.trx_in_block = note.trx_in_block;
+    op.op_in_trx = note.op_in_trx;
+    op.virtual_op = is_virtual_operation(note.op);
+    op.timestamp = database().head_block_time();
+    op.op = note.op;
+
+    _export_operations.push_back(std::move(op));
+}
+
+void blockchain_history_plugin_impl::on_export_block(const signed_block& block)
+{
+    const uint32_t block_num = block.block_num();
+
+    // blocks of abandoned fork are replaced
+    _export_pending.erase(_export_pending.lower_bound(block_num), _export_pending.end());
+
+    exported_block& pending = _export_pending[block_num];
+    pending.block_num = block_num;
+    pending.operations = std::move(_export_operations);
+    _export_operations.clear();
+
+    export_irreversible_blocks();
+}
+
+void blockchain_history_plugin_impl::export_irreversible_blocks()
+{
+    _export_last_irreversible_block
+        = database().obtain_service<dbs_dynamic_global_property>().get().last_irreversible_block_num;
+
+    if (_export_next_block == 0)
+    {
+        // new export directory starts from the next irreversible block
+        const uint32_t last_exported = _exporter->last_exported_block();
+        _export_next_block = last_exported ? last_exported + 1 : _export_last_irreversible_block + 1;
+    }
+
+    // blocks stay here while export queue is full
+    while (_export_next_block <= _export_last_irreversible_block)
+    {
+        auto it = _export_pending.begin();
+        if (it != _export_pending.end() && it->first < _export_next_block)
+        {
+            // exported before restart and applied again by replay
+            _export_pending.erase(it);
+            continue;
         }
+
+        if (it != _export_pending.end() && it->first == _export_next_block)
+        {
+            if (!_exporter->push(std::move(it->second)))
+                break;
+            _export_pending.erase(it);
+        }
+        else
+        {
+            // applied before restart, operations are taken from history
+            if (!_exporter->push(read_exported_block(_export_next_block)))
+                break;
+        }
+
+        ++_export_next_block;
+    }
+
+    if (_export_next_block <= _export_last_irreversible_block)
+    {
+        // export is stalled, operations of held blocks are read back from history once the queue has space,
+        // so only reversible blocks keep their operations in memory
+        _export_pending.erase(_export_pending.begin(),
+                              _export_pending.upper_bound(_export_last_irreversible_block));
+    }
+}
+
+exported_block blockchain_history_plugin_impl::read_exported_block(uint32_t block_num)
+{
+    std::map<int64_t, applied_operation> operations;
+
+    if (_archive && block_num <= _archive->last_block())
+    {
+        _archive->get_operations_in_block(block_num, [&](int64_t id, const applied_operation& op) {
+            operations[id] = op;
+            return true;
+        });
+    }
+
+    const auto& idx = database().get_index<operation_index>().indices().get<by_location>();
+    for (auto range = idx.equal_range(block_num); range.first != range.second; ++range.first)
+        operations[range.first->id._id] = applied_operation(*range.first);
+
+    exported_block result;
+    result.block_num = block_num;
+
+    for (const auto& entry : operations)
+    {
+        const applied_operation& op = entry.second;
+
+        exported_operation record;
+        record.block = op.block;
+        record.trx_id = op.trx_id;
+        record.trx_in_block = op.trx_in_block;
+        record.op_in_trx = op.op_in_trx;
+        record.virtual_op = is_virtual_operation(op.op);
+        record.timestamp = op.timestamp;
+        record.op = op.op;
+        result.operations.push_back(std::move(record));
     }
+
+    return result;
 }
 
 } // end namespace detail
@@ -308,7 +682,23 @@ void blockchain_history_plugin::plugin_set_program_options(boost::program_option
         "times")("history-whitelist-ops", boost::program_options::value<std::vector<std::string>>()->composing(),
                  "Defines a list of operations which will be explicitly logged.")(
         "history-blacklist-ops", boost::program_options::value<std::vector<std::string>>()->composing(),
-        "Defines a list of operations which will be explicitly ignored.");
+        "Defines a list of operations which will be explicitly ignored.")(
+        "history-archive-interval", boost::program_options::value<uint32_t>()->default_value(0),
+        "Move irreversible operations from shared memory to history archive every this many blocks. 0 disables "
+        "archive")("history-archive-dir", boost::program_options::value<boost::filesystem::path>(),
+                   "Directory of history archive. Defaults to data_dir/blockchain/history_archive")(
+        "history-export-dir", boost::program_options::value<boost::filesystem::path>(),
+        "Export operations of irreversible blocks to rotating files in this directory (relative to data_dir). "
+        "Export is disabled if not set")("history-export-format",
+                                          boost::program_options::value<std::string>()->default_value("binary"),
+                                          "Format of export files: binary (length-prefixed) or json (one "
+                                          "operation per line)")(
+        "history-export-file-size", boost::program_options::value<uint64_t>()->default_value(256),
+        "Size of export file in MiB after which the next file is started")(
+        "history-export-queue-size",
+        boost::program_options::value<uint64_t>()->default_value(history_exporter::default_queue_capacity),
+        "Maximum number of operations queued for export, further blocks are read back from history when the "
+        "queue is written");
     cli.add(get_api_config(API_BLOCKCHAIN_HISTORY).get_options_descriptions());
     cli.add(get_api_config(API_ACCOUNT_HISTORY).get_options_descriptions());
     cfg.add(cli);
@@ -362,6 +752,38 @@ void blockchain_history_plugin::plugin_initialize(const boost::program_options::
             ilog("Account History: blacklisting ops ${o}", ("o", _my->_op_list));
         }
 
+        if (options.count("history-archive-interval") && options.at("history-archive-interval").as<uint32_t>() > 0)
+        {
+            fc::path dir = scorum::app::get_data_dir_path(options) / "blockchain" / "history_archive";
+            if (options.count("history-archive-dir"))
+            {
+                dir = options.at("history-archive-dir").as<boost::filesystem::path>();
+                if (dir.is_relative())
+                    dir = scorum::app::get_data_dir_path(options) / dir;
+            }
+
+            _my->_archive_interval = options.at("history-archive-interval").as<uint32_t>();
+            _my->_archive = std::make_shared<history_archive>(dir);
+
+            ilog("Blockchain History: archiving irreversible operations to ${d} every ${n} blocks",
+                 ("d", dir)("n", _my->_archive_interval));
+        }
+
+        if (options.count("history-export-dir"))
+        {
+            fc::path dir = options.at("history-export-dir").as<boost::filesystem::path>();
+            if (dir.is_relative())
+                dir = scorum::app::get_data_dir_path(options) / dir;
+
+            const auto format = history_exporter::parse_format(options.at("history-export-format").as<std::string>());
+            const uint64_t file_size = options.at("history-export-file-size").as<uint64_t>() * 1024 * 1024;
+            const uint64_t queue_size = options.at("history-export-queue-size").as<uint64_t>();
+
+            _my->_exporter.reset(new history_exporter(dir, format, file_size, queue_size));
+
+            ilog("Blockchain History: exporting irreversible operations to ${d}", ("d", dir));
+        }
+
         _my->initialize();
     }
     FC_LOG_AND_RETHROW()
@@ -371,6 +793,18 @@ void blockchain_history_plugin::plugin_initialize(const boost::program_options::
 
 void blockchain_history_plugin::plugin_startup()
 {
+    if (_my->_exporter)
+    {
+        if (_my->_filter_content)
+        {
+            wlog("History export resumes blocks applied before restart from history, operations filtered by "
+                 "history-whitelist-ops or history-blacklist-ops are missing there");
+        }
+
+        // irreversible blocks applied before restart are exported from history
+        database().with_read_lock([&]() { _my->export_irreversible_blocks(); });
+    }
+
     app().register_api_factory<account_history_api>(API_ACCOUNT_HISTORY);
     app().register_api_factory<blockchain_history_api>(API_BLOCKCHAIN_HISTORY);
 }
@@ -379,6 +813,24 @@ flat_map<account_name_type, account_name_type> blockchain_history_plugin::tracke
 {
     return _my->_tracked_accounts;
 }
+
+std::shared_ptr<const history_archive> blockchain_history_plugin::archive() const
+{
+    return _my->_archive;
+}
+
+history_export_stats blockchain_history_plugin::export_stats() const
+{
+    FC_ASSERT(_my->_exporter, "History export is disabled");
+
+    history_export_stats stats = _my->_exporter->get_stats();
+    if (_my->_export_next_block && _my->_export_next_block <= _my->_export_last_irreversible_block)
+        stats.held_blocks = _my->_export_last_irreversible_block - _my->_export_next_block + 1;
+    stats.reversible_blocks = std::distance(_my->_export_pending.upper_bound(_my->_export_last_irreversible_block),
+                                            _my->_export_pending.end());
+
+    return stats;
+}
 }
 }
 
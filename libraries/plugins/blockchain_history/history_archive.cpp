@@ -0,0 +1,1553 @@
+#include <scorum/blockchain_history/history_archive.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/io/raw.hpp>
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace scorum {
+namespace blockchain_history {
+
+namespace detail {
+
+namespace {
+
+const uint32_t archive_version = 2;
+const uint32_t archive_state_magic = 0x54534148; // "HAST"
+const uint32_t column_block_magic = 0x4b4c4243; // "CBLK"
+const uint32_t posting_segment_magic = 0x47455350; // "PSEG"
+const uint32_t transaction_run_magic = 0x4e555254; // "TRUN"
+
+const size_t account_name_size = 16;
+
+/// compaction starts when data appended since the previous one exceeds both this size and 1 / compaction_ratio
+/// of the compacted data, so every byte is rewritten a bounded number of times
+const uint64_t min_compaction_size = 1024 * 1024;
+const uint64_t compaction_ratio = 4;
+
+/// entries of merged posting segment
+const size_t max_compacted_segment_size = 64 * 1024;
+
+/// compaction output is written by chunks of this size
+const size_t compaction_chunk_size = 16 * 1024 * 1024;
+
+size_t align8(size_t size)
+{
+    return (size + 7) & ~size_t(7);
+}
+
+struct archive_state
+{
+    uint32_t magic = archive_state_magic;
+    uint32_t version = archive_version;
+    int64_t next_operation_id = 0;
+    uint64_t operations_size = 0;
+    uint64_t postings_size = 0;
+    uint64_t transactions_size = 0;
+    /// postings and transactions are rewritten by compaction to files of the next generation
+    uint32_t generation = 0;
+    uint32_t reserved = 0;
+    uint64_t compacted_postings_size = 0;
+    uint64_t compacted_transactions_size = 0;
+};
+
+struct column_block_header
+{
+    uint32_t magic = column_block_magic;
+    uint32_t count = 0;
+    int64_t first_id = 0;
+    uint32_t first_block = 0;
+    uint32_t last_block = 0;
+    uint32_t first_timestamp = 0;
+    uint32_t last_timestamp = 0;
+    uint64_t size = 0;
+};
+
+struct posting_segment_header
+{
+    uint32_t magic = posting_segment_magic;
+    uint16_t list = 0;
+    uint16_t has_progress = 0;
+    char account[account_name_size] = {};
+    uint64_t first_sequence = 0;
+    uint32_t count = 0;
+    uint32_t reserved = 0;
+    uint64_t size = 0;
+};
+
+struct transaction_run_header
+{
+    uint32_t magic = transaction_run_magic;
+    uint32_t count = 0;
+    uint64_t size = 0;
+};
+
+struct transaction_record
+{
+    transaction_id_type id;
+    uint32_t block = 0;
+    uint32_t trx_in_block = 0;
+};
+
+static_assert(std::is_trivially_copyable<transaction_id_type>::value, "transaction id is written as is");
+
+fc::path generation_file(const fc::path& dir, const std::string& name, uint32_t generation)
+{
+    return dir / (name + "." + std::to_string(generation) + ".dat");
+}
+
+/**
+ * Bloom filter of transaction ids of run. Ids are hashes, so their words are used as independent hash values.
+ */
+class transaction_filter
+{
+public:
+    transaction_filter() = default;
+
+    explicit transaction_filter(uint32_t count)
+        : _bits((uint64_t(count) * bits_per_id + 63) / 64 + 1)
+    {
+    }
+
+    void add(const transaction_id_type& id)
+    {
+        for (uint32_t ci = 0; ci < hash_count; ++ci)
+        {
+            const uint64_t bit = position(id, ci);
+            _bits[bit / 64] |= uint64_t(1) << (bit % 64);
+        }
+    }
+
+    /// empty filter contains everything
+    bool may_contain(const transaction_id_type& id) const
+    {
+        if (_bits.empty())
+            return true;
+
+        for (uint32_t ci = 0; ci < hash_count; ++ci)
+        {
+            const uint64_t bit = position(id, ci);
+            if (!(_bits[bit / 64] & (uint64_t(1) << (bit % 64))))
+                return false;
+        }
+        return true;
+    }
+
+private:
+    /// about 1% of false positives
+    static const uint32_t bits_per_id = 10;
+    static const uint32_t hash_count = 3;
+
+    uint64_t position(const transaction_id_type& id, uint32_t ci) const
+    {
+        return id._hash[ci] % (_bits.size() * 64);
+    }
+
+    std::vector<uint64_t> _bits;
+};
+
+/**
+ * Offsets of columns of column block with given number of operations. Every column is aligned by 8.
+ */
+struct column_layout
+{
+    explicit column_layout(uint32_t count)
+    {
+        blocks = align8(sizeof(column_block_header));
+        trx_in_blocks = align8(blocks + count * sizeof(uint32_t));
+        op_in_trxs = align8(trx_in_blocks + count * sizeof(uint32_t));
+        timestamps = align8(op_in_trxs + count * sizeof(uint16_t));
+        trx_ids = align8(timestamps + count * sizeof(uint32_t));
+        op_offsets = align8(trx_ids + count * sizeof(transaction_id_type));
+        ops = op_offsets + (count + 1) * sizeof(uint32_t);
+    }
+
+    size_t blocks = 0;
+    size_t trx_in_blocks = 0;
+    size_t op_in_trxs = 0;
+    size_t timestamps = 0;
+    size_t trx_ids = 0;
+    size_t op_offsets = 0;
+    size_t ops = 0;
+};
+
+class column_block
+{
+public:
+    explicit column_block(const char* data)
+        : _data(data)
+        , _layout(header().count)
+    {
+    }
+
+    const column_block_header& header() const
+    {
+        return *reinterpret_cast<const column_block_header*>(_data);
+    }
+
+    uint32_t block(uint32_t i) const
+    {
+        return column<uint32_t>(_layout.blocks)[i];
+    }
+
+    uint32_t timestamp(uint32_t i) const
+    {
+        return column<uint32_t>(_layout.timestamps)[i];
+    }
+
+    applied_operation operation(uint32_t i) const
+    {
+        applied_operation result;
+
+        std::memcpy(&result.trx_id, _data + _layout.trx_ids + i * sizeof(transaction_id_type),
+                    sizeof(transaction_id_type));
+        result.block = block(i);
+        result.trx_in_block = column<uint32_t>(_layout.trx_in_blocks)[i];
+        result.op_in_trx = column<uint16_t>(_layout.op_in_trxs)[i];
+        result.timestamp = fc::time_point_sec(timestamp(i));
+
+        const uint32_t* offsets = column<uint32_t>(_layout.op_offsets);
+        fc::datastream<const char*> ds(_data + _layout.ops + offsets[i], offsets[i + 1] - offsets[i]);
+        fc::raw::unpack(ds, result.op);
+
+        return result;
+    }
+
+private:
+    template <typename T> const T* column(size_t offset) const
+    {
+        return reinterpret_cast<const T*>(_data + offset);
+    }
+
+    const char* _data;
+    column_layout _layout;
+};
+
+class posting_segment
+{
+public:
+    explicit posting_segment(const char* data)
+        : _data(data)
+    {
+    }
+
+    const posting_segment_header& header() const
+    {
+        return *reinterpret_cast<const posting_segment_header*>(_data);
+    }
+
+    int64_t op(uint32_t i) const
+    {
+        return reinterpret_cast<const int64_t*>(_data + ops_offset())[i];
+    }
+
+    std::vector<int64_t> progress(uint32_t i) const
+    {
+        if (!header().has_progress)
+            return std::vector<int64_t>();
+
+        const uint32_t* offsets = reinterpret_cast<const uint32_t*>(_data + progress_offsets_offset());
+        const int64_t* ids = reinterpret_cast<const int64_t*>(_data + progress_offset(header().count));
+        return std::vector<int64_t>(ids + offsets[i], ids + offsets[i + 1]);
+    }
+
+    static size_t ops_offset()
+    {
+        return align8(sizeof(posting_segment_header));
+    }
+
+    static size_t progress_offsets_offset(uint32_t count)
+    {
+        return ops_offset() + count * sizeof(int64_t);
+    }
+
+    static size_t progress_offset(uint32_t count)
+    {
+        return align8(progress_offsets_offset(count) + (count + 1) * sizeof(uint32_t));
+    }
+
+private:
+    size_t progress_offsets_offset() const
+    {
+        return progress_offsets_offset(header().count);
+    }
+
+    const char* _data;
+};
+
+account_name_type read_account(const char* account)
+{
+    return account_name_type(std::string(account, strnlen(account, account_name_size)));
+}
+
+void write_account(char* dst, const account_name_type& account)
+{
+    const std::string name = account;
+    FC_ASSERT(name.size() <= account_name_size, "Account name ${a} is too long", ("a", name));
+    std::memcpy(dst, name.data(), name.size());
+}
+
+template <typename T> void append_pod(std::vector<char>& buffer, const T& value)
+{
+    const char* data = reinterpret_cast<const char*>(&value);
+    buffer.insert(buffer.end(), data, data + sizeof(T));
+}
+
+/**
+ * Read only shared mapping of file prefix. It is coherent with writes on Linux.
+ */
+class file_mapping
+{
+public:
+    file_mapping(int fd, uint64_t size, const fc::path& path, int advice)
+        : _size(size)
+    {
+        if (!_size)
+            return;
+
+        void* data = ::mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+        FC_ASSERT(data != MAP_FAILED, "Could not map ${f}: ${e}", ("f", path)("e", std::strerror(errno)));
+        ::madvise(data, _size, advice);
+        _data = static_cast<const char*>(data);
+    }
+
+    ~file_mapping()
+    {
+        if (_data)
+            ::munmap(const_cast<char*>(_data), _size);
+    }
+
+    file_mapping(const file_mapping&) = delete;
+    file_mapping& operator=(const file_mapping&) = delete;
+
+    const char* data() const
+    {
+        return _data;
+    }
+
+private:
+    uint64_t _size = 0;
+    const char* _data = nullptr;
+};
+
+/**
+ * File appended by write calls and read through the mapping of committed size. Data written past
+ * the committed size is not mapped until commit.
+ */
+class archive_file
+{
+public:
+    archive_file(const fc::path& path, uint64_t committed_size)
+        : _path(path)
+    {
+        _fd = ::open(path.generic_string().c_str(), O_RDWR | O_CREAT, 0644);
+        FC_ASSERT(_fd >= 0, "Could not open ${f}: ${e}", ("f", path)("e", std::strerror(errno)));
+
+        struct stat st;
+        FC_ASSERT(::fstat(_fd, &st) == 0, "Could not stat ${f}: ${e}", ("f", path)("e", std::strerror(errno)));
+        FC_ASSERT(uint64_t(st.st_size) >= committed_size, "History archive file ${f} is truncated", ("f", path));
+
+        if (uint64_t(st.st_size) > committed_size)
+        {
+            wlog("Dropping ${n} bytes of interrupted append to ${f}",
+                 ("n", uint64_t(st.st_size) - committed_size)("f", path));
+            truncate(committed_size);
+        }
+
+        commit(committed_size);
+    }
+
+    ~archive_file()
+    {
+        _mapping.reset();
+        ::close(_fd);
+    }
+
+    const fc::path& path() const
+    {
+        return _path;
+    }
+
+    uint64_t size() const
+    {
+        return _size;
+    }
+
+    const char* data() const
+    {
+        return _mapping->data();
+    }
+
+    /// separate mapping of committed data, it is not affected by commits
+    std::unique_ptr<file_mapping> map(uint64_t size, int advice) const
+    {
+        return std::unique_ptr<file_mapping>(new file_mapping(_fd, size, _path, advice));
+    }
+
+    void write(uint64_t offset, const std::vector<char>& buffer)
+    {
+        size_t written = 0;
+        while (written < buffer.size())
+        {
+            const ssize_t n = ::pwrite(_fd, buffer.data() + written, buffer.size() - written, offset + written);
+            if (n < 0 && errno == EINTR)
+                continue;
+            FC_ASSERT(n > 0, "Could not write ${f}: ${e}", ("f", _path)("e", std::strerror(errno)));
+            written += n;
+        }
+    }
+
+    void sync()
+    {
+        FC_ASSERT(::fdatasync(_fd) == 0, "Could not sync ${f}: ${e}", ("f", _path)("e", std::strerror(errno)));
+    }
+
+    void truncate(uint64_t size)
+    {
+        FC_ASSERT(::ftruncate(_fd, size) == 0, "Could not truncate ${f}: ${e}",
+                  ("f", _path)("e", std::strerror(errno)));
+    }
+
+    void commit(uint64_t size)
+    {
+        _mapping.reset();
+        _size = size;
+        _mapping = map(_size, MADV_RANDOM);
+    }
+
+private:
+    fc::path _path;
+    int _fd = -1;
+    uint64_t _size = 0;
+    std::unique_ptr<file_mapping> _mapping;
+};
+}
+
+class history_archive_impl
+{
+public:
+    using posting_key = std::pair<uint16_t, account_name_type>;
+
+    struct column_block_ref
+    {
+        uint64_t offset = 0;
+        column_block_header header;
+    };
+
+    struct posting_segment_ref
+    {
+        uint64_t first_sequence = 0;
+        uint32_t count = 0;
+        uint64_t offset = 0;
+    };
+
+    /// every run but the first one of file is filtered, the first one is the product of compaction
+    struct transaction_run_ref
+    {
+        uint64_t offset = 0;
+        uint32_t count = 0;
+        transaction_filter filter;
+    };
+
+    struct sync_job
+    {
+        uint64_t ticket = 0;
+        archive_state state;
+        std::shared_ptr<archive_file> operations;
+        std::shared_ptr<archive_file> postings;
+        std::shared_ptr<archive_file> transactions;
+    };
+
+    /// compaction reads committed data of the state, data appended meanwhile is copied by installation
+    struct compaction_job
+    {
+        archive_state state;
+        std::shared_ptr<archive_file> postings;
+        std::shared_ptr<archive_file> transactions;
+    };
+
+    struct compaction_result
+    {
+        archive_state source;
+        uint32_t generation = 0;
+        std::shared_ptr<archive_file> postings;
+        std::shared_ptr<archive_file> transactions;
+        uint64_t postings_size = 0;
+        uint64_t transactions_size = 0;
+    };
+
+    history_archive_impl(const fc::path& dir, uint32_t column_block_size)
+        : _dir(dir)
+        , _state_path(dir / "archive.state")
+        , _column_block_size(column_block_size)
+    {
+        FC_ASSERT(_column_block_size > 0);
+
+        if (!fc::exists(dir))
+            fc::create_directories(dir);
+
+        read_state();
+        remove_stale_files(_state.generation);
+        _synced_generation = _state.generation;
+
+        _operations = std::make_shared<archive_file>(dir / "operations.dat", _state.operations_size);
+        _postings = std::make_shared<archive_file>(generation_file(dir, "postings", _state.generation),
+                                                   _state.postings_size);
+        _transactions = std::make_shared<archive_file>(generation_file(dir, "transactions", _state.generation),
+                                                       _state.transactions_size);
+
+        scan(*_operations, 0);
+        scan_postings(0);
+        scan_transactions(0);
+
+        _sync_thread = std::thread([this]() { run_sync(); });
+        _compaction_thread = std::thread([this]() { run_compaction(); });
+    }
+
+    ~history_archive_impl()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopped = true;
+        }
+        _cv.notify_all();
+
+        _sync_thread.join();
+        _compaction_thread.join();
+    }
+
+    void read_state()
+    {
+        if (!fc::exists(_state_path))
+            return;
+
+        archive_state state;
+        FC_ASSERT(fc::file_size(_state_path) == sizeof(state), "Invalid history archive state ${f}",
+                  ("f", _state_path));
+
+        const int fd = ::open(_state_path.generic_string().c_str(), O_RDONLY);
+        FC_ASSERT(fd >= 0, "Could not open ${f}", ("f", _state_path));
+        const ssize_t n = ::read(fd, &state, sizeof(state));
+        ::close(fd);
+
+        FC_ASSERT(n == ssize_t(sizeof(state)) && state.magic == archive_state_magic,
+                  "Invalid history archive state ${f}", ("f", _state_path));
+        FC_ASSERT(state.version == archive_version, "Unsupported history archive version ${v}", ("v", state.version));
+
+        _state = state;
+    }
+
+    void write_state(const archive_state& state)
+    {
+        const fc::path tmp = _state_path.generic_string() + ".tmp";
+
+        const int fd = ::open(tmp.generic_string().c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        FC_ASSERT(fd >= 0, "Could not open ${f}", ("f", tmp));
+        const bool ok = ::write(fd, &state, sizeof(state)) == ssize_t(sizeof(state)) && ::fdatasync(fd) == 0;
+        ::close(fd);
+        FC_ASSERT(ok, "Could not write ${f}: ${e}", ("f", tmp)("e", std::strerror(errno)));
+
+        boost::filesystem::rename(tmp, _state_path);
+    }
+
+    void remove_generation(uint32_t generation)
+    {
+        boost::filesystem::remove(generation_file(_dir, "postings", generation).string());
+        boost::filesystem::remove(generation_file(_dir, "transactions", generation).string());
+    }
+
+    /// removes postings and transactions of other generations left by compaction
+    void remove_stale_files(uint32_t generation)
+    {
+        const std::vector<std::string> current
+            = { generation_file(_dir, "postings", generation).filename().string(),
+                generation_file(_dir, "transactions", generation).filename().string() };
+
+        std::vector<boost::filesystem::path> stale;
+        for (boost::filesystem::directory_iterator it(_dir.string()), end; it != end; ++it)
+        {
+            const std::string name = it->path().filename().string();
+            if ((boost::starts_with(name, "postings.") || boost::starts_with(name, "transactions."))
+                && boost::ends_with(name, ".dat") && std::find(current.begin(), current.end(), name) == current.end())
+            {
+                stale.push_back(it->path());
+            }
+        }
+
+        for (const auto& path : stale)
+            boost::filesystem::remove(path);
+    }
+
+    void scan(const archive_file& file, uint64_t offset)
+    {
+        while (offset < file.size())
+        {
+            FC_ASSERT(offset + sizeof(column_block_header) <= file.size(), "Truncated column block");
+
+            column_block_ref ref;
+            ref.offset = offset;
+            std::memcpy(&ref.header, file.data() + offset, sizeof(column_block_header));
+
+            FC_ASSERT(ref.header.magic == column_block_magic && ref.header.size
+                          && offset + ref.header.size <= file.size(),
+                      "Invalid column block at ${o}", ("o", offset));
+
+            _column_blocks.push_back(ref);
+            offset += ref.header.size;
+        }
+    }
+
+    void scan_postings(uint64_t offset)
+    {
+        while (offset < _postings->size())
+        {
+            FC_ASSERT(offset + sizeof(posting_segment_header) <= _postings->size(), "Truncated posting segment");
+
+            posting_segment_header header;
+            std::memcpy(&header, _postings->data() + offset, sizeof(header));
+
+            FC_ASSERT(header.magic == posting_segment_magic && header.size && offset + header.size <= _postings->size(),
+                      "Invalid posting segment at ${o}", ("o", offset));
+
+            posting_segment_ref ref;
+            ref.first_sequence = header.first_sequence;
+            ref.count = header.count;
+            ref.offset = offset;
+            _segments[posting_key(header.list, read_account(header.account))].push_back(ref);
+
+            offset += header.size;
+        }
+    }
+
+    void scan_transactions(uint64_t offset)
+    {
+        while (offset < _transactions->size())
+        {
+            FC_ASSERT(offset + sizeof(transaction_run_header) <= _transactions->size(), "Truncated transaction run");
+
+            transaction_run_header header;
+            std::memcpy(&header, _transactions->data() + offset, sizeof(header));
+
+            FC_ASSERT(header.magic == transaction_run_magic && header.size
+                          && offset + header.size <= _transactions->size(),
+                      "Invalid transaction run at ${o}", ("o", offset));
+
+            transaction_run_ref ref;
+            ref.offset = offset;
+            ref.count = header.count;
+
+            if (offset != 0)
+            {
+                ref.filter = transaction_filter(header.count);
+                for (const auto* record = records(ref); record != records(ref) + ref.count; ++record)
+                    ref.filter.add(record->id);
+            }
+
+            _transaction_runs.push_back(std::move(ref));
+
+            offset += header.size;
+        }
+    }
+
+    const transaction_record* records(const transaction_run_ref& ref) const
+    {
+        return reinterpret_cast<const transaction_record*>(_transactions->data() + ref.offset
+                                                           + sizeof(transaction_run_header));
+    }
+
+    void write_column_block(const std::vector<history_archive::operation_entry>& operations,
+                            size_t begin,
+                            size_t end,
+                            std::vector<char>& buffer) const
+    {
+        const uint32_t count = end - begin;
+        const column_layout layout(count);
+
+        size_t ops_size = 0;
+        for (size_t ci = begin; ci < end; ++ci)
+            ops_size += operations[ci].serialized_op.size();
+
+        const size_t start = buffer.size();
+        buffer.resize(start + align8(layout.ops + ops_size), 0);
+        char* data = buffer.data() + start;
+
+        column_block_header header;
+        header.count = count;
+        header.first_id = operations[begin].id;
+        header.first_block = operations[begin].block;
+        header.last_block = operations[end - 1].block;
+        header.first_timestamp = operations[begin].timestamp.sec_since_epoch();
+        header.last_timestamp = operations[end - 1].timestamp.sec_since_epoch();
+        header.size = buffer.size() - start;
+        std::memcpy(data, &header, sizeof(header));
+
+        uint32_t op_offset = 0;
+        for (uint32_t ci = 0; ci < count; ++ci)
+        {
+            const auto& op = operations[begin + ci];
+
+            const uint32_t timestamp = op.timestamp.sec_since_epoch();
+            std::memcpy(data + layout.blocks + ci * sizeof(uint32_t), &op.block, sizeof(uint32_t));
+            std::memcpy(data + layout.trx_in_blocks + ci * sizeof(uint32_t), &op.trx_in_block, sizeof(uint32_t));
+            std::memcpy(data + layout.op_in_trxs + ci * sizeof(uint16_t), &op.op_in_trx, sizeof(uint16_t));
+            std::memcpy(data + layout.timestamps + ci * sizeof(uint32_t), &timestamp, sizeof(uint32_t));
+            std::memcpy(data + layout.trx_ids + ci * sizeof(transaction_id_type), &op.trx_id,
+                        sizeof(transaction_id_type));
+            std::memcpy(data + layout.op_offsets + ci * sizeof(uint32_t), &op_offset, sizeof(uint32_t));
+
+            if (!op.serialized_op.empty())
+                std::memcpy(data + layout.ops + op_offset, op.serialized_op.data(), op.serialized_op.size());
+            op_offset += op.serialized_op.size();
+        }
+        std::memcpy(data + layout.op_offsets + count * sizeof(uint32_t), &op_offset, sizeof(uint32_t));
+    }
+
+    void write_posting_segment(const std::vector<const history_archive::posting_entry*>& entries,
+                               size_t begin,
+                               size_t end,
+                               std::vector<char>& buffer) const
+    {
+        const uint32_t count = end - begin;
+
+        bool has_progress = false;
+        size_t progress_size = 0;
+        for (size_t ci = begin; ci < end; ++ci)
+        {
+            has_progress |= !entries[ci]->progress.empty();
+            progress_size += entries[ci]->progress.size();
+        }
+
+        const size_t size = has_progress
+            ? posting_segment::progress_offset(count) + progress_size * sizeof(int64_t)
+            : posting_segment::progress_offsets_offset(count);
+
+        const size_t start = buffer.size();
+        buffer.resize(start + align8(size), 0);
+        char* data = buffer.data() + start;
+
+        posting_segment_header header;
+        header.list = entries[begin]->list;
+        header.has_progress = has_progress;
+        write_account(header.account, entries[begin]->account);
+        header.first_sequence = entries[begin]->sequence;
+        header.count = count;
+        header.size = buffer.size() - start;
+        std::memcpy(data, &header, sizeof(header));
+
+        uint32_t progress_offset = 0;
+        for (uint32_t ci = 0; ci < count; ++ci)
+        {
+            const auto& entry = *entries[begin + ci];
+
+            std::memcpy(data + posting_segment::ops_offset() + ci * sizeof(int64_t), &entry.op, sizeof(int64_t));
+
+            if (!has_progress)
+                continue;
+
+            std::memcpy(data + posting_segment::progress_offsets_offset(count) + ci * sizeof(uint32_t),
+                        &progress_offset, sizeof(uint32_t));
+            if (!entry.progress.empty())
+                std::memcpy(data + posting_segment::progress_offset(count) + progress_offset * sizeof(int64_t),
+                            entry.progress.data(), entry.progress.size() * sizeof(int64_t));
+            progress_offset += entry.progress.size();
+        }
+
+        if (has_progress)
+            std::memcpy(data + posting_segment::progress_offsets_offset(count) + count * sizeof(uint32_t),
+                        &progress_offset, sizeof(uint32_t));
+    }
+
+    void write_transaction_run(const std::vector<history_archive::operation_entry>& operations,
+                               std::vector<char>& buffer) const
+    {
+        std::vector<transaction_record> records;
+        records.reserve(operations.size());
+
+        for (const auto& op : operations)
+        {
+            if (op.trx_id == transaction_id_type())
+                continue;
+
+            transaction_record record;
+            record.id = op.trx_id;
+            record.block = op.block;
+            record.trx_in_block = op.trx_in_block;
+            records.push_back(record);
+        }
+
+        if (records.empty())
+            return;
+
+        std::stable_sort(records.begin(), records.end(),
+                         [](const transaction_record& a, const transaction_record& b) { return a.id < b.id; });
+        records.erase(std::unique(records.begin(), records.end(),
+                                  [](const transaction_record& a, const transaction_record& b) {
+                                      return a.id == b.id;
+                                  }),
+                      records.end());
+
+        transaction_run_header header;
+        header.count = records.size();
+        header.size = align8(sizeof(header) + records.size() * sizeof(transaction_record));
+
+        const size_t start = buffer.size();
+        append_pod(buffer, header);
+        for (const auto& record : records)
+            append_pod(buffer, record);
+        buffer.resize(start + header.size, 0);
+    }
+
+    void append(const std::vector<history_archive::operation_entry>& operations,
+                const std::vector<history_archive::posting_entry>& postings)
+    {
+        install_compaction();
+
+        if (operations.empty() && postings.empty())
+            return;
+
+        archive_state state = _state;
+
+        std::vector<char> operations_buffer;
+        for (size_t begin = 0; begin < operations.size();)
+        {
+            FC_ASSERT(operations[begin].id >= state.next_operation_id, "Operation ${id} is already archived",
+                      ("id", operations[begin].id));
+
+            size_t end = begin + 1;
+            while (end < operations.size() && end - begin < _column_block_size
+                   && operations[end].id == operations[end - 1].id + 1)
+            {
+                ++end;
+            }
+
+            write_column_block(operations, begin, end, operations_buffer);
+
+            state.next_operation_id = operations[end - 1].id + 1;
+            begin = end;
+        }
+
+        std::map<posting_key, std::vector<const history_archive::posting_entry*>> lists;
+        for (const auto& entry : postings)
+            lists[posting_key(entry.list, entry.account)].push_back(&entry);
+
+        std::vector<char> postings_buffer;
+        for (const auto& list : lists)
+        {
+            const auto& entries = list.second;
+
+            FC_ASSERT(entries.front()->sequence >= next_sequence(list.first.first, list.first.second),
+                      "Entry ${s} of ${a} is already archived",
+                      ("s", entries.front()->sequence)("a", list.first.second));
+
+            for (size_t begin = 0; begin < entries.size();)
+            {
+                size_t end = begin + 1;
+                while (end < entries.size() && entries[end]->sequence == entries[end - 1]->sequence + 1)
+                    ++end;
+
+                write_posting_segment(entries, begin, end, postings_buffer);
+                begin = end;
+            }
+        }
+
+        std::vector<char> transactions_buffer;
+        write_transaction_run(operations, transactions_buffer);
+
+        _operations->write(_state.operations_size, operations_buffer);
+        _postings->write(_state.postings_size, postings_buffer);
+        _transactions->write(_state.transactions_size, transactions_buffer);
+
+        state.operations_size += operations_buffer.size();
+        state.postings_size += postings_buffer.size();
+        state.transactions_size += transactions_buffer.size();
+
+        const archive_state old_state = _state;
+        _state = state;
+
+        _operations->commit(_state.operations_size);
+        _postings->commit(_state.postings_size);
+        _transactions->commit(_state.transactions_size);
+
+        scan(*_operations, old_state.operations_size);
+        scan_postings(old_state.postings_size);
+        scan_transactions(old_state.transactions_size);
+
+        request_sync();
+
+        if (compaction_needed(_state.postings_size, _state.compacted_postings_size)
+            || compaction_needed(_state.transactions_size, _state.compacted_transactions_size))
+        {
+            request_compaction();
+        }
+    }
+
+    static bool compaction_needed(uint64_t size, uint64_t compacted_size)
+    {
+        const uint64_t appended = size - compacted_size;
+        return appended >= min_compaction_size && appended >= compacted_size / compaction_ratio;
+    }
+
+    void request_sync()
+    {
+        std::unique_ptr<sync_job> job(new sync_job());
+        job->ticket = ++_appends;
+        job->state = _state;
+        job->operations = _operations;
+        job->postings = _postings;
+        job->transactions = _transactions;
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            // the latest job syncs data of replaced ones as well
+            _sync_job = std::move(job);
+        }
+        _cv.notify_all();
+    }
+
+    void request_compaction()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_compaction_job || _compacting || _compaction_result)
+                return;
+
+            _compaction_job.reset(new compaction_job());
+            _compaction_job->state = _state;
+            _compaction_job->postings = _postings;
+            _compaction_job->transactions = _transactions;
+        }
+        _cv.notify_all();
+    }
+
+    bool is_synced() const
+    {
+        return _synced_ticket == _appends;
+    }
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _idle_cv.wait(lock, [&]() { return !_sync_job && !_syncing && !_compaction_job && !_compacting; });
+    }
+
+    void run_sync()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true)
+        {
+            _cv.wait(lock, [&]() { return _sync_job || _stopped; });
+            if (!_sync_job)
+                break;
+
+            std::unique_ptr<sync_job> job = std::move(_sync_job);
+            _syncing = true;
+            lock.unlock();
+
+            try
+            {
+                sync(*job);
+            }
+            catch (const fc::exception& e)
+            {
+                // objects are kept in shared memory until the archive is synced, next append retries
+                elog("Could not sync history archive: ${e}", ("e", e.to_detail_string()));
+            }
+            catch (const std::exception& e)
+            {
+                elog("Could not sync history archive: ${e}", ("e", e.what()));
+            }
+
+            lock.lock();
+            _syncing = false;
+            _idle_cv.notify_all();
+        }
+    }
+
+    void sync(const sync_job& job)
+    {
+        job.operations->sync();
+        job.postings->sync();
+        job.transactions->sync();
+
+        write_state(job.state);
+
+        // files of previous generations are not referred by the synced state anymore
+        for (; _synced_generation < job.state.generation; ++_synced_generation)
+            remove_generation(_synced_generation);
+
+        _synced_ticket = job.ticket;
+    }
+
+    void run_compaction()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true)
+        {
+            _cv.wait(lock, [&]() { return _compaction_job || _stopped; });
+            if (_stopped)
+                break;
+
+            std::unique_ptr<compaction_job> job = std::move(_compaction_job);
+            _compacting = true;
+            lock.unlock();
+
+            std::unique_ptr<compaction_result> result;
+            try
+            {
+                result = compact(*job);
+            }
+            catch (const fc::exception& e)
+            {
+                elog("Could not compact history archive: ${e}", ("e", e.to_detail_string()));
+            }
+            catch (const std::exception& e)
+            {
+                elog("Could not compact history archive: ${e}", ("e", e.what()));
+            }
+
+            lock.lock();
+            _compaction_result = std::move(result);
+            _compacting = false;
+            _idle_cv.notify_all();
+        }
+    }
+
+    /// writes postings and transactions of the job state to files of the next generation, null if interrupted
+    std::unique_ptr<compaction_result> compact(const compaction_job& job)
+    {
+        std::unique_ptr<compaction_result> result(new compaction_result());
+        result->source = job.state;
+        result->generation = job.state.generation + 1;
+
+        // left by interrupted compaction
+        remove_generation(result->generation);
+
+        result->postings = std::make_shared<archive_file>(generation_file(_dir, "postings", result->generation), 0);
+        result->transactions
+            = std::make_shared<archive_file>(generation_file(_dir, "transactions", result->generation), 0);
+
+        if (!compact_postings(*job.postings, job.state.postings_size, *result->postings, result->postings_size)
+            || !compact_transactions(*job.transactions, job.state.transactions_size, *result->transactions,
+                                     result->transactions_size))
+        {
+            return nullptr;
+        }
+
+        result->postings->sync();
+        result->transactions->sync();
+
+        return result;
+    }
+
+    /// merges segments of every list with contiguous sequences
+    bool compact_postings(const archive_file& source, uint64_t size, archive_file& target, uint64_t& written)
+    {
+        const auto mapping = source.map(size, MADV_SEQUENTIAL);
+
+        std::map<posting_key, std::vector<uint64_t>> lists;
+        for (uint64_t offset = 0; offset < size;)
+        {
+            const posting_segment segment(mapping->data() + offset);
+            lists[posting_key(segment.header().list, read_account(segment.header().account))].push_back(offset);
+            offset += segment.header().size;
+        }
+
+        std::vector<char> buffer;
+        std::vector<history_archive::posting_entry> entries;
+        std::vector<const history_archive::posting_entry*> refs;
+        written = 0;
+
+        auto flush_segment = [&]() {
+            if (entries.empty())
+                return;
+
+            refs.clear();
+            for (const auto& entry : entries)
+                refs.push_back(&entry);
+
+            write_posting_segment(refs, 0, refs.size(), buffer);
+            entries.clear();
+
+            if (buffer.size() >= compaction_chunk_size)
+            {
+                target.write(written, buffer);
+                written += buffer.size();
+                buffer.clear();
+            }
+        };
+
+        for (const auto& list : lists)
+        {
+            if (_stopped)
+                return false;
+
+            for (const uint64_t offset : list.second)
+            {
+                const posting_segment segment(mapping->data() + offset);
+                const auto& header = segment.header();
+
+                if (!entries.empty() && entries.back().sequence + 1 != header.first_sequence)
+                    flush_segment();
+
+                for (uint32_t ci = 0; ci < header.count; ++ci)
+                {
+                    if (entries.size() == max_compacted_segment_size)
+                        flush_segment();
+
+                    history_archive::posting_entry entry;
+                    entry.list = list.first.first;
+                    entry.account = list.first.second;
+                    entry.sequence = header.first_sequence + ci;
+                    entry.op = segment.op(ci);
+                    entry.progress = segment.progress(ci);
+                    entries.push_back(std::move(entry));
+                }
+            }
+
+            flush_segment();
+        }
+
+        target.write(written, buffer);
+        written += buffer.size();
+
+        return true;
+    }
+
+    /// merges sorted runs into one run
+    bool compact_transactions(const archive_file& source, uint64_t size, archive_file& target, uint64_t& written)
+    {
+        using cursor = std::pair<const transaction_record*, const transaction_record*>;
+
+        const auto mapping = source.map(size, MADV_SEQUENTIAL);
+
+        auto greater = [](const cursor& a, const cursor& b) { return b.first->id < a.first->id; };
+        std::priority_queue<cursor, std::vector<cursor>, decltype(greater)> runs(greater);
+
+        for (uint64_t offset = 0; offset < size;)
+        {
+            transaction_run_header header;
+            std::memcpy(&header, mapping->data() + offset, sizeof(header));
+
+            const auto* begin = reinterpret_cast<const transaction_record*>(mapping->data() + offset
+                                                                            + sizeof(transaction_run_header));
+            if (header.count)
+                runs.push(cursor(begin, begin + header.count));
+
+            offset += header.size;
+        }
+
+        written = 0;
+        if (runs.empty())
+            return true;
+
+        transaction_run_header header;
+        std::vector<char> buffer;
+        append_pod(buffer, header);
+
+        while (!runs.empty())
+        {
+            cursor run = runs.top();
+            runs.pop();
+
+            // transaction split between appends is recorded by several runs
+            if (!header.count || !(run.first->id == last_id(buffer)))
+            {
+                append_pod(buffer, *run.first);
+                ++header.count;
+            }
+
+            if (++run.first != run.second)
+                runs.push(run);
+
+            if (buffer.size() >= compaction_chunk_size)
+            {
+                if (_stopped)
+                    return false;
+
+                // the last record is kept in buffer to compare with the next one
+                std::vector<char> last(buffer.end() - sizeof(transaction_record), buffer.end());
+                buffer.resize(buffer.size() - sizeof(transaction_record));
+                target.write(written, buffer);
+                written += buffer.size();
+                buffer.swap(last);
+            }
+        }
+
+        header.size = align8(sizeof(header) + uint64_t(header.count) * sizeof(transaction_record));
+        buffer.resize(header.size - written, 0);
+        target.write(written, buffer);
+        written = header.size;
+
+        std::vector<char> header_buffer;
+        append_pod(header_buffer, header);
+        target.write(0, header_buffer);
+
+        return true;
+    }
+
+    static const transaction_id_type& last_id(const std::vector<char>& buffer)
+    {
+        return reinterpret_cast<const transaction_record*>(buffer.data() + buffer.size() - sizeof(transaction_record))
+            ->id;
+    }
+
+    /// switches to compacted files, data appended during compaction is copied to them
+    void install_compaction()
+    {
+        std::unique_ptr<compaction_result> result;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            result = std::move(_compaction_result);
+        }
+
+        if (!result)
+            return;
+
+        const archive_state& source = result->source;
+
+        archive_state state = _state;
+        state.generation = result->generation;
+        state.compacted_postings_size = result->postings_size;
+        state.compacted_transactions_size = result->transactions_size;
+        state.postings_size = result->postings_size + (_state.postings_size - source.postings_size);
+        state.transactions_size = result->transactions_size + (_state.transactions_size - source.transactions_size);
+
+        result->postings->write(result->postings_size, std::vector<char>(_postings->data() + source.postings_size,
+                                                                         _postings->data() + _state.postings_size));
+        result->transactions->write(result->transactions_size,
+                                    std::vector<char>(_transactions->data() + source.transactions_size,
+                                                      _transactions->data() + _state.transactions_size));
+
+        _state = state;
+
+        _postings = result->postings;
+        _transactions = result->transactions;
+        _postings->commit(_state.postings_size);
+        _transactions->commit(_state.transactions_size);
+
+        _segments.clear();
+        _transaction_runs.clear();
+        scan_postings(0);
+        scan_transactions(0);
+
+        request_sync();
+
+        ilog("History archive is compacted to generation ${g}: postings ${p} -> ${cp} bytes, transactions ${t} -> "
+             "${ct} bytes",
+             ("g", state.generation)("p", source.postings_size)("cp", result->postings_size)(
+                 "t", source.transactions_size)("ct", result->transactions_size));
+    }
+
+    void clear()
+    {
+        std::unique_ptr<compaction_result> result;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _sync_job.reset();
+            _compaction_job.reset();
+            _idle_cv.wait(lock, [&]() { return !_syncing && !_compacting; });
+            result = std::move(_compaction_result);
+        }
+
+        if (result)
+        {
+            const uint32_t generation = result->generation;
+            result.reset();
+            remove_generation(generation);
+        }
+
+        archive_state state;
+        state.generation = _state.generation;
+        write_state(state);
+        _state = state;
+
+        for (auto* file : { _operations.get(), _postings.get(), _transactions.get() })
+        {
+            file->truncate(0);
+            file->commit(0);
+        }
+
+        _column_blocks.clear();
+        _segments.clear();
+        _transaction_runs.clear();
+
+        _synced_ticket = _appends.load();
+    }
+
+    uint64_t next_sequence(uint16_t list, const account_name_type& account) const
+    {
+        auto it = _segments.find(posting_key(list, account));
+        if (it == _segments.end())
+            return 0;
+
+        const auto& last = it->second.back();
+        return last.first_sequence + last.count;
+    }
+
+    column_block block_at(const column_block_ref& ref) const
+    {
+        return column_block(_operations->data() + ref.offset);
+    }
+
+    /// column blocks which can contain operations of [from, to] ids
+    std::vector<column_block_ref>::const_iterator first_block_by_id(int64_t id) const
+    {
+        auto it = std::upper_bound(_column_blocks.begin(), _column_blocks.end(), id,
+                                   [](int64_t id, const column_block_ref& ref) { return id < ref.header.first_id; });
+        if (it != _column_blocks.begin())
+            --it;
+        return it;
+    }
+
+    archive_state _state;
+    fc::path _dir;
+    fc::path _state_path;
+    uint32_t _column_block_size;
+
+    /// files are shared with jobs of background threads
+    std::shared_ptr<archive_file> _operations;
+    std::shared_ptr<archive_file> _postings;
+    std::shared_ptr<archive_file> _transactions;
+
+    std::vector<column_block_ref> _column_blocks;
+    std::map<posting_key, std::vector<posting_segment_ref>> _segments;
+    std::vector<transaction_run_ref> _transaction_runs;
+
+    /// appends and installed compactions, each of them is synced by the job with its number
+    std::atomic<uint64_t> _appends{ 0 };
+    std::atomic<uint64_t> _synced_ticket{ 0 };
+    /// used by sync thread only
+    uint32_t _synced_generation = 0;
+
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::condition_variable _idle_cv;
+    std::unique_ptr<sync_job> _sync_job;
+    std::unique_ptr<compaction_job> _compaction_job;
+    std::unique_ptr<compaction_result> _compaction_result;
+    bool _syncing = false;
+    bool _compacting = false;
+    std::atomic<bool> _stopped{ false };
+
+    std::thread _sync_thread;
+    std::thread _compaction_thread;
+};
+}
+
+history_archive::history_archive(const fc::path& dir, uint32_t column_block_size)
+    : _impl(new detail::history_archive_impl(dir, column_block_size))
+{
+}
+
+history_archive::~history_archive()
+{
+}
+
+int64_t history_archive::next_operation_id() const
+{
+    return _impl->_state.next_operation_id;
+}
+
+uint32_t history_archive::last_block() const
+{
+    return _impl->_column_blocks.empty() ? 0 : _impl->_column_blocks.back().header.last_block;
+}
+
+uint64_t history_archive::next_sequence(uint16_t list, const account_name_type& account) const
+{
+    return _impl->next_sequence(list, account);
+}
+
+void history_archive::append(const std::vector<operation_entry>& operations, const std::vector<posting_entry>& postings)
+{
+    _impl->append(operations, postings);
+}
+
+void history_archive::clear()
+{
+    _impl->clear();
+}
+
+bool history_archive::is_synced() const
+{
+    return _impl->is_synced();
+}
+
+void history_archive::compact()
+{
+    _impl->request_compaction();
+}
+
+void history_archive::wait() const
+{
+    _impl->wait();
+}
+
+fc::optional<applied_operation> history_archive::find_operation(int64_t id) const
+{
+    fc::optional<applied_operation> result;
+    get_operations(id, id, [&](int64_t, const applied_operation& op) {
+        result = op;
+        return false;
+    });
+    return result;
+}
+
+void history_archive::get_operations(int64_t from, int64_t to, const operation_visitor& visit) const
+{
+    const auto& blocks = _impl->_column_blocks;
+
+    for (auto it = _impl->first_block_by_id(from); it != blocks.end() && it->header.first_id <= to; ++it)
+    {
+        const auto block = _impl->block_at(*it);
+        const int64_t first_id = it->header.first_id;
+
+        for (int64_t id = std::max(from, first_id); id <= to && id < first_id + it->header.count; ++id)
+        {
+            if (!visit(id, block.operation(id - first_id)))
+                return;
+        }
+    }
+}
+
+void history_archive::get_operations_by_time(const fc::time_point_sec& from,
+                                             const fc::time_point_sec& to,
+                                             const operation_visitor& visit) const
+{
+    const auto& blocks = _impl->_column_blocks;
+    const uint32_t from_sec = from.sec_since_epoch();
+    const uint32_t to_sec = to.sec_since_epoch();
+
+    auto it = std::lower_bound(blocks.begin(), blocks.end(), from_sec,
+                               [](const detail::history_archive_impl::column_block_ref& ref, uint32_t t) {
+                                   return ref.header.last_timestamp < t;
+                               });
+
+    for (; it != blocks.end() && it->header.first_timestamp <= to_sec; ++it)
+    {
+        const auto block = _impl->block_at(*it);
+
+        for (uint32_t ci = 0; ci < it->header.count; ++ci)
+        {
+            const uint32_t t = block.timestamp(ci);
+            if (t < from_sec)
+                continue;
+            if (t > to_sec)
+                return;
+            if (!visit(it->header.first_id + ci, block.operation(ci)))
+                return;
+        }
+    }
+}
+
+void history_archive::get_operations_in_block(uint32_t block_num, const operation_visitor& visit) const
+{
+    const auto& blocks = _impl->_column_blocks;
+
+    auto it = std::lower_bound(blocks.begin(), blocks.end(), block_num,
+                               [](const detail::history_archive_impl::column_block_ref& ref, uint32_t b) {
+                                   return ref.header.last_block < b;
+                               });
+
+    for (; it != blocks.end() && it->header.first_block <= block_num; ++it)
+    {
+        const auto block = _impl->block_at(*it);
+
+        for (uint32_t ci = 0; ci < it->header.count; ++ci)
+        {
+            const uint32_t b = block.block(ci);
+            if (b < block_num)
+                continue;
+            if (b > block_num)
+                return;
+            if (!visit(it->header.first_id + ci, block.operation(ci)))
+                return;
+        }
+    }
+}
+
+bool history_archive::find_transaction(const transaction_id_type& id, uint32_t& block, uint32_t& trx_in_block) const
+{
+    using detail::transaction_record;
+
+    const auto& runs = _impl->_transaction_runs;
+
+    for (auto it = runs.rbegin(); it != runs.rend(); ++it)
+    {
+        if (!it->filter.may_contain(id))
+            continue;
+
+        const auto* records = _impl->records(*it);
+        const auto* end = records + it->count;
+
+        auto found = std::lower_bound(records, end, id,
+                                      [](const transaction_record& r, const transaction_id_type& id) {
+                                          return r.id < id;
+                                      });
+        if (found != end && found->id == id)
+        {
+            block = found->block;
+            trx_in_block = found->trx_in_block;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void history_archive::get_postings(uint16_t list,
+                                   const account_name_type& account,
+                                   uint64_t from,
+                                   uint64_t to,
+                                   const posting_visitor& visit) const
+{
+    using segment_ref = detail::history_archive_impl::posting_segment_ref;
+
+    auto list_it = _impl->_segments.find(detail::history_archive_impl::posting_key(list, account));
+    if (list_it == _impl->_segments.end() || from > to)
+        return;
+
+    const auto& segments = list_it->second;
+
+    auto it = std::upper_bound(segments.begin(), segments.end(), from,
+                               [](uint64_t s, const segment_ref& ref) { return s < ref.first_sequence; });
+    if (it != segments.begin())
+        --it;
+
+    posting_entry entry;
+    entry.list = list;
+    entry.account = account;
+
+    for (; it != segments.end() && it->first_sequence <= to; ++it)
+    {
+        const detail::posting_segment segment(_impl->_postings->data() + it->offset);
+
+        for (uint64_t s = std::max(from, it->first_sequence); s <= to && s < it->first_sequence + it->count; ++s)
+        {
+            const uint32_t ci = s - it->first_sequence;
+            entry.sequence = s;
+            entry.op = segment.op(ci);
+            entry.progress = segment.progress(ci);
+            visit(entry);
+        }
+    }
+}
+}
+}
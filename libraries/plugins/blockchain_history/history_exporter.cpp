@@ -0,0 +1,510 @@
+#include <scorum/blockchain_history/history_exporter.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/io/json.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/reflect/variant.hpp>
+#include <fc/time.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace scorum {
+namespace blockchain_history {
+
+namespace {
+
+const std::string file_prefix = "history-";
+const std::string part_suffix = ".part";
+
+void append_length(std::vector<char>& buffer, uint32_t length)
+{
+    for (int ci = 0; ci < 4; ++ci)
+        buffer.push_back(char((length >> (8 * ci)) & 0xff));
+}
+
+bool is_export_file(const std::string& name)
+{
+    return name.compare(0, file_prefix.size(), file_prefix) == 0;
+}
+
+bool is_part_file(const std::string& name)
+{
+    return name.size() > part_suffix.size()
+        && name.compare(name.size() - part_suffix.size(), part_suffix.size(), part_suffix) == 0;
+}
+
+uint32_t first_block_of(const std::string& name)
+{
+    return (uint32_t)std::strtoul(name.c_str() + file_prefix.size(), nullptr, 10);
+}
+
+struct record_position
+{
+    uint64_t offset = 0;
+    uint32_t block = 0;
+};
+
+// complete records of export file, a record cut by interrupted write and everything after it are skipped
+std::vector<record_position> scan_records(const fc::path& file)
+{
+    std::ifstream io(file.string(), std::ios::binary);
+    std::vector<char> data((std::istreambuf_iterator<char>(io)), std::istreambuf_iterator<char>());
+
+    const bool binary = file.string().find(".bin") != std::string::npos;
+
+    std::vector<record_position> result;
+    size_t pos = 0;
+    while (pos < data.size())
+    {
+        record_position record;
+        record.offset = pos;
+
+        try
+        {
+            if (binary)
+            {
+                if (pos + 4 > data.size())
+                    break;
+
+                uint32_t length = 0;
+                for (int ci = 0; ci < 4; ++ci)
+                    length |= uint32_t(uint8_t(data[pos + ci])) << (8 * ci);
+
+                if (pos + 4 + length > data.size())
+                    break;
+
+                std::vector<char> packed(data.begin() + pos + 4, data.begin() + pos + 4 + length);
+                record.block = fc::raw::unpack<exported_operation>(packed).block;
+                pos += 4 + length;
+            }
+            else
+            {
+                auto end = std::find(data.begin() + pos, data.end(), '\n');
+                if (end == data.end())
+                    break;
+
+                const std::string line(data.begin() + pos, end);
+                record.block = fc::json::from_string(line).as<exported_operation>().block;
+                pos = end - data.begin() + 1;
+            }
+        }
+        catch (const fc::exception&)
+        {
+            break;
+        }
+
+        result.push_back(record);
+    }
+
+    return result;
+}
+}
+
+const char* history_exporter::cursor_file_name = "export.cursor";
+
+history_exporter::history_exporter(const fc::path& dir,
+                                   format_type format,
+                                   uint64_t max_file_size,
+                                   uint64_t queue_capacity)
+    : _dir(dir)
+    , _format(format)
+    , _max_file_size(max_file_size)
+    , _queue_capacity(queue_capacity)
+{
+    FC_ASSERT(_max_file_size > 0, "Export file size must be greater than zero");
+    FC_ASSERT(_queue_capacity > 0, "Export queue capacity must be greater than zero");
+
+    if (!fc::exists(_dir))
+        fc::create_directories(_dir);
+
+    _stats.queue_capacity = _queue_capacity;
+
+    recover();
+
+    _thread = std::thread([this]() { run(); });
+}
+
+history_exporter::~history_exporter()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopped = true;
+    }
+    _cv.notify_all();
+
+    _thread.join();
+}
+
+bool history_exporter::push(exported_block&& block)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        const uint64_t records = block.operations.size();
+        if (_stats.queued_blocks > 0 && _stats.queued_records + records > _queue_capacity)
+        {
+            ++_stats.rejected_pushes;
+            return false;
+        }
+
+        _stats.last_queued_block = block.block_num;
+        ++_stats.queued_blocks;
+        _stats.queued_records += records;
+        _stats.max_queued_records = std::max(_stats.max_queued_records, _stats.queued_records);
+
+        _queue.push_back(std::move(block));
+    }
+    _cv.notify_one();
+
+    return true;
+}
+
+uint32_t history_exporter::last_exported_block() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats.last_exported_block;
+}
+
+history_export_stats history_exporter::get_stats() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats;
+}
+
+history_exporter::format_type history_exporter::parse_format(const std::string& name)
+{
+    if (name == "binary")
+        return format_type::binary;
+    if (name == "json")
+        return format_type::json;
+
+    FC_THROW_EXCEPTION(fc::invalid_arg_exception, "Unknown history export format ${f}, expected binary or json",
+                       ("f", name));
+}
+
+void history_exporter::recover()
+{
+    std::vector<std::string> files;
+    for (boost::filesystem::directory_iterator it(_dir.string()), end; it != end; ++it)
+    {
+        const std::string name = it->path().filename().string();
+        if (is_export_file(name))
+            files.push_back(name);
+    }
+
+    // names start with zero padded number of the first block
+    std::sort(files.begin(), files.end());
+
+    history_export_cursor cursor;
+
+    const fc::path cursor_path = _dir / cursor_file_name;
+    if (fc::exists(cursor_path))
+    {
+        cursor = fc::json::from_file(cursor_path).as<history_export_cursor>();
+    }
+    else if (!files.empty())
+    {
+        // exported without cursor, the last block of unfinished file may be incomplete and is exported again
+        const std::string& name = files.back();
+        const auto records = scan_records(_dir / name);
+
+        cursor.last_block = first_block_of(name) - 1;
+
+        if (is_part_file(name))
+        {
+            size_t first = records.size();
+            while (first > 0 && records[first - 1].block == records.back().block)
+                --first;
+
+            if (first > 0)
+                cursor.last_block = records[first - 1].block;
+
+            cursor.file = name;
+            cursor.file_size = first < records.size() ? records[first].offset : 0;
+        }
+        else if (!records.empty())
+        {
+            cursor.last_block = records.back().block;
+        }
+    }
+
+    for (const auto& name : files)
+    {
+        if (!is_part_file(name))
+            continue;
+
+        const fc::path file = _dir / name;
+
+        if (name == cursor.file)
+        {
+            reopen_file(file, cursor.file_size);
+        }
+        else if (first_block_of(name) <= cursor.last_block)
+        {
+            // rotated file is committed by cursor before it is renamed
+            fc::rename(file, file.parent_path() / file.stem());
+        }
+        else
+        {
+            wlog("Removing ${f} written after the last committed block ${b}, it is exported again",
+                 ("f", file.string())("b", cursor.last_block));
+            fc::remove(file);
+        }
+    }
+
+    _last_written_block = cursor.last_block;
+    _stats.last_exported_block = cursor.last_block;
+    _stats.current_file = _file.string();
+
+    save_cursor();
+
+    if (cursor.last_block > 0)
+        ilog("History export continues after block ${b}", ("b", cursor.last_block));
+}
+
+void history_exporter::save_cursor()
+{
+    history_export_cursor cursor;
+    cursor.last_block = _last_written_block;
+    if (_fd >= 0)
+    {
+        cursor.file = _file.filename().string();
+        cursor.file_size = _file_size;
+    }
+
+    const std::string data = fc::json::to_string(cursor);
+    const fc::path path = _dir / cursor_file_name;
+    const fc::path tmp = _dir / (std::string(cursor_file_name) + ".tmp");
+
+    const int fd = ::open(tmp.string().c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    FC_ASSERT(fd >= 0, "Could not open ${f}: ${e}", ("f", tmp.string())("e", std::strerror(errno)));
+
+    const bool written = ::write(fd, data.data(), data.size()) == (ssize_t)data.size() && ::fdatasync(fd) == 0;
+    ::close(fd);
+    FC_ASSERT(written, "Could not write ${f}", ("f", tmp.string()));
+
+    fc::rename(tmp, path);
+}
+
+void history_exporter::run()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    while (true)
+    {
+        _cv.wait(lock, [&]() { return _stopped || !_queue.empty(); });
+        if (_queue.empty())
+            break;
+
+        // queued stats keep the batch until it is written, so it is counted against capacity meanwhile
+        std::deque<exported_block> batch;
+        batch.swap(_queue);
+
+        lock.unlock();
+
+        const auto start = fc::time_point::now();
+        size_t written = 0;
+        bool failed = false;
+
+        try
+        {
+            for (const auto& block : batch)
+            {
+                write_block(block);
+                ++written;
+            }
+
+            if (_fd >= 0 && ::fdatasync(_fd) != 0)
+                FC_THROW("Could not sync ${f}: ${e}", ("f", _file.string())("e", std::strerror(errno)));
+
+            save_cursor();
+        }
+        catch (const fc::exception& e)
+        {
+            failed = true;
+            wlog("History export failed: ${e}", ("e", e.to_detail_string()));
+        }
+        catch (const std::exception& e)
+        {
+            failed = true;
+            wlog("History export failed: ${e}", ("e", e.what()));
+        }
+
+        const uint64_t elapsed = (fc::time_point::now() - start).count();
+
+        lock.lock();
+
+        uint64_t records = 0;
+        for (size_t ci = 0; ci < written; ++ci)
+            records += batch[ci].operations.size();
+
+        _stats.queued_blocks -= written;
+        _stats.queued_records -= records;
+        _stats.exported_records += records;
+        if (written > 0)
+            _stats.last_exported_block = batch[written - 1].block_num;
+        _stats.current_file = _file.string();
+
+        ++_stats.batches;
+        _stats.last_batch_microseconds = elapsed;
+        _stats.max_batch_microseconds = std::max(_stats.max_batch_microseconds, elapsed);
+        _stats.written_bytes = _written_bytes;
+
+        if (failed)
+        {
+            ++_stats.write_errors;
+
+            if (_stopped)
+            {
+                elog("History export is stopped, ${n} blocks are not exported", ("n", batch.size() - written));
+                _stats.queued_blocks = 0;
+                _stats.queued_records = 0;
+                break;
+            }
+
+            // unwritten blocks go back to the head of the queue and are retried after a pause
+            for (size_t ci = batch.size(); ci > written; --ci)
+                _queue.push_front(std::move(batch[ci - 1]));
+
+            _cv.wait_for(lock, std::chrono::seconds(1), [&]() { return _stopped; });
+        }
+    }
+
+    lock.unlock();
+
+    try
+    {
+        close_file();
+    }
+    catch (const fc::exception& e)
+    {
+        wlog("Could not close history export file: ${e}", ("e", e.to_detail_string()));
+    }
+}
+
+void history_exporter::write_block(const exported_block& block)
+{
+    if (_fd >= 0 && _file_size >= _max_file_size)
+        close_file();
+
+    if (_fd < 0)
+        open_file(block.block_num);
+
+    std::vector<char> buffer;
+    for (const auto& op : block.operations)
+    {
+        if (_format == format_type::binary)
+        {
+            const auto record = fc::raw::pack(op);
+            append_length(buffer, record.size());
+            buffer.insert(buffer.end(), record.begin(), record.end());
+        }
+        else
+        {
+            const std::string record = fc::json::to_string(op);
+            buffer.insert(buffer.end(), record.begin(), record.end());
+            buffer.push_back('\n');
+        }
+    }
+
+    const uint64_t size_before = _file_size;
+    try
+    {
+        write(buffer.data(), buffer.size());
+    }
+    catch (...)
+    {
+        // drop partially written block, it is written again by retry
+        if (::ftruncate(_fd, size_before) == 0)
+        {
+            _written_bytes -= _file_size - size_before;
+            _file_size = size_before;
+        }
+        throw;
+    }
+
+    _last_written_block = block.block_num;
+}
+
+void history_exporter::open_file(uint32_t block_num)
+{
+    char name[64];
+    std::snprintf(name, sizeof(name), "history-%010u.%s.part", block_num,
+                  _format == format_type::binary ? "bin" : "json");
+
+    _file = _dir / name;
+    _fd = ::open(_file.string().c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    FC_ASSERT(_fd >= 0, "Could not open ${f}: ${e}", ("f", _file.string())("e", std::strerror(errno)));
+
+    // files beyond the cursor are removed on start, existing data is not clobbered anyway
+    const off_t size = ::lseek(_fd, 0, SEEK_END);
+    _file_size = size > 0 ? size : 0;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_stats.files;
+}
+
+void history_exporter::reopen_file(const fc::path& file, uint64_t size)
+{
+    _file = file;
+    _fd = ::open(_file.string().c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+    FC_ASSERT(_fd >= 0, "Could not open ${f}: ${e}", ("f", _file.string())("e", std::strerror(errno)));
+
+    // data after the committed size belongs to blocks which are exported again
+    FC_ASSERT(::ftruncate(_fd, size) == 0, "Could not truncate ${f}: ${e}",
+              ("f", _file.string())("e", std::strerror(errno)));
+    _file_size = size;
+
+    ++_stats.files;
+}
+
+void history_exporter::close_file()
+{
+    if (_fd < 0)
+        return;
+
+    ::fdatasync(_fd);
+    ::close(_fd);
+    _fd = -1;
+
+    // committed before renaming, so the file is completed by the next start if renaming is interrupted
+    save_cursor();
+
+    // strip .part suffix
+    fc::rename(_file, _file.parent_path() / _file.stem());
+    _file = fc::path();
+    _file_size = 0;
+}
+
+void history_exporter::write(const char* data, size_t size)
+{
+    while (size > 0)
+    {
+        const ssize_t written = ::write(_fd, data, size);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            FC_THROW("Could not write ${f}: ${e}", ("f", _file.string())("e", std::strerror(errno)));
+        }
+
+        data += written;
+        size -= written;
+        _file_size += written;
+        _written_bytes += written;
+    }
+}
+}
+}
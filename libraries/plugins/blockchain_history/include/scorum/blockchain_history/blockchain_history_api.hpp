@@ -4,6 +4,7 @@
 #include <fc/api.hpp>
 #include <scorum/blockchain_history/schema/applied_operation.hpp>
 #include <scorum/blockchain_history/api_objects.hpp>
+#include <scorum/blockchain_history/history_exporter.hpp>
 #include <scorum/protocol/transaction.hpp>
 
 #ifndef API_BLOCKCHAIN_HISTORY
@@ -112,6 +113,11 @@ public:
      */
     std::map<uint32_t, signed_block_api_obj> get_blocks_history(uint32_t block_num, uint32_t limit) const;
 
+    /**
+     * @brief Returns state of history export: queue fill, blocks held by backpressure, written files and bytes
+     */
+    history_export_stats get_history_export_stats() const;
+
     /// @}
 
 private:
@@ -124,4 +130,6 @@ private:
 FC_API(scorum::blockchain_history::blockchain_history_api,
        (get_ops_history)(get_ops_history_by_time)(get_ops_in_block)
        // Blocks and transactions
-       (get_transaction)(get_block_header)(get_block_headers_history)(get_block)(get_blocks_history))
+       (get_transaction)(get_block_header)(get_block_headers_history)(get_block)(get_blocks_history)
+       // Export
+       (get_history_export_stats))
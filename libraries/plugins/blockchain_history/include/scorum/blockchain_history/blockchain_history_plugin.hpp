@@ -39,6 +39,9 @@ namespace detail {
 class blockchain_history_plugin_impl;
 }
 
+class history_archive;
+struct history_export_stats;
+
 /**
  * @brief This plugin is designed to track a range of operations by account so that one node doesn't need to hold the
  * full operation history in memory.
@@ -60,6 +63,12 @@ public:
 
     flat_map<account_name_type, account_name_type> tracked_accounts() const; /// map start_range to end_range
 
+    /// archive of irreversible history, null if archive is disabled
+    std::shared_ptr<const history_archive> archive() const;
+
+    /// state of export pipeline, throws if export is disabled
+    history_export_stats export_stats() const;
+
     friend class detail::blockchain_history_plugin_impl;
     std::unique_ptr<detail::blockchain_history_plugin_impl> _my;
 };
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <scorum/blockchain_history/schema/applied_operation.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/optional.hpp>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace scorum {
+namespace blockchain_history {
+
+namespace detail {
+class history_archive_impl;
+}
+
+/**
+ * @brief Append-only archive of irreversible history moved out of shared memory.
+ *
+ * Operations are stored by column blocks in operations.dat: each field of consecutive operations is kept
+ * in its own array, so lookups by id, block or timestamp touch only the needed columns of the mapped file.
+ * Account histories and filtered operation lists are posting lists (sequence -> operation id) written
+ * by segments of contiguous sequences to postings.N.dat. Transaction ids of every append are written
+ * to transactions.N.dat as a sorted run, runs are looked up through in-memory bloom filters.
+ *
+ * Postings and transactions are compacted by background thread when they grow by a quarter since the previous
+ * compaction: segments of every list are merged and runs are merged into one, which is searched directly.
+ * Compacted data is written to files of the next generation N, data appended meanwhile is copied to them when
+ * the result is installed by the next append.
+ *
+ * Appends are written without waiting for disk. Another background thread syncs them and commits by rewriting
+ * archive.state, data beyond committed sizes is dropped on open, so an interrupted append does not corrupt
+ * the archive, but appends which are not synced yet are lost by a crash.
+ *
+ * Archive is appended under write lock of database and read under read lock, it is not synchronized itself.
+ */
+class history_archive
+{
+public:
+    static const uint32_t default_column_block_size = 4096;
+
+    struct operation_entry
+    {
+        int64_t id = 0;
+        transaction_id_type trx_id;
+        uint32_t block = 0;
+        uint32_t trx_in_block = 0;
+        uint16_t op_in_trx = 0;
+        fc::time_point_sec timestamp;
+        std::vector<char> serialized_op;
+    };
+
+    /**
+     * Entry of posting list. Account histories are lists of object type of history object and account,
+     * filtered operations are lists of object type of filtered object and empty account.
+     */
+    struct posting_entry
+    {
+        uint16_t list = 0;
+        account_name_type account;
+        uint64_t sequence = 0;
+        int64_t op = 0;
+        std::vector<int64_t> progress;
+    };
+
+    /// return false to stop
+    using operation_visitor = std::function<bool(int64_t id, const applied_operation&)>;
+    using posting_visitor = std::function<void(const posting_entry&)>;
+
+    explicit history_archive(const fc::path& dir, uint32_t column_block_size = default_column_block_size);
+    ~history_archive();
+
+    /**
+     * Operations with lower ids are archived.
+     */
+    int64_t next_operation_id() const;
+
+    /**
+     * Block of the last archived operation, zero if archive is empty.
+     */
+    uint32_t last_block() const;
+
+    /**
+     * Sequence following the last archived entry of the list, zero if nothing is archived.
+     */
+    uint64_t next_sequence(uint16_t list, const account_name_type& account) const;
+
+    /**
+     * Appends operations ordered by id and postings ordered by sequence within each list.
+     */
+    void append(const std::vector<operation_entry>& operations, const std::vector<posting_entry>& postings);
+
+    /**
+     * Removes all archived data.
+     */
+    void clear();
+
+    /**
+     * All appended data is synced to disk, so it survives a crash.
+     */
+    bool is_synced() const;
+
+    /**
+     * Starts compaction regardless of the size of appended data.
+     */
+    void compact();
+
+    /**
+     * Waits until appended data is synced and running compaction is finished. Compacted files are used
+     * after the next append.
+     */
+    void wait() const;
+
+    fc::optional<applied_operation> find_operation(int64_t id) const;
+
+    /// visits operations with ids in [from, to]
+    void get_operations(int64_t from, int64_t to, const operation_visitor& visit) const;
+
+    /// visits operations with timestamps in [from, to] in order of ids
+    void get_operations_by_time(const fc::time_point_sec& from,
+                                const fc::time_point_sec& to,
+                                const operation_visitor& visit) const;
+
+    void get_operations_in_block(uint32_t block, const operation_visitor& visit) const;
+
+    bool find_transaction(const transaction_id_type& id, uint32_t& block, uint32_t& trx_in_block) const;
+
+    /// visits entries of the list with sequences in [from, to]
+    void get_postings(uint16_t list,
+                      const account_name_type& account,
+                      uint64_t from,
+                      uint64_t to,
+                      const posting_visitor& visit) const;
+
+private:
+    std::unique_ptr<detail::history_archive_impl> _impl;
+};
+}
+}
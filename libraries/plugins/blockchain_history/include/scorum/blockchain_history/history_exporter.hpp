@@ -0,0 +1,172 @@
+#pragma once
+
+#include <scorum/protocol/operations.hpp>
+#include <scorum/protocol/types.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/reflect/reflect.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace scorum {
+namespace blockchain_history {
+
+using scorum::protocol::operation;
+using scorum::protocol::transaction_id_type;
+
+struct exported_operation
+{
+    uint32_t block = 0;
+    transaction_id_type trx_id;
+    uint32_t trx_in_block = 0;
+    uint16_t op_in_trx = 0;
+    bool virtual_op = false;
+    fc::time_point_sec timestamp;
+    operation op;
+};
+
+struct exported_block
+{
+    uint32_t block_num = 0;
+    std::vector<exported_operation> operations;
+};
+
+/**
+ * Blocks up to last_block are written and synced. The file of the next block is kept open with file_size
+ * bytes of complete blocks, it is empty if there is no open file.
+ */
+struct history_export_cursor
+{
+    uint32_t last_block = 0;
+    std::string file;
+    uint64_t file_size = 0;
+};
+
+struct history_export_stats
+{
+    uint32_t last_queued_block = 0;
+    uint32_t last_exported_block = 0;
+
+    uint64_t queued_blocks = 0;
+    uint64_t queued_records = 0;
+    uint64_t max_queued_records = 0;
+    uint64_t queue_capacity = 0;
+
+    /// irreversible blocks waiting because the queue was full, their operations are read back from history
+    uint64_t held_blocks = 0;
+    /// blocks waiting for irreversibility
+    uint64_t reversible_blocks = 0;
+    uint64_t rejected_pushes = 0;
+
+    uint64_t batches = 0;
+    uint64_t last_batch_microseconds = 0;
+    uint64_t max_batch_microseconds = 0;
+    uint64_t exported_records = 0;
+    uint64_t written_bytes = 0;
+    uint64_t files = 0;
+    uint64_t write_errors = 0;
+    std::string current_file;
+};
+
+/**
+ * @brief Writes operations of irreversible blocks to rotating files by background thread.
+ *
+ * Blocks are queued by the chain thread and written by batches of everything queued, so the chain thread
+ * never waits for disk. The queue is bounded by the number of records: push is rejected while the queue
+ * is full and the caller keeps the block until the next attempt (backpressure).
+ *
+ * Files are named by the first block they contain (history-0000000001.bin or .json) and are written
+ * with .part suffix until rotated, so complete files can be consumed while export goes on. A file is
+ * rotated at block boundary after it reaches the size limit.
+ *
+ * Binary format is a sequence of records of 32 bit little endian length followed by exported_operation
+ * packed by fc::raw. JSON format is one exported_operation object per line.
+ *
+ * The last synced block is committed to export.cursor after every batch and rotation. On construction
+ * the open file of the cursor is reopened and truncated to its committed size, files of blocks beyond
+ * the cursor are dropped, and the owner continues from last_exported_block() + 1. Files exported without
+ * cursor are trimmed to the last block having complete records.
+ */
+class history_exporter
+{
+public:
+    enum class format_type
+    {
+        binary,
+        json
+    };
+
+    static const uint64_t default_file_size = 256 * 1024 * 1024;
+    static const uint64_t default_queue_capacity = 1000000;
+
+    history_exporter(const fc::path& dir,
+                     format_type format,
+                     uint64_t max_file_size = default_file_size,
+                     uint64_t queue_capacity = default_queue_capacity);
+
+    /// writes everything queued and closes the current file
+    ~history_exporter();
+
+    static const char* cursor_file_name;
+
+    /// last block committed to export files, zero if nothing is exported to the directory
+    uint32_t last_exported_block() const;
+
+    /**
+     * Queues block for writing, returns false if the queue is full. A block is accepted by empty queue
+     * regardless of its size.
+     */
+    bool push(exported_block&& block);
+
+    history_export_stats get_stats() const;
+
+    static format_type parse_format(const std::string& name);
+
+private:
+    void recover();
+    void save_cursor();
+    void run();
+    void write_block(const exported_block& block);
+    void open_file(uint32_t block_num);
+    void reopen_file(const fc::path& file, uint64_t size);
+    void close_file();
+    void write(const char* data, size_t size);
+
+    fc::path _dir;
+    format_type _format;
+    uint64_t _max_file_size;
+    uint64_t _queue_capacity;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _cv;
+    std::deque<exported_block> _queue;
+    bool _stopped = false;
+
+    history_export_stats _stats;
+
+    // accessed by writer thread only
+    int _fd = -1;
+    fc::path _file;
+    uint64_t _file_size = 0;
+    uint64_t _written_bytes = 0;
+    uint32_t _last_written_block = 0;
+
+    std::thread _thread;
+};
+}
+}
+
+FC_REFLECT(scorum::blockchain_history::exported_operation,
+           (block)(trx_id)(trx_in_block)(op_in_trx)(virtual_op)(timestamp)(op))
+
+FC_REFLECT(scorum::blockchain_history::history_export_cursor, (last_block)(file)(file_size))
+
+FC_REFLECT(scorum::blockchain_history::history_export_stats,
+           (last_queued_block)(last_exported_block)(queued_blocks)(queued_records)(max_queued_records)(
+               queue_capacity)(held_blocks)(reversible_blocks)(rejected_pushes)(batches)(last_batch_microseconds)(
+               max_batch_microseconds)(exported_records)(written_bytes)(files)(write_errors)(current_file))
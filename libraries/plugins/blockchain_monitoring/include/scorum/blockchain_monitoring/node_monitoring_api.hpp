@@ -2,6 +2,16 @@
 
 #include <fc/api.hpp>
 
+#include <scorum/protocol/signature_keys_cache.hpp>
+#include <scorum/app/api_thread_pool.hpp>
+
+#include <chainbase/memory_stats.hpp>
+#include <chainbase/segment_flusher.hpp>
+
+#include <scorum/chain/database/block_production_stats.hpp>
+#include <scorum/chain/database/pending_transaction_pool.hpp>
+#include <scorum/chain/database/state_digest.hpp>
+
 #ifndef API_NODE_MONITORING
 #define API_NODE_MONITORING "node_monitoring_api"
 #endif
@@ -47,6 +57,45 @@ public:
     uint32_t get_free_shared_memory_mb() const;
     uint32_t get_total_shared_memory_mb() const;
 
+    /**
+    * @brief Returns hit/miss counters of cache of public keys recovered from transaction signatures.
+    */
+    scorum::protocol::signature_keys_cache_stats get_signature_keys_cache_stats() const;
+
+    /**
+    * @brief Returns per API call counters, queue depth and latencies of API worker threads.
+    */
+    std::map<std::string, scorum::app::api_thread_pool_stats> get_api_thread_pool_stats() const;
+
+    /**
+    * @brief Returns count, latency and written bytes of background flushes of shared memory file.
+    */
+    chainbase::flush_stats get_shared_memory_flush_stats() const;
+
+    /**
+    * @brief Returns objects count, memory of nodes, dynamic members and undo history of every index
+    * of shared memory file. Dynamic members of large indexes are estimated by sample.
+    */
+    std::vector<chainbase::index_memory_stats> get_index_memory_stats() const;
+
+    /**
+    * @brief Returns size of pending transactions pool and counters of its rebuilds after blocks: authority
+    * verifications done and reused, transactions dropped as expired, included or invalid.
+    */
+    scorum::chain::pending_transaction_stats get_pending_transaction_stats() const;
+
+    /**
+    * @brief Returns counts of blocks produced by this node from the block candidate kept by pending state
+    * and by applying pending transactions again, with latency histograms of block production.
+    */
+    scorum::chain::block_production_stats get_block_production_stats() const;
+
+    /**
+    * @brief Returns digest of chain state at the head block and digests of every index. Requires
+    * state-digest-interval option.
+    */
+    scorum::chain::state_digest get_state_digest() const;
+
     /// @}
 
 private:
@@ -56,4 +105,6 @@ private:
 } // namespace scorum
 
 FC_API(scorum::blockchain_monitoring::node_monitoring_api,
-       (get_last_block_duration_microseconds)(get_free_shared_memory_mb)(get_total_shared_memory_mb))
+       (get_last_block_duration_microseconds)(get_free_shared_memory_mb)(get_total_shared_memory_mb)(
+           get_signature_keys_cache_stats)(get_api_thread_pool_stats)(get_shared_memory_flush_stats)(
+           get_index_memory_stats)(get_pending_transaction_stats)(get_block_production_stats)(get_state_digest))
@@ -54,5 +54,42 @@ uint32_t node_monitoring_api::get_total_shared_memory_mb() const
         [&]() { return uint32_t(_my->_app.chain_database()->get_size() / (1024 * 1024)); });
 }
 
+scorum::protocol::signature_keys_cache_stats node_monitoring_api::get_signature_keys_cache_stats() const
+{
+    return scorum::protocol::signature_keys_cache::instance().get_stats();
+}
+
+std::map<std::string, scorum::app::api_thread_pool_stats> node_monitoring_api::get_api_thread_pool_stats() const
+{
+    return _my->_app.api_pool().get_stats();
+}
+
+chainbase::flush_stats node_monitoring_api::get_shared_memory_flush_stats() const
+{
+    return _my->_app.chain_database()->get_flush_stats();
+}
+
+std::vector<chainbase::index_memory_stats> node_monitoring_api::get_index_memory_stats() const
+{
+    return _my->_app.chain_database()->with_read_lock([&]() { return _my->_app.chain_database()->get_memory_stats(); });
+}
+
+scorum::chain::pending_transaction_stats node_monitoring_api::get_pending_transaction_stats() const
+{
+    return _my->_app.chain_database()->with_read_lock(
+        [&]() { return _my->_app.chain_database()->get_pending_transaction_stats(); });
+}
+
+scorum::chain::block_production_stats node_monitoring_api::get_block_production_stats() const
+{
+    return _my->_app.chain_database()->with_read_lock(
+        [&]() { return _my->_app.chain_database()->get_block_production_stats(); });
+}
+
+scorum::chain::state_digest node_monitoring_api::get_state_digest() const
+{
+    return _my->_app.chain_database()->with_read_lock([&]() { return _my->_app.chain_database()->get_state_digest(); });
+}
+
 } // namespace blockchain_monitoring
 } // namespace scorum
@@ -0,0 +1,194 @@
+#include <scorum/tags/discussions_cache.hpp>
+
+#include <fc/io/raw.hpp>
+
+namespace scorum {
+namespace tags {
+
+discussions_cache::discussions_cache(uint32_t capacity, uint32_t max_age)
+    : _capacity(capacity)
+    , _max_age(max_age)
+{
+}
+
+void discussions_cache::set_capacity(uint32_t capacity)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _capacity = capacity;
+    shrink(capacity);
+}
+
+void discussions_cache::set_max_age(uint32_t max_age)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _max_age = max_age;
+}
+
+bool discussions_cache::enabled() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _capacity > 0;
+}
+
+std::string discussions_cache::make_key(const std::string& ordering,
+                                        const std::set<std::string>& tags,
+                                        const api::discussion_query& query)
+{
+    api::discussion_query normalized = query;
+    normalized.tags = tags;
+
+    auto data = fc::raw::pack(normalized);
+
+    std::string key = ordering;
+    key.push_back(':');
+    key.append(data.begin(), data.end());
+
+    return key;
+}
+
+bool discussions_cache::find(const std::string& key, uint32_t head_block_num, std::vector<api::discussion>& result)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto itr = _index.find(key);
+    if (itr == _index.end())
+    {
+        ++_misses;
+        return false;
+    }
+
+    if (head_block_num - itr->second->block_num >= _max_age)
+    {
+        erase(itr->second);
+        ++_misses;
+        return false;
+    }
+
+    ++_hits;
+    _lru.splice(_lru.begin(), _lru, itr->second);
+    result = itr->second->discussions;
+
+    return true;
+}
+
+void discussions_cache::insert(const std::string& key,
+                               uint32_t head_block_num,
+                               const std::set<std::string>& tags,
+                               const std::vector<api::discussion>& discussions)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (!_capacity || _index.count(key))
+        return;
+
+    entry e;
+    e.key = key;
+    e.block_num = head_block_num;
+    e.tags = tags;
+    e.discussions = discussions;
+    for (const auto& d : discussions)
+    {
+        e.comments.insert(d.id);
+        e.comments.insert(d.root_comment);
+    }
+
+    _lru.push_front(std::move(e));
+
+    const auto& inserted = _lru.front();
+    _index.emplace(key, _lru.begin());
+    for (const auto& tag : inserted.tags)
+        _keys_by_tag[tag].insert(key);
+    for (const auto& comment : inserted.comments)
+        _keys_by_comment[comment].insert(key);
+
+    shrink(_capacity);
+}
+
+void discussions_cache::invalidate(const std::set<std::string>& tags, const std::set<comment_id_type>& comments)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_index.empty())
+        return;
+
+    std::set<std::string> keys;
+
+    for (const auto& tag : tags)
+    {
+        auto itr = _keys_by_tag.find(tag);
+        if (itr != _keys_by_tag.end())
+            keys.insert(itr->second.begin(), itr->second.end());
+    }
+
+    for (const auto& comment : comments)
+    {
+        auto itr = _keys_by_comment.find(comment);
+        if (itr != _keys_by_comment.end())
+            keys.insert(itr->second.begin(), itr->second.end());
+    }
+
+    for (const auto& key : keys)
+        erase(_index.at(key));
+
+    _invalidated += keys.size();
+}
+
+void discussions_cache::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _invalidated += _index.size();
+    _index.clear();
+    _lru.clear();
+    _keys_by_tag.clear();
+    _keys_by_comment.clear();
+}
+
+discussions_cache_stats discussions_cache::get_stats() const
+{
+    discussions_cache_stats stats;
+    stats.hits = _hits;
+    stats.misses = _misses;
+    stats.invalidated = _invalidated;
+    stats.evicted = _evicted;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    stats.size = _index.size();
+    stats.capacity = _capacity;
+
+    return stats;
+}
+
+// _mutex must be locked
+void discussions_cache::erase(lru_list_type::iterator itr)
+{
+    for (const auto& tag : itr->tags)
+    {
+        auto keys = _keys_by_tag.find(tag);
+        keys->second.erase(itr->key);
+        if (keys->second.empty())
+            _keys_by_tag.erase(keys);
+    }
+
+    for (const auto& comment : itr->comments)
+    {
+        auto keys = _keys_by_comment.find(comment);
+        keys->second.erase(itr->key);
+        if (keys->second.empty())
+            _keys_by_comment.erase(keys);
+    }
+
+    _index.erase(itr->key);
+    _lru.erase(itr);
+}
+
+// _mutex must be locked
+void discussions_cache::shrink(uint32_t capacity)
+{
+    while (_index.size() > capacity)
+    {
+        erase(std::prev(_lru.end()));
+        ++_evicted;
+    }
+}
+}
+}
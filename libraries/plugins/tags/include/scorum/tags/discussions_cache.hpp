@@ -0,0 +1,98 @@
+#pragma once
+
+#include <scorum/tags/tags_api_objects.hpp>
+
+#include <atomic>
+#include <list>
+#include <map>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+
+namespace scorum {
+namespace tags {
+
+struct discussions_cache_stats
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t invalidated = 0;
+    uint64_t evicted = 0;
+    uint32_t size = 0;
+    uint32_t capacity = 0;
+};
+
+/**
+ * @brief Bounded LRU cache of get_discussions_by_trending/hot/created results.
+ *
+ * Entries are keyed by the ordering and the normalized discussion_query. Every entry remembers
+ * the tags it was built from and the comments it returned so that an applied block drops only
+ * the entries it could affect. Pending payouts depend on reward fund state which is not tracked,
+ * therefore entries also expire after max age blocks. It is thread safe. Zero capacity disables the cache.
+ */
+class discussions_cache
+{
+public:
+    static const uint32_t default_capacity = 1000;
+    static const uint32_t default_max_age = 20;
+
+    explicit discussions_cache(uint32_t capacity = default_capacity, uint32_t max_age = default_max_age);
+
+    void set_capacity(uint32_t capacity);
+    void set_max_age(uint32_t max_age);
+    bool enabled() const;
+
+    /**
+     * @param tags normalized (lower case, truncated) query tags
+     */
+    static std::string
+    make_key(const std::string& ordering, const std::set<std::string>& tags, const api::discussion_query& query);
+
+    bool find(const std::string& key, uint32_t head_block_num, std::vector<api::discussion>& result);
+
+    void insert(const std::string& key,
+                uint32_t head_block_num,
+                const std::set<std::string>& tags,
+                const std::vector<api::discussion>& discussions);
+
+    /**
+     * Drop entries which were built from any of touched tags or returned any of touched comments.
+     */
+    void invalidate(const std::set<std::string>& tags, const std::set<comment_id_type>& comments);
+
+    void clear();
+
+    discussions_cache_stats get_stats() const;
+
+private:
+    struct entry
+    {
+        std::string key;
+        uint32_t block_num = 0;
+        std::set<std::string> tags;
+        std::set<comment_id_type> comments;
+        std::vector<api::discussion> discussions;
+    };
+
+    using lru_list_type = std::list<entry>;
+
+    void erase(lru_list_type::iterator itr);
+    void shrink(uint32_t capacity);
+
+    mutable std::mutex _mutex;
+    uint32_t _capacity;
+    uint32_t _max_age;
+    lru_list_type _lru;
+    std::unordered_map<std::string, lru_list_type::iterator> _index;
+    std::map<std::string, std::set<std::string>> _keys_by_tag;
+    std::map<comment_id_type, std::set<std::string>> _keys_by_comment;
+
+    std::atomic<uint64_t> _hits{ 0 };
+    std::atomic<uint64_t> _misses{ 0 };
+    std::atomic<uint64_t> _invalidated{ 0 };
+    std::atomic<uint64_t> _evicted{ 0 };
+};
+}
+}
+
+FC_REFLECT(scorum::tags::discussions_cache_stats, (hits)(misses)(invalidated)(evicted)(size)(capacity))
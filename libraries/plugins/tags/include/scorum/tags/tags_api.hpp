@@ -1,15 +1,22 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 
 #include <scorum/protocol/types.hpp>
 #include <scorum/tags/tags_api_objects.hpp>
+#include <scorum/tags/discussions_cache.hpp>
 
 namespace chainbase {
 class database_guard;
 }
 
 namespace scorum {
+namespace app {
+class application;
+struct api_context;
+}
+
 namespace tags {
 
 class tags_api_impl;
@@ -31,6 +38,14 @@ class tags_api : public std::enable_shared_from_this<tags_api>
 
     chainbase::database_guard& guard() const;
 
+    template <typename Lambda> auto with_read_lock(Lambda&& callback) const -> decltype((*(Lambda*)nullptr)());
+
+    scorum::app::application& _app;
+
+    std::vector<api::discussion> get_cached_discussions(const std::string& ordering,
+                                                        const api::discussion_query& query,
+                                                        std::function<std::vector<api::discussion>()> fetch) const;
+
 public:
     tags_api(const app::api_context& ctx);
     ~tags_api();
@@ -89,6 +104,11 @@ public:
      */
     std::vector<api::discussion> get_posts_and_comments(const api::discussion_query& query) const;
 
+    /**
+     * @brief Return hit rate and size of get_discussions_by_trending/hot/created result cache.
+     */
+    discussions_cache_stats get_discussions_cache_stats() const;
+
       /// @}
 };
 
@@ -109,5 +129,8 @@ FC_API(scorum::tags::tags_api,
        (get_content)
        (get_comments)
        (get_posts_and_comments)
-       (get_discussions_by_author))
+       (get_discussions_by_author)
+
+       // monitoring
+       (get_discussions_cache_stats))
 // clang-format on
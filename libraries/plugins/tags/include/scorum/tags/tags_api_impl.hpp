@@ -1,16 +1,15 @@
 #pragma once
 
 #include <boost/algorithm/string.hpp>
-#include <boost/range/numeric.hpp>
+#include <boost/algorithm/cxx11/all_of.hpp>
 #include <boost/range/adaptors.hpp>
-#include <boost/range/algorithm/set_algorithm.hpp>
-#include <boost/range/algorithm/copy.hpp>
 #include <boost/range/algorithm/transform.hpp>
-#include <boost/range/algorithm/sort.hpp>
 #include <boost/range/algorithm/max_element.hpp>
-#include <boost/range/algorithm/lower_bound.hpp>
+#include <boost/range/algorithm/min_element.hpp>
 #include <boost/range/join.hpp>
 
+#include <limits>
+#include <queue>
 #include <stack>
 #include <set>
 
@@ -62,8 +61,6 @@ template <typename Fund> asset calc_pending_payout(const discussion& d, const Fu
 class tags_api_impl
 {
 public:
-    using posts_crefs = std::vector<std::reference_wrapper<const tag_object>>;
-
     tags_api_impl(scorum::chain::database& db)
         : _db(db)
         , _services(_db)
@@ -144,12 +141,33 @@ public:
         return ret;
     }
 
+    /// Lower case and truncate query tags, no tags means all posts
+    static std::set<std::string> normalize_tags(const std::set<std::string>& query_tags)
+    {
+        // clang-format off
+        auto rng = query_tags
+            | boost::adaptors::transformed(utils::to_lower_copy)
+            | boost::adaptors::transformed([](const std::string& s) { return utils::substring(s, 0, TAG_LENGTH_MAX); });
+        // clang-format on
+
+        std::set<std::string> tags(rng.begin(), rng.end());
+        if (tags.empty())
+            tags.insert("");
+
+        return tags;
+    }
+
     std::vector<discussion> get_discussions_by_trending(const discussion_query& query) const
     {
-        auto ordering = [](const tag_object& lhs, const tag_object& rhs) { return lhs.trending > rhs.trending; };
+        auto ordering = [](const tag_object& lhs, const tag_object& rhs) {
+            return std::tie(lhs.trending, lhs.comment) > std::tie(rhs.trending, rhs.comment);
+        };
+        auto position = [](const tag_name_type& tag, const tag_object& t) {
+            return boost::make_tuple(tag, t.trending, t.comment);
+        };
         auto filter = [](const tag_object& t) { return t.net_rshares > 0; };
 
-        return get_discussions(query, ordering, filter);
+        return get_discussions<tags::by_tag_trending>(query, ordering, position, filter);
     }
 
     std::vector<discussion> get_discussions_by_created(const discussion_query& query) const
@@ -157,16 +175,24 @@ public:
         auto ordering = [](const tag_object& lhs, const tag_object& rhs) {
             return std::tie(lhs.created, lhs.comment) > std::tie(rhs.created, rhs.comment);
         };
+        auto position = [](const tag_name_type& tag, const tag_object& t) {
+            return boost::make_tuple(tag, t.created, t.comment);
+        };
 
-        return get_discussions(query, ordering);
+        return get_discussions<tags::by_tag_created>(query, ordering, position);
     }
 
     std::vector<discussion> get_discussions_by_hot(const discussion_query& query) const
     {
-        auto ordering = [](const tag_object& lhs, const tag_object& rhs) { return lhs.hot > rhs.hot; };
+        auto ordering = [](const tag_object& lhs, const tag_object& rhs) {
+            return std::tie(lhs.hot, lhs.comment) > std::tie(rhs.hot, rhs.comment);
+        };
+        auto position = [](const tag_name_type& tag, const tag_object& t) {
+            return boost::make_tuple(tag, t.hot, t.comment);
+        };
         auto filter = [](const tag_object& t) { return t.net_rshares > 0; };
 
-        return get_discussions(query, ordering, filter);
+        return get_discussions<tags::by_tag_hot>(query, ordering, position, filter);
     }
 
     std::vector<discussion> get_discussions_by_author(const discussion_query& query) const
@@ -322,76 +348,41 @@ private:
         return result;
     }
 
-    posts_crefs get_posts(const std::string& tag,
-                          const std::function<bool(const tag_object&)>& tag_filter = &tag_filter_default) const
+    /// Tag with the least number of posts according to tag stats. Tags without stats are considered the largest.
+    tag_name_type get_least_populated_tag(const std::set<std::string>& tags) const
     {
-        std::string tag_lower = utils::to_lower_copy(tag);
-
-        const auto& tag_idx = _db.get_index<tags::tag_index, tags::by_tag>();
-
-        auto rng = tag_idx.equal_range(tag_lower) | boost::adaptors::filtered(tag_filter);
-
-        posts_crefs posts;
-        boost::copy(rng, std::back_inserter(posts));
-
-        return posts;
-    }
+        const auto& stats_idx = _db.get_index<tags::tag_stats_index, tags::by_tag>();
 
-    posts_crefs intersect(const std::vector<posts_crefs>& posts_by_tags) const
-    {
-        using post_cref = posts_crefs::value_type;
-
-        auto from = posts_by_tags.begin();
-        auto to = posts_by_tags.end();
-
-        posts_crefs start(from->begin(), from->end());
-        auto tail = boost::make_iterator_range(std::next(from), to);
+        auto posts_count = [&](const std::string& t) {
+            auto it = stats_idx.find(t);
+            return it != stats_idx.end() ? it->posts : std::numeric_limits<uint32_t>::max();
+        };
 
-        /// Each collection in 'posts_by_tags' is already sorted by comment id (see 'tag_index/by_comment').
-        /// Intersect collections in 'posts_by_tags' each with other.
-        /// [[a,b,c],[b,c,d],[c,d,e]] => start: [a,b,c]; tail: [[b,c,d], [c,d,e]]
-        /// 1. [a,b,c] /\ [b,c,d] = [b,c] (i.e. 'intersection' = [b,c])
-        /// 2. [b,c] /\ [c,d,e] = [c] (i.e 'intersection' = [c])
-        // clang-format off
-        posts_crefs intersection = boost::accumulate(tail, start, [](posts_crefs& intersection, const posts_crefs& posts) {
-            /// intersect 'intersection' with 'posts' and put result back into 'intersection'
-            auto upper_bound = boost::set_intersection(intersection, posts, intersection.begin(), [](post_cref lhs, post_cref rhs) {
-                return lhs.get().comment < rhs.get().comment;
-            });
-            intersection.erase(upper_bound, intersection.end());
-
-            return intersection;
+        return *boost::min_element(tags, [&](const std::string& lhs, const std::string& rhs) {
+            return posts_count(lhs) < posts_count(rhs);
         });
-        // clang-format on
-
-        return intersection;
     }
 
-    posts_crefs union_all(const std::vector<posts_crefs>& posts_by_tags) const
+    bool has_tags(comment_id_type comment, const std::set<std::string>& tags) const
     {
-        using post_cref = posts_crefs::value_type;
-
-        struct less_by_comment
-        {
-            bool operator()(post_cref lhs, post_cref rhs) const
-            {
-                return lhs.get().comment < rhs.get().comment;
-            }
-        };
-
-        std::set<post_cref, less_by_comment> set;
-        for (const auto& posts : posts_by_tags)
-            boost::copy(posts, std::inserter(set, end(set)));
-
-        posts_crefs result;
-        result.reserve(set.size());
-        result.assign(set.begin(), set.end());
+        const auto& tag_idx = _db.get_index<tags::tag_index, tags::by_tag>();
 
-        return result;
+        return boost::algorithm::all_of(tags, [&](const std::string& t) {
+            return tag_idx.find(boost::make_tuple(tag_name_type(t), comment)) != tag_idx.end();
+        });
     }
 
+    /// Posts are read lazily from the per tag 'OrderTag' index which is sorted by 'ordering' within every tag.
+    /// For logical OR the ranges of all tags are merged through a heap, for logical AND the range of the least
+    /// populated tag is walked and every post is checked for the rest of tags. Reading stops as soon as 'limit'
+    /// discussions are collected.
+    ///
+    /// 'position' builds the index key of a tag_object within given tag and is used to start from
+    /// start_author/start_permlink (inclusive).
+    template <typename OrderTag, typename Ordering, typename Position>
     std::vector<discussion> get_discussions(const discussion_query& query,
-                                            const std::function<bool(const tag_object&, const tag_object&)>& ordering,
+                                            Ordering ordering,
+                                            Position position,
                                             const std::function<bool(const tag_object&)>& tag_filter
                                             = &tag_filter_default) const
     {
@@ -401,50 +392,69 @@ private:
         FC_ASSERT((query.start_author && query.start_permlink && !query.start_author->empty() && !query.start_permlink->empty()) ||
                   (!query.start_author && !query.start_permlink),
                   "start_author and start_permlink should be either both specified and not empty or both not specified");
-
-        auto rng = query.tags
-            | boost::adaptors::transformed(utils::to_lower_copy)
-            | boost::adaptors::transformed([](const std::string& s) { return utils::substring(s, 0, TAG_LENGTH_MAX); });
         // clang-format on
 
-        std::set<std::string> tags(rng.begin(), rng.end());
-        if (tags.empty())
-            tags.insert("");
-
-        std::vector<posts_crefs> posts_by_tags;
-        posts_by_tags.reserve(tags.size());
+        auto tags = normalize_tags(query.tags);
 
-        boost::transform(tags, std::back_inserter(posts_by_tags),
-                         [&](const std::string& t) { return get_posts(t, tag_filter); });
+        const tag_object* threshold = nullptr;
+        if (query.start_author && query.start_permlink)
+        {
+            auto id = _services.comment_service().get(*query.start_author, *query.start_permlink).id;
+            const auto& comment_idx = _db.get_index<tags::tag_index, tags::by_comment>();
+            auto it = comment_idx.lower_bound(id);
+            FC_ASSERT(it != comment_idx.end() && it->comment == id, "Start post has no tags.");
+            threshold = &(*it);
+        }
 
-        // clang-format off
-        posts_crefs posts = query.tags_logical_and
-                ? intersect(posts_by_tags)
-                : union_all(posts_by_tags);
-        // clang-format on
+        const auto& idx = _db.get_index<tags::tag_index, OrderTag>();
+        using iterator_type = typename std::decay<decltype(idx)>::type::const_iterator;
+        using posts_range = std::pair<iterator_type, iterator_type>;
 
-        std::vector<discussion> result;
-        if (posts.empty())
-            return result;
+        auto later = [&](const posts_range& lhs, const posts_range& rhs) { return ordering(*rhs.first, *lhs.first); };
+        std::priority_queue<posts_range, std::vector<posts_range>, decltype(later)> heap(later);
 
-        boost::sort(posts, ordering);
+        std::vector<tag_name_type> range_tags;
+        if (query.tags_logical_and)
+            range_tags.push_back(get_least_populated_tag(tags));
+        else
+            range_tags.assign(tags.begin(), tags.end());
 
-        posts_crefs::value_type threshold = *(posts.begin());
-        if (query.start_author && query.start_permlink)
+        for (const auto& t : range_tags)
         {
-            auto id = _services.comment_service().get(*query.start_author, *query.start_permlink).id;
-            const auto& comment_idx = _db.get_index<tags::tag_index, tags::by_comment>();
-            threshold = *(comment_idx.find(id));
+            auto from = threshold ? idx.lower_bound(position(t, *threshold)) : idx.lower_bound(t);
+            auto to = idx.upper_bound(t);
+            if (from != to)
+                heap.push(std::make_pair(from, to));
         }
 
-        auto it = boost::lower_bound(posts, threshold.get(), ordering);
+        std::vector<discussion> result;
+        const tag_object* last_post = nullptr;
 
-        for (; it != posts.end() && result.size() < query.limit; ++it)
+        while (!heap.empty() && result.size() < query.limit)
         {
+            auto range = heap.top();
+            heap.pop();
+
+            const tag_object& post = *range.first;
+            if (++range.first != range.second)
+                heap.push(range);
+
+            // posts with several requested tags have equal keys in every tag so duplicates go one after another
+            if (last_post && last_post->comment == post.comment)
+                continue;
+
+            if (!tag_filter(post))
+                continue;
+
+            if (query.tags_logical_and && tags.size() > 1 && !has_tags(post.comment, tags))
+                continue;
+
+            last_post = &post;
+
             try
             {
-                result.push_back(get_discussion(it->get().comment, query.truncate_body));
-                result.back().promoted = asset(it->get().promoted_balance, SCORUM_SYMBOL);
+                result.push_back(get_discussion(post.comment, query.truncate_body));
+                result.back().promoted = asset(post.promoted_balance, SCORUM_SYMBOL);
             }
             catch (const fc::exception& e)
             {
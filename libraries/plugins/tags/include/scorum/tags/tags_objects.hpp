@@ -93,6 +93,9 @@ struct by_cashout; /// all posts regardless of depth
 struct by_author_comment;
 struct by_comment;
 struct by_tag;
+struct by_tag_created;
+struct by_tag_trending;
+struct by_tag_hot;
 
 // clang-format off
 typedef shared_multi_index_container<
@@ -112,7 +115,37 @@ typedef shared_multi_index_container<
                        composite_key<tag_object,
                                      member<tag_object, tag_name_type, &tag_object::tag>,
                                      member<tag_object, comment_id_type, &tag_object::comment>,
-                                     member<tag_object, tag_id_type, &tag_object::id>>>>
+                                     member<tag_object, tag_id_type, &tag_object::id>>>,
+        ordered_unique<tag<by_tag_created>,
+                       composite_key<tag_object,
+                                     member<tag_object, tag_name_type, &tag_object::tag>,
+                                     member<tag_object, time_point_sec, &tag_object::created>,
+                                     member<tag_object, comment_id_type, &tag_object::comment>,
+                                     member<tag_object, tag_id_type, &tag_object::id>>,
+                       composite_key_compare<std::less<tag_name_type>,
+                                             std::greater<time_point_sec>,
+                                             std::greater<comment_id_type>,
+                                             std::less<tag_id_type>>>,
+        ordered_unique<tag<by_tag_trending>,
+                       composite_key<tag_object,
+                                     member<tag_object, tag_name_type, &tag_object::tag>,
+                                     member<tag_object, double, &tag_object::trending>,
+                                     member<tag_object, comment_id_type, &tag_object::comment>,
+                                     member<tag_object, tag_id_type, &tag_object::id>>,
+                       composite_key_compare<std::less<tag_name_type>,
+                                             std::greater<double>,
+                                             std::greater<comment_id_type>,
+                                             std::less<tag_id_type>>>,
+        ordered_unique<tag<by_tag_hot>,
+                       composite_key<tag_object,
+                                     member<tag_object, tag_name_type, &tag_object::tag>,
+                                     member<tag_object, double, &tag_object::hot>,
+                                     member<tag_object, comment_id_type, &tag_object::comment>,
+                                     member<tag_object, tag_id_type, &tag_object::id>>,
+                       composite_key_compare<std::less<tag_name_type>,
+                                             std::greater<double>,
+                                             std::greater<comment_id_type>,
+                                             std::less<tag_id_type>>>>
     >
     tag_index;
 // clang-format on
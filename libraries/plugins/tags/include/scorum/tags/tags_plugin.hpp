@@ -9,6 +9,8 @@ namespace detail {
 class tags_plugin_impl;
 }
 
+class discussions_cache;
+
 using namespace scorum::chain;
 
 /**
@@ -29,6 +31,8 @@ public:
     virtual void plugin_initialize(const boost::program_options::variables_map& options) override;
     virtual void plugin_startup() override;
 
+    discussions_cache& get_discussions_cache();
+
     friend class detail::tags_plugin_impl;
     std::unique_ptr<detail::tags_plugin_impl> my;
 };
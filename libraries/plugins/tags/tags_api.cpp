@@ -1,6 +1,9 @@
 #include <scorum/tags/tags_api.hpp>
 
 #include <scorum/tags/tags_api_impl.hpp>
+#include <scorum/tags/tags_plugin.hpp>
+
+#include <scorum/app/api_thread_pool.hpp>
 
 namespace scorum {
 namespace tags {
@@ -14,9 +17,15 @@ chainbase::database_guard& tags_api::guard() const
     return *_guard;
 }
 
+template <typename Lambda> auto tags_api::with_read_lock(Lambda&& callback) const -> decltype((*(Lambda*)nullptr)())
+{
+    return _app.api_pool().with_read_lock(TAGS_API_NAME, guard(), std::forward<Lambda>(callback));
+}
+
 tags_api::tags_api(const app::api_context& ctx)
     : _impl(new tags_api_impl(*ctx.app.chain_database()))
     , _guard(ctx.app.chain_database())
+    , _app(ctx.app)
 {
 }
 
@@ -32,7 +41,7 @@ std::vector<tag_api_obj> tags_api::get_trending_tags(const std::string& after_ta
 {
     try
     {
-        return guard().with_read_lock([&]() { return _impl->get_trending_tags(after_tag, limit); });
+        return with_read_lock([&]() { return _impl->get_trending_tags(after_tag, limit); });
     }
     FC_CAPTURE_AND_RETHROW((after_tag)(limit))
 }
@@ -41,7 +50,7 @@ std::vector<std::pair<std::string, uint32_t>> tags_api::get_tags_used_by_author(
 {
     try
     {
-        return guard().with_read_lock([&]() { return _impl->get_tags_used_by_author(author); });
+        return with_read_lock([&]() { return _impl->get_tags_used_by_author(author); });
     }
     FC_CAPTURE_AND_RETHROW((author))
 }
@@ -51,7 +60,7 @@ std::vector<std::pair<std::string, uint32_t>> tags_api::get_tags_by_category(con
 {
     try
     {
-        return guard().with_read_lock([&]() { return _impl->get_tags_by_category(domain, category); });
+        return with_read_lock([&]() { return _impl->get_tags_by_category(domain, category); });
     }
     FC_CAPTURE_AND_RETHROW((category))
 }
@@ -60,7 +69,7 @@ std::vector<discussion> tags_api::get_discussions_by_trending(const discussion_q
 {
     try
     {
-        return guard().with_read_lock([&]() { return _impl->get_discussions_by_trending(query); });
+        return get_cached_discussions("trending", query, [&]() { return _impl->get_discussions_by_trending(query); });
     }
     FC_CAPTURE_AND_RETHROW((query))
 }
@@ -69,7 +78,7 @@ std::vector<discussion> tags_api::get_discussions_by_created(const discussion_qu
 {
     try
     {
-        return guard().with_read_lock([&]() { return _impl->get_discussions_by_created(query); });
+        return get_cached_discussions("created", query, [&]() { return _impl->get_discussions_by_created(query); });
     }
     FC_CAPTURE_AND_RETHROW((query))
 }
@@ -78,7 +87,7 @@ std::vector<discussion> tags_api::get_discussions_by_hot(const discussion_query&
 {
     try
     {
-        return guard().with_read_lock([&]() { return _impl->get_discussions_by_hot(query); });
+        return get_cached_discussions("hot", query, [&]() { return _impl->get_discussions_by_hot(query); });
     }
     FC_CAPTURE_AND_RETHROW((query))
 }
@@ -87,7 +96,7 @@ discussion tags_api::get_content(const std::string& author, const std::string& p
 {
     try
     {
-        return guard().with_read_lock([&]() { return _impl->get_content(author, permlink); });
+        return with_read_lock([&]() { return _impl->get_content(author, permlink); });
     }
     FC_CAPTURE_AND_RETHROW((author)(permlink))
 }
@@ -97,7 +106,7 @@ tags_api::get_comments(const std::string& parent_author, const std::string& pare
 {
     try
     {
-        return guard().with_read_lock([&]() { return _impl->get_comments(parent_author, parent_permlink, depth); });
+        return with_read_lock([&]() { return _impl->get_comments(parent_author, parent_permlink, depth); });
     }
     FC_CAPTURE_AND_RETHROW((parent_author)(parent_permlink)(depth))
 }
@@ -106,7 +115,7 @@ std::vector<discussion> tags_api::get_discussions_by_author(const api::discussio
 {
     try
     {
-        return guard().with_read_lock([&]() { return _impl->get_discussions_by_author(query); });
+        return with_read_lock([&]() { return _impl->get_discussions_by_author(query); });
     }
     FC_CAPTURE_AND_RETHROW((query))
 }
@@ -115,10 +124,49 @@ std::vector<discussion> tags_api::get_posts_and_comments(const api::discussion_q
 {
     try
     {
-        return guard().with_read_lock([&]() { return _impl->get_posts_and_comments(query); });
+        return with_read_lock([&]() { return _impl->get_posts_and_comments(query); });
     }
     FC_CAPTURE_AND_RETHROW((query))
 }
 
+discussions_cache_stats tags_api::get_discussions_cache_stats() const
+{
+    try
+    {
+        // plugin is looked up lazily since api could be created before plugin is enabled
+        auto plugin = std::dynamic_pointer_cast<tags_plugin>(_app.get_plugin(TAGS_PLUGIN_NAME));
+        FC_ASSERT(plugin, "Tags plugin is not enabled.");
+
+        return plugin->get_discussions_cache().get_stats();
+    }
+    FC_CAPTURE_AND_RETHROW()
+}
+
+std::vector<discussion> tags_api::get_cached_discussions(const std::string& ordering,
+                                                         const discussion_query& query,
+                                                         std::function<std::vector<discussion>()> fetch) const
+{
+    auto plugin = std::dynamic_pointer_cast<tags_plugin>(_app.get_plugin(TAGS_PLUGIN_NAME));
+    if (!plugin || !plugin->get_discussions_cache().enabled())
+        return with_read_lock([&]() { return fetch(); });
+
+    auto& cache = plugin->get_discussions_cache();
+    auto tags = tags_api_impl::normalize_tags(query.tags);
+    auto key = discussions_cache::make_key(ordering, tags, query);
+
+    return with_read_lock([&]() {
+        const uint32_t head_block_num = _app.chain_database()->head_block_num();
+
+        std::vector<discussion> result;
+        if (!cache.find(key, head_block_num, result))
+        {
+            result = fetch();
+            cache.insert(key, head_block_num, tags, result);
+        }
+
+        return result;
+    });
+}
+
 } // namespace tags
 } // namespace scorum
@@ -1,6 +1,7 @@
 #include <scorum/tags/tags_plugin.hpp>
 #include <scorum/tags/tags_api.hpp>
 #include <scorum/tags/tags_objects.hpp>
+#include <scorum/tags/discussions_cache.hpp>
 
 #include <scorum/protocol/config.hpp>
 #include <scorum/common_api/config_api.hpp>
@@ -33,6 +34,25 @@ namespace detail {
 
 using namespace scorum::protocol;
 
+/// Tags and comments changed since the last applied block
+struct touched_discussions
+{
+    std::set<std::string> tags;
+    std::set<comment_id_type> comments;
+
+    void touch(const tag_object& t)
+    {
+        tags.insert(t.tag);
+        comments.insert(t.comment);
+    }
+
+    void clear()
+    {
+        tags.clear();
+        comments.clear();
+    }
+};
+
 class tags_plugin_impl
 {
 public:
@@ -49,8 +69,13 @@ public:
 
     void pre_operation(const operation_notification& note);
     void post_operation(const operation_notification& note);
+    void on_applied_block(const signed_block& block);
 
     tags_plugin& _self;
+
+    discussions_cache _discussions_cache;
+    touched_discussions _touched;
+    uint32_t _last_block_num = 0;
 };
 
 tags_plugin_impl::~tags_plugin_impl()
@@ -193,14 +218,77 @@ struct category_stats_post_operation_visitor
     } /// ignore all other ops
 };
 
+/// Collects comments which discussions could be changed by operation
+struct touched_comments_visitor
+{
+    typedef void result_type;
+
+    database& _db;
+    touched_discussions& _touched;
+
+    touched_comments_visitor(database& db, touched_discussions& touched)
+        : _db(db)
+        , _touched(touched)
+    {
+    }
+
+    void touch(const account_name_type& author, const std::string& permlink) const
+    {
+        const comment_object* c
+            = _db.obtain_service<dbs_comment>().find_by<by_permlink>(std::make_tuple(author, permlink));
+
+        if (c != nullptr)
+        {
+            _touched.comments.insert(c->id);
+            _touched.comments.insert(c->root_comment);
+        }
+    }
+
+    void operator()(const comment_operation& op) const
+    {
+        touch(op.author, op.permlink);
+    }
+
+    void operator()(const comment_options_operation& op) const
+    {
+        touch(op.author, op.permlink);
+    }
+
+    void operator()(const delete_comment_operation& op) const
+    {
+        touch(op.author, op.permlink);
+    }
+
+    void operator()(const vote_operation& op) const
+    {
+        touch(op.author, op.permlink);
+    }
+
+    void operator()(const comment_reward_operation& op) const
+    {
+        touch(op.author, op.permlink);
+    }
+
+    void operator()(const comment_payout_update_operation& op) const
+    {
+        touch(op.author, op.permlink);
+    }
+
+    template <typename Op> void operator()(Op&&) const
+    {
+    } /// ignore all other ops
+};
+
 struct post_operation_visitor
 {
     typedef void result_type;
 
     database& _db;
+    touched_discussions& _touched;
 
-    post_operation_visitor(database& db)
+    post_operation_visitor(database& db, touched_discussions& touched)
         : _db(db)
+        , _touched(touched)
     {
     }
 
@@ -225,6 +313,7 @@ struct post_operation_visitor
     void remove_tag(const tag_object& tag) const
     {
         /// TODO: update tag stats object
+        _touched.touch(tag);
         _db.remove(tag);
 
         const auto& idx = _db.get_index<author_tag_stats_index, by_author_tag_posts>();
@@ -290,6 +379,8 @@ struct post_operation_visitor
         });
 
         add_stats(current, stats);
+
+        _touched.touch(current);
     }
 
     void create_tag(const std::string& tag, const comment_object& comment, double hot, double trending) const
@@ -311,6 +402,8 @@ struct post_operation_visitor
         });
         add_stats(tag_obj, get_stats(tag));
 
+        _touched.touch(tag_obj);
+
         const auto& idx = _db.get_index<author_tag_stats_index, by_author_tag_posts>();
         auto itr = idx.lower_bound(boost::make_tuple(author, tag));
         if (itr != idx.end() && itr->author == author && itr->tag == tag)
@@ -471,6 +564,7 @@ struct post_operation_visitor
                                 if (t.cashout != fc::time_point_sec::maximum())
                                     t.promoted_balance += op.amount.amount;
                             });
+                            _touched.touch(*citr);
                             ++citr;
                         }
 
@@ -554,6 +648,9 @@ void tags_plugin_impl::pre_operation(const operation_notification& note)
     {
         /// plugins shouldn't ever throw
         note.op.visit(category_stats_pre_operation_visitor(database()));
+
+        if (_discussions_cache.enabled())
+            note.op.visit(touched_comments_visitor(database(), _touched));
     }
     catch (const fc::exception& e)
     {
@@ -570,8 +667,34 @@ void tags_plugin_impl::post_operation(const operation_notification& note)
     try
     {
         /// plugins shouldn't ever throw
-        note.op.visit(post_operation_visitor(database()));
+        note.op.visit(post_operation_visitor(database(), _touched));
         note.op.visit(category_stats_post_operation_visitor(database()));
+
+        if (_discussions_cache.enabled())
+            note.op.visit(touched_comments_visitor(database(), _touched));
+    }
+    catch (const fc::exception& e)
+    {
+        edump((e.to_detail_string()));
+    }
+    catch (...)
+    {
+        elog("unhandled exception");
+    }
+}
+
+void tags_plugin_impl::on_applied_block(const signed_block& block)
+{
+    try
+    {
+        // changes undone by popped blocks are not tracked so cache is dropped on fork switch
+        if (block.block_num() <= _last_block_num)
+            _discussions_cache.clear();
+        else
+            _discussions_cache.invalidate(_touched.tags, _touched.comments);
+
+        _touched.clear();
+        _last_block_num = block.block_num();
     }
     catch (const fc::exception& e)
     {
@@ -604,6 +727,13 @@ void tags_plugin::plugin_set_program_options(boost::program_options::options_des
                                              boost::program_options::options_description& cfg)
 {
     cli.add(get_api_config(TAGS_API_NAME).get_options_descriptions());
+    cli.add_options()(
+        "tags-discussions-cache-size",
+        boost::program_options::value<uint32_t>()->default_value(discussions_cache::default_capacity),
+        "Number of get_discussions_by_trending/hot/created results to cache. 0 disables the cache.")(
+        "tags-discussions-cache-max-age",
+        boost::program_options::value<uint32_t>()->default_value(discussions_cache::default_max_age),
+        "Number of blocks a cached discussions result is valid for.");
     cfg.add(cli);
 }
 
@@ -615,6 +745,7 @@ void tags_plugin::plugin_initialize(const boost::program_options::variables_map&
 
         db.pre_apply_operation.connect([&](const operation_notification& note) { my->pre_operation(note); });
         db.post_apply_operation.connect([&](const operation_notification& note) { my->post_operation(note); });
+        db.applied_block.connect([&](const signed_block& block) { my->on_applied_block(block); });
 
         db.add_plugin_index<tags::tag_index>();
         db.add_plugin_index<tag_stats_index>();
@@ -623,12 +754,22 @@ void tags_plugin::plugin_initialize(const boost::program_options::variables_map&
         db.add_plugin_index<category_stats_index>();
 
         get_api_config(TAGS_API_NAME).set_options(options);
+
+        if (options.count("tags-discussions-cache-size"))
+            my->_discussions_cache.set_capacity(options.at("tags-discussions-cache-size").as<uint32_t>());
+        if (options.count("tags-discussions-cache-max-age"))
+            my->_discussions_cache.set_max_age(options.at("tags-discussions-cache-max-age").as<uint32_t>());
     }
     FC_LOG_AND_RETHROW()
 
     print_greeting();
 }
 
+discussions_cache& tags_plugin::get_discussions_cache()
+{
+    return my->_discussions_cache;
+}
+
 void tags_plugin::plugin_startup()
 {
     app().register_api_factory<tags_api>("tags_api");
@@ -541,7 +541,7 @@ void witness_plugin::block_production_loop()
     switch (result)
     {
     case block_production_condition::produced:
-        ilog("Generated block #${n} with timestamp ${t} at time ${c} by ${w}", (capture));
+        ilog("Generated block #${n} with timestamp ${t} at time ${c} by ${w} in ${l} ms", (capture));
         break;
     case block_production_condition::not_synced:
         // ilog("Not producing block because production is disabled until we receive a recent block (see:
@@ -665,7 +665,8 @@ witness_plugin::maybe_produce_block(fc::mutable_variant_object& capture)
         {
             auto block
                 = db.generate_block(scheduled_time, scheduled_witness, private_key_itr->second, _production_skip_flags);
-            capture("n", block.block_num())("t", block.timestamp)("c", now)("w", scheduled_witness);
+            capture("n", block.block_num())("t", block.timestamp)("c", now)("w", scheduled_witness)(
+                "l", db.get_block_production_stats().production.last / 1000);
             fc::async([this, block]() { p2p_node().broadcast(graphene::net::block_message(block)); });
 
             return block_production_condition::produced;
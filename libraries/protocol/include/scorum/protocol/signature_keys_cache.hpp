@@ -0,0 +1,72 @@
+#pragma once
+
+#include <scorum/protocol/types.hpp>
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace scorum {
+namespace protocol {
+
+struct signature_keys_cache_stats
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint32_t size = 0;
+    uint32_t capacity = 0;
+};
+
+/**
+ * @brief Bounded LRU cache of public keys recovered from signatures.
+ *
+ * The same transaction is verified when it is pushed, when pending transactions are reapplied
+ * for block generation or after pop_block and when the block containing it arrives. The cache
+ * lets all these paths share the result of ECDSA public key recovery which is keyed by
+ * signature digest and signature. It is thread safe. Zero capacity disables the cache.
+ */
+class signature_keys_cache
+{
+public:
+    static const uint32_t default_capacity = 50000;
+
+    static signature_keys_cache& instance();
+
+    explicit signature_keys_cache(uint32_t capacity = default_capacity);
+
+    void set_capacity(uint32_t capacity);
+
+    /**
+     * Return key from the cache or recover it from signature.
+     */
+    public_key_type get_public_key(const signature_type& signature, const digest_type& digest);
+
+    signature_keys_cache_stats get_stats() const;
+
+    void clear();
+
+private:
+    using key_type = std::pair<digest_type, signature_type>;
+
+    struct key_hash
+    {
+        size_t operator()(const key_type& key) const;
+    };
+
+    using lru_list_type = std::list<std::pair<key_type, public_key_type>>;
+
+    void shrink(uint32_t capacity);
+
+    mutable std::mutex _mutex;
+    uint32_t _capacity;
+    lru_list_type _lru;
+    std::unordered_map<key_type, lru_list_type::iterator, key_hash> _index;
+
+    std::atomic<uint64_t> _hits{ 0 };
+    std::atomic<uint64_t> _misses{ 0 };
+};
+}
+}
+
+FC_REFLECT(scorum::protocol::signature_keys_cache_stats, (hits)(misses)(size)(capacity))
@@ -71,6 +71,16 @@ struct signed_transaction : public transaction
                           const authority_getter& get_posting,
                           uint32_t max_recursion = SCORUM_MAX_SIG_CHECK_DEPTH) const;
 
+    /**
+     * Same as above but uses keys that were already recovered from signatures
+     * (see get_signature_keys) instead of recovering them again.
+     */
+    void verify_authority(const flat_set<public_key_type>& signature_keys,
+                          const authority_getter& get_active,
+                          const authority_getter& get_owner,
+                          const authority_getter& get_posting,
+                          uint32_t max_recursion = SCORUM_MAX_SIG_CHECK_DEPTH) const;
+
     std::set<public_key_type> minimize_required_signatures(const chain_id_type& chain_id,
                                                            const flat_set<public_key_type>& available_keys,
                                                            const authority_getter& get_active,
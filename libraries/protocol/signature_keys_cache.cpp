@@ -0,0 +1,104 @@
+#include <scorum/protocol/signature_keys_cache.hpp>
+
+#include <cstring>
+
+namespace scorum {
+namespace protocol {
+
+signature_keys_cache& signature_keys_cache::instance()
+{
+    static signature_keys_cache cache;
+    return cache;
+}
+
+signature_keys_cache::signature_keys_cache(uint32_t capacity)
+    : _capacity(capacity)
+{
+}
+
+void signature_keys_cache::set_capacity(uint32_t capacity)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _capacity = capacity;
+    shrink(capacity);
+}
+
+public_key_type signature_keys_cache::get_public_key(const signature_type& signature, const digest_type& digest)
+{
+    key_type key(digest, signature);
+    bool enabled = false;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        enabled = _capacity > 0;
+
+        auto itr = _index.find(key);
+        if (itr != _index.end())
+        {
+            ++_hits;
+            _lru.splice(_lru.begin(), _lru, itr->second);
+            return itr->second->second;
+        }
+    }
+
+    if (!enabled)
+        return fc::ecc::public_key(signature, digest);
+
+    ++_misses;
+
+    // recovery is the expensive part so it is done without lock
+    public_key_type result = fc::ecc::public_key(signature, digest);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_capacity && !_index.count(key))
+    {
+        _lru.emplace_front(key, result);
+        _index.emplace(key, _lru.begin());
+        shrink(_capacity);
+    }
+
+    return result;
+}
+
+signature_keys_cache_stats signature_keys_cache::get_stats() const
+{
+    signature_keys_cache_stats stats;
+    stats.hits = _hits;
+    stats.misses = _misses;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    stats.size = _index.size();
+    stats.capacity = _capacity;
+
+    return stats;
+}
+
+void signature_keys_cache::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _index.clear();
+    _lru.clear();
+    _hits = 0;
+    _misses = 0;
+}
+
+size_t signature_keys_cache::key_hash::operator()(const key_type& key) const
+{
+    // both digest and signature are random enough already
+    size_t digest_part = 0;
+    size_t signature_part = 0;
+    memcpy(&digest_part, key.first.data(), sizeof(digest_part));
+    memcpy(&signature_part, key.second.begin() + 1, sizeof(signature_part));
+    return digest_part ^ signature_part;
+}
+
+// _mutex must be locked
+void signature_keys_cache::shrink(uint32_t capacity)
+{
+    while (_index.size() > capacity)
+    {
+        _index.erase(_lru.back().first);
+        _lru.pop_back();
+    }
+}
+}
+}
@@ -1,6 +1,7 @@
 
 #include <scorum/protocol/transaction.hpp>
 #include <scorum/protocol/exceptions.hpp>
+#include <scorum/protocol/signature_keys_cache.hpp>
 
 #include <fc/io/raw.hpp>
 #include <fc/bitutil.hpp>
@@ -174,8 +175,8 @@ flat_set<public_key_type> signed_transaction::get_signature_keys(const chain_id_
         flat_set<public_key_type> result;
         for (const auto& sig : signatures)
         {
-            SCORUM_ASSERT(result.insert(fc::ecc::public_key(sig, d)).second, tx_duplicate_sig,
-                          "Duplicate Signature detected");
+            auto key = signature_keys_cache::instance().get_public_key(sig, d);
+            SCORUM_ASSERT(result.insert(key).second, tx_duplicate_sig, "Duplicate Signature detected");
         }
         return result;
     }
@@ -288,5 +289,19 @@ void signed_transaction::verify_authority(const chain_id_type& chain_id,
     }
     FC_CAPTURE_AND_RETHROW((*this))
 }
+
+void signed_transaction::verify_authority(const flat_set<public_key_type>& signature_keys,
+                                          const authority_getter& get_active,
+                                          const authority_getter& get_owner,
+                                          const authority_getter& get_posting,
+                                          uint32_t max_recursion) const
+{
+    try
+    {
+        scorum::protocol::verify_authority(operations, signature_keys, get_active, get_owner, get_posting,
+                                           max_recursion);
+    }
+    FC_CAPTURE_AND_RETHROW((*this))
+}
 }
 } // scorum::protocol
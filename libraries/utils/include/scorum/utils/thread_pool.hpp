@@ -0,0 +1,63 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace scorum {
+namespace utils {
+
+/**
+ * Fixed size pool of OS threads executing tasks in FIFO order.
+ *
+ * The pool is not bound to fc::thread so tasks must not yield to fc scheduler
+ * and must not touch chainbase without holding appropriate lock.
+ */
+class thread_pool
+{
+public:
+    using task_type = std::function<void()>;
+
+    explicit thread_pool(size_t threads_count);
+    ~thread_pool();
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    void post(task_type task);
+
+    template <typename Callable> auto async(Callable&& callable) -> std::future<decltype(callable())>
+    {
+        using result_type = decltype(callable());
+
+        auto task = std::make_shared<std::packaged_task<result_type()>>(std::forward<Callable>(callable));
+        auto result = task->get_future();
+
+        post([task]() { (*task)(); });
+
+        return result;
+    }
+
+    /**
+     * Stops accepting new tasks, finishes already queued ones and joins all threads.
+     */
+    void stop();
+
+    size_t size() const;
+    size_t queue_size() const;
+
+private:
+    void run();
+
+    mutable std::mutex _mutex;
+    std::condition_variable _cv;
+    std::deque<task_type> _tasks;
+    std::vector<std::thread> _threads;
+    bool _stopped = false;
+};
+}
+}
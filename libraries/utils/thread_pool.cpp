@@ -0,0 +1,84 @@
+#include <scorum/utils/thread_pool.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace scorum {
+namespace utils {
+
+thread_pool::thread_pool(size_t threads_count)
+{
+    threads_count = std::max<size_t>(threads_count, 1u);
+
+    _threads.reserve(threads_count);
+    for (size_t ci = 0; ci < threads_count; ++ci)
+    {
+        _threads.emplace_back([this]() { run(); });
+    }
+}
+
+thread_pool::~thread_pool()
+{
+    stop();
+}
+
+void thread_pool::post(task_type task)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_stopped)
+            throw std::logic_error("thread_pool is stopped");
+        _tasks.emplace_back(std::move(task));
+    }
+    _cv.notify_one();
+}
+
+void thread_pool::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_stopped)
+            return;
+        _stopped = true;
+    }
+    _cv.notify_all();
+
+    for (auto& t : _threads)
+    {
+        if (t.joinable())
+            t.join();
+    }
+}
+
+size_t thread_pool::size() const
+{
+    return _threads.size();
+}
+
+size_t thread_pool::queue_size() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _tasks.size();
+}
+
+void thread_pool::run()
+{
+    for (;;)
+    {
+        task_type task;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cv.wait(lock, [this]() { return _stopped || !_tasks.empty(); });
+
+            if (_tasks.empty())
+                return; // stopped and drained
+
+            task = std::move(_tasks.front());
+            _tasks.pop_front();
+        }
+
+        task();
+    }
+}
+}
+}
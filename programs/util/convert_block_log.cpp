@@ -0,0 +1,134 @@
+#include <scorum/chain/block_log.hpp>
+#include <scorum/chain/compressed_block_log.hpp>
+
+#include <fc/io/raw.hpp>
+#include <fc/log/logger.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <iostream>
+
+namespace bpo = boost::program_options;
+
+using scorum::chain::block_log;
+using scorum::chain::compressed_block_log;
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        bpo::options_description opts("Convert legacy block_log into compressed chunked block log");
+        // clang-format off
+        opts.add_options()
+            ("help,h", "Print this help message and exit.")
+            ("input,i", bpo::value<std::string>()->required(), "Path to legacy block_log file.")
+            ("output-dir,o", bpo::value<std::string>()->required(), "Directory to write converted block log to.")
+            ("blocks-per-chunk", bpo::value<uint32_t>()->default_value(compressed_block_log::default_blocks_per_chunk), "Number of blocks compressed together.")
+            ("level", bpo::value<int>()->default_value(9), "zlib compression level (1-9).")
+            ("dictionary-samples", bpo::value<uint32_t>()->default_value(256), "Number of blocks sampled to build preset dictionary. 0 disables dictionary.")
+            ("keep-tail", bpo::value<uint32_t>()->default_value(0), "Number of last blocks kept in legacy format to continue appending to.")
+            ("verify", bpo::bool_switch()->default_value(false), "Compare every converted block with the original one.");
+        // clang-format on
+
+        bpo::variables_map options;
+        bpo::store(bpo::parse_command_line(argc, argv, opts), options);
+
+        if (options.count("help"))
+        {
+            std::cout << opts << std::endl;
+            return 0;
+        }
+        bpo::notify(options);
+
+        const fc::path input = options["input"].as<std::string>();
+        const fc::path output_dir = options["output-dir"].as<std::string>();
+        const fc::path output = output_dir / "block_log";
+        const uint32_t blocks_per_chunk = options["blocks-per-chunk"].as<uint32_t>();
+        const uint32_t dictionary_samples = options["dictionary-samples"].as<uint32_t>();
+        const uint32_t keep_tail = options["keep-tail"].as<uint32_t>();
+
+        FC_ASSERT(fc::exists(input), "Block log ${f} does not exist.", ("f", input.generic_string()));
+        FC_ASSERT(!fc::exists(output), "Block log ${f} already exists.", ("f", output.generic_string()));
+        fc::create_directories(output_dir);
+
+        block_log source;
+        source.open(input);
+        FC_ASSERT(source.head().valid(), "Block log is empty.");
+
+        const uint32_t head_num = source.head()->block_num();
+        const uint32_t archive_head_num = head_num > keep_tail ? head_num - keep_tail : 0;
+
+        std::vector<char> dictionary;
+        if (dictionary_samples && archive_head_num)
+        {
+            std::vector<std::vector<char>> samples;
+            const uint32_t step = std::max(archive_head_num / dictionary_samples, 1u);
+            for (uint32_t num = 1; num <= archive_head_num && samples.size() < dictionary_samples; num += step)
+                samples.push_back(*source.read_packed_block_by_num(num));
+
+            dictionary = compressed_block_log::build_dictionary(samples);
+            ilog("Built ${s} bytes dictionary from ${n} blocks", ("s", dictionary.size())("n", samples.size()));
+        }
+
+        ilog("Compressing ${n} blocks", ("n", archive_head_num));
+        {
+            compressed_block_log archive;
+            archive.create(compressed_block_log::compressed_block_log_path(output), blocks_per_chunk,
+                           options["level"].as<int>(), dictionary);
+
+            for (uint32_t num = 1; num <= archive_head_num; ++num)
+            {
+                archive.append(*source.read_block_by_num(num));
+
+                if (num % 100000 == 0)
+                    ilog("${n} blocks compressed", ("n", num));
+            }
+            archive.close();
+        }
+
+        if (archive_head_num < head_num)
+        {
+            ilog("Writing ${n} blocks to legacy block log", ("n", head_num - archive_head_num));
+
+            block_log tail;
+            tail.open(output);
+            for (uint32_t num = archive_head_num + 1; num <= head_num; ++num)
+                tail.append(*source.read_block_by_num(num));
+            tail.flush();
+        }
+
+        if (options["verify"].as<bool>())
+        {
+            ilog("Verifying converted block log");
+
+            block_log converted;
+            converted.open(output);
+            FC_ASSERT(converted.head().valid() && converted.head()->id() == source.head()->id(),
+                      "Converted block log head mismatch.");
+
+            for (uint32_t num = 1; num <= head_num; ++num)
+            {
+                FC_ASSERT(*converted.read_packed_block_by_num(num) == *source.read_packed_block_by_num(num),
+                          "Converted block ${n} mismatch.", ("n", num));
+            }
+        }
+
+        auto archive_file = compressed_block_log::compressed_block_log_path(output);
+        auto archive_size = fc::file_size(archive_file)
+            + fc::file_size(compressed_block_log::compressed_block_log_index_path(archive_file));
+
+        ilog("Done. ${src} bytes compressed to ${dst} bytes", ("src", fc::file_size(input))("dst", archive_size));
+    }
+    catch (const fc::exception& e)
+    {
+        edump((e.to_detail_string()));
+        return 1;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -2,10 +2,80 @@
 #include <scorum/protocol/block.hpp>
 #include <fc/io/raw.hpp>
 
+#include <fstream>
+
+namespace {
+
+std::vector<char> read_file(const fc::path& file)
+{
+    std::ifstream stream(file.generic_string().c_str(), std::ios::in | std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+
+void benchmark_index_rebuild(const fc::path& block_log_file, uint32_t threads_count)
+{
+    using scorum::chain::block_log;
+    using scorum::chain::index_rebuild_mode;
+
+    const auto index_file = block_log::block_log_index_path(block_log_file);
+
+    const std::vector<std::pair<index_rebuild_mode, std::string>> modes
+        = { { index_rebuild_mode::unpack, "unpack" },
+            { index_rebuild_mode::backward, "backward" },
+            { index_rebuild_mode::parallel, "parallel" } };
+
+    std::vector<char> expected_index;
+    for (const auto& mode_name : modes)
+    {
+        auto mode = mode_name.first;
+
+        auto start = fc::time_point::now();
+        auto blocks_count = block_log::rebuild_index(block_log_file, mode, threads_count);
+        auto elapsed_ms = (fc::time_point::now() - start).count() / 1000;
+
+        auto index = read_file(index_file);
+        if (expected_index.empty())
+            expected_index = index;
+
+        ilog("Index rebuild mode ${m}: ${n} blocks in ${t} ms, index ${r}",
+             ("m", mode_name.second)("n", blocks_count)("t", elapsed_ms)(
+                 "r", index == expected_index ? "matches" : "DIFFERS"));
+    }
+}
+
+void generate_block_log(const fc::path& block_log_file, uint32_t blocks_count)
+{
+    scorum::chain::block_log log;
+    log.open(block_log_file);
+
+    scorum::protocol::signed_block b;
+    b.witness = "alice";
+    for (uint32_t ci = 0; ci < blocks_count; ++ci)
+    {
+        log.append(b);
+        b.previous = b.id();
+        b.timestamp += 3;
+    }
+    log.flush();
+}
+}
+
+/**
+ * Usage: test_block_log [block_log_file [threads_count]]
+ *
+ * With block log file given benchmarks index rebuild modes on it (index file is rewritten),
+ * otherwise runs append/read demo and benchmarks index rebuild on generated block log.
+ */
 int main(int argc, char** argv, char** envp)
 {
     try
     {
+        if (argc > 1)
+        {
+            benchmark_index_rebuild(fc::path(argv[1]), argc > 2 ? std::stoul(argv[2]) : 0);
+            return 0;
+        }
+
         // scorum::chain::database db;
         scorum::chain::block_log log;
 
@@ -49,6 +119,9 @@ int main(int argc, char** argv, char** envp)
 
         auto r3 = log.read_block(r2.second);
         idump((r3));
+
+        generate_block_log(temp_dir.path() / "bench_log", 200000);
+        benchmark_index_rebuild(temp_dir.path() / "bench_log", 0);
     }
     catch (const std::exception& e)
     {
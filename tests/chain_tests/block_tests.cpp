@@ -38,6 +38,8 @@
 
 #include <fc/crypto/digest.hpp>
 
+#include <numeric>
+
 #include "database_default_integration.hpp"
 #include "database_integration.hpp"
 
@@ -141,6 +143,46 @@ BOOST_AUTO_TEST_CASE(generate_empty_blocks)
     }
 }
 
+BOOST_AUTO_TEST_CASE(pipelined_reindex)
+{
+    try
+    {
+        fc::temp_directory data_dir(graphene::utilities::temp_directory_path());
+        auto init_account_priv_key = fc::ecc::private_key::regenerate(fc::sha256::hash(std::string(TEST_INIT_KEY)));
+        genesis_state_type genesis = database_integration_fixture::create_default_genesis_state();
+
+        signed_block cutoff_block;
+        {
+            database db(database::opt_default);
+            db_setup_and_open(db, data_dir.path());
+            while (db.obtain_service<dbs_dynamic_global_property>().get().last_irreversible_block_num < 100)
+            {
+                db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key,
+                                  database::skip_nothing);
+            }
+            cutoff_block = *db.fetch_block_by_number(
+                db.obtain_service<dbs_dynamic_global_property>().get().last_irreversible_block_num);
+            db.close();
+        }
+        for (uint32_t replay_threads : { 0u, 1u, 4u })
+        {
+            database db(database::opt_default);
+            db.set_replay_threads(replay_threads);
+            db.reindex(data_dir.path(), data_dir.path(), TEST_SHARED_MEM_SIZE_10MB, db.get_reindex_skip_flags(),
+                       genesis);
+
+            BOOST_CHECK_EQUAL(db.head_block_num(), cutoff_block.block_num());
+            BOOST_CHECK(db.head_block_id() == cutoff_block.id());
+            db.close();
+        }
+    }
+    catch (fc::exception& e)
+    {
+        edump((e.to_detail_string()));
+        throw;
+    }
+}
+
 BOOST_AUTO_TEST_CASE(undo_block)
 {
     try
@@ -394,6 +436,526 @@ BOOST_AUTO_TEST_CASE(duplicate_transactions)
     }
 }
 
+BOOST_AUTO_TEST_CASE(pending_transactions_restored_incrementally)
+{
+    try
+    {
+        fc::temp_directory dir1(graphene::utilities::temp_directory_path());
+        fc::temp_directory dir2(graphene::utilities::temp_directory_path());
+
+        database db1(database::opt_default);
+        db_setup_and_open(db1, dir1.path());
+        database db2(database::opt_default);
+        db_setup_and_open(db2, dir2.path());
+
+        auto init_account_priv_key = fc::ecc::private_key::regenerate(fc::sha256::hash(std::string(TEST_INIT_KEY)));
+        public_key_type init_account_pub_key = init_account_priv_key.get_public_key();
+
+        signed_transaction trx;
+        account_create_operation cop;
+        cop.new_account_name = "alice";
+        cop.creator = TEST_INIT_DELEGATE_NAME;
+        cop.owner = authority(1, init_account_pub_key, 1);
+        cop.fee = SUFFICIENT_FEE;
+        cop.active = cop.owner;
+        trx.operations.push_back(cop);
+        trx.set_expiration(db1.head_block_time() + SCORUM_MAX_TIME_UNTIL_EXPIRATION);
+        trx.sign(init_account_priv_key, db1.get_chain_id());
+        PUSH_TX(db1, trx, database::skip_nothing);
+
+        BOOST_CHECK_EQUAL(db1.get_pending_transaction_stats().full_verifications, 1u);
+
+        // block without the transaction keeps it pending without verifying it again
+        auto b = db2.generate_block(db2.get_slot_time(1), db2.get_scheduled_witness(1), init_account_priv_key,
+                                    database::skip_nothing);
+        PUSH_BLOCK(db1, b, database::skip_nothing);
+
+        auto stats = db1.get_pending_transaction_stats();
+        BOOST_CHECK_EQUAL(stats.pending, 1u);
+        BOOST_CHECK_EQUAL(stats.restores, 1u);
+        BOOST_CHECK_EQUAL(stats.full_verifications, 1u);
+        BOOST_CHECK_EQUAL(stats.reused_verifications, 1u);
+
+        // included transaction is dropped without applying it
+        b = db1.generate_block(db1.get_slot_time(1), db1.get_scheduled_witness(1), init_account_priv_key,
+                               database::skip_nothing);
+        PUSH_BLOCK(db2, b, database::skip_nothing);
+        BOOST_REQUIRE_EQUAL(b.transactions.size(), 1u);
+
+        stats = db1.get_pending_transaction_stats();
+        BOOST_CHECK_EQUAL(stats.pending, 0u);
+        BOOST_CHECK_EQUAL(stats.dropped_included, 1u);
+        BOOST_CHECK_EQUAL(stats.full_verifications, 1u);
+
+        // expired transaction is dropped without applying it
+        trx = decltype(trx)();
+        transfer_operation t;
+        t.from = TEST_INIT_DELEGATE_NAME;
+        t.to = "alice";
+        t.amount = asset(500, SCORUM_SYMBOL);
+        trx.operations.push_back(t);
+        trx.set_expiration(db1.head_block_time() + SCORUM_BLOCK_INTERVAL);
+        trx.sign(init_account_priv_key, db1.get_chain_id());
+        PUSH_TX(db1, trx, database::skip_nothing);
+
+        b = db2.generate_block(db2.get_slot_time(1), db2.get_scheduled_witness(1), init_account_priv_key,
+                               database::skip_nothing);
+        PUSH_BLOCK(db1, b, database::skip_nothing);
+
+        stats = db1.get_pending_transaction_stats();
+        BOOST_CHECK_EQUAL(stats.pending, 0u);
+        BOOST_CHECK_EQUAL(stats.dropped_expired, 1u);
+        BOOST_CHECK_EQUAL(stats.dropped_invalid, 0u);
+    }
+    catch (fc::exception& e)
+    {
+        edump((e.to_detail_string()));
+        throw;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(block_generated_from_pending_candidate)
+{
+    try
+    {
+        fc::temp_directory data_dir(graphene::utilities::temp_directory_path());
+
+        database db(database::opt_default);
+        db_setup_and_open(db, data_dir.path());
+
+        auto init_account_priv_key = fc::ecc::private_key::regenerate(fc::sha256::hash(std::string(TEST_INIT_KEY)));
+        public_key_type init_account_pub_key = init_account_priv_key.get_public_key();
+
+        signed_transaction trx;
+        account_create_operation cop;
+        cop.new_account_name = "alice";
+        cop.creator = TEST_INIT_DELEGATE_NAME;
+        cop.owner = authority(1, init_account_pub_key, 1);
+        cop.fee = SUFFICIENT_FEE;
+        cop.active = cop.owner;
+        trx.operations.push_back(cop);
+        trx.set_expiration(db.head_block_time() + SCORUM_MAX_TIME_UNTIL_EXPIRATION);
+        trx.sign(init_account_priv_key, db.get_chain_id());
+        PUSH_TX(db, trx, database::skip_nothing);
+
+        // transactions already applied to pending state make the block
+        auto b = db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key,
+                                   database::skip_nothing);
+        BOOST_REQUIRE_EQUAL(b.transactions.size(), 1u);
+
+        auto stats = db.get_block_production_stats();
+        BOOST_CHECK_EQUAL(stats.speculative_blocks, 1u);
+        BOOST_CHECK_EQUAL(stats.rebuilt_blocks, 0u);
+        BOOST_CHECK_EQUAL(stats.production.counts.size(), stats.production.bounds.size() + 1);
+        BOOST_CHECK_EQUAL(std::accumulate(stats.production.counts.begin(), stats.production.counts.end(), 0u), 1u);
+
+        // transaction expiring before the slot makes pending transactions applied again without it
+        trx = decltype(trx)();
+        transfer_operation t;
+        t.from = TEST_INIT_DELEGATE_NAME;
+        t.to = "alice";
+        t.amount = asset(500, SCORUM_SYMBOL);
+        trx.operations.push_back(t);
+        trx.set_expiration(db.head_block_time() + 1);
+        trx.sign(init_account_priv_key, db.get_chain_id());
+        PUSH_TX(db, trx, database::skip_nothing);
+
+        b = db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key,
+                              database::skip_nothing);
+        BOOST_CHECK_EQUAL(b.transactions.size(), 0u);
+
+        stats = db.get_block_production_stats();
+        BOOST_CHECK_EQUAL(stats.speculative_blocks, 1u);
+        BOOST_CHECK_EQUAL(stats.rebuilt_blocks, 1u);
+        BOOST_CHECK_EQUAL(std::accumulate(stats.assembly.counts.begin(), stats.assembly.counts.end(), 0u), 2u);
+    }
+    catch (fc::exception& e)
+    {
+        edump((e.to_detail_string()));
+        throw;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(parallel_signature_recovery)
+{
+    try
+    {
+        fc::temp_directory dir1(graphene::utilities::temp_directory_path());
+        fc::temp_directory dir2(graphene::utilities::temp_directory_path());
+
+        database db1(database::opt_default);
+        db_setup_and_open(db1, dir1.path());
+        database db2(database::opt_default);
+        db_setup_and_open(db2, dir2.path());
+        db2.set_signature_threads(2);
+
+        auto skip_sigs = database::skip_transaction_signatures | database::skip_authority_check;
+
+        auto init_account_priv_key = fc::ecc::private_key::regenerate(fc::sha256::hash(std::string(TEST_INIT_KEY)));
+        auto wrong_priv_key = fc::ecc::private_key::regenerate(fc::sha256::hash(std::string("wrong")));
+
+        public_key_type init_account_pub_key = init_account_priv_key.get_public_key();
+
+        auto make_account_create = [&](const std::string& name, const fc::ecc::private_key& key) {
+            signed_transaction trx;
+            account_create_operation cop;
+            cop.new_account_name = name;
+            cop.creator = TEST_INIT_DELEGATE_NAME;
+            cop.owner = authority(1, init_account_pub_key, 1);
+            cop.fee = SUFFICIENT_FEE;
+            cop.active = cop.owner;
+            trx.operations.push_back(cop);
+            trx.set_expiration(db1.head_block_time() + SCORUM_MAX_TIME_UNTIL_EXPIRATION);
+            trx.sign(key, db1.get_chain_id());
+            return trx;
+        };
+
+        for (const std::string name : { "alice", "bob", "sam", "dave", "eve" })
+            PUSH_TX(db1, make_account_create(name, init_account_priv_key), skip_sigs);
+
+        auto b
+            = db1.generate_block(db1.get_slot_time(1), db1.get_scheduled_witness(1), init_account_priv_key, skip_sigs);
+        BOOST_REQUIRE_EQUAL(b.transactions.size(), 5u);
+
+        PUSH_BLOCK(db2, b, database::skip_nothing);
+        BOOST_CHECK(db2.head_block_id() == b.id());
+
+        PUSH_TX(db1, make_account_create("frank", init_account_priv_key), skip_sigs);
+        PUSH_TX(db1, make_account_create("mike", wrong_priv_key), skip_sigs);
+
+        b = db1.generate_block(db1.get_slot_time(1), db1.get_scheduled_witness(1), init_account_priv_key, skip_sigs);
+
+        SCORUM_CHECK_THROW(PUSH_BLOCK(db2, b, database::skip_nothing), fc::exception);
+        BOOST_CHECK(db2.head_block_id() != b.id());
+    }
+    catch (fc::exception& e)
+    {
+        edump((e.to_detail_string()));
+        throw;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(parallel_transaction_validation)
+{
+    try
+    {
+        fc::temp_directory dir1(graphene::utilities::temp_directory_path());
+        fc::temp_directory dir2(graphene::utilities::temp_directory_path());
+
+        database db1(database::opt_default);
+        db_setup_and_open(db1, dir1.path());
+        database db2(database::opt_default);
+        db_setup_and_open(db2, dir2.path());
+        db2.set_signature_threads(2);
+
+        auto init_account_priv_key = fc::ecc::private_key::regenerate(fc::sha256::hash(std::string(TEST_INIT_KEY)));
+        public_key_type init_account_pub_key = init_account_priv_key.get_public_key();
+
+        for (const std::string name : { "alice", "bob", "sam" })
+        {
+            signed_transaction trx;
+            account_create_operation cop;
+            cop.new_account_name = name;
+            cop.creator = TEST_INIT_DELEGATE_NAME;
+            cop.owner = authority(1, init_account_pub_key, 1);
+            cop.fee = SUFFICIENT_FEE;
+            cop.active = cop.owner;
+            trx.operations.push_back(cop);
+            trx.set_expiration(db1.head_block_time() + SCORUM_MAX_TIME_UNTIL_EXPIRATION);
+            trx.sign(init_account_priv_key, db1.get_chain_id());
+            PUSH_TX(db1, trx, database::skip_nothing);
+        }
+
+        auto b = db1.generate_block(db1.get_slot_time(1), db1.get_scheduled_witness(1), init_account_priv_key,
+                                    database::skip_nothing);
+        BOOST_REQUIRE_EQUAL(b.transactions.size(), 3u);
+
+        PUSH_BLOCK(db2, b, database::skip_nothing);
+        BOOST_CHECK(db2.head_block_id() == b.id());
+        BOOST_CHECK(db2.obtain_service<dbs_account>().is_exists("sam"));
+
+        signed_transaction trx;
+        transfer_operation t;
+        t.from = TEST_INIT_DELEGATE_NAME;
+        t.to = "alice";
+        t.amount = asset(500, SCORUM_SYMBOL);
+        trx.operations.push_back(t);
+        trx.set_expiration(db1.head_block_time() + SCORUM_MAX_TIME_UNTIL_EXPIRATION);
+        trx.sign(init_account_priv_key, db1.get_chain_id());
+        PUSH_TX(db1, trx, database::skip_nothing);
+
+        b = db1.generate_block(db1.get_slot_time(1), db1.get_scheduled_witness(1), init_account_priv_key,
+                               database::skip_nothing);
+        BOOST_REQUIRE_EQUAL(b.transactions.size(), 1u);
+
+        // operation failing validation fails the block as it does without validation threads
+        b.transactions[0].operations[0].get<transfer_operation>().amount = asset(-500, SCORUM_SYMBOL);
+
+        auto skip_checks = database::skip_merkle_check | database::skip_witness_signature
+            | database::skip_transaction_signatures | database::skip_authority_check;
+        SCORUM_CHECK_THROW(PUSH_BLOCK(db2, b, skip_checks), fc::exception);
+        BOOST_CHECK(db2.head_block_id() != b.id());
+    }
+    catch (fc::exception& e)
+    {
+        edump((e.to_detail_string()));
+        throw;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(state_digest_matches_between_nodes)
+{
+    try
+    {
+        fc::temp_directory dir1(graphene::utilities::temp_directory_path());
+        fc::temp_directory dir2(graphene::utilities::temp_directory_path());
+
+        database db1(database::opt_default);
+        db1.set_state_digest_interval(1);
+        db_setup_and_open(db1, dir1.path());
+        database db2(database::opt_default);
+        db2.set_state_digest_interval(1);
+        db_setup_and_open(db2, dir2.path());
+
+        BOOST_CHECK(db1.get_state_digest().digest == db2.get_state_digest().digest);
+
+        auto init_account_priv_key = fc::ecc::private_key::regenerate(fc::sha256::hash(std::string(TEST_INIT_KEY)));
+        public_key_type init_account_pub_key = init_account_priv_key.get_public_key();
+
+        signed_transaction trx;
+        account_create_operation cop;
+        cop.new_account_name = "alice";
+        cop.creator = TEST_INIT_DELEGATE_NAME;
+        cop.owner = authority(1, init_account_pub_key, 1);
+        cop.fee = SUFFICIENT_FEE;
+        cop.active = cop.owner;
+        trx.operations.push_back(cop);
+        trx.set_expiration(db1.head_block_time() + SCORUM_MAX_TIME_UNTIL_EXPIRATION);
+        trx.sign(init_account_priv_key, db1.get_chain_id());
+        PUSH_TX(db1, trx, database::skip_nothing);
+
+        // pending transactions are not a part of state at the head block
+        BOOST_CHECK(db1.get_state_digest().digest == db2.get_state_digest().digest);
+
+        for (int ci = 0; ci < 3; ++ci)
+        {
+            auto b = db1.generate_block(db1.get_slot_time(1), db1.get_scheduled_witness(1), init_account_priv_key,
+                                        database::skip_nothing);
+            PUSH_BLOCK(db2, b, database::skip_nothing);
+
+            auto digest1 = db1.get_state_digest();
+            auto digest2 = db2.get_state_digest();
+            BOOST_CHECK_EQUAL(digest1.block_num, b.block_num());
+            BOOST_CHECK(digest1.digest == digest2.digest);
+            BOOST_REQUIRE_EQUAL(digest1.indexes.size(), digest2.indexes.size());
+        }
+
+        // digest survives popping blocks as undo restores it
+        auto digest = db2.get_state_digest();
+        db2.generate_block(db2.get_slot_time(1), db2.get_scheduled_witness(1), init_account_priv_key,
+                           database::skip_nothing);
+        BOOST_CHECK(db2.get_state_digest().digest != digest.digest);
+        db2.pop_block();
+        BOOST_CHECK_EQUAL(db2.get_state_digest().block_num, digest.block_num);
+        BOOST_CHECK(db2.get_state_digest().digest == digest.digest);
+    }
+    catch (fc::exception& e)
+    {
+        edump((e.to_detail_string()));
+        throw;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(state_snapshot_restores_every_index)
+{
+    try
+    {
+        fc::temp_directory data_dir(graphene::utilities::temp_directory_path());
+        const fc::path snapshot_file = data_dir.path() / "state.snapshot";
+
+        auto init_account_priv_key = fc::ecc::private_key::regenerate(fc::sha256::hash(std::string(TEST_INIT_KEY)));
+        public_key_type init_account_pub_key = init_account_priv_key.get_public_key();
+
+        {
+            database db(database::opt_default);
+            db_setup_and_open(db, data_dir.path());
+
+            signed_transaction trx;
+            account_create_operation cop;
+            cop.new_account_name = "alice";
+            cop.creator = TEST_INIT_DELEGATE_NAME;
+            cop.owner = authority(1, init_account_pub_key, 1);
+            cop.fee = SUFFICIENT_FEE;
+            cop.active = cop.owner;
+            trx.operations.push_back(cop);
+            trx.set_expiration(db.head_block_time() + SCORUM_MAX_TIME_UNTIL_EXPIRATION);
+            trx.sign(init_account_priv_key, db.get_chain_id());
+            PUSH_TX(db, trx, database::skip_nothing);
+
+            trx.clear();
+            transfer_operation t;
+            t.from = TEST_INIT_DELEGATE_NAME;
+            t.to = "alice";
+            t.amount = asset(500, SCORUM_SYMBOL);
+            trx.operations.push_back(t);
+            trx.set_expiration(db.head_block_time() + SCORUM_MAX_TIME_UNTIL_EXPIRATION);
+            trx.sign(init_account_priv_key, db.get_chain_id());
+            PUSH_TX(db, trx, database::skip_nothing);
+
+            // blocks are written to block log once they become irreversible
+            for (uint32_t ci = 0; ci < SCORUM_MAX_WITNESSES + 5; ++ci)
+            {
+                db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key,
+                                  database::skip_nothing);
+            }
+            db.close();
+        }
+
+        state_digest exported;
+        {
+            // reopening rewinds state to the head of block log
+            database db(database::opt_default);
+            db.set_state_digest_interval(1);
+            db_setup_and_open(db, data_dir.path());
+            BOOST_REQUIRE_GT(db.head_block_num(), 0u);
+
+            exported = db.get_state_digest();
+            db.export_state_snapshot(snapshot_file);
+            db.close();
+        }
+
+        database db(database::opt_default);
+        db.set_state_digest_interval(1);
+        db.wipe(data_dir.path(), data_dir.path(), false);
+        db_setup_and_open(db, data_dir.path());
+        BOOST_REQUIRE_EQUAL(db.head_block_num(), 0u);
+
+        db.import_state_snapshot(snapshot_file, 2, db.get_reindex_skip_flags());
+
+        auto imported = db.get_state_digest();
+        BOOST_CHECK_EQUAL(imported.block_num, exported.block_num);
+        BOOST_CHECK(imported.block_id == exported.block_id);
+        BOOST_REQUIRE_EQUAL(imported.indexes.size(), exported.indexes.size());
+        for (size_t ci = 0; ci < imported.indexes.size(); ++ci)
+        {
+            const auto& name = exported.indexes[ci].name;
+            BOOST_CHECK_EQUAL(imported.indexes[ci].name, name);
+            BOOST_CHECK_MESSAGE(imported.indexes[ci].objects == exported.indexes[ci].objects, name);
+            BOOST_CHECK_MESSAGE(imported.indexes[ci].digest == exported.indexes[ci].digest, name);
+        }
+        BOOST_CHECK(imported.digest == exported.digest);
+
+        BOOST_CHECK_EQUAL(db.obtain_service<dbs_account>().get_account("alice").balance.amount, 500);
+
+        // imported state is able to apply following blocks
+        db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key,
+                          database::skip_nothing);
+        BOOST_CHECK_EQUAL(db.head_block_num(), exported.block_num + 1);
+    }
+    catch (fc::exception& e)
+    {
+        edump((e.to_detail_string()));
+        throw;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(irreversible_blocks_skip_undo)
+{
+    try
+    {
+        fc::temp_directory dir1(graphene::utilities::temp_directory_path());
+        fc::temp_directory dir2(graphene::utilities::temp_directory_path());
+
+        database db1(database::opt_default);
+        db_setup_and_open(db1, dir1.path());
+        database db2(database::opt_default);
+        db_setup_and_open(db2, dir2.path());
+
+        auto init_account_priv_key = fc::ecc::private_key::regenerate(fc::sha256::hash(std::string(TEST_INIT_KEY)));
+
+        std::vector<signed_block> blocks;
+        for (uint32_t i = 0; i < 5; ++i)
+        {
+            blocks.push_back(db1.generate_block(db1.get_slot_time(1), db1.get_scheduled_witness(1),
+                                                init_account_priv_key, database::skip_nothing));
+        }
+
+        for (uint32_t i = 0; i < 3; ++i)
+            PUSH_BLOCK(db2, blocks[i], database::skip_undo_block);
+
+        BOOST_CHECK_EQUAL(db2.head_block_num(), 3u);
+        db2.for_each_index([&](chainbase::abstract_generic_index_i& item) {
+            BOOST_CHECK_EQUAL(item.revision(), (int64_t)db2.head_block_num());
+        });
+
+        for (uint32_t i = 3; i < 5; ++i)
+            PUSH_BLOCK(db2, blocks[i], database::skip_nothing);
+
+        BOOST_CHECK(db2.head_block_id() == db1.head_block_id());
+
+        db2.pop_block();
+        db2.pop_block();
+        BOOST_CHECK(db2.head_block_id() == blocks[2].id());
+
+        PUSH_BLOCK(db2, blocks[3], database::skip_nothing);
+        BOOST_CHECK(db2.head_block_id() == blocks[3].id());
+    }
+    catch (fc::exception& e)
+    {
+        edump((e.to_detail_string()));
+        throw;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(failed_irreversible_block_corrupts_state)
+{
+    try
+    {
+        fc::temp_directory dir1(graphene::utilities::temp_directory_path());
+        fc::temp_directory dir2(graphene::utilities::temp_directory_path());
+
+        database db1(database::opt_default);
+        db_setup_and_open(db1, dir1.path());
+        database db2(database::opt_default);
+        db_setup_and_open(db2, dir2.path());
+
+        auto init_account_priv_key = fc::ecc::private_key::regenerate(fc::sha256::hash(std::string(TEST_INIT_KEY)));
+        public_key_type init_account_pub_key = init_account_priv_key.get_public_key();
+
+        signed_transaction trx;
+        account_create_operation cop;
+        cop.new_account_name = "alice";
+        cop.creator = TEST_INIT_DELEGATE_NAME;
+        cop.owner = authority(1, init_account_pub_key, 1);
+        cop.fee = SUFFICIENT_FEE;
+        cop.active = cop.owner;
+        trx.operations.push_back(cop);
+        trx.set_expiration(db1.head_block_time() + SCORUM_MAX_TIME_UNTIL_EXPIRATION);
+        trx.sign(init_account_priv_key, db1.get_chain_id());
+        PUSH_TX(db1, trx, database::skip_nothing);
+
+        auto b = db1.generate_block(db1.get_slot_time(1), db1.get_scheduled_witness(1), init_account_priv_key,
+                                    database::skip_nothing);
+
+        auto bad_block = b;
+        bad_block.transactions[0].operations[0].get<account_create_operation>().creator = "nobody";
+
+        auto skip_checks = database::skip_undo_block | database::skip_merkle_check | database::skip_witness_signature
+            | database::skip_transaction_signatures | database::skip_authority_check;
+        SCORUM_CHECK_THROW(PUSH_BLOCK(db2, bad_block, skip_checks), fc::exception);
+
+        // block applied without undo session can't be rolled back, node refuses to go on until replay
+        db2.for_each_index([&](chainbase::abstract_generic_index_i& item) { BOOST_CHECK_EQUAL(item.revision(), -1); });
+        SCORUM_CHECK_THROW(PUSH_BLOCK(db2, b, database::skip_nothing), fc::exception);
+        SCORUM_CHECK_THROW(PUSH_TX(db2, trx, database::skip_nothing), fc::exception);
+    }
+    catch (fc::exception& e)
+    {
+        edump((e.to_detail_string()));
+        throw;
+    }
+}
+
 BOOST_AUTO_TEST_CASE(tapos)
 {
     try
@@ -0,0 +1,90 @@
+#include <boost/test/unit_test.hpp>
+
+#include <scorum/app/api_context.hpp>
+#include <scorum/app/database_api.hpp>
+#include <scorum/app/head_state_snapshot.hpp>
+
+#include "database_trx_integration.hpp"
+
+#include <chrono>
+#include <future>
+
+using namespace scorum;
+using namespace scorum::chain;
+using namespace scorum::app;
+
+namespace head_state_tests {
+
+using namespace database_fixture;
+
+struct head_state_fixture : public database_trx_integration_fixture
+{
+    head_state_fixture()
+        : _database_api_ctx(app, API_DATABASE, std::make_shared<api_session_data>())
+        , database_api_call(_database_api_ctx)
+    {
+        open_database();
+    }
+
+    api_context _database_api_ctx;
+    database_api database_api_call;
+};
+
+BOOST_FIXTURE_TEST_SUITE(head_state_snapshot_tests, head_state_fixture)
+
+SCORUM_TEST_CASE(state_is_published_after_block)
+{
+    generate_block();
+
+    auto state = app.head_state().get();
+    BOOST_REQUIRE(state);
+    BOOST_CHECK_EQUAL(state->head_block_num, db.head_block_num());
+    BOOST_CHECK_EQUAL(database_api_call.get_dynamic_global_properties().head_block_number, db.head_block_num());
+    BOOST_CHECK(database_api_call.get_chain_id() == db.get_chain_id());
+    BOOST_CHECK_EQUAL(database_api_call.get_active_witnesses().size(),
+                      db.get(witness_schedule_id_type()).current_shuffled_witnesses.size());
+}
+
+SCORUM_TEST_CASE(taken_state_is_not_changed_by_next_blocks)
+{
+    generate_block();
+
+    auto state = app.head_state().get();
+    BOOST_REQUIRE(state);
+    const auto block_num = state->head_block_num;
+
+    generate_blocks(3);
+
+    BOOST_CHECK_EQUAL(state->head_block_num, block_num);
+    BOOST_CHECK_EQUAL(state->dynamic_global_properties.head_block_number, block_num);
+    BOOST_CHECK_EQUAL(app.head_state().get()->head_block_num, block_num + 3);
+}
+
+SCORUM_TEST_CASE(state_follows_popped_block)
+{
+    generate_blocks(2);
+    const auto block_num = db.head_block_num();
+
+    db.pop_block();
+
+    auto state = app.head_state().get();
+    BOOST_REQUIRE(state);
+    BOOST_CHECK_EQUAL(state->head_block_num, block_num - 1);
+    BOOST_CHECK_EQUAL(state->dynamic_global_properties.head_block_number, block_num - 1);
+}
+
+SCORUM_TEST_CASE(reader_does_not_wait_for_write_lock)
+{
+    generate_block();
+
+    db.with_write_lock([&]() {
+        auto reader = std::async(std::launch::async,
+                                 [&]() { return database_api_call.get_dynamic_global_properties().head_block_number; });
+
+        BOOST_REQUIRE(reader.wait_for(std::chrono::seconds(1)) == std::future_status::ready);
+        BOOST_CHECK_EQUAL(reader.get(), db.head_block_num());
+    });
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}
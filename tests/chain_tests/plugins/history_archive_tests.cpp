@@ -0,0 +1,491 @@
+#include <boost/test/unit_test.hpp>
+
+#include <scorum/blockchain_history/history_archive.hpp>
+#include <scorum/blockchain_history/blockchain_history_plugin.hpp>
+#include <scorum/blockchain_history/account_history_api.hpp>
+#include <scorum/blockchain_history/blockchain_history_api.hpp>
+#include <scorum/blockchain_history/schema/operation_objects.hpp>
+
+#include <scorum/app/api_context.hpp>
+#include <scorum/common_api/config_api.hpp>
+
+#include <graphene/utilities/tempdir.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include "database_trx_integration.hpp"
+#include "defines.hpp"
+
+using scorum::blockchain_history::applied_operation;
+using scorum::blockchain_history::history_archive;
+using scorum::protocol::account_name_type;
+using scorum::protocol::transaction_id_type;
+using scorum::protocol::transfer_operation;
+
+namespace {
+
+struct history_archive_fixture
+{
+    history_archive_fixture()
+        : data_dir(graphene::utilities::temp_directory_path())
+        , dir(data_dir.path() / "history_archive")
+        , start(fc::time_point_sec(1500000000))
+    {
+    }
+
+    transaction_id_type make_trx_id(uint32_t block, uint32_t trx_in_block)
+    {
+        return transaction_id_type(fc::sha256::hash(std::to_string(block) + ":" + std::to_string(trx_in_block)));
+    }
+
+    // operations of blocks [from_block, to_block], ops_per_block in one transaction of each block
+    std::vector<history_archive::operation_entry>
+    make_operations(int64_t first_id, uint32_t from_block, uint32_t to_block, uint32_t ops_per_block)
+    {
+        std::vector<history_archive::operation_entry> result;
+        int64_t id = first_id;
+        for (uint32_t block = from_block; block <= to_block; ++block)
+        {
+            for (uint16_t ci = 0; ci < ops_per_block; ++ci)
+            {
+                transfer_operation op;
+                op.from = "alice";
+                op.to = "bob";
+                op.amount = ASSET_SCR(id);
+                op.memo = std::to_string(id);
+
+                history_archive::operation_entry entry;
+                entry.id = id++;
+                entry.trx_id = make_trx_id(block, 0);
+                entry.block = block;
+                entry.trx_in_block = 0;
+                entry.op_in_trx = ci;
+                entry.timestamp = start + block * SCORUM_BLOCK_INTERVAL;
+                entry.serialized_op = fc::raw::pack(scorum::protocol::operation(op));
+                result.push_back(entry);
+            }
+        }
+        return result;
+    }
+
+    history_archive::posting_entry
+    make_posting(const account_name_type& account, uint64_t sequence, int64_t op, std::vector<int64_t> progress = {})
+    {
+        history_archive::posting_entry entry;
+        entry.list = 1;
+        entry.account = account;
+        entry.sequence = sequence;
+        entry.op = op;
+        entry.progress = progress;
+        return entry;
+    }
+
+    std::string memo_of(const applied_operation& op)
+    {
+        return op.op.get<transfer_operation>().memo;
+    }
+
+    fc::temp_directory data_dir;
+    fc::path dir;
+    fc::time_point_sec start;
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(history_archive_tests, history_archive_fixture)
+
+BOOST_AUTO_TEST_CASE(empty_archive)
+{
+    history_archive archive(dir);
+
+    BOOST_CHECK_EQUAL(archive.next_operation_id(), 0);
+    BOOST_CHECK_EQUAL(archive.last_block(), 0u);
+    BOOST_CHECK_EQUAL(archive.next_sequence(1, "alice"), 0u);
+    BOOST_CHECK(!archive.find_operation(0).valid());
+
+    uint32_t block = 0;
+    uint32_t trx_in_block = 0;
+    BOOST_CHECK(!archive.find_transaction(make_trx_id(1, 0), block, trx_in_block));
+}
+
+BOOST_AUTO_TEST_CASE(operations_are_found_across_column_blocks)
+{
+    history_archive archive(dir, 4);
+
+    archive.append(make_operations(0, 1, 5, 3), {});
+    archive.append(make_operations(15, 6, 7, 3), {});
+
+    BOOST_CHECK_EQUAL(archive.next_operation_id(), 21);
+    BOOST_CHECK_EQUAL(archive.last_block(), 7u);
+
+    auto op = archive.find_operation(13);
+    BOOST_REQUIRE(op.valid());
+    BOOST_CHECK_EQUAL(memo_of(*op), "13");
+    BOOST_CHECK_EQUAL(op->block, 5u);
+    BOOST_CHECK_EQUAL(op->op_in_trx, 1u);
+    BOOST_CHECK(op->trx_id == make_trx_id(5, 0));
+    BOOST_CHECK(op->timestamp == start + 5 * SCORUM_BLOCK_INTERVAL);
+    BOOST_CHECK(!archive.find_operation(21).valid());
+
+    std::vector<int64_t> ids;
+    archive.get_operations(2, 17, [&](int64_t id, const applied_operation& op) {
+        BOOST_CHECK_EQUAL(memo_of(op), std::to_string(id));
+        ids.push_back(id);
+        return ids.size() < 10;
+    });
+    BOOST_REQUIRE_EQUAL(ids.size(), 10u);
+    BOOST_CHECK_EQUAL(ids.front(), 2);
+    BOOST_CHECK_EQUAL(ids.back(), 11);
+
+    ids.clear();
+    archive.get_operations_in_block(6, [&](int64_t id, const applied_operation&) {
+        ids.push_back(id);
+        return true;
+    });
+    BOOST_CHECK((ids == std::vector<int64_t>{ 15, 16, 17 }));
+
+    ids.clear();
+    archive.get_operations_by_time(start + 2 * SCORUM_BLOCK_INTERVAL, start + 3 * SCORUM_BLOCK_INTERVAL,
+                                   [&](int64_t id, const applied_operation&) {
+                                       ids.push_back(id);
+                                       return true;
+                                   });
+    BOOST_CHECK((ids == std::vector<int64_t>{ 3, 4, 5, 6, 7, 8 }));
+}
+
+BOOST_AUTO_TEST_CASE(transactions_are_found_in_every_run)
+{
+    history_archive archive(dir);
+
+    archive.append(make_operations(0, 1, 3, 2), {});
+    archive.append(make_operations(6, 4, 6, 2), {});
+
+    uint32_t block = 0;
+    uint32_t trx_in_block = 1;
+    BOOST_REQUIRE(archive.find_transaction(make_trx_id(2, 0), block, trx_in_block));
+    BOOST_CHECK_EQUAL(block, 2u);
+    BOOST_CHECK_EQUAL(trx_in_block, 0u);
+
+    BOOST_REQUIRE(archive.find_transaction(make_trx_id(5, 0), block, trx_in_block));
+    BOOST_CHECK_EQUAL(block, 5u);
+
+    BOOST_CHECK(!archive.find_transaction(make_trx_id(7, 0), block, trx_in_block));
+}
+
+BOOST_AUTO_TEST_CASE(postings_keep_sequences_and_progress)
+{
+    history_archive archive(dir);
+
+    archive.append(make_operations(0, 1, 2, 2),
+                   { make_posting("alice", 0, 0), make_posting("alice", 1, 2, { 3 }), make_posting("bob", 0, 1) });
+    archive.append({}, { make_posting("alice", 2, 3) });
+
+    BOOST_CHECK_EQUAL(archive.next_sequence(1, "alice"), 3u);
+    BOOST_CHECK_EQUAL(archive.next_sequence(1, "bob"), 1u);
+    BOOST_CHECK_EQUAL(archive.next_sequence(2, "alice"), 0u);
+
+    std::vector<history_archive::posting_entry> entries;
+    archive.get_postings(1, "alice", 1, 10, [&](const history_archive::posting_entry& entry) {
+        entries.push_back(entry);
+    });
+    BOOST_REQUIRE_EQUAL(entries.size(), 2u);
+    BOOST_CHECK_EQUAL(entries[0].sequence, 1u);
+    BOOST_CHECK_EQUAL(entries[0].op, 2);
+    BOOST_CHECK((entries[0].progress == std::vector<int64_t>{ 3 }));
+    BOOST_CHECK_EQUAL(entries[1].sequence, 2u);
+    BOOST_CHECK_EQUAL(entries[1].op, 3);
+    BOOST_CHECK(entries[1].progress.empty());
+}
+
+BOOST_AUTO_TEST_CASE(archive_is_restored_after_reopen)
+{
+    {
+        history_archive archive(dir, 4);
+        archive.append(make_operations(0, 1, 3, 3), { make_posting("alice", 0, 4) });
+    }
+
+    history_archive archive(dir, 4);
+
+    BOOST_CHECK_EQUAL(archive.next_operation_id(), 9);
+    BOOST_CHECK_EQUAL(archive.last_block(), 3u);
+    BOOST_CHECK_EQUAL(archive.next_sequence(1, "alice"), 1u);
+
+    auto op = archive.find_operation(8);
+    BOOST_REQUIRE(op.valid());
+    BOOST_CHECK_EQUAL(memo_of(*op), "8");
+
+    archive.append(make_operations(9, 4, 4, 1), {});
+    BOOST_CHECK_EQUAL(archive.next_operation_id(), 10);
+    BOOST_REQUIRE(archive.find_operation(9).valid());
+}
+
+BOOST_AUTO_TEST_CASE(clear_removes_everything)
+{
+    history_archive archive(dir);
+    archive.append(make_operations(0, 1, 3, 1), { make_posting("alice", 0, 0) });
+
+    archive.clear();
+
+    BOOST_CHECK_EQUAL(archive.next_operation_id(), 0);
+    BOOST_CHECK_EQUAL(archive.last_block(), 0u);
+    BOOST_CHECK_EQUAL(archive.next_sequence(1, "alice"), 0u);
+    BOOST_CHECK(!archive.find_operation(0).valid());
+
+    archive.append(make_operations(0, 1, 1, 1), {});
+    BOOST_CHECK_EQUAL(archive.next_operation_id(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(appends_are_synced_by_background_thread)
+{
+    {
+        history_archive archive(dir);
+        BOOST_CHECK(archive.is_synced());
+
+        archive.append(make_operations(0, 1, 3, 1), { make_posting("alice", 0, 0) });
+        archive.wait();
+
+        BOOST_CHECK(archive.is_synced());
+    }
+
+    history_archive archive(dir);
+    BOOST_CHECK_EQUAL(archive.next_operation_id(), 3);
+    BOOST_CHECK_EQUAL(archive.next_sequence(1, "alice"), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(compaction_merges_postings_and_transactions)
+{
+    auto check = [&](const history_archive& archive) {
+        for (uint32_t b = 1; b <= 7; ++b)
+        {
+            uint32_t block = 0;
+            uint32_t trx_in_block = 1;
+            BOOST_REQUIRE(archive.find_transaction(make_trx_id(b, 0), block, trx_in_block));
+            BOOST_CHECK_EQUAL(block, b);
+            BOOST_CHECK_EQUAL(trx_in_block, 0u);
+        }
+
+        uint32_t block = 0;
+        uint32_t trx_in_block = 0;
+        BOOST_CHECK(!archive.find_transaction(make_trx_id(8, 0), block, trx_in_block));
+
+        BOOST_CHECK_EQUAL(archive.next_sequence(1, "alice"), 4u);
+        BOOST_CHECK_EQUAL(archive.next_sequence(1, "bob"), 1u);
+
+        std::vector<history_archive::posting_entry> entries;
+        archive.get_postings(1, "alice", 0, 10, [&](const history_archive::posting_entry& entry) {
+            entries.push_back(entry);
+        });
+        BOOST_REQUIRE_EQUAL(entries.size(), 4u);
+        BOOST_CHECK_EQUAL(entries[0].op, 0);
+        BOOST_CHECK((entries[1].progress == std::vector<int64_t>{ 1 }));
+        BOOST_CHECK_EQUAL(entries[2].op, 6);
+        BOOST_CHECK_EQUAL(entries[3].sequence, 3u);
+        BOOST_CHECK_EQUAL(entries[3].op, 12);
+
+        auto op = archive.find_operation(13);
+        BOOST_REQUIRE(op.valid());
+        BOOST_CHECK_EQUAL(memo_of(*op), "13");
+    };
+
+    {
+        history_archive archive(dir);
+
+        // transaction of block 3 is split between appends
+        archive.append(make_operations(0, 1, 3, 2),
+                       { make_posting("alice", 0, 0), make_posting("alice", 1, 2, { 1 }) });
+        archive.append(make_operations(6, 3, 5, 2), { make_posting("alice", 2, 6), make_posting("bob", 0, 7) });
+
+        archive.compact();
+        // copied to compacted files if it is appended while compaction runs
+        archive.append(make_operations(12, 6, 7, 1), { make_posting("alice", 3, 12) });
+        archive.wait();
+
+        // installs compaction finished after the previous append
+        archive.append({}, {});
+        archive.wait();
+
+        BOOST_CHECK(archive.is_synced());
+        BOOST_CHECK(fc::exists(dir / "postings.1.dat"));
+        BOOST_CHECK(fc::exists(dir / "transactions.1.dat"));
+        BOOST_CHECK(!fc::exists(dir / "postings.0.dat"));
+        BOOST_CHECK(!fc::exists(dir / "transactions.0.dat"));
+
+        check(archive);
+    }
+
+    history_archive archive(dir);
+    check(archive);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+namespace {
+
+using scorum::blockchain_history::operation_index;
+using scorum::blockchain_history::operation_object;
+
+struct archived_transfer
+{
+    int64_t id = 0;
+    transaction_id_type trx_id;
+    uint32_t block = 0;
+};
+
+struct history_archive_plugin_fixture : public database_fixture::database_trx_integration_fixture
+{
+    history_archive_plugin_fixture()
+        : archive_dir(graphene::utilities::temp_directory_path())
+        , alice("alice")
+        , bob("bob")
+        , blockchain_history_api_ctx(app, API_BLOCKCHAIN_HISTORY, std::make_shared<scorum::app::api_session_data>())
+        , account_history_api_ctx(app, API_ACCOUNT_HISTORY, std::make_shared<scorum::app::api_session_data>())
+    {
+        auto plugin = init_plugin<scorum::blockchain_history::blockchain_history_plugin>(
+            { "--history-archive-interval=1", "--history-archive-dir=" + archive_dir.path().string() });
+        archive = plugin->archive();
+
+        // apis take the archive from the plugin when they are created
+        blockchain_history_api.reset(
+            new scorum::blockchain_history::blockchain_history_api(blockchain_history_api_ctx));
+        account_history_api.reset(new scorum::blockchain_history::account_history_api(account_history_api_ctx));
+
+        open_database();
+        generate_block();
+
+        actor(initdelegate).create_account(alice);
+        actor(initdelegate).give_scr(alice, 1000);
+        actor(initdelegate).create_account(bob);
+    }
+
+    archived_transfer push_transfer(const std::string& memo)
+    {
+        transfer_operation op;
+        op.from = alice.name;
+        op.to = bob.name;
+        op.amount = ASSET_SCR(1);
+        op.memo = memo;
+        push_operation(op, alice.private_key);
+
+        archived_transfer result;
+        result.block = db.head_block_num();
+
+        for (const auto& obj : db.get_index<operation_index>().indices())
+        {
+            const applied_operation op(obj);
+            if (op.block == result.block && op.op.which() == scorum::protocol::operation::tag<transfer_operation>::value
+                && memo_of(op) == memo)
+            {
+                result.id = obj.id._id;
+                result.trx_id = obj.trx_id;
+            }
+        }
+
+        BOOST_REQUIRE(result.trx_id != transaction_id_type());
+        return result;
+    }
+
+    bool in_shared_memory(int64_t id)
+    {
+        const auto& idx = db.get_index<operation_index, scorum::blockchain_history::by_id>();
+        return idx.find(operation_object::id_type(id)) != idx.end();
+    }
+
+    /// generates blocks until the operation is archived and removed from shared memory by the head block
+    void archive_operation(int64_t id)
+    {
+        for (uint32_t ci = 0; ci < 2 * SCORUM_MAX_WITNESSES + 2 && in_shared_memory(id); ++ci)
+        {
+            // objects are removed when their archived copies are synced
+            archive->wait();
+            generate_block();
+        }
+
+        BOOST_REQUIRE(!in_shared_memory(id));
+        BOOST_REQUIRE_GT(archive->next_operation_id(), id);
+    }
+
+    size_t count_transfers(const std::map<uint32_t, applied_operation>& ops, const std::string& memo)
+    {
+        return std::count_if(ops.begin(), ops.end(), [&](const std::pair<const uint32_t, applied_operation>& op) {
+            return op.second.op.which() == scorum::protocol::operation::tag<transfer_operation>::value
+                && memo_of(op.second) == memo;
+        });
+    }
+
+    std::vector<uint32_t> keys(const std::map<uint32_t, applied_operation>& ops)
+    {
+        std::vector<uint32_t> result;
+        for (const auto& op : ops)
+            result.push_back(op.first);
+        return result;
+    }
+
+    std::string memo_of(const applied_operation& op)
+    {
+        return op.op.get<transfer_operation>().memo;
+    }
+
+    fc::temp_directory archive_dir;
+
+    Actor alice;
+    Actor bob;
+
+    scorum::app::api_context blockchain_history_api_ctx;
+    scorum::app::api_context account_history_api_ctx;
+
+    std::shared_ptr<const history_archive> archive;
+    std::unique_ptr<scorum::blockchain_history::blockchain_history_api> blockchain_history_api;
+    std::unique_ptr<scorum::blockchain_history::account_history_api> account_history_api;
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(history_archive_plugin_tests, history_archive_plugin_fixture)
+
+BOOST_AUTO_TEST_CASE(archived_history_is_served_by_api)
+{
+    const auto transfer = push_transfer("archived");
+    archive_operation(transfer.id);
+
+    using scorum::blockchain_history::applied_operation_type;
+
+    const auto block_ops = blockchain_history_api->get_ops_in_block(transfer.block, applied_operation_type::all);
+    BOOST_CHECK_EQUAL(count_transfers(block_ops, "archived"), 1u);
+
+    const auto history = blockchain_history_api->get_ops_history(transfer.id, 1, applied_operation_type::all);
+    BOOST_REQUIRE_EQUAL(history.size(), 1u);
+    BOOST_CHECK_EQUAL(int64_t(history.begin()->first), transfer.id);
+    BOOST_CHECK_EQUAL(count_transfers(history, "archived"), 1u);
+
+    const auto trx = blockchain_history_api->get_transaction(transfer.trx_id);
+    BOOST_CHECK_EQUAL(trx.block_num, transfer.block);
+
+    const auto account_ops = account_history_api->get_account_history(alice.name, uint64_t(-1), 50);
+    BOOST_CHECK_EQUAL(count_transfers(account_ops, "archived"), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(objects_restored_by_undo_are_not_archived_again)
+{
+    const auto transfer = push_transfer("restored");
+    archive_operation(transfer.id);
+
+    const auto history = keys(account_history_api->get_account_history(alice.name, uint64_t(-1), 50));
+
+    // the head block removed archived objects, undo restores them to shared memory
+    db.pop_block();
+    BOOST_REQUIRE(in_shared_memory(transfer.id));
+
+    // archived copies and restored objects are not returned twice
+    BOOST_CHECK((keys(account_history_api->get_account_history(alice.name, uint64_t(-1), 50)) == history));
+    BOOST_CHECK_EQUAL(count_transfers(blockchain_history_api->get_ops_in_block(
+                                          transfer.block, scorum::blockchain_history::applied_operation_type::all),
+                                      "restored"),
+                      1u);
+
+    // restored objects are removed again without appending them
+    archive->wait();
+    generate_block();
+
+    BOOST_CHECK(!in_shared_memory(transfer.id));
+    BOOST_CHECK((keys(account_history_api->get_account_history(alice.name, uint64_t(-1), 50)) == history));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,373 @@
+#include <boost/test/unit_test.hpp>
+
+#include <scorum/blockchain_history/blockchain_history_plugin.hpp>
+#include <scorum/blockchain_history/history_exporter.hpp>
+#include <scorum/blockchain_history/schema/operation_objects.hpp>
+#include <scorum/chain/services/dynamic_global_property.hpp>
+
+#include <graphene/utilities/tempdir.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/io/raw.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+#include "database_integration.hpp"
+#include "defines.hpp"
+
+using scorum::blockchain_history::blockchain_history_plugin;
+using scorum::blockchain_history::exported_block;
+using scorum::blockchain_history::exported_operation;
+using scorum::blockchain_history::history_exporter;
+using scorum::chain::database;
+using scorum::protocol::transfer_operation;
+
+namespace {
+
+struct history_exporter_fixture
+{
+    history_exporter_fixture()
+        : data_dir(graphene::utilities::temp_directory_path())
+        , dir(data_dir.path() / "export")
+    {
+    }
+
+    exported_block make_block(uint32_t block_num, uint16_t ops)
+    {
+        exported_block result;
+        result.block_num = block_num;
+        for (uint16_t ci = 0; ci < ops; ++ci)
+        {
+            transfer_operation op;
+            op.from = "alice";
+            op.to = "bob";
+            op.amount = ASSET_SCR(block_num);
+            op.memo = std::to_string(block_num) + ":" + std::to_string(ci);
+
+            exported_operation record;
+            record.block = block_num;
+            record.op_in_trx = ci;
+            record.op = op;
+            result.operations.push_back(record);
+        }
+        return result;
+    }
+
+    std::vector<std::string> files()
+    {
+        std::vector<std::string> result;
+        for (boost::filesystem::directory_iterator it(dir.string()), end; it != end; ++it)
+        {
+            // export cursor is not listed
+            const std::string name = it->path().filename().string();
+            if (name.find("history-") == 0)
+                result.push_back(name);
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    std::vector<exported_operation> read_all()
+    {
+        std::vector<exported_operation> result;
+        for (const auto& name : files())
+        {
+            auto records = read_binary(name);
+            result.insert(result.end(), records.begin(), records.end());
+        }
+        return result;
+    }
+
+    std::vector<exported_operation> read_binary(const std::string& name)
+    {
+        std::ifstream file((dir / name).string(), std::ios::binary);
+        std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        std::vector<exported_operation> result;
+        size_t pos = 0;
+        while (pos < data.size())
+        {
+            BOOST_REQUIRE_LE(pos + 4, data.size());
+            uint32_t length = 0;
+            for (int ci = 0; ci < 4; ++ci)
+                length |= uint32_t(uint8_t(data[pos + ci])) << (8 * ci);
+            pos += 4;
+
+            BOOST_REQUIRE_LE(pos + length, data.size());
+            std::vector<char> record(data.begin() + pos, data.begin() + pos + length);
+            result.push_back(fc::raw::unpack<exported_operation>(record));
+            pos += length;
+        }
+        return result;
+    }
+
+    std::string memo_of(const exported_operation& record)
+    {
+        return record.op.get<transfer_operation>().memo;
+    }
+
+    fc::temp_directory data_dir;
+    fc::path dir;
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(history_exporter_tests, history_exporter_fixture)
+
+BOOST_AUTO_TEST_CASE(binary_records_are_written_in_order)
+{
+    {
+        history_exporter exporter(dir, history_exporter::format_type::binary);
+        BOOST_REQUIRE(exporter.push(make_block(1, 2)));
+        BOOST_REQUIRE(exporter.push(make_block(2, 0)));
+        BOOST_REQUIRE(exporter.push(make_block(3, 1)));
+    }
+
+    BOOST_REQUIRE((files() == std::vector<std::string>{ "history-0000000001.bin" }));
+
+    auto records = read_binary("history-0000000001.bin");
+    BOOST_REQUIRE_EQUAL(records.size(), 3u);
+    BOOST_CHECK_EQUAL(memo_of(records[0]), "1:0");
+    BOOST_CHECK_EQUAL(memo_of(records[1]), "1:1");
+    BOOST_CHECK_EQUAL(memo_of(records[2]), "3:0");
+    BOOST_CHECK_EQUAL(records[2].block, 3u);
+}
+
+BOOST_AUTO_TEST_CASE(files_are_rotated_at_block_boundary)
+{
+    {
+        history_exporter exporter(dir, history_exporter::format_type::binary, 1);
+        BOOST_REQUIRE(exporter.push(make_block(5, 3)));
+        BOOST_REQUIRE(exporter.push(make_block(6, 3)));
+    }
+
+    BOOST_REQUIRE((files() == std::vector<std::string>{ "history-0000000005.bin", "history-0000000006.bin" }));
+    BOOST_CHECK_EQUAL(read_binary("history-0000000005.bin").size(), 3u);
+    BOOST_CHECK_EQUAL(read_binary("history-0000000006.bin").size(), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(json_records_are_written_by_lines)
+{
+    {
+        history_exporter exporter(dir, history_exporter::format_type::json);
+        BOOST_REQUIRE(exporter.push(make_block(7, 2)));
+    }
+
+    std::ifstream file((dir / "history-0000000007.json").string());
+    std::vector<exported_operation> records;
+    for (std::string line; std::getline(file, line);)
+        records.push_back(fc::json::from_string(line).as<exported_operation>());
+
+    BOOST_REQUIRE_EQUAL(records.size(), 2u);
+    BOOST_CHECK_EQUAL(memo_of(records[1]), "7:1");
+}
+
+BOOST_AUTO_TEST_CASE(stats_count_exported_records)
+{
+    history_exporter exporter(dir, history_exporter::format_type::binary, history_exporter::default_file_size, 1);
+
+    // empty queue accepts block larger than capacity
+    BOOST_REQUIRE(exporter.push(make_block(1, 5)));
+
+    for (int ci = 0; ci < 1000 && exporter.get_stats().last_exported_block < 1; ++ci)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    auto stats = exporter.get_stats();
+    BOOST_CHECK_EQUAL(stats.last_queued_block, 1u);
+    BOOST_CHECK_EQUAL(stats.last_exported_block, 1u);
+    BOOST_CHECK_EQUAL(stats.exported_records, 5u);
+    BOOST_CHECK_EQUAL(stats.queued_records, 0u);
+    BOOST_CHECK_EQUAL(stats.max_queued_records, 5u);
+    BOOST_CHECK_EQUAL(stats.files, 1u);
+    BOOST_CHECK_GT(stats.written_bytes, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(unfinished_file_is_continued_from_cursor)
+{
+    {
+        history_exporter exporter(dir, history_exporter::format_type::binary);
+        BOOST_REQUIRE(exporter.push(make_block(1, 2)));
+        BOOST_REQUIRE(exporter.push(make_block(2, 1)));
+    }
+
+    // state left by crash: unfinished file with uncommitted tail
+    const auto size = boost::filesystem::file_size((dir / "history-0000000001.bin").string());
+    fc::rename(dir / "history-0000000001.bin", dir / "history-0000000001.bin.part");
+    {
+        std::ofstream file((dir / "history-0000000001.bin.part").string(), std::ios::binary | std::ios::app);
+        file << "tail of block 3";
+    }
+    fc::json::save_to_file(scorum::blockchain_history::history_export_cursor{ 2, "history-0000000001.bin.part", size },
+                           dir / history_exporter::cursor_file_name);
+
+    {
+        history_exporter exporter(dir, history_exporter::format_type::binary);
+        BOOST_CHECK_EQUAL(exporter.last_exported_block(), 2u);
+        BOOST_REQUIRE(exporter.push(make_block(3, 1)));
+    }
+
+    BOOST_REQUIRE((files() == std::vector<std::string>{ "history-0000000001.bin" }));
+
+    auto records = read_binary("history-0000000001.bin");
+    BOOST_REQUIRE_EQUAL(records.size(), 4u);
+    BOOST_CHECK_EQUAL(memo_of(records[2]), "2:0");
+    BOOST_CHECK_EQUAL(memo_of(records[3]), "3:0");
+}
+
+BOOST_AUTO_TEST_CASE(file_without_cursor_is_trimmed_to_complete_block)
+{
+    {
+        history_exporter exporter(dir, history_exporter::format_type::binary);
+        BOOST_REQUIRE(exporter.push(make_block(1, 2)));
+        BOOST_REQUIRE(exporter.push(make_block(2, 2)));
+    }
+
+    // the last record is cut by interrupted write
+    const auto part = dir / "history-0000000001.bin.part";
+    fc::rename(dir / "history-0000000001.bin", part);
+    boost::filesystem::resize_file(part.string(), boost::filesystem::file_size(part.string()) - 1);
+    fc::remove(dir / history_exporter::cursor_file_name);
+
+    {
+        history_exporter exporter(dir, history_exporter::format_type::binary);
+        // complete record of block 2 is dropped as well, the block is exported again
+        BOOST_CHECK_EQUAL(exporter.last_exported_block(), 1u);
+        BOOST_REQUIRE(exporter.push(make_block(2, 2)));
+    }
+
+    auto records = read_binary("history-0000000001.bin");
+    BOOST_REQUIRE_EQUAL(records.size(), 4u);
+    BOOST_CHECK_EQUAL(memo_of(records[1]), "1:1");
+    BOOST_CHECK_EQUAL(memo_of(records[2]), "2:0");
+    BOOST_CHECK_EQUAL(memo_of(records[3]), "2:1");
+}
+
+BOOST_AUTO_TEST_CASE(unknown_format_is_rejected)
+{
+    BOOST_CHECK(history_exporter::parse_format("json") == history_exporter::format_type::json);
+    BOOST_CHECK_THROW(history_exporter::parse_format("xml"), fc::exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+namespace {
+
+// node with blockchain history plugin, export is enabled if export dir is set
+struct history_export_node
+{
+    history_export_node(const fc::path& data_dir, const fc::path& export_dir, uint64_t queue_size = 0)
+        : app(std::make_shared<database>(database::opt_notify_virtual_op_applying))
+        , db(*app.chain_database())
+    {
+        auto plugin = app.register_plugin<blockchain_history_plugin>();
+        app.enable_plugin(plugin->plugin_name());
+
+        boost::program_options::options_description cli, cfg;
+        plugin->plugin_set_program_options(cli, cfg);
+
+        std::vector<std::string> args;
+        if (!export_dir.string().empty())
+            args.push_back("--history-export-dir=" + export_dir.string());
+        if (queue_size)
+            args.push_back("--history-export-queue-size=" + std::to_string(queue_size));
+
+        boost::program_options::variables_map options;
+        boost::program_options::store(boost::program_options::command_line_parser(args).options(cfg).run(), options);
+
+        plugin->plugin_initialize(options);
+        db.open(data_dir, data_dir, TEST_SHARED_MEM_SIZE_10MB, chainbase::database::read_write,
+                database_fixture::database_integration_fixture::create_default_genesis_state());
+        plugin->plugin_startup();
+    }
+
+    void generate_blocks(uint32_t count)
+    {
+        const auto key = fc::ecc::private_key::regenerate(fc::sha256::hash(std::string(TEST_INIT_KEY)));
+        for (uint32_t ci = 0; ci < count; ++ci)
+            db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), key, database::skip_nothing);
+    }
+
+    // number of operations of every irreversible block kept in history
+    std::map<uint32_t, size_t> history()
+    {
+        const uint32_t last_irreversible_block
+            = db.obtain_service<scorum::chain::dbs_dynamic_global_property>().get().last_irreversible_block_num;
+
+        std::map<uint32_t, size_t> result;
+        for (const auto& op : db.get_index<scorum::blockchain_history::operation_index>().indices())
+        {
+            if (op.block > 0 && op.block <= last_irreversible_block)
+                ++result[op.block];
+        }
+        return result;
+    }
+
+    scorum::app::application app;
+    database& db;
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(history_export_plugin_tests, history_exporter_fixture)
+
+BOOST_AUTO_TEST_CASE(export_resumes_after_restart)
+{
+    fc::temp_directory node_dir(graphene::utilities::temp_directory_path());
+    std::map<uint32_t, size_t> expected;
+
+    // blocks become irreversible SCORUM_MAX_WITNESSES blocks after they are applied
+    {
+        history_export_node node(node_dir.path(), dir);
+        node.generate_blocks(SCORUM_MAX_WITNESSES + 5);
+    }
+    {
+        // blocks applied while export is off are exported from history after restart
+        history_export_node node(node_dir.path(), fc::path());
+        node.generate_blocks(5);
+    }
+    {
+        history_export_node node(node_dir.path(), dir);
+        node.generate_blocks(3);
+        expected = node.history();
+    }
+
+    std::map<uint32_t, size_t> exported;
+    for (const auto& record : read_all())
+        ++exported[record.block];
+
+    BOOST_REQUIRE(!expected.empty());
+    BOOST_CHECK_GT(expected.rbegin()->first, 10u);
+    // every irreversible block is exported once without gaps at restarts
+    BOOST_CHECK((exported == expected));
+}
+
+BOOST_AUTO_TEST_CASE(export_with_full_queue_matches_history)
+{
+    fc::temp_directory node_dir(graphene::utilities::temp_directory_path());
+    std::map<uint32_t, size_t> expected;
+
+    {
+        // queue of a single operation is full most of the time, held blocks are read back from history
+        history_export_node node(node_dir.path(), dir, 1);
+        node.generate_blocks(SCORUM_MAX_WITNESSES + 20);
+
+        auto plugin = node.app.get_plugin<blockchain_history_plugin>(BLOCKCHAIN_HISTORY_PLUGIN_NAME);
+        BOOST_CHECK_LE(plugin->export_stats().reversible_blocks, SCORUM_MAX_WITNESSES + 1);
+
+        expected = node.history();
+    }
+
+    std::map<uint32_t, size_t> exported;
+    for (const auto& record : read_all())
+        ++exported[record.block];
+
+    BOOST_REQUIRE(!expected.empty());
+    BOOST_CHECK((exported == expected));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
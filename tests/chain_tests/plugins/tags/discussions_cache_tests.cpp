@@ -0,0 +1,112 @@
+#ifndef IS_LOW_MEM
+
+#include "tags_common.hpp"
+#include <scorum/tags/tags_api_objects.hpp>
+#include <scorum/tags/tags_api.hpp>
+#include <boost/test/unit_test.hpp>
+
+using namespace scorum;
+using namespace scorum::tags::api;
+using namespace scorum::app;
+using namespace scorum::tags;
+
+namespace database_fixture {
+
+struct discussions_cache_fixture : public tags_fixture
+{
+    using discussion = scorum::tags::api::discussion;
+
+    discussions_cache_fixture()
+    {
+        actor(initdelegate).give_sp(alice, 1e9);
+        actor(initdelegate).give_sp(bob, 1e9);
+        actor(initdelegate).give_sp(sam, 1e9);
+    }
+
+    discussion_query make_query(std::set<std::string> tags)
+    {
+        discussion_query q;
+        q.limit = 100;
+        q.tags_logical_and = false;
+        q.tags = tags;
+        return q;
+    }
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(discussions_cache_tests, database_fixture::discussions_cache_fixture)
+
+SCORUM_TEST_CASE(repeated_query_is_served_from_cache)
+{
+    auto p1 = create_post(alice).set_json(R"({"domains": ["com"], "categories": ["cat"], "tags":["A"]})").in_block();
+    p1.vote(sam).in_block();
+
+    auto before = _api.get_discussions_cache_stats();
+
+    auto first = _api.get_discussions_by_trending(make_query({ "a" }));
+    auto second = _api.get_discussions_by_trending(make_query({ "A" }));
+
+    auto after = _api.get_discussions_cache_stats();
+
+    BOOST_REQUIRE_EQUAL(first.size(), 1u);
+    BOOST_REQUIRE_EQUAL(second.size(), 1u);
+    BOOST_CHECK_EQUAL(second[0].permlink, p1.permlink());
+    BOOST_CHECK_EQUAL(after.misses - before.misses, 1u);
+    BOOST_CHECK_EQUAL(after.hits - before.hits, 1u);
+    BOOST_CHECK_EQUAL(after.size, before.size + 1);
+}
+
+SCORUM_TEST_CASE(block_touching_query_tags_invalidates_entry)
+{
+    auto p1 = create_post(alice).set_json(R"({"domains": ["com"], "categories": ["cat"], "tags":["A"]})").in_block();
+    p1.vote(sam).in_block();
+
+    BOOST_REQUIRE_EQUAL(_api.get_discussions_by_trending(make_query({ "a" })).size(), 1u);
+
+    auto p2 = create_post(bob).set_json(R"({"domains": ["com"], "categories": ["cat"], "tags":["A"]})").in_block();
+    p2.vote(sam).in_block();
+
+    auto before = _api.get_discussions_cache_stats();
+    auto discussions = _api.get_discussions_by_trending(make_query({ "a" }));
+    auto after = _api.get_discussions_cache_stats();
+
+    BOOST_CHECK_EQUAL(discussions.size(), 2u);
+    BOOST_CHECK_EQUAL(after.misses - before.misses, 1u);
+    BOOST_CHECK_GE(after.invalidated, 1u);
+}
+
+SCORUM_TEST_CASE(vote_for_returned_post_invalidates_entry)
+{
+    auto p1 = create_post(alice).set_json(R"({"domains": ["com"], "categories": ["cat"], "tags":["A"]})").in_block();
+    p1.vote(sam).in_block();
+
+    auto cached = _api.get_discussions_by_created(make_query({ "a" }));
+    BOOST_REQUIRE_EQUAL(cached.size(), 1u);
+
+    p1.vote(bob).in_block();
+
+    auto discussions = _api.get_discussions_by_created(make_query({ "a" }));
+    BOOST_REQUIRE_EQUAL(discussions.size(), 1u);
+    BOOST_CHECK_EQUAL(discussions[0].net_votes, cached[0].net_votes + 1);
+}
+
+SCORUM_TEST_CASE(unrelated_block_keeps_entry)
+{
+    auto p1 = create_post(alice).set_json(R"({"domains": ["com"], "categories": ["cat"], "tags":["A"]})").in_block();
+    p1.vote(sam).in_block();
+
+    BOOST_REQUIRE_EQUAL(_api.get_discussions_by_hot(make_query({ "a" })).size(), 1u);
+
+    auto p2 = create_post(bob).set_json(R"({"domains": ["org"], "categories": ["dog"], "tags":["B"]})").in_block();
+    p2.vote(sam).in_block();
+
+    auto before = _api.get_discussions_cache_stats();
+    BOOST_CHECK_EQUAL(_api.get_discussions_by_hot(make_query({ "a" })).size(), 1u);
+    auto after = _api.get_discussions_cache_stats();
+
+    BOOST_CHECK_EQUAL(after.hits - before.hits, 1u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
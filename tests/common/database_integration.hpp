@@ -94,6 +94,24 @@ protected:
         return plugin;
     }
 
+    /// initializes plugin with command line arguments parsed by its config options
+    template <class Plugin> std::shared_ptr<Plugin> init_plugin(const std::vector<std::string>& args)
+    {
+        auto plugin = app.register_plugin<Plugin>();
+        app.enable_plugin(plugin->plugin_name());
+
+        boost::program_options::options_description cli, cfg;
+        plugin->plugin_set_program_options(cli, cfg);
+
+        boost::program_options::variables_map options;
+        boost::program_options::store(boost::program_options::command_line_parser(args).options(cfg).run(), options);
+
+        plugin->plugin_initialize(options);
+        plugin->plugin_startup();
+
+        return plugin;
+    }
+
 public:
     static Actor initdelegate;
 
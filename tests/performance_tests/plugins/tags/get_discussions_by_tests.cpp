@@ -7,6 +7,7 @@
 #include <boost/test/unit_test.hpp>
 #include <fc/filesystem.hpp>
 #include <graphene/utilities/tempdir.hpp>
+#include <algorithm>
 #include <chrono>
 #include <random>
 
@@ -104,6 +105,78 @@ struct tag_perf_fixture : public database_fixture::database_trx_integration_fixt
     }
 };
 
+struct tag_ranking_perf_fixture : public tag_perf_fixture
+{
+    void create_ranked_posts(uint32_t posts_count)
+    {
+        auto acc_name = "alice";
+        auto tags = { "a", "b", "c", "d", "e", "f", "g", "h", "" };
+
+        auto& acc_service = db.obtain_service<dbs_account>();
+        auto alice_id = acc_service.get_account(acc_name).id;
+
+        std::random_device device;
+        std::mt19937 generator(device());
+        std::uniform_int_distribution<> created_distr(3000, posts_count + 3000);
+        std::uniform_int_distribution<> rshares_distr(-100, 1000);
+        std::uniform_real_distribution<> rank_distr(0, 10000);
+        std::bernoulli_distribution tag_distr(0.5);
+
+        for (uint32_t i = 0; i < posts_count; i++)
+        {
+            const auto created = fc::time_point_sec(created_distr(generator));
+            const auto net_rshares = rshares_distr(generator);
+            const auto trending = rank_distr(generator);
+            const auto hot = rank_distr(generator);
+
+            const auto& comment = db.create<comment_object>([&](comment_object& c) {
+                c.author = acc_name;
+                c.created = created;
+                c.net_rshares = net_rshares;
+                fc::from_string(c.permlink, boost::lexical_cast<std::string>(i));
+            });
+            db.create<comment_statistic_scr_object>([&](comment_statistic_scr_object& o) { o.comment = comment.id; });
+            db.create<comment_statistic_sp_object>([&](comment_statistic_sp_object& o) { o.comment = comment.id; });
+
+            for (auto& t : tags)
+            {
+                // every post has about a half of the tags so that intersections are not trivial
+                if (*t && tag_distr(generator))
+                    continue;
+
+                db.create<tag_object>([&](tag_object& obj) {
+                    obj.tag = t;
+                    obj.comment = comment.id;
+                    obj.created = created;
+                    obj.net_rshares = net_rshares;
+                    obj.trending = trending;
+                    obj.hot = hot;
+                    obj.author = alice_id;
+                });
+            }
+        }
+
+        auto size = db.get_index<tag_index, by_tag>().count("");
+        BOOST_REQUIRE_EQUAL(size, posts_count);
+    }
+
+    template <typename Request>
+    std::vector<api::discussion> measure(const std::string& name, uint32_t expected_ms, Request&& request)
+    {
+        auto t1 = std::chrono::steady_clock::now();
+
+        auto posts = request();
+
+        auto t2 = std::chrono::steady_clock::now();
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
+        BOOST_TEST_MESSAGE(name << "' time: " << ms << "ms");
+
+        BOOST_CHECK_LE(ms, expected_ms);
+
+        return posts;
+    }
+};
+
 BOOST_FIXTURE_TEST_SUITE(get_discussions_performance_tests, tag_perf_fixture)
 
 SCORUM_TEST_CASE(check_100000_posts_under_100ms)
@@ -121,3 +194,63 @@ SCORUM_TEST_CASE(check_1000000_posts_under_1000ms)
 }
 
 BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_FIXTURE_TEST_SUITE(get_discussions_ranking_performance_tests, tag_ranking_perf_fixture)
+
+SCORUM_TEST_CASE(check_1000000_posts_trending_union_under_100ms)
+{
+    create_ranked_posts(1000000);
+
+    api::discussion_query q;
+    q.tags = { "a", "b", "c" };
+    q.tags_logical_and = false;
+    q.limit = 100;
+    auto posts = measure("get_discussions_by_trending", 100, [&]() { return _api.get_discussions_by_trending(q); });
+
+    BOOST_CHECK_EQUAL(posts.size(), 100u);
+    BOOST_CHECK(std::all_of(posts.begin(), posts.end(), [](const api::discussion& d) { return d.net_rshares > 0; }));
+}
+
+SCORUM_TEST_CASE(check_1000000_posts_hot_intersection_under_100ms)
+{
+    create_ranked_posts(1000000);
+
+    api::discussion_query q;
+    q.tags = { "a", "b", "c", "d" };
+    q.tags_logical_and = true;
+    q.limit = 100;
+    auto posts = measure("get_discussions_by_hot", 100, [&]() { return _api.get_discussions_by_hot(q); });
+
+    BOOST_CHECK_EQUAL(posts.size(), 100u);
+}
+
+SCORUM_TEST_CASE(check_1000000_posts_paging_under_100ms)
+{
+    create_ranked_posts(1000000);
+
+    api::discussion_query q;
+    q.tags = { "e", "f" };
+    q.tags_logical_and = false;
+    q.limit = 100;
+
+    for (int page = 0; page < 10; ++page)
+    {
+        auto posts
+            = measure("get_discussions_by_created page", 100, [&]() { return _api.get_discussions_by_created(q); });
+        BOOST_REQUIRE_EQUAL(posts.size(), 100u);
+
+        BOOST_CHECK(
+            std::is_sorted(posts.begin(), posts.end(), [](const api::discussion& lhs, const api::discussion& rhs) {
+                return lhs.created > rhs.created;
+            }));
+
+        // start post is included into the next page
+        if (q.start_permlink)
+            BOOST_CHECK_EQUAL(posts.front().permlink, *q.start_permlink);
+
+        q.start_author = posts.back().author;
+        q.start_permlink = posts.back().permlink;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
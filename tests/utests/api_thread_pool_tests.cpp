@@ -0,0 +1,88 @@
+#include <boost/test/unit_test.hpp>
+
+#include <scorum/app/api_thread_pool.hpp>
+
+#include <thread>
+
+using scorum::app::api_thread_pool;
+
+BOOST_AUTO_TEST_SUITE(api_thread_pool_tests)
+
+BOOST_AUTO_TEST_CASE(call_is_executed_inline_without_threads)
+{
+    api_thread_pool pool;
+    pool.start(0);
+
+    const auto caller = std::this_thread::get_id();
+
+    BOOST_CHECK(pool.run("api", [&]() { return std::this_thread::get_id(); }) == caller);
+
+    auto stats = pool.get_stats();
+    BOOST_REQUIRE_EQUAL(stats.count("api"), 1u);
+    BOOST_CHECK_EQUAL(stats["api"].calls, 1u);
+    BOOST_CHECK_EQUAL(stats["api"].queue_depth, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(call_is_executed_on_worker_thread)
+{
+    api_thread_pool pool;
+    pool.start(2);
+
+    const auto caller = std::this_thread::get_id();
+
+    BOOST_CHECK(pool.run("api", [&]() { return std::this_thread::get_id(); }) != caller);
+    BOOST_CHECK_EQUAL(pool.run("api", [&]() { return 42; }), 42);
+
+    auto stats = pool.get_stats();
+    BOOST_CHECK_EQUAL(stats["api"].calls, 2u);
+    BOOST_CHECK_EQUAL(stats["api"].queue_depth, 0u);
+    BOOST_CHECK_GE(stats["api"].max_queue_depth, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(nested_call_is_executed_on_same_worker)
+{
+    api_thread_pool pool;
+    pool.start(1);
+
+    // single worker would deadlock if nested call were queued
+    auto same_thread = pool.run("outer", [&]() {
+        const auto worker = std::this_thread::get_id();
+        return pool.run("inner", [&]() { return std::this_thread::get_id(); }) == worker;
+    });
+
+    BOOST_CHECK(same_thread);
+
+    auto stats = pool.get_stats();
+    BOOST_CHECK_EQUAL(stats["outer"].calls, 1u);
+    BOOST_CHECK_EQUAL(stats["inner"].calls, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(exception_is_passed_to_caller)
+{
+    api_thread_pool pool;
+    pool.start(1);
+
+    BOOST_CHECK_THROW(pool.run("api", []() -> int {
+        FC_ASSERT(false, "failed");
+        return 0;
+    }), fc::assert_exception);
+    BOOST_CHECK_THROW(pool.run("api", []() -> int { throw std::runtime_error("failed"); }), fc::exception);
+
+    BOOST_CHECK_EQUAL(pool.get_stats()["api"].calls, 2u);
+}
+
+BOOST_AUTO_TEST_CASE(calls_are_counted_per_api)
+{
+    api_thread_pool pool;
+    pool.start(2);
+
+    for (int i = 0; i < 3; ++i)
+        pool.run("first", []() { return 0; });
+    pool.run("second", []() { return 0; });
+
+    auto stats = pool.get_stats();
+    BOOST_CHECK_EQUAL(stats["first"].calls, 3u);
+    BOOST_CHECK_EQUAL(stats["second"].calls, 1u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
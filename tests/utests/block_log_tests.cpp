@@ -0,0 +1,377 @@
+#include <boost/test/unit_test.hpp>
+
+#include <scorum/chain/block_log.hpp>
+#include <scorum/chain/compressed_block_log.hpp>
+
+#include <graphene/utilities/tempdir.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include <atomic>
+#include <thread>
+
+using scorum::chain::block_log;
+using scorum::chain::compressed_block_log;
+using scorum::chain::index_rebuild_mode;
+using scorum::chain::serialized_block_view;
+using scorum::protocol::signed_block;
+
+namespace {
+
+struct block_log_fixture
+{
+    block_log_fixture()
+        : data_dir(graphene::utilities::temp_directory_path())
+        , log_file(data_dir.path() / "block_log")
+    {
+    }
+
+    signed_block make_block(const signed_block* prev)
+    {
+        signed_block b;
+        if (prev)
+        {
+            b.previous = prev->id();
+            b.timestamp = prev->timestamp + 3;
+        }
+        b.witness = "initdelegate";
+        return b;
+    }
+
+    std::vector<signed_block> append_blocks(block_log& log, uint32_t count)
+    {
+        std::vector<signed_block> blocks;
+        blocks.reserve(count);
+        for (uint32_t ci = 0; ci < count; ++ci)
+        {
+            blocks.push_back(make_block(blocks.empty() ? nullptr : &blocks.back()));
+            log.append(blocks.back());
+        }
+        return blocks;
+    }
+
+    fc::temp_directory data_dir;
+    fc::path log_file;
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(block_log_tests, block_log_fixture)
+
+BOOST_AUTO_TEST_CASE(read_flushed_blocks_from_mapping)
+{
+    block_log log;
+    log.open(log_file);
+
+    auto blocks = append_blocks(log, 10);
+    log.flush();
+
+    for (uint32_t num = 1; num <= blocks.size(); ++num)
+    {
+        auto view = log.read_serialized_block_by_num(num);
+        BOOST_REQUIRE(view.valid());
+        BOOST_CHECK(fc::raw::pack(blocks[num - 1]) == std::vector<char>(view->data, view->data + view->size));
+
+        auto block = log.read_block_by_num(num);
+        BOOST_REQUIRE(block.valid());
+        BOOST_CHECK(block->id() == blocks[num - 1].id());
+    }
+
+    BOOST_CHECK(!log.read_serialized_block_by_num(0).valid());
+    BOOST_CHECK(!log.read_serialized_block_by_num(11).valid());
+}
+
+BOOST_AUTO_TEST_CASE(unflushed_blocks_are_read_from_stream)
+{
+    block_log log;
+    log.open(log_file);
+
+    auto blocks = append_blocks(log, 3);
+    log.flush();
+
+    blocks.push_back(make_block(&blocks.back()));
+    log.append(blocks.back());
+
+    BOOST_CHECK(!log.read_serialized_block_by_num(4).valid());
+
+    auto block = log.read_block_by_num(4);
+    BOOST_REQUIRE(block.valid());
+    BOOST_CHECK(block->id() == blocks.back().id());
+}
+
+BOOST_AUTO_TEST_CASE(reopened_log_is_mapped)
+{
+    std::vector<signed_block> blocks;
+    {
+        block_log log;
+        log.open(log_file);
+        blocks = append_blocks(log, 5);
+    }
+
+    block_log log;
+    log.open(log_file);
+
+    auto view = log.read_serialized_block_by_num(5);
+    BOOST_REQUIRE(view.valid());
+    BOOST_CHECK(fc::raw::pack(blocks.back()) == std::vector<char>(view->data, view->data + view->size));
+    BOOST_CHECK_EQUAL(log.get_block_pos(1), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(closed_log_serves_no_mapped_blocks)
+{
+    block_log log;
+    log.open(log_file);
+
+    append_blocks(log, 3);
+    log.flush();
+    BOOST_REQUIRE(log.read_serialized_block_by_num(3).valid());
+
+    log.close();
+    BOOST_CHECK(!log.read_serialized_block_by_num(3).valid());
+
+    log.open(log_file);
+    BOOST_CHECK(log.read_serialized_block_by_num(3).valid());
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_read_while_appending)
+{
+    block_log log;
+    log.open(log_file);
+
+    auto blocks = append_blocks(log, 1);
+    log.flush();
+
+    std::atomic<bool> done{ false };
+    std::atomic<uint32_t> errors{ 0 };
+
+    std::thread reader([&]() {
+        while (!done)
+        {
+            for (uint32_t num = 1;; ++num)
+            {
+                auto view = log.read_serialized_block_by_num(num);
+                if (!view.valid())
+                    break;
+
+                signed_block b;
+                fc::datastream<const char*> ds(view->data, view->size);
+                fc::raw::unpack(ds, b);
+                if (b.block_num() != num)
+                    ++errors;
+            }
+        }
+    });
+
+    for (uint32_t ci = 0; ci < 200; ++ci)
+    {
+        blocks.push_back(make_block(&blocks.back()));
+        log.append(blocks.back());
+        log.flush();
+    }
+
+    done = true;
+    reader.join();
+
+    BOOST_CHECK_EQUAL(errors, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_unflushed_reads_while_appending)
+{
+    block_log log;
+    log.open(log_file);
+
+    std::vector<signed_block> blocks;
+    blocks.reserve(301);
+    blocks.push_back(make_block(nullptr));
+    log.append(blocks.back());
+    log.flush();
+
+    std::atomic<uint32_t> appended{ 1 };
+    std::atomic<bool> done{ false };
+    std::atomic<uint32_t> errors{ 0 };
+
+    auto read = [&]() {
+        while (!done)
+        {
+            const uint32_t head_num = appended;
+            for (uint32_t num = std::max(head_num, 10u) - 9; num <= head_num; ++num)
+            {
+                try
+                {
+                    auto b = log.read_block_by_num(num);
+                    if (!b.valid() || b->id() != blocks[num - 1].id())
+                        ++errors;
+                }
+                catch (...)
+                {
+                    ++errors;
+                }
+            }
+        }
+    };
+
+    // the most recent blocks are not flushed, so readers share append streams
+    std::thread reader1(read);
+    std::thread reader2(read);
+
+    for (uint32_t ci = 0; ci < 300; ++ci)
+    {
+        blocks.push_back(make_block(&blocks.back()));
+        log.append(blocks.back());
+        ++appended;
+
+        if (ci % 10 == 0)
+            log.flush();
+    }
+
+    done = true;
+    reader1.join();
+    reader2.join();
+
+    BOOST_CHECK_EQUAL(errors, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(rebuild_index_in_all_modes)
+{
+    std::vector<signed_block> blocks;
+    {
+        block_log log;
+        log.open(log_file);
+        blocks = append_blocks(log, 50);
+    }
+
+    const auto index_file = block_log::block_log_index_path(log_file);
+    const auto expected_size = fc::file_size(index_file);
+
+    for (auto mode : { index_rebuild_mode::unpack, index_rebuild_mode::backward, index_rebuild_mode::parallel })
+    {
+        fc::remove_all(index_file);
+
+        BOOST_CHECK_EQUAL(block_log::rebuild_index(log_file, mode, 3), 50u);
+        BOOST_CHECK_EQUAL(fc::file_size(index_file), expected_size);
+
+        block_log log;
+        log.open(log_file);
+        for (uint32_t num = 1; num <= blocks.size(); ++num)
+        {
+            BOOST_REQUIRE(log.read_block_by_num(num).valid());
+            BOOST_CHECK(log.read_block_by_num(num)->id() == blocks[num - 1].id());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(missing_index_is_reconstructed_on_open)
+{
+    std::vector<signed_block> blocks;
+    {
+        block_log log;
+        log.open(log_file);
+        blocks = append_blocks(log, 20);
+    }
+
+    fc::remove_all(block_log::block_log_index_path(log_file));
+
+    block_log log;
+    log.set_index_rebuild_mode(index_rebuild_mode::parallel, 2);
+    log.open(log_file);
+
+    BOOST_CHECK_EQUAL(log.get_block_pos(1), 0u);
+    BOOST_CHECK(log.read_block_by_num(20)->id() == blocks.back().id());
+}
+
+BOOST_AUTO_TEST_CASE(parallel_rebuild_detects_broken_links)
+{
+    {
+        block_log log;
+        log.open(log_file);
+        append_blocks(log, 10);
+
+        // block with the right number that does not follow the head
+        signed_block b = make_block(&*log.head());
+        b.previous._hash[4] ^= 1;
+        log.append(b);
+    }
+
+    BOOST_CHECK_NO_THROW(block_log::rebuild_index(log_file, index_rebuild_mode::backward));
+    BOOST_CHECK_THROW(block_log::rebuild_index(log_file, index_rebuild_mode::parallel, 2), fc::exception);
+}
+
+BOOST_AUTO_TEST_CASE(compressed_block_log_random_access)
+{
+    std::vector<signed_block> blocks;
+    for (uint32_t ci = 0; ci < 10; ++ci)
+        blocks.push_back(make_block(blocks.empty() ? nullptr : &blocks.back()));
+
+    auto dictionary = compressed_block_log::build_dictionary({ fc::raw::pack(blocks[0]), fc::raw::pack(blocks[1]) });
+
+    auto archive_file = compressed_block_log::compressed_block_log_path(log_file);
+    {
+        compressed_block_log archive;
+        archive.create(archive_file, 4, 9, dictionary);
+        for (const auto& b : blocks)
+            archive.append(b);
+    }
+
+    compressed_block_log archive;
+    archive.open(archive_file);
+
+    BOOST_CHECK_EQUAL(archive.blocks_per_chunk(), 4u);
+    BOOST_CHECK_EQUAL(archive.head_block_num(), 10u);
+    BOOST_REQUIRE(archive.head().valid());
+    BOOST_CHECK(archive.head()->id() == blocks.back().id());
+
+    for (uint32_t num : { 7u, 1u, 10u, 4u, 5u, 2u })
+    {
+        auto b = archive.read_block_by_num(num);
+        BOOST_REQUIRE(b.valid());
+        BOOST_CHECK(b->id() == blocks[num - 1].id());
+    }
+
+    BOOST_CHECK(!archive.read_block_by_num(0).valid());
+    BOOST_CHECK(!archive.read_block_by_num(11).valid());
+}
+
+BOOST_AUTO_TEST_CASE(block_log_continues_compressed_block_log)
+{
+    std::vector<signed_block> blocks;
+    for (uint32_t ci = 0; ci < 10; ++ci)
+        blocks.push_back(make_block(blocks.empty() ? nullptr : &blocks.back()));
+
+    {
+        compressed_block_log archive;
+        archive.create(compressed_block_log::compressed_block_log_path(log_file), 3);
+        for (uint32_t ci = 0; ci < 7; ++ci)
+            archive.append(blocks[ci]);
+    }
+
+    {
+        block_log log;
+        log.open(log_file);
+
+        BOOST_REQUIRE(log.head().valid());
+        BOOST_CHECK_EQUAL(log.head()->block_num(), 7u);
+
+        for (uint32_t ci = 7; ci < blocks.size(); ++ci)
+            log.append(blocks[ci]);
+        log.flush();
+    }
+
+    block_log log;
+    log.open(log_file);
+
+    BOOST_REQUIRE(log.head().valid());
+    BOOST_CHECK(log.head()->id() == blocks.back().id());
+
+    for (uint32_t num = 1; num <= blocks.size(); ++num)
+    {
+        auto b = log.read_block_by_num(num);
+        BOOST_REQUIRE(b.valid());
+        BOOST_CHECK(b->id() == blocks[num - 1].id());
+        BOOST_CHECK(*log.read_packed_block_by_num(num) == fc::raw::pack(blocks[num - 1]));
+    }
+
+    BOOST_CHECK(!log.read_serialized_block_by_num(7).valid());
+    BOOST_CHECK(log.read_serialized_block_by_num(8).valid());
+    BOOST_CHECK_EQUAL(log.get_block_pos(8), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,161 @@
+#include <boost/test/unit_test.hpp>
+
+#include <scorum/chain/database/pending_transaction_pool.hpp>
+#include <scorum/protocol/scorum_operations.hpp>
+
+#include <fc/io/raw.hpp>
+
+using scorum::chain::pending_transaction;
+using scorum::chain::pending_transaction_limits;
+using scorum::chain::pending_transaction_pool;
+using scorum::protocol::asset;
+using scorum::protocol::signed_transaction;
+using scorum::protocol::transfer_operation;
+
+namespace {
+
+struct pending_transaction_pool_fixture
+{
+    pending_transaction make_transaction(const std::string& from, uint32_t expiration, const std::string& memo = "")
+    {
+        transfer_operation op;
+        op.from = from;
+        op.to = "bob";
+        op.amount = asset(1, SCORUM_SYMBOL);
+        op.memo = memo;
+
+        signed_transaction trx;
+        trx.operations.push_back(op);
+        trx.set_expiration(start + expiration);
+
+        return pending_transaction(trx, trx.id());
+    }
+
+    std::vector<uint32_t> expirations_of(const pending_transaction_pool::container_type& transactions)
+    {
+        std::vector<uint32_t> result;
+        for (const auto& trx : transactions)
+            result.push_back((trx.trx.expiration - start).to_seconds());
+        return result;
+    }
+
+    fc::time_point_sec start = fc::time_point_sec(1500000000);
+    pending_transaction_pool pool;
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(pending_transaction_pool_tests, pending_transaction_pool_fixture)
+
+BOOST_AUTO_TEST_CASE(transaction_is_indexed_by_id_and_account)
+{
+    auto trx = make_transaction("alice", 10);
+    const auto id = trx.id;
+
+    BOOST_CHECK_EQUAL(trx.account, "alice");
+    BOOST_CHECK_EQUAL(trx.pack_size, fc::raw::pack_size(trx.trx));
+
+    pool.push(std::move(trx));
+
+    BOOST_CHECK(pool.contains(id));
+    BOOST_CHECK_EQUAL(pool.count_by_account("alice"), 1u);
+    BOOST_CHECK_EQUAL(pool.count_by_account("bob"), 0u);
+    BOOST_CHECK_EQUAL(pool.size(), 1u);
+    BOOST_CHECK_GT(pool.bytes(), 0u);
+
+    auto taken = pool.take();
+    BOOST_CHECK_EQUAL(taken.size(), 1u);
+    BOOST_CHECK(pool.empty());
+    BOOST_CHECK(!pool.contains(id));
+    BOOST_CHECK_EQUAL(pool.count_by_account("alice"), 0u);
+    BOOST_CHECK_EQUAL(pool.bytes(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_is_charged_to_account_of_first_operation)
+{
+    transfer_operation op;
+    op.from = "zoe";
+    op.to = "bob";
+    op.amount = asset(1, SCORUM_SYMBOL);
+
+    signed_transaction trx;
+    trx.operations.push_back(op);
+    op.from = "alice";
+    trx.operations.push_back(op);
+    trx.set_expiration(start + 10);
+
+    BOOST_CHECK_EQUAL(pending_transaction(trx, trx.id()).account, "zoe");
+}
+
+BOOST_AUTO_TEST_CASE(admission_checks_limits)
+{
+    pending_transaction_limits limits;
+    limits.max_count = 3;
+    limits.max_per_account = 2;
+    pool.set_limits(limits);
+
+    pool.push(make_transaction("alice", 10, "1"));
+    pool.push(make_transaction("alice", 10, "2"));
+
+    BOOST_CHECK_THROW(pool.check_admission(make_transaction("alice", 10, "3")), fc::exception);
+    BOOST_CHECK_NO_THROW(pool.check_admission(make_transaction("sam", 10, "3")));
+
+    pool.push(make_transaction("sam", 10, "3"));
+    BOOST_CHECK_THROW(pool.check_admission(make_transaction("zoe", 10, "4")), fc::exception);
+
+    limits = pending_transaction_limits();
+    limits.max_bytes = pool.bytes();
+    pool.set_limits(limits);
+    BOOST_CHECK_THROW(pool.check_admission(make_transaction("zoe", 10, "4")), fc::exception);
+}
+
+BOOST_AUTO_TEST_CASE(earliest_expiring_candidates_are_evicted)
+{
+    pending_transaction_limits limits;
+    limits.max_count = 4;
+    pool.set_limits(limits);
+
+    pool.push(make_transaction("alice", 100));
+
+    pending_transaction_pool::container_type candidates;
+    candidates.push_back(make_transaction("bob", 30));
+    candidates.push_back(make_transaction("sam", 10));
+    candidates.push_back(make_transaction("zoe", 50));
+    candidates.push_back(make_transaction("kim", 20));
+    candidates.push_back(make_transaction("ann", 40));
+
+    BOOST_CHECK_EQUAL(pool.evict_by_expiration(candidates), 2u);
+
+    // order of arrival is kept
+    BOOST_CHECK((expirations_of(candidates) == std::vector<uint32_t>{ 30, 50, 40 }));
+
+    BOOST_CHECK_EQUAL(pool.evict_by_expiration(candidates), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(candidate_is_closed_by_first_transaction_over_capacity)
+{
+    auto trx = make_transaction("alice", 30);
+    const auto size = trx.pack_size;
+
+    pool.open_candidate(scorum::protocol::block_id_type(), size * 2 + 1);
+    pool.push(std::move(trx));
+    pool.push(make_transaction("alice", 20));
+    pool.push(make_transaction("sam", 10, "x"));
+    pool.push(make_transaction("sam", 5));
+
+    const auto& candidate = pool.candidate();
+    BOOST_CHECK(candidate.valid);
+    BOOST_CHECK(candidate.closed);
+    BOOST_CHECK_EQUAL(candidate.count, 2u);
+    BOOST_CHECK_EQUAL(candidate.bytes, size * 2);
+    BOOST_CHECK(candidate.min_expiration == start + 20);
+
+    pool.take();
+    BOOST_CHECK(!pool.candidate().valid);
+
+    // transactions left in the pool were not applied to the state of the new candidate
+    pool.push(make_transaction("alice", 10));
+    pool.open_candidate(scorum::protocol::block_id_type(), size * 2 + 1);
+    BOOST_CHECK(!pool.candidate().valid);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
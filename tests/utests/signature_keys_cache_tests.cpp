@@ -0,0 +1,100 @@
+#include <boost/test/unit_test.hpp>
+
+#include <scorum/protocol/signature_keys_cache.hpp>
+
+#include <fc/crypto/elliptic.hpp>
+
+using scorum::protocol::digest_type;
+using scorum::protocol::public_key_type;
+using scorum::protocol::signature_keys_cache;
+using scorum::protocol::signature_type;
+
+namespace {
+
+struct signature_keys_cache_fixture
+{
+    signature_keys_cache_fixture()
+        : key(fc::ecc::private_key::regenerate(fc::sha256::hash(std::string("key"))))
+    {
+    }
+
+    std::pair<signature_type, digest_type> make_signature(const std::string& data)
+    {
+        auto digest = fc::sha256::hash(data);
+        return std::make_pair(key.sign_compact(digest), digest);
+    }
+
+    fc::ecc::private_key key;
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(signature_keys_cache_tests, signature_keys_cache_fixture)
+
+BOOST_AUTO_TEST_CASE(recovered_key_is_cached)
+{
+    signature_keys_cache cache(10);
+
+    auto sig = make_signature("trx");
+
+    BOOST_CHECK(cache.get_public_key(sig.first, sig.second) == public_key_type(key.get_public_key()));
+    BOOST_CHECK(cache.get_public_key(sig.first, sig.second) == public_key_type(key.get_public_key()));
+
+    auto stats = cache.get_stats();
+    BOOST_CHECK_EQUAL(stats.hits, 1u);
+    BOOST_CHECK_EQUAL(stats.misses, 1u);
+    BOOST_CHECK_EQUAL(stats.size, 1u);
+    BOOST_CHECK_EQUAL(stats.capacity, 10u);
+}
+
+BOOST_AUTO_TEST_CASE(least_recently_used_key_is_evicted)
+{
+    signature_keys_cache cache(2);
+
+    auto sig1 = make_signature("trx1");
+    auto sig2 = make_signature("trx2");
+    auto sig3 = make_signature("trx3");
+
+    cache.get_public_key(sig1.first, sig1.second);
+    cache.get_public_key(sig2.first, sig2.second);
+    cache.get_public_key(sig1.first, sig1.second); // sig2 becomes least recently used
+    cache.get_public_key(sig3.first, sig3.second);
+
+    BOOST_CHECK_EQUAL(cache.get_stats().size, 2u);
+    BOOST_CHECK_EQUAL(cache.get_stats().hits, 1u);
+
+    cache.get_public_key(sig1.first, sig1.second);
+    BOOST_CHECK_EQUAL(cache.get_stats().hits, 2u);
+
+    cache.get_public_key(sig2.first, sig2.second);
+    BOOST_CHECK_EQUAL(cache.get_stats().hits, 2u);
+    BOOST_CHECK_EQUAL(cache.get_stats().misses, 4u);
+}
+
+BOOST_AUTO_TEST_CASE(zero_capacity_disables_cache)
+{
+    signature_keys_cache cache(0);
+
+    auto sig = make_signature("trx");
+
+    BOOST_CHECK(cache.get_public_key(sig.first, sig.second) == public_key_type(key.get_public_key()));
+    BOOST_CHECK(cache.get_public_key(sig.first, sig.second) == public_key_type(key.get_public_key()));
+
+    BOOST_CHECK_EQUAL(cache.get_stats().hits, 0u);
+    BOOST_CHECK_EQUAL(cache.get_stats().size, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(shrinks_on_capacity_change)
+{
+    signature_keys_cache cache(10);
+
+    for (const auto& data : { "trx1", "trx2", "trx3" })
+    {
+        auto sig = make_signature(data);
+        cache.get_public_key(sig.first, sig.second);
+    }
+
+    cache.set_capacity(1);
+    BOOST_CHECK_EQUAL(cache.get_stats().size, 1u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,151 @@
+#include <boost/test/unit_test.hpp>
+
+#include <scorum/chain/database/state_snapshot.hpp>
+
+#include <graphene/utilities/tempdir.hpp>
+
+#include <fstream>
+
+using scorum::chain::state_snapshot_header;
+using scorum::chain::state_snapshot_reader;
+using scorum::chain::state_snapshot_section;
+using scorum::chain::state_snapshot_writer;
+
+namespace {
+
+struct snapshot_object
+{
+    int64_t id = 0;
+    std::string name;
+};
+}
+
+FC_REFLECT(snapshot_object, (id)(name))
+
+namespace {
+
+struct snapshot_index
+{
+    struct id_type
+    {
+        int64_t _id;
+    };
+
+    const std::vector<snapshot_object>& indices() const
+    {
+        return objects;
+    }
+
+    id_type next_id() const
+    {
+        return id_type{ objects.empty() ? 0 : objects.back().id + 1 };
+    }
+
+    std::vector<snapshot_object> objects;
+};
+
+struct state_snapshot_fixture
+{
+    state_snapshot_fixture()
+        : data_dir(graphene::utilities::temp_directory_path())
+        , file(data_dir.path() / "snapshot")
+    {
+        header.head_block_num = 42;
+
+        for (int64_t ci = 0; ci < 1000; ++ci)
+            accounts.objects.push_back(snapshot_object{ ci * 2, "account" + std::to_string(ci) });
+    }
+
+    void write(uint32_t chunk_size)
+    {
+        state_snapshot_writer writer(file, header, chunk_size);
+        writer.write_section("accounts", false, accounts);
+        writer.write_section("empty", true, snapshot_index());
+        writer.finish();
+    }
+
+    std::vector<snapshot_object> read(const state_snapshot_reader& reader, const state_snapshot_section& section)
+    {
+        std::vector<snapshot_object> result;
+        reader.read_section(section, [&](fc::datastream<const char*>& ds) {
+            result.emplace_back();
+            fc::raw::unpack(ds, result.back());
+        });
+        return result;
+    }
+
+    fc::temp_directory data_dir;
+    fc::path file;
+
+    state_snapshot_header header;
+    snapshot_index accounts;
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(state_snapshot_tests, state_snapshot_fixture)
+
+BOOST_AUTO_TEST_CASE(sections_are_read_back)
+{
+    write(1024);
+
+    state_snapshot_reader reader(file);
+
+    BOOST_CHECK_EQUAL(reader.header().head_block_num, 42u);
+    BOOST_REQUIRE_EQUAL(reader.sections().size(), 2u);
+
+    const auto& section = reader.sections()[0];
+    BOOST_CHECK_EQUAL(section.name, "accounts");
+    BOOST_CHECK(!section.optional);
+    BOOST_CHECK_EQUAL(section.objects, 1000u);
+    BOOST_CHECK_EQUAL(section.next_id, 1999);
+
+    const auto objects = read(reader, section);
+    BOOST_REQUIRE_EQUAL(objects.size(), accounts.objects.size());
+    for (size_t ci = 0; ci < objects.size(); ++ci)
+    {
+        BOOST_CHECK_EQUAL(objects[ci].id, accounts.objects[ci].id);
+        BOOST_CHECK_EQUAL(objects[ci].name, accounts.objects[ci].name);
+    }
+
+    const auto& empty = reader.sections()[1];
+    BOOST_CHECK(empty.optional);
+    BOOST_CHECK_EQUAL(empty.objects, 0u);
+    BOOST_CHECK(read(reader, empty).empty());
+}
+
+BOOST_AUTO_TEST_CASE(unfinished_snapshot_is_rejected)
+{
+    {
+        state_snapshot_writer writer(file, header);
+        writer.write_section("accounts", false, accounts);
+    }
+
+    BOOST_CHECK_THROW(state_snapshot_reader reader(file), fc::exception);
+}
+
+BOOST_AUTO_TEST_CASE(corrupted_chunk_is_detected)
+{
+    write(state_snapshot_writer::default_chunk_size);
+
+    uint64_t position = 0;
+    {
+        state_snapshot_reader reader(file);
+        position = reader.sections()[0].position;
+    }
+
+    // flip a byte of compressed data of the first chunk
+    {
+        std::fstream stream(file.generic_string().c_str(), std::ios::in | std::ios::out | std::ios::binary);
+        stream.seekg(position + 4 * sizeof(uint32_t) + 8);
+        char c = 0;
+        stream.read(&c, 1);
+        stream.seekp(position + 4 * sizeof(uint32_t) + 8);
+        c = ~c;
+        stream.write(&c, 1);
+    }
+
+    state_snapshot_reader reader(file);
+    BOOST_CHECK_THROW(read(reader, reader.sections()[0]), fc::exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()